@@ -0,0 +1,11 @@
+#!/bin/sh
+# nb: Headless build for Linux, everything that does not need Win32.
+# Produces the board core library and the benchmark runner in build/.
+set -e
+root=$(cd "$(dirname "$0")" && pwd)
+mkdir -p $root/build
+cd $root/build
+flags="-O2 -g -march=native -fno-rtti -fno-exceptions -Wall -Wno-unused-function -pthread"
+c++ $flags -c $root/src/minesweeper_core.cpp -o minesweeper_core.o
+ar rcs libminesweeper_core.a minesweeper_core.o
+c++ $flags $root/src/bench.cpp -L. -lminesweeper_core -o minesweeper_bench
@@ -0,0 +1,554 @@
+#include "base.h"
+
+#if OS_WINDOWS
+# ifndef WIN32_LEAN_AND_MEAN
+#  define WIN32_LEAN_AND_MEAN
+# endif
+# include <windows.h>
+#elif OS_LINUX
+# include <fcntl.h>
+# include <stdio.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <time.h>
+# include <unistd.h>
+# include <pthread.h>
+#endif
+#include <math.h>
+
+////////////////////////////////
+//~ nb: OS layer
+#if OS_WINDOWS
+void *
+os_reserve(u64 size)
+{
+  return VirtualAlloc(0, size, MEM_RESERVE, PAGE_READWRITE);
+}
+
+b32
+os_commit(void *ptr, u64 size)
+{
+  return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != 0;
+}
+
+void
+os_release(void *ptr, u64 size)
+{
+  VirtualFree(ptr, 0, MEM_RELEASE);
+}
+
+u64
+os_now_microseconds()
+{
+  static LARGE_INTEGER frequency = {0};
+  if(frequency.QuadPart == 0)
+    QueryPerformanceFrequency(&frequency);
+  LARGE_INTEGER counter;
+  QueryPerformanceCounter(&counter);
+  return (u64)(counter.QuadPart / frequency.QuadPart) * 1000000 +
+    (u64)(counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+}
+
+// nb: only as fine as the scheduler tick
+u64
+os_thread_cpu_microseconds()
+{
+  FILETIME creation, exit, kernel, user;
+  GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+  u64 kernel_100ns = ((u64)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+  u64 user_100ns   = ((u64)user.dwHighDateTime << 32) | user.dwLowDateTime;
+  return (kernel_100ns + user_100ns) / 10;
+}
+
+internal DWORD WINAPI
+os_thread_entry(LPVOID param)
+{
+  OS_Thread *thread = (OS_Thread*)param;
+  thread->func(thread->params);
+  return 0;
+}
+
+void
+os_thread_launch(OS_Thread *thread, OS_Thread_Func *func, void *params)
+{
+  thread->func   = func;
+  thread->params = params;
+  thread->handle = (u64)CreateThread(0, 0, os_thread_entry, thread, 0, 0);
+  Assert(thread->handle);
+}
+
+void
+os_thread_join(OS_Thread *thread)
+{
+  HANDLE handle = (HANDLE)thread->handle;
+  WaitForSingleObject(handle, INFINITE);
+  CloseHandle(handle);
+  thread->handle = 0;
+}
+
+u32
+os_logical_core_count()
+{
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (u32)info.dwNumberOfProcessors;
+}
+
+b32
+os_file_map(const char *path, OS_FileMap *map)
+{
+  memset(map, 0, sizeof(*map));
+  HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+  if(file == INVALID_HANDLE_VALUE)
+    return 0;
+  LARGE_INTEGER size = {0};
+  b32 ok = GetFileSizeEx(file, &size);
+  if(ok && size.QuadPart > 0)
+  {
+    // nb: the view keeps the mapping and the file alive
+    HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+    map->data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : 0;
+    if(mapping)
+      CloseHandle(mapping);
+    ok = map->data != 0;
+  }
+  CloseHandle(file);
+  map->size = ok ? (u64)size.QuadPart : 0;
+  return ok;
+}
+
+void
+os_file_unmap(OS_FileMap *map)
+{
+  if(map->data)
+    UnmapViewOfFile(map->data);
+  memset(map, 0, sizeof(*map));
+}
+
+b32
+os_file_write(const char *path, const void *data, u64 size)
+{
+  char temp_path[MAX_PATH];
+  u64 length = strlen(path);
+  if(length + 5 > sizeof(temp_path))
+    return 0;
+  memcpy(temp_path, path, length);
+  memcpy(temp_path + length, ".tmp", 5);
+  HANDLE file = CreateFileA(temp_path, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+  if(file == INVALID_HANDLE_VALUE)
+    return 0;
+  b32 ok = 1;
+  for(u64 at = 0; ok && at < size;)
+  {
+    DWORD chunk = (DWORD)Min(size - at, 1u << 30);
+    DWORD written = 0;
+    ok = WriteFile(file, (const u8*)data + at, chunk, &written, 0) && written == chunk;
+    at += written;
+  }
+  CloseHandle(file);
+  ok = ok && MoveFileExA(temp_path, path, MOVEFILE_REPLACE_EXISTING);
+  if(!ok)
+    DeleteFileA(temp_path);
+  return ok;
+}
+#elif OS_LINUX
+void *
+os_reserve(u64 size)
+{
+  void *ptr = mmap(0, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if(ptr == MAP_FAILED)
+    ptr = 0;
+  return ptr;
+}
+
+b32
+os_commit(void *ptr, u64 size)
+{
+  return mprotect(ptr, size, PROT_READ | PROT_WRITE) == 0;
+}
+
+void
+os_release(void *ptr, u64 size)
+{
+  munmap(ptr, size);
+}
+
+u64
+os_now_microseconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (u64)ts.tv_sec * 1000000 + (u64)ts.tv_nsec / 1000;
+}
+
+u64
+os_thread_cpu_microseconds()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (u64)ts.tv_sec * 1000000 + (u64)ts.tv_nsec / 1000;
+}
+
+internal void *
+os_thread_entry(void *param)
+{
+  OS_Thread *thread = (OS_Thread*)param;
+  thread->func(thread->params);
+  return 0;
+}
+
+void
+os_thread_launch(OS_Thread *thread, OS_Thread_Func *func, void *params)
+{
+  thread->func   = func;
+  thread->params = params;
+  pthread_t handle;
+  int error = pthread_create(&handle, 0, os_thread_entry, thread);
+  Assert(error == 0);
+  thread->handle = (u64)handle;
+}
+
+void
+os_thread_join(OS_Thread *thread)
+{
+  pthread_join((pthread_t)thread->handle, 0);
+  thread->handle = 0;
+}
+
+u32
+os_logical_core_count()
+{
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (u32)count : 1;
+}
+
+b32
+os_file_map(const char *path, OS_FileMap *map)
+{
+  memset(map, 0, sizeof(*map));
+  int fd = open(path, O_RDONLY);
+  if(fd < 0)
+    return 0;
+  struct stat info;
+  b32 ok = fstat(fd, &info) == 0;
+  if(ok && info.st_size > 0)
+  {
+    // nb: the mapping keeps the file alive
+    void *data = mmap(0, (u64)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ok = data != MAP_FAILED;
+    map->data = ok ? data : 0;
+  }
+  close(fd);
+  map->size = ok ? (u64)info.st_size : 0;
+  return ok;
+}
+
+void
+os_file_unmap(OS_FileMap *map)
+{
+  if(map->data)
+    munmap(map->data, map->size);
+  memset(map, 0, sizeof(*map));
+}
+
+b32
+os_file_write(const char *path, const void *data, u64 size)
+{
+  char temp_path[4096];
+  u64 length = strlen(path);
+  if(length + 5 > sizeof(temp_path))
+    return 0;
+  memcpy(temp_path, path, length);
+  memcpy(temp_path + length, ".tmp", 5);
+  int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if(fd < 0)
+    return 0;
+  b32 ok = 1;
+  for(u64 at = 0; ok && at < size;)
+  {
+    ssize_t written = write(fd, (const u8*)data + at, size - at);
+    ok = written > 0;
+    at += ok ? (u64)written : 0;
+  }
+  ok = (close(fd) == 0) && ok;
+  ok = ok && rename(temp_path, path) == 0;
+  if(!ok)
+    unlink(temp_path);
+  return ok;
+}
+#endif
+
+////////////////////////////////
+//~ nb: Arena
+Arena *
+arena_alloc()
+{
+  return arena_alloc_reserve(RESERVE_SIZE);
+}
+
+Arena *
+arena_alloc_reserve(u64 reserve_size)
+{
+  reserve_size = AlignPow2(reserve_size, COMMIT_SIZE);
+  void *ptr = os_reserve(reserve_size);
+  Assert(ptr);
+  os_commit(ptr, COMMIT_SIZE);
+
+  Arena *arena = (Arena*)ptr;
+  {
+    arena->pos          = AlignPow2(sizeof(Arena), 16);
+    arena->base_pos     = 0;
+    arena->reserved     = reserve_size;
+    arena->reserve_size = reserve_size;
+    arena->committed    = COMMIT_SIZE;
+    arena->commit_size  = COMMIT_SIZE;
+  }
+
+  return arena;
+}
+
+void
+arena_release(Arena *arena)
+{
+  os_release(arena, arena->reserved);
+}
+
+void *
+arena_push(Arena *arena, u64 size)
+{
+  u64 pos_pre = AlignPow2(arena->pos, 16);
+  u64 pos_pst = pos_pre + size;
+  // TODO(nb): chain more arenas
+  if(pos_pst > arena->reserved)
+  {
+    Trap();
+  }
+  // nb: commit new pages
+  if(arena->committed < pos_pst)
+  {
+    u64 cmt_pst_aligned = pos_pst + arena->commit_size - 1;
+    cmt_pst_aligned -= cmt_pst_aligned % arena->commit_size;
+    u64 cmt_pst_clamped = ClampTop(cmt_pst_aligned, arena->reserved);
+    u64 cmt_size = cmt_pst_clamped - arena->committed;
+    u8 *cmt_ptr = (u8 *)arena + arena->committed;
+    os_commit(cmt_ptr, cmt_size);
+    arena->committed = cmt_pst_clamped;
+  }
+  // nb: return the start of the allocation, then update the cursor
+  void *result = (u8*)arena + pos_pre;
+  arena->pos = pos_pst;
+  return result;
+}
+
+void
+arena_pop_to(Arena *arena, u64 pos)
+{
+  u64 big_pos = ClampBot(AlignPow2(sizeof(Arena), 16), pos);
+  u64 new_pos = big_pos - arena->base_pos;
+  Assert(new_pos <= arena->pos);
+  arena->pos = new_pos;
+}
+
+void
+arena_clear(Arena *arena)
+{
+  arena_pop_to(arena, 0);
+}
+
+Temp
+temp_begin(Arena *arena)
+{
+  Temp temp = {0};
+  temp.arena = arena;
+  temp.pos = arena->pos;
+  return temp;
+}
+
+void
+temp_end(Temp temp)
+{
+  arena_pop_to(temp.arena, temp.pos);
+}
+
+////////////////////////////////
+//~ nb: Random numbers
+internal u64
+splitmix64(u64 *state)
+{
+  u64 z = (*state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+internal inline u64
+rotl64(u64 x, u32 k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+Rng
+rng_from_seed(u64 seed)
+{
+  Rng rng;
+  for(u32 i = 0; i < 4; i++)
+  {
+    rng.s[i] = splitmix64(&seed);
+  }
+  return rng;
+}
+
+u64
+rng_next_u64(Rng *rng)
+{
+  u64 *s = rng->s;
+  u64 result = rotl64(s[1] * 5, 7) * 9;
+  u64 t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl64(s[3], 45);
+  return result;
+}
+
+//- nb: Lemire's bounded ints, shared by both generator kinds
+typedef u64 Rng_Next_Func(void *state);
+
+internal inline u32
+rng_range_u32_from(Rng_Next_Func *next, void *state, u32 bound)
+{
+  u64 m = (next(state) >> 32) * bound;
+  u32 low = (u32)m;
+  if(low < bound)
+  {
+    // nb: reject the few values that would make the low end more likely
+    u32 threshold = (0u - bound) % bound;
+    while(low < threshold)
+    {
+      m = (next(state) >> 32) * bound;
+      low = (u32)m;
+    }
+  }
+  return (u32)(m >> 32);
+}
+
+internal u64
+rng_next_u64_from_state(void *state)
+{
+  return rng_next_u64((Rng*)state);
+}
+
+u32
+rng_range_u32(Rng *rng, u32 bound)
+{
+  return rng_range_u32_from(rng_next_u64_from_state, rng, bound);
+}
+
+f64
+rng_f64(Rng *rng)
+{
+  return (f64)(rng_next_u64(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+internal f64
+log_choose(f64 n, f64 k)
+{
+  return lgamma(n + 1.0) - lgamma(k + 1.0) - lgamma(n - k + 1.0);
+}
+
+u64
+rng_hypergeometric(Rng *rng, u64 population, u64 successes, u64 draws)
+{
+  Assert(successes <= population && draws <= population);
+  u64 lo = (draws + successes > population) ? draws + successes - population : 0;
+  u64 hi = Min(draws, successes);
+  if(lo == hi)
+    return lo;
+
+  f64 N = (f64)population, K = (f64)successes, n = (f64)draws;
+  u64 mode = (u64)((n + 1.0) * (K + 1.0) / (N + 2.0));
+  mode = Clamp(lo, mode, hi);
+  f64 m = (f64)mode;
+  f64 p_mode = exp(log_choose(K, m) + log_choose(N - K, n - m) - log_choose(N, n));
+
+  //- nb: walk outwards from the mode, alternating sides, subtracting each
+  // outcome's probability from u. Every outcome is visited exactly once, so
+  // the order does not bias anything, and the walk is short because the
+  // mass sits within a few standard deviations of the mode.
+  f64 u = rng_f64(rng) - p_mode;
+  if(u <= 0.0)
+    return mode;
+  u64 k_lo = mode, k_hi = mode;
+  f64 p_lo = p_mode, p_hi = p_mode;
+  for(;;)
+  {
+    b32 moved = 0;
+    if(k_lo > lo)
+    {
+      f64 k = (f64)k_lo;
+      p_lo *= k * (N - K - n + k) / ((K - k + 1.0) * (n - k + 1.0));
+      k_lo -= 1;
+      u -= p_lo;
+      if(u <= 0.0)
+        return k_lo;
+      moved = 1;
+    }
+    if(k_hi < hi)
+    {
+      f64 k = (f64)k_hi;
+      p_hi *= (K - k) * (n - k) / ((k + 1.0) * (N - K - n + k + 1.0));
+      k_hi += 1;
+      u -= p_hi;
+      if(u <= 0.0)
+        return k_hi;
+      moved = 1;
+    }
+    // nb: only reachable through rounding in the probabilities
+    if(!moved)
+      return mode;
+  }
+}
+
+//- nb: Counter-based streams
+u64
+rng_hash_u64(u64 key, u64 counter)
+{
+  // nb: two splitmix64 finalizer rounds over (key, counter); one round on
+  // key + counter * gamma alone lets streams with nearby keys overlap
+  u64 z = key + (counter + 1) * 0x9e3779b97f4a7c15ull;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  z ^= (z >> 31) ^ rotl64(key, 23);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+Rng_Stream
+rng_stream(u64 seed, u64 stream_idx)
+{
+  Rng_Stream stream;
+  stream.key     = rng_hash_u64(seed, stream_idx);
+  stream.counter = 0;
+  return stream;
+}
+
+u64
+rng_stream_next_u64(Rng_Stream *stream)
+{
+  return rng_hash_u64(stream->key, stream->counter++);
+}
+
+internal u64
+rng_stream_next_u64_from_state(void *state)
+{
+  return rng_stream_next_u64((Rng_Stream*)state);
+}
+
+u32
+rng_stream_range_u32(Rng_Stream *stream, u32 bound)
+{
+  return rng_range_u32_from(rng_stream_next_u64_from_state, stream, bound);
+}
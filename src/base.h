@@ -0,0 +1,196 @@
+#ifndef BASE_H
+#define BASE_H
+
+////////////////////////////////
+//~ nb: Base layer
+// Types, macros, arenas and the tiny OS layer everything else sits on.
+// Nothing in here may depend on Win32 headers, so the board core can be
+// built on its own (see build.sh).
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_WIN32)
+# define OS_WINDOWS 1
+#elif defined(__linux__)
+# define OS_LINUX 1
+#else
+# error "unsupported platform"
+#endif
+
+#if defined(_MSC_VER)
+# include <intrin.h>
+# define Trap() __debugbreak()
+#else
+# define Trap() __builtin_trap()
+#endif
+#define Assert(cond) do{ if(!(cond)) Trap(); } while(0)
+
+typedef int8_t      s8;
+typedef uint8_t     u8;
+typedef int16_t     s16;
+typedef uint16_t    u16;
+typedef int32_t     s32;
+typedef uint32_t    u32;
+typedef int64_t     s64;
+typedef uint64_t    u64;
+typedef s32         b32;
+typedef float       f32;
+typedef double      f64;
+
+#define internal    static
+#define global      static
+
+#define Kilobytes(x) ((u64)(x) << 10)
+#define Megabytes(x) ((u64)(x) << 20)
+#define Gigabytes(x) ((u64)(x) << 30)
+
+#define RESERVE_SIZE Megabytes(64)
+#define COMMIT_SIZE  Kilobytes(64)
+#define PAGE_SIZE    4096
+
+#define ArrayCount(a) (sizeof(a) / sizeof((a)[0]))
+#define AlignPow2(pos, align) (((pos) + (align) - 1) & ~((align) - 1))
+#define Min(A,B) (((A)<(B))?(A):(B))
+#define Max(A,B) (((A)>(B))?(A):(B))
+#define ClampTop(A,X) Min(A,X)
+#define ClampBot(X,B) Max(X,B)
+#define Clamp(A,X,B) (((X)<(A))?(A):((X)>(B))?(B):(X))
+
+////////////////////////////////
+//~ nb: Bit helpers
+#if defined(_MSC_VER)
+static inline u32 count_bits_u64(u64 x) { return (u32)__popcnt64(x); }
+static inline u32 ctz_u64(u64 x) { unsigned long idx; _BitScanForward64(&idx, x); return (u32)idx; }
+static inline u32 clz_u64(u64 x) { unsigned long idx; _BitScanReverse64(&idx, x); return 63 - (u32)idx; }
+#else
+static inline u32 count_bits_u64(u64 x) { return (u32)__builtin_popcountll(x); }
+static inline u32 ctz_u64(u64 x) { return (u32)__builtin_ctzll(x); }
+static inline u32 clz_u64(u64 x) { return (u32)__builtin_clzll(x); }
+#endif
+
+////////////////////////////////
+//~ nb: Atomics
+// Only what the board's worker threads need: relaxed loads and an OR that
+// other threads may race with.
+#if defined(_MSC_VER)
+static inline u64 atomic_load_u64(u64 volatile *ptr) { return *ptr; }
+static inline void atomic_or_u64(u64 volatile *ptr, u64 value) { _InterlockedOr64((long long volatile*)ptr, (long long)value); }
+#else
+static inline u64 atomic_load_u64(u64 volatile *ptr) { return __atomic_load_n(ptr, __ATOMIC_RELAXED); }
+static inline void atomic_or_u64(u64 volatile *ptr, u64 value) { __atomic_fetch_or(ptr, value, __ATOMIC_RELAXED); }
+#endif
+
+////////////////////////////////
+//~ nb: Arena
+typedef struct Arena Arena;
+struct Arena
+{
+  void *base_ptr;
+  u64  reserved;
+  u64  committed;
+  u64  pos;
+
+  u64 base_pos;
+  u64 reserve_size;
+  u64 commit_size;
+};
+
+typedef struct Temp Temp;
+struct Temp
+{
+  Arena *arena;
+  u64 pos;
+};
+
+Arena *arena_alloc();
+Arena *arena_alloc_reserve(u64 reserve_size);
+void   arena_release(Arena *arena);
+void  *arena_push(Arena *arena, u64 size);
+void   arena_pop_to(Arena *arena, u64 pos);
+void   arena_clear(Arena *arena);
+
+Temp temp_begin(Arena *arena);
+void temp_end(Temp temp);
+
+////////////////////////////////
+//~ nb: Random numbers
+// xoshiro256** seeded through splitmix64, bounded ints use Lemire's
+// multiply-shift with rejection so they are unbiased.
+typedef struct Rng Rng;
+struct Rng
+{
+  u64 s[4];
+};
+
+Rng rng_from_seed(u64 seed);
+u64 rng_next_u64(Rng *rng);
+// nb: uniform in [0, bound), bound must be > 0
+u32 rng_range_u32(Rng *rng, u32 bound);
+// nb: uniform in [0, 1)
+f64 rng_f64(Rng *rng);
+// nb: How many of `draws` picks, without replacement, out of `population`
+// items land on one of the `successes` marked ones. Exact inversion around
+// the mode, so it costs O(standard deviation) instead of O(draws).
+u64 rng_hypergeometric(Rng *rng, u64 population, u64 successes, u64 draws);
+
+//- nb: Counter-based streams
+// Value i of a stream is a pure function of (key, i), so every stream can be
+// started anywhere without replaying the ones before it. Used to give each
+// unit of parallel work its own generator.
+typedef struct Rng_Stream Rng_Stream;
+struct Rng_Stream
+{
+  u64 key;
+  u64 counter;
+};
+
+u64        rng_hash_u64(u64 key, u64 counter);
+Rng_Stream rng_stream(u64 seed, u64 stream_idx);
+u64        rng_stream_next_u64(Rng_Stream *stream);
+u32        rng_stream_range_u32(Rng_Stream *stream, u32 bound);
+
+////////////////////////////////
+//~ nb: OS layer
+void *os_reserve(u64 size);
+b32   os_commit(void *ptr, u64 size);
+void  os_release(void *ptr, u64 size);
+
+u64   os_now_microseconds();
+// nb: time the calling thread spent running, without the time it was
+// preempted
+u64   os_thread_cpu_microseconds();
+
+//- nb: Threads
+typedef void OS_Thread_Func(void *params);
+
+typedef struct OS_Thread OS_Thread;
+struct OS_Thread
+{
+  OS_Thread_Func *func;
+  void           *params;
+  u64            handle;
+};
+
+// nb: `thread` has to stay alive until os_thread_join returns
+void  os_thread_launch(OS_Thread *thread, OS_Thread_Func *func, void *params);
+void  os_thread_join(OS_Thread *thread);
+u32   os_logical_core_count();
+
+//- nb: Files
+typedef struct OS_FileMap OS_FileMap;
+struct OS_FileMap
+{
+  void *data;
+  u64  size;
+};
+
+// nb: Maps a whole file read only, 0 when it can't be opened. An empty file
+// maps to no data.
+b32   os_file_map(const char *path, OS_FileMap *map);
+void  os_file_unmap(OS_FileMap *map);
+// nb: Writes next to `path` and renames over it, readers see the old file
+// or the new one, never half of it.
+b32   os_file_write(const char *path, const void *data, u64 size);
+
+#endif //BASE_H
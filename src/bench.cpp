@@ -0,0 +1,3861 @@
+////////////////////////////////
+//~ nb: Headless benchmarks
+// Links against libminesweeper_core.a, see build.sh.
+// Usage: minesweeper_bench [name...], runs everything when no name is given.
+// Benches that render write their frames as PPM into $BENCH_DUMP_DIR when
+// it is set.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "base.h"
+#include "core.h"
+#include "chunk_board.h"
+#include "render_core.h"
+#include "render_bc.h"
+#include "font_cache.h"
+#include "rect_pack.h"
+#include "glyph_sdf.h"
+#include "glyph_cache.h"
+#include "text_cache.h"
+#include "render_soft.h"
+
+typedef void Bench_Func(Arena *arena);
+typedef struct Bench Bench;
+struct Bench
+{
+  const char *name;
+  Bench_Func *func;
+};
+
+//- nb: tiny lcg so the benchmarks don't depend on the core's rng
+internal u32
+bench_rand(u64 *state)
+{
+  *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+  return (u32)(*state >> 33);
+}
+
+////////////////////////////////
+//~ nb: Play random games until they are lost or won
+internal void
+bench_play_games(Board *board, u32 columns, u32 rows, u32 mine_count, u32 game_count)
+{
+  u64 rng = 1234;
+  u64 sweep_count = 0;
+  u64 worst_sweep_us = 0;
+  u64 begin = os_now_microseconds();
+  for(u32 game = 0; game < game_count; game++)
+  {
+    board_reset(board, columns, rows, mine_count, game);
+    while(board->is_playable && board->swept_count + board->mine_count < board->tiles_count)
+    {
+      u32 idx = bench_rand(&rng) % board->tiles_count;
+      if(board_tile(board, idx) & TILE_BIT_SWEPT)
+        continue;
+      u64 sweep_begin = os_now_microseconds();
+      board_sweep(board, idx);
+      u64 sweep_us = os_now_microseconds() - sweep_begin;
+      worst_sweep_us = Max(worst_sweep_us, sweep_us);
+      sweep_count += 1;
+    }
+  }
+  u64 total_us = os_now_microseconds() - begin;
+  printf("  %5ux%-5u %8u mines: %6u games in %8.2f ms, %8.2f us/sweep, worst sweep %8.2f ms\n",
+         columns, rows, mine_count, game_count, total_us / 1000.0,
+         sweep_count ? (f64)total_us / sweep_count : 0.0, worst_sweep_us / 1000.0);
+}
+
+internal void
+bench_play(Arena *arena)
+{
+  Board *board = board_alloc();
+  bench_play_games(board, 30, 16, 90, 10000);
+  bench_play_games(board, 256, 256, 10000, 100);
+  bench_play_games(board, 1000, 1000, 150000, 4);
+  board_release(board);
+}
+
+////////////////////////////////
+//~ nb: Packed tiles vs the old 16 byte tile struct
+typedef struct Bench_Legacy_Tile Bench_Legacy_Tile;
+struct Bench_Legacy_Tile
+{
+  u32 neighbor_count;
+  bool has_flag;
+  bool is_mine;
+  bool is_swept;
+  f32 sprite[2];
+};
+
+global const f32 bench_sprite_uvs[TILE_END][2] =
+{
+  {0.0f, 0.0f},   {0.25f, 0.0f},   {0.50f, 0.0f},  {0.75f, 0.0f},
+  {0.0f, 0.25f},  {0.25f, 0.25f},  {0.50f, 0.25f}, {0.75f, 0.25f},
+  {0.0f, 0.50f},  {0.25f, 0.50f},  {0.50f, 0.50f}, {0.75f, 0.50f},
+  {0.0f, 0.75f},  {0.25f, 0.75f},  {0.50f, 0.75f}, {0.75f, 0.75f},
+};
+
+internal void
+bench_tiles(Arena *arena)
+{
+  const u32 side = 2048;
+  const u32 count = side * side;
+  Arena *big = arena_alloc_reserve(Gigabytes(1));
+  Bench_Legacy_Tile *legacy = (Bench_Legacy_Tile*)arena_push(big, sizeof(Bench_Legacy_Tile) * count);
+  Tile *packed = (Tile*)arena_push(big, sizeof(Tile) * count);
+  f32 *uvs = (f32*)arena_push(big, sizeof(f32) * 2 * count);
+
+  //- nb: same random board in both layouts
+  u64 rng = 42;
+  for(u32 i = 0; i < count; i++)
+  {
+    u32 r = bench_rand(&rng);
+    Tile tile = (Tile)(r % 9);
+    if(r % 5 == 0)  tile = TILE_BIT_MINE;
+    if(r % 7 == 0)  tile |= TILE_BIT_SWEPT;
+    if(r % 11 == 0 && !(tile & TILE_BIT_SWEPT)) tile |= TILE_BIT_FLAG;
+    packed[i] = tile;
+
+    Bench_Legacy_Tile *lt = &legacy[i];
+    lt->neighbor_count = tile & TILE_COUNT_MASK;
+    lt->is_mine  = !!(tile & TILE_BIT_MINE);
+    lt->has_flag = !!(tile & TILE_BIT_FLAG);
+    lt->is_swept = !!(tile & TILE_BIT_SWEPT);
+    u32 kind = tile_kind(tile);
+    lt->sprite[0] = bench_sprite_uvs[kind][0];
+    lt->sprite[1] = bench_sprite_uvs[kind][1];
+  }
+
+  printf("  %ux%u board: legacy %6.1f MiB, packed %6.1f MiB (%zux smaller)\n",
+         side, side,
+         sizeof(Bench_Legacy_Tile) * (f64)count / Megabytes(1),
+         sizeof(Tile) * (f64)count / Megabytes(1),
+         sizeof(Bench_Legacy_Tile) / sizeof(Tile));
+
+  //- nb: every tile byte maps to one sprite, so the render pass is a table lookup
+  f32 uv_from_tile[256][2];
+  for(u32 tile = 0; tile < 256; tile++)
+  {
+    uv_from_tile[tile][0] = bench_sprite_uvs[tile_kind((Tile)tile)][0];
+    uv_from_tile[tile][1] = bench_sprite_uvs[tile_kind((Tile)tile)][1];
+  }
+
+  u64 best[4] = {~0ull, ~0ull, ~0ull, ~0ull};
+  u64 checksum[4] = {0};
+  for(u32 iter = 0; iter < 5; iter++)
+  {
+    //- nb: render pass, one uv per tile
+    u64 t0 = os_now_microseconds();
+    for(u32 i = 0; i < count; i++)
+    {
+      uvs[i*2 + 0] = legacy[i].sprite[0];
+      uvs[i*2 + 1] = legacy[i].sprite[1];
+    }
+    u64 t1 = os_now_microseconds();
+    checksum[0] += (u64)(uvs[count] * 4);
+    for(u32 i = 0; i < count; i++)
+    {
+      uvs[i*2 + 0] = uv_from_tile[packed[i]][0];
+      uvs[i*2 + 1] = uv_from_tile[packed[i]][1];
+    }
+    u64 t2 = os_now_microseconds();
+    checksum[1] += (u64)(uvs[count] * 4);
+
+    //- nb: reveal-style scan, count hidden zero tiles
+    u64 hidden_zero = 0;
+    for(u32 i = 0; i < count; i++)
+    {
+      Bench_Legacy_Tile *lt = &legacy[i];
+      hidden_zero += !lt->is_mine && !lt->is_swept && !lt->has_flag && lt->neighbor_count == 0;
+    }
+    u64 t3 = os_now_microseconds();
+    checksum[2] += hidden_zero;
+    hidden_zero = 0;
+    for(u32 i = 0; i < count; i++)
+    {
+      hidden_zero += (packed[i] & (TILE_BIT_MINE | TILE_BIT_SWEPT | TILE_BIT_FLAG | TILE_COUNT_MASK)) == 0;
+    }
+    u64 t4 = os_now_microseconds();
+    checksum[3] += hidden_zero;
+
+    best[0] = Min(best[0], t1 - t0);
+    best[1] = Min(best[1], t2 - t1);
+    best[2] = Min(best[2], t3 - t2);
+    best[3] = Min(best[3], t4 - t3);
+  }
+  Assert(checksum[0] == checksum[1] && checksum[2] == checksum[3]);
+  printf("  render pass:  legacy %7.2f ms, packed %7.2f ms\n", best[0] / 1000.0, best[1] / 1000.0);
+  printf("  reveal scan:  legacy %7.2f ms, packed %7.2f ms\n", best[2] / 1000.0, best[3] / 1000.0);
+  arena_release(big);
+}
+
+////////////////////////////////
+//~ nb: Neighbor counts, vectorized bit-plane pass vs per-mine scatter
+internal void
+bench_counts_scatter(u32 *mines, u32 mine_count, u32 columns, u32 rows, u8 *counts)
+{
+  // nb: this is what the board did before bit-planes
+  for(u32 i = 0; i < mine_count; i++)
+  {
+    u32 tile_x = mines[i] % columns;
+    u32 tile_y = mines[i] / columns;
+    for(s32 dy = -1; dy <= 1; dy++)
+    {
+      for(s32 dx = -1; dx <= 1; dx++)
+      {
+        if(dx == 0 && dy == 0)
+          continue;
+        s64 nx = (s64)tile_x + dx;
+        s64 ny = (s64)tile_y + dy;
+        if(nx >= 0 && nx < columns && ny >= 0 && ny < rows)
+        {
+          counts[(u32)ny * columns + (u32)nx] += 1;
+        }
+      }
+    }
+  }
+  // nb: mines carry no count
+  for(u32 i = 0; i < mine_count; i++)
+  {
+    counts[mines[i]] = 0;
+  }
+}
+
+internal void
+bench_counts_board(u32 columns, u32 rows, u32 density_percent)
+{
+  Board *board = board_alloc();
+  board_reset(board, columns, rows, 0, 0);
+  Arena *big = arena_alloc_reserve(Gigabytes(4));
+  u32 *mines = (u32*)arena_push(big, sizeof(u32) * board->tiles_count);
+  u8 *counts = (u8*)arena_push(big, board->tiles_count);
+  memset(counts, 0, board->tiles_count);
+
+  u64 rng = 7;
+  u32 mine_count = 0;
+  for(u32 y = 0; y < rows; y++)
+  {
+    for(u32 x = 0; x < columns; x++)
+    {
+      if(bench_rand(&rng) % 100 < density_percent)
+      {
+        board->mine_plane[(u64)y * board->words_per_row + (x >> 6)] |= 1ull << (x & 63);
+        mines[mine_count++] = y * columns + x;
+      }
+    }
+  }
+
+  u64 t0 = os_now_microseconds();
+  bench_counts_scatter(mines, mine_count, columns, rows, counts);
+  u64 t1 = os_now_microseconds();
+  board_compute_neighbor_counts(board);
+  u64 t2 = os_now_microseconds();
+
+  b32 match = memcmp(counts, board->neighbor_counts, board->tiles_count) == 0;
+  printf("  %5ux%-5u %2u%% mines: scatter %9.2f ms, bit-plane kernel %8.2f ms (%5.1fx) %s\n",
+         columns, rows, density_percent, (t1 - t0) / 1000.0, (t2 - t1) / 1000.0,
+         (f64)(t1 - t0) / Max(t2 - t1, 1), match ? "" : "MISMATCH");
+  Assert(match);
+  arena_release(big);
+  board_release(board);
+}
+
+internal void
+bench_counts(Arena *arena)
+{
+  bench_counts_board(30, 16, 19);
+  bench_counts_board(1000, 1000, 15);
+  bench_counts_board(3001, 1777, 20);
+  bench_counts_board(10000, 10000, 20);
+}
+
+////////////////////////////////
+//~ nb: Flood fill, span fill vs the old per-tile stack fill
+#define BenchBit(board, plane, idx) (((plane)[(u64)((idx) / (board)->columns) * (board)->words_per_row + ((idx) % (board)->columns) / 64] >> (((idx) % (board)->columns) & 63)) & 1)
+#define BenchSetBit(board, plane, idx) ((plane)[(u64)((idx) / (board)->columns) * (board)->words_per_row + ((idx) % (board)->columns) / 64] |= 1ull << (((idx) % (board)->columns) & 63))
+
+//- nb: the fill the board used before, one stack entry per zero tile
+internal u32
+bench_fill_legacy(Board *board, u32 idx, u64 *swept, u32 *stack)
+{
+  u32 swept_count = 0;
+  u32 stack_count = 0;
+  if(BenchBit(board, swept, idx) || BenchBit(board, board->flag_plane, idx) || BenchBit(board, board->mine_plane, idx))
+    return 0;
+  BenchSetBit(board, swept, idx);
+  swept_count += 1;
+  if(board->neighbor_counts[idx] == 0)
+    stack[stack_count++] = idx;
+  while(stack_count > 0)
+  {
+    u32 tile_idx = stack[--stack_count];
+    u32 tile_x = tile_idx % board->columns;
+    u32 tile_y = tile_idx / board->columns;
+    for(s32 dy = -1; dy <= 1; dy++)
+    {
+      for(s32 dx = -1; dx <= 1; dx++)
+      {
+        s64 nx = (s64)tile_x + dx;
+        s64 ny = (s64)tile_y + dy;
+        if((dx == 0 && dy == 0) || nx < 0 || nx >= board->columns || ny < 0 || ny >= board->rows)
+          continue;
+        u32 nb = (u32)ny * board->columns + (u32)nx;
+        if(BenchBit(board, board->mine_plane, nb) || BenchBit(board, swept, nb) || BenchBit(board, board->flag_plane, nb))
+          continue;
+        BenchSetBit(board, swept, nb);
+        swept_count += 1;
+        if(board->neighbor_counts[nb] == 0)
+          stack[stack_count++] = nb;
+      }
+    }
+  }
+  return swept_count;
+}
+
+internal void
+bench_fill_board(Arena *arena, u32 columns, u32 rows, u32 mine_count, u32 click_count)
+{
+  Board *board = board_alloc();
+  Arena *big = arena_alloc_reserve(Gigabytes(4));
+  board_reset(board, columns, rows, mine_count, 99);
+  u64 plane_size = sizeof(u64) * board->words_per_row * rows;
+  u64 *swept = (u64*)arena_push(big, plane_size);
+  u32 *stack = (u32*)arena_push(big, sizeof(u32) * board->tiles_count);
+
+  //- nb: place the mines, then start over from a hidden board with some flags
+  u64 rng = 5;
+  board_sweep(board, (rows / 2) * columns + columns / 2);
+  memset(board->swept_plane, 0, plane_size);
+  board->swept_count = 0;
+  for(u32 i = 0; i < board->tiles_count / 50; i++)
+  {
+    board_toggle_flag(board, bench_rand(&rng) % board->tiles_count);
+  }
+
+  u64 legacy_us = 0, span_us = 0, worst_legacy_us = 0, worst_span_us = 0;
+  u64 revealed = 0;
+  for(u32 click = 0; click < click_count; click++)
+  {
+    u32 idx = bench_rand(&rng) % board->tiles_count;
+    if(BenchBit(board, board->mine_plane, idx) || BenchBit(board, board->swept_plane, idx))
+      continue;
+    memcpy(swept, board->swept_plane, plane_size);
+
+    u64 t0 = os_now_microseconds();
+    u32 legacy_swept = bench_fill_legacy(board, idx, swept, stack);
+    u64 t1 = os_now_microseconds();
+    u32 swept_before = board->swept_count;
+    board_sweep(board, idx);
+    u64 t2 = os_now_microseconds();
+
+    b32 match = (memcmp(swept, board->swept_plane, plane_size) == 0 &&
+                 board->swept_count - swept_before == legacy_swept);
+    if(!match)
+      printf("  MISMATCH after sweeping %u\n", idx);
+    Assert(match);
+    legacy_us += t1 - t0;
+    span_us   += t2 - t1;
+    worst_legacy_us = Max(worst_legacy_us, t1 - t0);
+    worst_span_us   = Max(worst_span_us, t2 - t1);
+    revealed += legacy_swept;
+  }
+  printf("  %5ux%-5u %8u mines: %9llu tiles revealed, legacy %8.2f ms (worst %7.2f), span %8.2f ms (worst %7.2f)\n",
+         columns, rows, mine_count, (unsigned long long)revealed,
+         legacy_us / 1000.0, worst_legacy_us / 1000.0, span_us / 1000.0, worst_span_us / 1000.0);
+  arena_release(big);
+  board_release(board);
+}
+
+internal void
+bench_fill(Arena *arena)
+{
+  bench_fill_board(arena, 30, 16, 40, 200);
+  bench_fill_board(arena, 1000, 1000, 80000, 2000);
+  bench_fill_board(arena, 4000, 4000, 300000, 200);
+  bench_fill_board(arena, 10000, 10000, 1000000, 20);
+}
+
+////////////////////////////////
+//~ nb: First sweep mine placement
+internal void
+bench_place_board(u32 columns, u32 rows, u32 mine_count)
+{
+  Board *board = board_alloc();
+  Arena *big = arena_alloc_reserve(Gigabytes(4));
+  u32 tiles_count = columns * rows;
+  u32 safe_idx = (rows / 2) * columns + columns / 2;
+
+  //- nb: what the board did before: list every allowed tile, shuffle all of them
+  u32 *indices = (u32*)arena_push(big, sizeof(u32) * tiles_count);
+  u64 t0 = os_now_microseconds();
+  u32 candidate_count = 0;
+  for(u32 i = 0; i < tiles_count; i++)
+  {
+    s64 dx = (s64)(i % columns) - (safe_idx % columns);
+    s64 dy = (s64)(i / columns) - (safe_idx / columns);
+    if(dx < -1 || dx > 1 || dy < -1 || dy > 1)
+      indices[candidate_count++] = i;
+  }
+  srand(1);
+  for(u32 i = candidate_count; i-- > 1;)
+  {
+    u32 j = rand() % (i + 1);
+    u32 temp = indices[i];
+    indices[i] = indices[j];
+    indices[j] = temp;
+  }
+  u64 t1 = os_now_microseconds();
+
+  //- nb: the board's first sweep, placement + neighbor counts + reveal
+  board_reset(board, columns, rows, mine_count, 1234);
+  u64 t2 = os_now_microseconds();
+  board_sweep(board, safe_idx);
+  u64 t3 = os_now_microseconds();
+
+  //- nb: same seed, same board, whatever the thread count
+  u64 plane_size = sizeof(u64) * board->words_per_row * rows;
+  u64 *first = (u64*)arena_push(big, plane_size);
+  memcpy(first, board->mine_plane, plane_size);
+  u32 thread_counts[] = {1, 2, 3, 8};
+  u64 thread_us[ArrayCount(thread_counts)];
+  u64 fill_us[ArrayCount(thread_counts)];
+  b32 same = 1;
+  for(u32 i = 0; i < ArrayCount(thread_counts); i++)
+  {
+    // nb: a flagged first sweep only places the mines, counts them and
+    // builds the openings, the board times the chunk fill on its own
+    board->thread_count = thread_counts[i];
+    board_reset(board, columns, rows, mine_count, 1234);
+    board_toggle_flag(board, safe_idx);
+    u64 t4 = os_now_microseconds();
+    board_sweep(board, safe_idx);
+    thread_us[i] = os_now_microseconds() - t4;
+    fill_us[i] = board->place_fill_us;
+    board_toggle_flag(board, safe_idx);
+    same = same && memcmp(first, board->mine_plane, plane_size) == 0;
+  }
+
+  u64 placed = 0;
+  for(u64 w = 0; w < (u64)board->words_per_row * rows; w++)
+    placed += count_bits_u64(board->mine_plane[w]);
+  b32 safe_clear = 1;
+  for(s32 dy = -1; dy <= 1; dy++)
+  {
+    for(s32 dx = -1; dx <= 1; dx++)
+    {
+      s64 x = (s64)(safe_idx % columns) + dx;
+      s64 y = (s64)(safe_idx / columns) + dy;
+      if(x >= 0 && y >= 0 && x < columns && y < rows && BenchBit(board, board->mine_plane, (u32)(y * columns + x)))
+        safe_clear = 0;
+    }
+  }
+  Assert(same && safe_clear && placed == board->mine_count && board->is_playable);
+
+  printf("  %5ux%-5u %9u mines: legacy shuffle %9.2f ms, first sweep %8.2f ms\n    chunk fill (",
+         columns, rows, mine_count, (t1 - t0) / 1000.0, (t3 - t2) / 1000.0);
+  for(u32 i = 0; i < ArrayCount(thread_counts); i++)
+    printf("%s%u thr %.2f ms", i ? ", " : "", thread_counts[i], fill_us[i] / 1000.0);
+  printf(")\n    with counts and openings (");
+  for(u32 i = 0; i < ArrayCount(thread_counts); i++)
+    printf("%s%u thr %.2f ms", i ? ", " : "", thread_counts[i], thread_us[i] / 1000.0);
+  printf(")\n");
+  arena_release(big);
+  board_release(board);
+}
+
+internal void
+bench_place(Arena *arena)
+{
+  //- nb: Every tile is in the first sweep's 3x3, nothing to place. The
+  // board played a bigger game before, so its arena is full of old jobs.
+  {
+    Board *board = board_alloc();
+    u32 sizes[][2] = {{1, 1}, {3, 1}, {1, 3}, {2, 2}, {3, 3}};
+    for(u32 i = 0; i < ArrayCount(sizes); i++)
+    {
+      board_reset(board, 1000, 1000, 200000, 1234);
+      board_sweep(board, 500 * 1000 + 500);
+      u32 columns = sizes[i][0], rows = sizes[i][1];
+      board_reset(board, columns, rows, 5, 1234);
+      board_sweep(board, (rows / 2) * columns + columns / 2);
+      Assert(board->mine_count == 0 && board->swept_count == columns * rows);
+    }
+    board_release(board);
+    printf("  tiny boards: no mines placed, the first sweep clears them\n");
+  }
+  bench_place_board(3, 3, 5);
+  bench_place_board(30, 16, 99);
+  bench_place_board(1000, 1000, 200000);
+  bench_place_board(10000, 10000, 90);
+  bench_place_board(10000, 10000, 20000000);
+}
+
+////////////////////////////////
+//~ nb: Opening index
+//- nb: 3BV and opening statistics the slow way, one legacy fill per opening
+internal void
+bench_openings_reference(Board *board, Arena *arena, u32 *opening_count, u32 *largest, u32 *bbbv)
+{
+  u64 plane_size = sizeof(u64) * board->words_per_row * board->rows;
+  u64 *covered = (u64*)arena_push(arena, plane_size);
+  u64 *single  = (u64*)arena_push(arena, plane_size);
+  u32 *stack   = (u32*)arena_push(arena, sizeof(u32) * board->tiles_count);
+  memset(covered, 0, plane_size);
+  memset(single, 0, plane_size);
+  *opening_count = 0;
+  *largest = 0;
+  *bbbv = 0;
+  for(u32 idx = 0; idx < board->tiles_count; idx++)
+  {
+    if(board->neighbor_counts[idx] != 0 || BenchBit(board, board->mine_plane, idx) || BenchBit(board, covered, idx))
+      continue;
+    u32 size = bench_fill_legacy(board, idx, single, stack);
+    for(u64 w = 0; w < plane_size / sizeof(u64); w++)
+    {
+      covered[w] |= single[w];
+      single[w] = 0;
+    }
+    *opening_count += 1;
+    *largest = Max(*largest, size);
+  }
+  for(u32 idx = 0; idx < board->tiles_count; idx++)
+  {
+    if(!BenchBit(board, board->mine_plane, idx) && !BenchBit(board, covered, idx))
+      *bbbv += 1;
+  }
+  *bbbv += *opening_count;
+}
+
+internal void
+bench_openings_board(u32 columns, u32 rows, u32 mine_count, u32 game_count, b32 reference)
+{
+  Board *board = board_alloc();
+  Arena *big = arena_alloc_reserve(Gigabytes(4));
+  u32 safe_idx = (rows / 2) * columns + columns / 2;
+  u64 build_us = 0, legacy_us = 0, bulk_us = 0;
+  u64 opening_total = 0, bbbv_total = 0, revealed = 0;
+  u32 largest = 0;
+  for(u32 game = 0; game < game_count; game++)
+  {
+    //- nb: place the mines without sweeping anything
+    board_reset(board, columns, rows, mine_count, game);
+    board_toggle_flag(board, safe_idx);
+    board_sweep(board, safe_idx);
+    board_toggle_flag(board, safe_idx);
+    u64 t0 = os_now_microseconds();
+    board_build_openings(board);
+    build_us += os_now_microseconds() - t0;
+    opening_total += board->opening_count;
+    bbbv_total += board->bbbv;
+    largest = Max(largest, board->largest_opening);
+
+    Temp temp = temp_begin(big);
+    if(reference)
+    {
+      u32 ref_openings, ref_largest, ref_bbbv;
+      bench_openings_reference(board, big, &ref_openings, &ref_largest, &ref_bbbv);
+      b32 match = (ref_openings == board->opening_count && ref_largest == board->largest_opening && ref_bbbv == board->bbbv);
+      if(!match)
+        printf("  MISMATCH in game %u: openings %u/%u, largest %u/%u, 3bv %u/%u\n", game,
+               board->opening_count, ref_openings, board->largest_opening, ref_largest, board->bbbv, ref_bbbv);
+      Assert(match);
+    }
+
+    //- nb: click every opening once, bulk reveal against the legacy fill
+    u64 plane_size = sizeof(u64) * board->words_per_row * rows;
+    u64 *swept  = (u64*)arena_push(big, plane_size);
+    u32 *stack  = (u32*)arena_push(big, sizeof(u32) * board->tiles_count);
+    memset(swept, 0, plane_size);
+    u32 legacy_swept = 0;
+    for(u32 i = 0; i < board->opening_count; i++)
+    {
+      BoardRun *run = &board->opening_runs[board->opening_run_list[board->opening_first[i]]];
+      u32 idx = run->y * columns + run->x0;
+      u64 t1 = os_now_microseconds();
+      legacy_swept += bench_fill_legacy(board, idx, swept, stack);
+      u64 t2 = os_now_microseconds();
+      board_sweep(board, idx);
+      u64 t3 = os_now_microseconds();
+      legacy_us += t2 - t1;
+      bulk_us   += t3 - t2;
+    }
+    b32 same = memcmp(swept, board->swept_plane, plane_size) == 0 && legacy_swept == board->swept_count;
+    Assert(same && board->is_playable);
+    revealed += legacy_swept;
+    temp_end(temp);
+  }
+  printf("  %5ux%-5u %8u mines: %7.1f openings, 3bv %9.1f, largest %8u, build %8.2f ms; "
+         "%9llu tiles by clicking every opening, legacy %8.2f ms, bulk %8.2f ms\n",
+         columns, rows, mine_count, (f64)opening_total / game_count, (f64)bbbv_total / game_count, largest,
+         build_us / 1000.0 / game_count, (unsigned long long)revealed, legacy_us / 1000.0, bulk_us / 1000.0);
+  arena_release(big);
+  board_release(board);
+}
+
+internal void
+bench_openings(Arena *arena)
+{
+  bench_openings_board(30, 16, 99, 500, 1);
+  bench_openings_board(30, 16, 40, 500, 1);
+  bench_openings_board(256, 256, 10000, 20, 1);
+  bench_openings_board(1000, 1000, 150000, 4, 1);
+  bench_openings_board(4000, 4000, 300000, 1, 0);
+  bench_openings_board(10000, 10000, 20000000, 1, 0);
+}
+
+////////////////////////////////
+//~ nb: Time-sliced reveal
+//- nb: The same clicks and flags on two boards, one revealing everything at
+// once, one stepping within the budget with clicks landing while reveals
+// are still in flight. Both have to end up identical.
+// nb: a step may run past its budget by a run or a row and the clock reads
+#define BENCH_REVEAL_MARGIN_US 250
+
+internal void
+bench_reveal_board(u32 columns, u32 rows, u32 mine_count, u32 action_count, u32 budget_tiles, u32 budget_us)
+{
+  Board *reference = board_alloc();
+  Board *sliced = board_alloc();
+  board_reset(reference, columns, rows, mine_count, 42);
+  board_reset(sliced, columns, rows, mine_count, 42);
+  sliced->reveal_budget_tiles = budget_tiles;
+  sliced->reveal_budget_us    = budget_us;
+
+  u64 rng = 7;
+  u32 first_idx = (rows / 2) * columns + columns / 2;
+  u64 reference_us = 0, sliced_us = 0, worst_step_us = 0, worst_reference_us = 0, first_us = 0;
+  // nb: what the steps themselves ran, a step preempted halfway isn't over
+  // its budget
+  u64 worst_step_cpu_us = 0;
+  u32 step_count = 0;
+  for(u32 action = 0; action < action_count; action++)
+  {
+    u32 idx = action == 0 ? first_idx : bench_rand(&rng) % reference->tiles_count;
+    Tile tile = board_tile(reference, idx);
+    if(tile & TILE_BIT_SWEPT)
+      continue;
+    b32 flag = (action % 16 == 15);
+    if(!flag && (tile & (TILE_BIT_MINE | TILE_BIT_FLAG)))
+      continue;
+
+    u64 t0 = os_now_microseconds();
+    if(flag) board_toggle_flag(reference, idx);
+    else     board_sweep(reference, idx);
+    u64 t1 = os_now_microseconds();
+    u64 cpu_t1 = os_thread_cpu_microseconds();
+    if(flag) board_toggle_flag(sliced, idx);
+    else     board_sweep(sliced, idx);
+    u64 t2 = os_now_microseconds();
+    u64 cpu_t2 = os_thread_cpu_microseconds();
+    reference_us += t1 - t0;
+    worst_reference_us = Max(worst_reference_us, t1 - t0);
+    sliced_us += t2 - t1;
+    // nb: the first sweep places the mines, that is no step. Flags in
+    // flight wait for the reveal, so they count like any other click.
+    if(action > 0)
+    {
+      worst_step_us     = Max(worst_step_us, t2 - t1);
+      worst_step_cpu_us = Max(worst_step_cpu_us, cpu_t2 - cpu_t1);
+    }
+    if(action == 0)
+      first_us = t2 - t1;
+
+    //- nb: a few frames pass before the next click
+    u32 frames = bench_rand(&rng) % 4;
+    for(u32 frame = 0; frame < frames && board_reveal_pending(sliced); frame++)
+    {
+      u64 t3 = os_now_microseconds();
+      u64 cpu_t3 = os_thread_cpu_microseconds();
+      board_reveal_step(sliced);
+      u64 step_us = os_now_microseconds() - t3;
+      sliced_us += step_us;
+      worst_step_us     = Max(worst_step_us, step_us);
+      worst_step_cpu_us = Max(worst_step_cpu_us, os_thread_cpu_microseconds() - cpu_t3);
+      step_count += 1;
+    }
+  }
+  while(board_reveal_pending(sliced))
+  {
+    u64 t3 = os_now_microseconds();
+    u64 cpu_t3 = os_thread_cpu_microseconds();
+    board_reveal_step(sliced);
+    u64 step_us = os_now_microseconds() - t3;
+    sliced_us += step_us;
+    worst_step_us     = Max(worst_step_us, step_us);
+    worst_step_cpu_us = Max(worst_step_cpu_us, os_thread_cpu_microseconds() - cpu_t3);
+    step_count += 1;
+  }
+
+  u64 plane_size = sizeof(u64) * reference->words_per_row * rows;
+  b32 same = (memcmp(reference->swept_plane, sliced->swept_plane, plane_size) == 0 &&
+              memcmp(reference->flag_plane, sliced->flag_plane, plane_size) == 0 &&
+              reference->swept_count == sliced->swept_count &&
+              reference->is_playable == sliced->is_playable);
+  if(!same)
+    printf("  MISMATCH between the sliced and the one-shot reveal\n");
+  Assert(same);
+  printf("  %5ux%-5u %8u mines, budget %6u tiles %5u us: %9u tiles, one-shot %8.2f ms (worst click %7.2f ms), "
+         "sliced %8.2f ms over %5u extra steps (first sweep %7.2f ms, worst step after it %6.2f ms, %6.2f ms on the cpu)\n",
+         columns, rows, mine_count, budget_tiles, budget_us, reference->swept_count,
+         reference_us / 1000.0, worst_reference_us / 1000.0, sliced_us / 1000.0, step_count, first_us / 1000.0,
+         worst_step_us / 1000.0, worst_step_cpu_us / 1000.0);
+  if(budget_us && worst_step_cpu_us > budget_us + BENCH_REVEAL_MARGIN_US)
+    printf("  OVER BUDGET by %.2f ms\n", (worst_step_cpu_us - budget_us) / 1000.0);
+  Assert(!budget_us || worst_step_cpu_us <= budget_us + BENCH_REVEAL_MARGIN_US);
+  board_release(sliced);
+  board_release(reference);
+}
+
+internal void
+bench_reveal(Arena *arena)
+{
+  bench_reveal_board(1000, 1000, 80000, 2000, 4096, 0);
+  bench_reveal_board(4000, 4000, 300000, 200, 0, 2000);
+  bench_reveal_board(10000, 10000, 1000000, 100, 0, 2000);
+  bench_reveal_board(10000, 10000, 1000000, 100, 1 << 20, 0);
+}
+
+////////////////////////////////
+//~ nb: Chunked board
+//- nb: The first sweep on a chunked board against the same mines copied
+// into a fixed board around it. Only openings that stay clear of the
+// window's edge can be compared, returns 0 for the others.
+internal b32
+bench_chunks_compare(ChunkBoard *chunk_board, Board *board, s64 click_x, s64 click_y, u32 size)
+{
+  s64 origin_x = click_x - size / 2;
+  s64 origin_y = click_y - size / 2;
+  chunk_board_sweep(chunk_board, click_x, click_y);
+
+  board_reset(board, size, size, 0, 0);
+  for(u32 y = 0; y < size; y++)
+  {
+    for(u32 x = 0; x < size; x++)
+    {
+      if(chunk_board_is_mine(chunk_board, origin_x + x, origin_y + y))
+      {
+        BenchSetBit(board, board->mine_plane, y * size + x);
+        board->mine_count += 1;
+      }
+    }
+  }
+  board->mines_placed = 1;
+  board_compute_neighbor_counts(board);
+  board_sweep(board, (size / 2) * size + size / 2);
+
+  Tile *row = (Tile*)malloc(size);
+  b32 touches_edge = 0;
+  b32 match = 1;
+  for(u32 y = 0; y < size; y++)
+  {
+    chunk_board_tile_row(chunk_board, origin_y + y, origin_x, size, row);
+    for(u32 x = 0; x < size; x++)
+    {
+      Tile expected = board_tile(board, y * size + x);
+      if((expected & TILE_BIT_SWEPT) && (x == 0 || y == 0 || x == size - 1 || y == size - 1))
+        touches_edge = 1;
+      // nb: hidden tiles of chunks that don't exist read as all zero
+      if((expected & TILE_BIT_SWEPT) != (row[x] & TILE_BIT_SWEPT) ||
+         ((expected & TILE_BIT_SWEPT) && expected != row[x]))
+        match = 0;
+    }
+  }
+  free(row);
+  if(touches_edge)
+    return 0;
+  if(!match)
+    printf("  MISMATCH for the first sweep at %lld,%lld\n", (long long)click_x, (long long)click_y);
+  Assert(match);
+  return 1;
+}
+
+internal void
+bench_chunks(Arena *arena)
+{
+  ChunkBoard *chunk_board = chunk_board_alloc();
+  Board *board = board_alloc();
+
+  //- nb: flood fill across chunk borders, negative coordinates included
+  u64 rng = 99;
+  u32 compared = 0, skipped = 0;
+  for(u32 game = 0; game < 200; game++)
+  {
+    chunk_board_reset(chunk_board, game % 2 ? 0.15 : 0.2, game);
+    // nb: right next to a chunk corner, so the fill has to cross borders
+    s64 click_x = ((s64)(bench_rand(&rng) % 64) - 32) * CHUNK_SIZE - (game & 1);
+    s64 click_y = ((s64)(bench_rand(&rng) % 64) - 32) * CHUNK_SIZE - ((game >> 1) & 1);
+    if(bench_chunks_compare(chunk_board, board, click_x, click_y, 1024))
+      compared += 1;
+    else
+      skipped += 1;
+  }
+  printf("  first sweeps match the fixed board: %u compared, %u too large for the window\n", compared, skipped);
+
+  //- nb: memory follows the explored area, not the coordinates
+  f64 densities[] = {0.15, 0.2};
+  for(u32 d = 0; d < ArrayCount(densities); d++)
+  {
+    chunk_board_reset(chunk_board, densities[d], 7);
+    u32 click_count = 0;
+    u64 worst_us = 0;
+    u64 begin = os_now_microseconds();
+    while(click_count < 2000)
+    {
+      // nb: spread over +-2^40 tiles, mines are skipped so the game goes on
+      s64 x = ((s64)bench_rand(&rng) << 9) - ((s64)1 << 40);
+      s64 y = ((s64)bench_rand(&rng) << 9) - ((s64)1 << 40);
+      if(chunk_board->mines_placed && chunk_board_is_mine(chunk_board, x, y))
+        continue;
+      u64 t0 = os_now_microseconds();
+      chunk_board_sweep(chunk_board, x, y);
+      worst_us = Max(worst_us, os_now_microseconds() - t0);
+      click_count += 1;
+    }
+    u64 total_us = os_now_microseconds() - begin;
+    Assert(chunk_board->is_playable);
+    u64 used = chunk_board->arena->pos - chunk_board->arena_reset_pos;
+    printf("  density %.2f: %u sweeps in %8.2f ms (worst %6.2f ms), %9llu tiles swept, %6llu chunks, %7.2f MB\n",
+           densities[d], click_count, total_us / 1000.0, worst_us / 1000.0,
+           (unsigned long long)chunk_board->swept_count, (unsigned long long)chunk_board->chunk_count,
+           used / (1024.0 * 1024.0));
+  }
+
+  board_release(board);
+  chunk_board_release(chunk_board);
+}
+
+////////////////////////////////
+//~ nb: Change records
+//- nb: Replays the records of one call on top of `shadow`, which has to
+// hold the old state of every record.
+internal b32
+bench_changes_apply(BoardChangeList *list, u64 first, Tile *shadow)
+{
+  for(u64 i = first; i < list->count; i++)
+  {
+    BoardChange *change = &list->records[i];
+    for(u32 j = 0; j < change->run_length; j++)
+    {
+      Tile *state = &shadow[change->first_idx + j];
+      if(*state != change->old_state)
+        return 0;
+      *state = change->new_state;
+    }
+  }
+  return 1;
+}
+
+internal b32
+bench_changes_compare(Board *board, Tile *shadow, Tile *row_tiles)
+{
+  for(u32 y = 0; y < board->rows; y++)
+  {
+    board_tile_row(board, y, 0, board->columns, row_tiles);
+    for(u32 x = 0; x < board->columns; x++)
+    {
+      if((row_tiles[x] & TILE_STATE_MASK) != shadow[y * board->columns + x])
+        return 0;
+    }
+  }
+  return 1;
+}
+
+//- nb: Sweeps, chords and flags on a recording board and a plain one. The
+// records of every call have to turn the old states into exactly the new
+// ones, and recording shouldn't cost much next to the work itself.
+internal void
+bench_changes_board(u32 columns, u32 rows, u32 mine_count, u32 action_count, u32 budget_tiles, b32 check_every_call)
+{
+  Board *plain = board_alloc();
+  Board *recorded = board_alloc();
+  board_reset(plain, columns, rows, mine_count, 42);
+  board_reset(recorded, columns, rows, mine_count, 42);
+  plain->reveal_budget_tiles    = budget_tiles;
+  recorded->reveal_budget_tiles = budget_tiles;
+
+  Arena *big = arena_alloc_reserve(Gigabytes(4));
+  BoardChangeList changes;
+  board_changes_begin(recorded, &changes, big);
+
+  Tile *shadow = (Tile*)arena_push(big, recorded->tiles_count);
+  Tile *row_tiles = (Tile*)arena_push(big, columns);
+  memset(shadow, 0, recorded->tiles_count);
+
+  u64 rng = 11;
+  u32 first_idx = (rows / 2) * columns + columns / 2;
+  u64 plain_us = 0, recorded_us = 0, changed_tiles = 0;
+  u32 call_count = 0;
+  b32 same = 1;
+  for(u32 action = 0; action <= action_count && recorded->is_playable; action++)
+  {
+    u32 idx = action == 0 ? first_idx : bench_rand(&rng) % recorded->tiles_count;
+    Tile tile = board_tile(recorded, idx);
+    b32 flag = (action % 16 == 15);
+    // nb: swept numbers are chords, mines are left alone until the end
+    if(!flag && !(tile & TILE_BIT_SWEPT) && (tile & (TILE_BIT_MINE | TILE_BIT_FLAG)))
+      continue;
+    if(action == action_count)
+      flag = 0;
+
+    u64 first = changes.count;
+    u64 t0 = os_now_microseconds();
+    if(action == action_count)  board_gameover(plain);
+    else if(flag)               board_toggle_flag(plain, idx);
+    else                        board_sweep(plain, idx);
+    while(board_reveal_pending(plain))
+      board_reveal_step(plain);
+    u64 t1 = os_now_microseconds();
+    if(action == action_count)  board_gameover(recorded);
+    else if(flag)               board_toggle_flag(recorded, idx);
+    else                        board_sweep(recorded, idx);
+    while(board_reveal_pending(recorded))
+      board_reveal_step(recorded);
+    u64 t2 = os_now_microseconds();
+    plain_us    += t1 - t0;
+    recorded_us += t2 - t1;
+    call_count  += 1;
+
+    for(u64 i = first; i < changes.count; i++)
+      changed_tiles += changes.records[i].run_length;
+    same = same && bench_changes_apply(&changes, first, shadow);
+    if(check_every_call)
+      same = same && bench_changes_compare(recorded, shadow, row_tiles);
+  }
+  board_changes_end(recorded);
+  same = same && bench_changes_compare(recorded, shadow, row_tiles);
+  u64 plane_size = sizeof(u64) * plain->words_per_row * rows;
+  same = same && (memcmp(plain->swept_plane, recorded->swept_plane, plane_size) == 0 &&
+                  memcmp(plain->flag_plane, recorded->flag_plane, plane_size) == 0);
+  if(!same)
+    printf("  MISMATCH between the change records and the board\n");
+  Assert(same);
+  printf("  %5ux%-5u %8u mines, budget %7u tiles: %6u calls, %9llu records for %10llu changed tiles (%5.1f tiles/record), "
+         "plain %8.2f ms, recording %8.2f ms\n",
+         columns, rows, mine_count, budget_tiles, call_count, (unsigned long long)changes.count, (unsigned long long)changed_tiles,
+         changes.count ? (f64)changed_tiles / changes.count : 0.0, plain_us / 1000.0, recorded_us / 1000.0);
+  arena_release(big);
+  board_release(recorded);
+  board_release(plain);
+}
+
+internal void
+bench_changes(Arena *arena)
+{
+  bench_changes_board(30, 16, 99, 400, 0, 1);
+  bench_changes_board(1000, 1000, 150000, 2000, 4096, 1);
+  bench_changes_board(1000, 1000, 10000, 20, 0, 1);
+  bench_changes_board(10000, 10000, 1000000, 200, 1 << 20, 0);
+}
+
+////////////////////////////////
+//~ nb: Dirty tile uploads
+// Same flow as game_render_board, against the recording backend.
+internal void
+bench_upload_update(Board *board, Tile *tiles, u32 first, u32 count)
+{
+  u32 tile_y = first / board->columns;
+  u32 tile_x = first % board->columns;
+  tiles += first;
+  while(count > 0)
+  {
+    u32 row_count = Min(count, board->columns - tile_x);
+    board_tile_row(board, tile_y, tile_x, row_count, tiles);
+    tiles    += row_count;
+    count    -= row_count;
+    tile_x    = 0;
+    tile_y   += 1;
+  }
+}
+
+//- nb: one frame, returns the plan it uploaded
+internal R_UploadPlan
+bench_upload_frame(Board *board, BoardChangeList *changes, Arena *change_arena, R_DirtyCells *dirty,
+                   Tile *tiles, R_UploadRecorder *recorder, Arena *frame_arena)
+{
+  for(u64 i = 0; i < changes->count; i++)
+  {
+    r_dirty_mark(dirty, changes->records[i].first_idx, changes->records[i].run_length);
+  }
+  arena_clear(change_arena);
+  board_changes_begin(board, changes, change_arena);
+
+  r_upload_recorder_frame(recorder);
+  R_UploadPlan plan = r_dirty_plan(dirty, frame_arena);
+  for(u32 i = 0; i < plan.range_count; i++)
+  {
+    bench_upload_update(board, tiles, plan.ranges[i].first, plan.ranges[i].count);
+  }
+  r_upload_plan_execute(&recorder->backend, &plan, tiles, sizeof(Tile));
+  return plan;
+}
+
+//- nb: what the GPU holds has to draw like the board does now. Sprites
+// only, counts and mines of hidden tiles show up with placement without
+// changing what is drawn.
+internal b32
+bench_upload_compare(Board *board, R_UploadRecorder *recorder, Tile *row_tiles)
+{
+  Tile *gpu = (Tile*)recorder->buffer;
+  for(u32 y = 0; y < board->rows; y++)
+  {
+    board_tile_row(board, y, 0, board->columns, row_tiles);
+    for(u32 x = 0; x < board->columns; x++)
+    {
+      if(tile_kind(gpu[y * board->columns + x]) != tile_kind(row_tiles[x]))
+        return 0;
+    }
+  }
+  return 1;
+}
+
+internal void
+bench_upload_board(u32 columns, u32 rows, u32 mine_count, u32 frame_count, u32 budget_tiles, u32 check_every)
+{
+  Board *board = board_alloc();
+  board_reset(board, columns, rows, mine_count, 42);
+  board->reveal_budget_tiles = budget_tiles;
+
+  Arena *big = arena_alloc_reserve(Gigabytes(4));
+  Arena *change_arena = arena_alloc_reserve(Gigabytes(1));
+  Arena *frame_arena = arena_alloc();
+  BoardChangeList changes;
+  board_changes_begin(board, &changes, change_arena);
+  u64 buffer_size = sizeof(Tile) * board->tiles_count;
+  Tile *tiles = (Tile*)arena_push(big, buffer_size);
+  R_DirtyCells *dirty = r_dirty_alloc(big, board->tiles_count);
+  R_UploadRecorder *recorder = r_upload_recorder_alloc(big, buffer_size);
+  Tile *row_tiles = (Tile*)arena_push(big, columns);
+  memset(tiles, 0, buffer_size);
+
+  //- nb: the first frame uploads everything
+  bench_upload_frame(board, &changes, change_arena, dirty, tiles, recorder, frame_arena);
+  Assert(recorder->record_count == 1 && recorder->records[0].offset == 0 && recorder->records[0].size == buffer_size);
+  b32 same = bench_upload_compare(board, recorder, row_tiles);
+
+  u64 rng = 5;
+  u64 begin_bytes = recorder->total_bytes;
+  u64 range_count = 0, full_count = 0, plan_us = 0, idle_frames = 0;
+  u32 first_idx = (rows / 2) * columns + columns / 2;
+  u32 frame = 0;
+  for(; frame < frame_count && board->is_playable; frame++)
+  {
+    arena_clear(frame_arena);
+    //- nb: every other frame gets a click, reveals keep stepping in between
+    u32 idx = frame == 0 ? first_idx : bench_rand(&rng) % board->tiles_count;
+    Tile tile = board_tile(board, idx);
+    b32 flag = (frame % 8 == 3);
+    b32 sweep = !flag && (frame % 2 == 0) && !(tile & (TILE_BIT_MINE | TILE_BIT_FLAG));
+    if(flag && !(tile & TILE_BIT_SWEPT) && !board_reveal_pending(board))
+    {
+      //- nb: a lone flag is exactly one instance
+      board_toggle_flag(board, idx);
+      R_UploadPlan plan = bench_upload_frame(board, &changes, change_arena, dirty, tiles, recorder, frame_arena);
+      Assert(recorder->record_count == 1 && plan.range_count == 1 && !plan.full);
+      Assert(recorder->records[0].offset == idx);
+      Assert(recorder->records[0].size == 1);
+      range_count += 1;
+      continue;
+    }
+    if(sweep)
+      board_sweep(board, idx);
+    else if(board_reveal_pending(board))
+      board_reveal_step(board);
+
+    u64 t0 = os_now_microseconds();
+    R_UploadPlan plan = bench_upload_frame(board, &changes, change_arena, dirty, tiles, recorder, frame_arena);
+    plan_us += os_now_microseconds() - t0;
+    Assert(plan.range_count == recorder->record_count);
+    range_count += plan.range_count;
+    full_count  += plan.full;
+    idle_frames += plan.range_count == 0;
+    if(frame % check_every == 0)
+      same = same && bench_upload_compare(board, recorder, row_tiles);
+  }
+  board_gameover(board);
+  bench_upload_frame(board, &changes, change_arena, dirty, tiles, recorder, frame_arena);
+  same = same && bench_upload_compare(board, recorder, row_tiles);
+  if(!same)
+    printf("  MISMATCH between the uploaded instances and the board\n");
+  Assert(same);
+
+  u64 uploaded = recorder->total_bytes - begin_bytes;
+  printf("  %5ux%-5u %8u mines: %5u frames, %6llu ranges (%3llu full, %4llu idle frames), %10.2f KiB uploaded vs %10.2f KiB "
+         "re-uploading every frame (%5.2f%%), plan+update %6.2f ms\n",
+         columns, rows, mine_count, frame + 1, (unsigned long long)range_count, (unsigned long long)full_count,
+         (unsigned long long)idle_frames, uploaded / 1024.0, (f64)buffer_size * (frame + 1) / 1024.0,
+         100.0 * uploaded / ((f64)buffer_size * (frame + 1)), plan_us / 1000.0);
+  arena_release(frame_arena);
+  arena_release(change_arena);
+  arena_release(big);
+  board_release(board);
+}
+
+internal void
+bench_upload(Arena *arena)
+{
+  bench_upload_board(30, 16, 90, 400, 0, 1);
+  bench_upload_board(256, 256, 8000, 2000, 2048, 1);
+  bench_upload_board(1000, 1000, 150000, 2000, 4096, 100);
+}
+
+////////////////////////////////
+//~ nb: Tile grid
+// The tile grid vertex math against the instanced sprite path it replaces,
+// on a board in mid play, plus what each path has to build per frame.
+typedef struct BenchInstance BenchInstance;
+struct BenchInstance
+{
+  f32 ipos[2];
+  f32 isize[2];
+  f32 iuv_rect[4];
+};
+
+internal void
+bench_tilegrid_board(u32 columns, u32 rows, u32 mine_count, u32 frame_count)
+{
+  Board *board = board_alloc();
+  board_reset(board, columns, rows, mine_count, 3);
+  u64 rng = 17;
+  for(u32 i = 0; i < 64 && board->is_playable; i++)
+  {
+    u32 idx = bench_rand(&rng) % board->tiles_count;
+    if(i % 4 == 3) board_toggle_flag(board, idx);
+    else if(!(board_tile(board, idx) & TILE_BIT_MINE) || i == 0) board_sweep(board, idx);
+  }
+  board_reveal_finish(board);
+
+  Arena *big = arena_alloc_reserve(Gigabytes(4));
+  R_TileGridConstants *grid = (R_TileGridConstants*)arena_push(big, sizeof(R_TileGridConstants));
+  grid->origin[0]    = 0;
+  grid->origin[1]    = 0;
+  grid->tile_size[0] = 32;
+  grid->tile_size[1] = 32;
+  grid->columns         = columns;
+  grid->visible_columns = columns;
+  grid->first_x         = 0;
+  grid->first_y         = 0;
+  for(u32 tile = 0; tile < 256; tile++)
+  {
+    u32 kind = tile_kind((Tile)tile);
+    grid->uv_rect_from_tile[tile][0] = (kind % 4) * 0.25f;
+    grid->uv_rect_from_tile[tile][1] = (kind / 4) * 0.25f;
+    grid->uv_rect_from_tile[tile][2] = 0.25f;
+    grid->uv_rect_from_tile[tile][3] = 0.25f;
+  }
+  Tile *tiles = (Tile*)arena_push(big, board->tiles_count);
+  BenchInstance *instances = (BenchInstance*)arena_push(big, sizeof(BenchInstance) * board->tiles_count);
+
+  //- nb: what a frame builds, all sprite instances or all tile bytes
+  u64 instance_us = 0, tile_us = 0;
+  for(u32 frame = 0; frame < frame_count; frame++)
+  {
+    u64 t0 = os_now_microseconds();
+    BenchInstance *instance = instances;
+    Tile *row_tiles = tiles;
+    for(u32 y = 0; y < rows; y++)
+    {
+      board_tile_row(board, y, 0, columns, row_tiles);
+      for(u32 x = 0; x < columns; x++)
+      {
+        f32 *uv_rect = grid->uv_rect_from_tile[row_tiles[x]];
+        *instance++ = {{(f32)x * 32, (f32)y * 32}, {32, 32}, {uv_rect[0], uv_rect[1], uv_rect[2], uv_rect[3]}};
+      }
+    }
+    u64 t1 = os_now_microseconds();
+    for(u32 y = 0; y < rows; y++)
+    {
+      board_tile_row(board, y, 0, columns, tiles + (u64)y * columns);
+    }
+    u64 t2 = os_now_microseconds();
+    instance_us += t1 - t0;
+    tile_us     += t2 - t1;
+  }
+
+  //- nb: every corner of every tile has to land where the sprite did
+  static const f32 corners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+  b32 same = 1;
+  for(u32 i = 0; i < board->tiles_count && same; i++)
+  {
+    BenchInstance *instance = &instances[i];
+    for(u32 c = 0; c < 4; c++)
+    {
+      f32 cx = corners[c][0], cy = corners[c][1];
+      R_TileGridVertex vertex = r_tile_grid_vertex(grid, tiles, i, cx, cy);
+      f32 pos_x = cx * instance->isize[0] + instance->ipos[0];
+      f32 pos_y = cy * instance->isize[1] + instance->ipos[1];
+      f32 uv_x  = cx * instance->iuv_rect[2] + instance->iuv_rect[0];
+      f32 uv_y  = cy * instance->iuv_rect[3] + instance->iuv_rect[1];
+      same = same && vertex.pos[0] == pos_x && vertex.pos[1] == pos_y && vertex.uv[0] == uv_x && vertex.uv[1] == uv_y;
+    }
+  }
+  if(!same)
+    printf("  MISMATCH between the tile grid and the sprite instances\n");
+  Assert(same);
+  printf("  %5ux%-5u: %10.2f KiB of sprite instances vs %9.2f KiB of tile bytes per frame (%ux), "
+         "build %7.2f ms vs %7.2f ms per frame\n",
+         columns, rows, sizeof(BenchInstance) * (f64)board->tiles_count / 1024, (f64)board->tiles_count / 1024,
+         (u32)sizeof(BenchInstance), instance_us / 1000.0 / frame_count, tile_us / 1000.0 / frame_count);
+  arena_release(big);
+  board_release(board);
+}
+
+internal void
+bench_tilegrid(Arena *arena)
+{
+  bench_tilegrid_board(30, 16, 99, 1000);
+  bench_tilegrid_board(1000, 1000, 150000, 20);
+  bench_tilegrid_board(4000, 4000, 2000000, 4);
+}
+
+////////////////////////////////
+//~ nb: Culling
+// Random cameras over a board. The culled rectangle has to hold exactly the
+// tiles that cover a pixel of the window, every pick has to land on a
+// tile that covers the picked pixel, and the culled tile grid has to put
+// every visible tile where the full grid does.
+internal b32
+bench_cull_covers(R_TileView *view, s64 tile_x, s64 tile_y)
+{
+  f64 x0, y0, x1, y1;
+  r_screen_from_tile(view, tile_x, tile_y, &x0, &y0);
+  r_screen_from_tile(view, tile_x + 1, tile_y + 1, &x1, &y1);
+  return x0 < view->width && x1 > 0 && y0 < view->height && y1 > 0;
+}
+
+internal void
+bench_cull_board(u32 columns, u32 rows, u32 width, u32 height, u32 view_count)
+{
+  Arena *big = arena_alloc_reserve(Gigabytes(4));
+  u64 tiles_count = (u64)columns * rows;
+  Tile *tiles = (Tile*)arena_push(big, tiles_count);
+  u64 rng = 41;
+  for(u64 i = 0; i < tiles_count; i++)
+    tiles[i] = (Tile)bench_rand(&rng);
+  R_TileGridConstants *full = (R_TileGridConstants*)arena_push(big, sizeof(R_TileGridConstants));
+  R_TileGridConstants *grid = (R_TileGridConstants*)arena_push(big, sizeof(R_TileGridConstants));
+  for(u32 tile = 0; tile < 256; tile++)
+  {
+    full->uv_rect_from_tile[tile][0] = (tile % 16) / 16.0f;
+    full->uv_rect_from_tile[tile][1] = (tile / 16) / 16.0f;
+    full->uv_rect_from_tile[tile][2] = 1 / 16.0f;
+    full->uv_rect_from_tile[tile][3] = 1 / 16.0f;
+  }
+  full->columns         = columns;
+  full->visible_columns = columns;
+  full->first_x         = 0;
+  full->first_y         = 0;
+
+  static const f32 corners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+  R_TileRect board_rect = {0, 0, columns, rows};
+  b32 valid = 1;
+  u64 visible_total = 0, vertex_us = 0;
+  for(u32 v = 0; v < view_count; v++)
+  {
+    //- nb: camera anywhere over the board and a bit past it
+    R_TileView view;
+    view.zoom      = 0.0625 * (1 << (bench_rand(&rng) % 7)) * (1 + (bench_rand(&rng) % 1000) / 1000.0);
+    view.tile_size = 32;
+    view.width     = width;
+    view.height    = height;
+    view.x = (f32)((s64)(bench_rand(&rng) % ((u64)columns * 32 + 2000)) - 1000) + (bench_rand(&rng) % 1000) / 1000.0f;
+    view.y = (f32)((s64)(bench_rand(&rng) % ((u64)rows * 32 + 2000)) - 1000) + (bench_rand(&rng) % 1000) / 1000.0f;
+
+    R_TileRect view_rect = r_tile_view_rect(&view);
+    valid = valid && bench_cull_covers(&view, view_rect.x0, view_rect.y0) &&
+            bench_cull_covers(&view, view_rect.x1 - 1, view_rect.y1 - 1) &&
+            !bench_cull_covers(&view, view_rect.x0 - 1, view_rect.y0) &&
+            !bench_cull_covers(&view, view_rect.x0, view_rect.y0 - 1) &&
+            !bench_cull_covers(&view, view_rect.x1, view_rect.y1 - 1) &&
+            !bench_cull_covers(&view, view_rect.x1 - 1, view_rect.y1);
+
+    //- nb: picks
+    for(u32 p = 0; p < 64; p++)
+    {
+      f64 screen_x = bench_rand(&rng) % width  + (bench_rand(&rng) % 256) / 256.0;
+      f64 screen_y = bench_rand(&rng) % height + (bench_rand(&rng) % 256) / 256.0;
+      s64 tile_x, tile_y;
+      r_tile_from_screen(&view, screen_x, screen_y, &tile_x, &tile_y);
+      f64 x0, y0, x1, y1;
+      r_screen_from_tile(&view, tile_x, tile_y, &x0, &y0);
+      r_screen_from_tile(&view, tile_x + 1, tile_y + 1, &x1, &y1);
+      valid = valid && tile_x >= view_rect.x0 && tile_x < view_rect.x1 && tile_y >= view_rect.y0 && tile_y < view_rect.y1;
+      valid = valid && x0 <= screen_x && screen_x < x1 && y0 <= screen_y && screen_y < y1;
+    }
+
+    //- nb: the culled grid, set up the way game_render_board does
+    R_TileRect rect = r_tile_rect_intersect(view_rect, board_rect);
+    u32 visible_columns = (u32)(rect.x1 - rect.x0);
+    u32 visible_count   = visible_columns * (u32)(rect.y1 - rect.y0);
+    f64 origin_x, origin_y;
+    r_screen_from_tile(&view, 0, 0, &origin_x, &origin_y);
+    full->origin[0]    = (f32)origin_x;
+    full->origin[1]    = (f32)origin_y;
+    full->tile_size[0] = (f32)(32 * view.zoom);
+    full->tile_size[1] = (f32)(32 * view.zoom);
+    memcpy(grid, full, sizeof(R_TileGridConstants));
+    grid->visible_columns = visible_columns;
+    grid->first_x         = (u32)rect.x0;
+    grid->first_y         = (u32)rect.y0;
+    u64 t0 = os_now_microseconds();
+    f32 sum = 0;
+    for(u32 i = 0; i < visible_count; i++)
+    {
+      for(u32 c = 0; c < 4; c++)
+      {
+        R_TileGridVertex vertex = r_tile_grid_vertex(grid, tiles, i, corners[c][0], corners[c][1]);
+        sum += vertex.pos[0] + vertex.uv[1];
+      }
+    }
+    vertex_us += os_now_microseconds() - t0;
+    valid = valid && sum == sum;
+    for(u32 i = 0; i < visible_count && valid; i += 1 + visible_count / 256)
+    {
+      u32 idx = (grid->first_y + i / visible_columns) * columns + grid->first_x + i % visible_columns;
+      for(u32 c = 0; c < 4; c++)
+      {
+        R_TileGridVertex culled = r_tile_grid_vertex(grid, tiles, i, corners[c][0], corners[c][1]);
+        R_TileGridVertex whole  = r_tile_grid_vertex(full, tiles, idx, corners[c][0], corners[c][1]);
+        valid = valid && memcmp(&culled, &whole, sizeof(R_TileGridVertex)) == 0;
+      }
+    }
+    visible_total += visible_count;
+  }
+
+  //- nb: what drawing every tile would cost
+  u64 t0 = os_now_microseconds();
+  f32 sum = 0;
+  for(u64 i = 0; i < tiles_count; i++)
+  {
+    for(u32 c = 0; c < 4; c++)
+    {
+      R_TileGridVertex vertex = r_tile_grid_vertex(full, tiles, (u32)i, corners[c][0], corners[c][1]);
+      sum += vertex.pos[0] + vertex.uv[1];
+    }
+  }
+  u64 full_us = os_now_microseconds() - t0;
+  valid = valid && sum == sum;
+  if(!valid)
+    printf("  MISMATCH between culling, picking and the tile grid\n");
+  Assert(valid);
+  printf("  %5ux%-5u in %4ux%-4u: %9.1f instances per view vs %9llu, vertex work %8.3f ms vs %8.3f ms\n",
+         columns, rows, width, height, (f64)visible_total / view_count, (unsigned long long)tiles_count,
+         vertex_us / 1000.0 / view_count, full_us / 1000.0);
+  arena_release(big);
+}
+
+internal void
+bench_cull(Arena *arena)
+{
+  bench_cull_board(30, 16, 960, 640, 10000);
+  bench_cull_board(1000, 1000, 1920, 1080, 2000);
+  bench_cull_board(4000, 4000, 1920, 1080, 500);
+  bench_cull_board(4000, 4000, 1023, 767, 500);
+}
+
+////////////////////////////////
+//~ nb: Frame command list
+// Frames shaped like the game's: board quads, strings of text pushed one by
+// one, mixed layers. The recorder has to see one map per frame, one draw
+// per texture run, and every quad where the layer/texture/submission order
+// puts it.
+typedef struct BenchPush BenchPush;
+struct BenchPush
+{
+  u32 layer;
+  u32 texture;
+  u32 first;                      // into the frame's reference quads
+  u32 count;
+};
+
+internal void
+bench_cmdlist_frames(u32 frame_count, u32 push_count, u32 texture_count, u32 max_quads)
+{
+  R_CmdList *list = r_cmd_list_alloc();
+  R_DrawRecorder *recorder = r_draw_recorder_alloc();
+  Arena *big = arena_alloc_reserve(Gigabytes(4));
+  BenchPush *pushes = (BenchPush*)arena_push(big, sizeof(BenchPush) * push_count);
+  R_Quad *pushed = (R_Quad*)arena_push(big, sizeof(R_Quad) * push_count * (u64)max_quads);
+  u32 *first_use = (u32*)arena_push(big, sizeof(u32) * texture_count);
+
+  u64 rng = 21;
+  u64 push_us = 0, flush_us = 0, quad_total = 0, draw_total = 0;
+  b32 same = 1;
+  for(u32 frame = 0; frame < frame_count; frame++)
+  {
+    r_draw_recorder_frame(recorder);
+    memset(first_use, 0xff, sizeof(u32) * texture_count);
+    u32 quad_count = 0, used_textures = 0;
+    u64 t0 = os_now_microseconds();
+    for(u32 i = 0; i < push_count; i++)
+    {
+      BenchPush *push = &pushes[i];
+      push->layer   = bench_rand(&rng) % R_LAYER_COUNT;
+      push->texture = bench_rand(&rng) % texture_count;
+      push->count   = 1 + bench_rand(&rng) % max_quads;
+      push->first   = quad_count;
+      if(first_use[push->texture] == 0xffffffff)
+        first_use[push->texture] = used_textures++;
+      R_Handle texture = {{push->texture + 1ull}};
+      R_Quad *quads = r_cmd_push_quads(list, texture, push->layer, push->count);
+      for(u32 q = 0; q < push->count; q++)
+      {
+        R_Quad quad = {{(f32)i, (f32)q}, {1, 1}, {(f32)push->texture, (f32)push->layer, 0, 0}};
+        quads[q] = quad;
+        pushed[quad_count + q] = quad;
+      }
+      quad_count += push->count;
+    }
+    u64 t1 = os_now_microseconds();
+    r_cmd_list_flush(list, &recorder->backend);
+    u64 t2 = os_now_microseconds();
+    push_us  += t1 - t0;
+    flush_us += t2 - t1;
+
+    //- nb: reference order, by layer, then texture in order of first use,
+    // then submission
+    R_FrameCounters *counters = &recorder->backend.counters;
+    same = same && counters->maps == 1 && counters->quads == quad_count && recorder->quad_count == quad_count;
+    same = same && counters->bytes_uploaded == sizeof(R_Quad) * (u64)quad_count;
+    u32 cursor = 0, draw_idx = 0, last_texture = 0xffffffff;
+    for(u32 layer = 0; layer < R_LAYER_COUNT; layer++)
+    {
+      for(u32 slot = 0; slot < used_textures; slot++)
+      {
+        for(u32 i = 0; i < push_count && same; i++)
+        {
+          BenchPush *push = &pushes[i];
+          if(push->layer != layer || first_use[push->texture] != slot)
+            continue;
+          same = same && memcmp(&recorder->quads[cursor], &pushed[push->first], sizeof(R_Quad) * push->count) == 0;
+          //- nb: a new texture has to start a new draw, the same one must not
+          if(push->texture != last_texture)
+          {
+            same = same && draw_idx < recorder->draw_count && recorder->draws[draw_idx].first_quad == cursor &&
+                   recorder->draws[draw_idx].texture.U64[0] == push->texture + 1ull;
+            draw_idx += 1;
+            last_texture = push->texture;
+          }
+          cursor += push->count;
+        }
+      }
+    }
+    same = same && cursor == quad_count && draw_idx == recorder->draw_count && counters->draws == draw_idx;
+    quad_total += quad_count;
+    draw_total += recorder->draw_count;
+  }
+  if(!same)
+    printf("  MISMATCH between the command list and the reference order\n");
+  Assert(same);
+  printf("  %6u pushes, %4u textures, <=%4u quads: %8.1f quads, %6.1f draws and 1 map per frame "
+         "(vs %6u of each unbatched), push %7.3f ms, flush %7.3f ms per frame\n",
+         push_count, texture_count, max_quads, (f64)quad_total / frame_count, (f64)draw_total / frame_count,
+         push_count, push_us / 1000.0 / frame_count, flush_us / 1000.0 / frame_count);
+  arena_release(big);
+  r_draw_recorder_release(recorder);
+  r_cmd_list_release(list);
+}
+
+internal void
+bench_cmdlist(Arena *arena)
+{
+  //- nb: the game: a board, a few strings and the atlas preview
+  bench_cmdlist_frames(200, 4, 3, 30);
+  bench_cmdlist_frames(100, 1000, 4, 32);
+  bench_cmdlist_frames(20, 100000, 16, 16);
+  bench_cmdlist_frames(20, 100000, 1000, 4);
+}
+
+////////////////////////////////
+//~ nb: Ring allocator
+// A simulated GPU that finishes frames `latency` frames after they were
+// submitted. Every allocation is checked against the ranges of the frames
+// still in flight in the same buffer.
+typedef struct BenchFence BenchFence;
+struct BenchFence
+{
+  R_Fence fence;
+  u64     submitted;
+  u64     completed;
+};
+
+internal u64
+bench_fence_completed(R_Fence *fence)
+{
+  return ((BenchFence*)fence)->completed;
+}
+
+internal void
+bench_fence_wait(R_Fence *fence, u64 value)
+{
+  BenchFence *bench_fence = (BenchFence*)fence;
+  Assert(value <= bench_fence->submitted);
+  bench_fence->completed = Max(bench_fence->completed, value);
+}
+
+typedef struct BenchRingRange BenchRingRange;
+struct BenchRingRange
+{
+  u64 generation;
+  u64 fence;
+  u64 offset;
+  u64 size;
+};
+
+internal void
+bench_ring_frames(u32 frame_count, u32 latency, u32 max_batches, u32 max_quads, u32 spike_every, u32 spike_quads)
+{
+  Arena *big = arena_alloc_reserve(Gigabytes(4));
+  // nb: live ranges, oldest first
+  u64 range_capacity = (u64)(latency + 2) * max_batches + 1;
+  BenchRingRange *ranges = (BenchRingRange*)arena_push(big, sizeof(BenchRingRange) * range_capacity);
+  u64 range_first = 0, range_count = 0;
+
+  //- nb: pass 0 checks every allocation, pass 1 replays the same frames for time
+  BenchFence fence;
+  R_Ring ring;
+  u64 alloc_count = 0, discard_count = 0, bytes = 0, alloc_us = 0;
+  b32 valid = 1;
+  for(u32 pass = 0; pass < 2; pass++)
+  {
+    fence.fence.completed = bench_fence_completed;
+    fence.fence.wait      = bench_fence_wait;
+    fence.submitted       = 0;
+    fence.completed       = 0;
+    r_ring_init(&ring, sizeof(R_Quad) * 30*16 * 100);
+    u64 rng = 33;
+    u64 t0 = os_now_microseconds();
+    for(u32 frame = 0; frame < frame_count; frame++)
+    {
+      u32 batch_count = 1 + bench_rand(&rng) % max_batches;
+      for(u32 batch = 0; batch < batch_count; batch++)
+      {
+        u32 quad_count = 1 + bench_rand(&rng) % max_quads;
+        if(spike_every && frame % spike_every == spike_every - 1 && batch == 0)
+          quad_count = spike_quads;
+        u64 size = (u64)quad_count * sizeof(R_Quad);
+        R_RingAlloc alloc = r_ring_alloc(&ring, size, sizeof(R_Quad), &fence.fence);
+        if(pass == 1)
+          continue;
+
+        //- nb: drop what the GPU is done with, or what lives in an older buffer
+        while(range_count > 0 && (ranges[range_first].fence <= fence.completed ||
+                                  ranges[range_first].generation != ring.grow_count))
+        {
+          range_first = (range_first + 1) % range_capacity;
+          range_count -= 1;
+        }
+        valid = valid && alloc.offset % sizeof(R_Quad) == 0 && alloc.offset + size <= ring.capacity;
+        for(u64 i = 0; i < range_count; i++)
+        {
+          BenchRingRange *range = &ranges[(range_first + i) % range_capacity];
+          valid = valid && (alloc.offset + size <= range->offset || range->offset + range->size <= alloc.offset);
+        }
+        Assert(range_count < range_capacity);
+        BenchRingRange range = {ring.grow_count, fence.submitted + 1, alloc.offset, size};
+        ranges[(range_first + range_count) % range_capacity] = range;
+        range_count   += 1;
+        alloc_count   += 1;
+        discard_count += alloc.discard;
+        bytes         += size;
+      }
+
+      //- nb: submit, the GPU catches up to `latency` frames behind
+      r_ring_end_frame(&ring, fence.submitted + 1, &fence.fence);
+      fence.submitted += 1;
+      if(fence.submitted > latency)
+        fence.completed = Max(fence.completed, fence.submitted - latency);
+    }
+    if(pass == 1)
+      alloc_us = os_now_microseconds() - t0;
+  }
+  if(!valid)
+    printf("  OVERLAP with a range still in flight\n");
+  Assert(valid);
+  printf("  latency %u, <=%2u batches of <=%5u quads, spike %6u: %7llu allocs, %3llu discards, %3llu grows, "
+         "%5llu waits, %6.2f MB ring, %5.2f MB/frame, %5.1f ns per alloc\n",
+         latency, max_batches, max_quads, spike_every ? spike_quads : 0, (unsigned long long)alloc_count,
+         (unsigned long long)discard_count, (unsigned long long)ring.grow_count, (unsigned long long)ring.wait_count, ring.capacity / (1024.0 * 1024.0), bytes / (1024.0 * 1024.0) / frame_count,
+         alloc_us * 1000.0 / alloc_count);
+  arena_release(big);
+}
+
+internal void
+bench_ring(Arena *arena)
+{
+  //- nb: the game, one flush per frame
+  bench_ring_frames(10000, 2, 1, 600, 0, 0);
+  bench_ring_frames(10000, 3, 16, 2000, 0, 0);
+  //- nb: a frame now and then needs more than the whole ring
+  bench_ring_frames(10000, 3, 4, 2000, 500, 200000);
+  //- nb: deep queue, the ring has to wait for the GPU
+  bench_ring_frames(10000, 7, 8, 6000, 0, 0);
+}
+
+////////////////////////////////
+//~ nb: Summary pyramid
+// Random edits with change recording. The pyramid kept up to date from the
+// records has to match one rebuilt from the board, level 0 has to match
+// the tiles counted one by one, and every block that changed since the
+// last check has to lie in its level's dirty rect.
+internal b32
+bench_pyramid_compare(BoardPyramid *kept, BoardPyramid *built, BoardPyramid *snapshot)
+{
+  b32 same = kept->level_count == built->level_count;
+  for(u32 l = 0; l < kept->level_count && same; l++)
+  {
+    BoardPyramidLevel *level = &kept->levels[l];
+    u64 block_count = (u64)level->columns * level->rows;
+    same = same && memcmp(level->blocks, built->levels[l].blocks, sizeof(BoardBlock) * block_count) == 0;
+    for(u64 i = 0; i < block_count && same; i++)
+    {
+      if(memcmp(&level->blocks[i], &snapshot->levels[l].blocks[i], sizeof(BoardBlock)) == 0)
+        continue;
+      u32 x = (u32)(i % level->columns), y = (u32)(i / level->columns);
+      same = x >= level->dirty_x0 && x < level->dirty_x1 && y >= level->dirty_y0 && y < level->dirty_y1;
+    }
+    level->dirty_x0 = level->dirty_x1 = 0;
+    memcpy(snapshot->levels[l].blocks, level->blocks, sizeof(BoardBlock) * block_count);
+  }
+  return same;
+}
+
+internal b32
+bench_pyramid_count_tiles(Board *board, BoardPyramid *pyramid)
+{
+  BoardPyramidLevel *level = &pyramid->levels[0];
+  b32 same = 1;
+  for(u32 by = 0; by < level->rows && same; by++)
+  {
+    for(u32 bx = 0; bx < level->columns && same; bx++)
+    {
+      BoardBlock block = {0};
+      for(u32 y = by * 8; y < Min(board->rows, by * 8 + 8); y++)
+      {
+        for(u32 x = bx * 8; x < Min(board->columns, bx * 8 + 8); x++)
+        {
+          Tile tile = board_tile(board, board_idx_from_xy(board, x, y));
+          if(tile & TILE_BIT_SWEPT)      block.swept += 1;
+          else if(tile & TILE_BIT_FLAG)  block.flagged += 1;
+          else                           block.hidden += 1;
+        }
+      }
+      same = memcmp(&block, &level->blocks[(u64)by * level->columns + bx], sizeof(BoardBlock)) == 0;
+    }
+  }
+  return same;
+}
+
+internal void
+bench_pyramid_board(u32 columns, u32 rows, u32 mine_count, u32 action_count, u32 check_every)
+{
+  Board *board = board_alloc();
+  board_reset(board, columns, rows, mine_count, 5);
+  board->reveal_budget_tiles = 1 << 16;
+  Arena *big = arena_alloc_reserve(Gigabytes(4));
+  BoardPyramid kept, snapshot;
+  board_pyramid_build(&kept, board, big);
+  board_pyramid_build(&snapshot, board, big);
+  u64 check_pos = big->pos;
+  BoardChangeList changes;
+  Arena *change_arena = arena_alloc_reserve(Gigabytes(4));
+  board_changes_begin(board, &changes, change_arena);
+
+  u64 rng = 9;
+  u64 apply_us = 0, build_us = 0, changed_tiles = 0;
+  u32 check_count = 0, step_count = 0;
+  b32 same = 1;
+  for(u32 action = 0; action <= action_count && board->is_playable; action++)
+  {
+    //- nb: sweeps and flags, the last action ends the game
+    u32 idx = action == 0 ? (rows / 2) * columns + columns / 2 : bench_rand(&rng) % board->tiles_count;
+    Tile tile = board_tile(board, idx);
+    if(action == action_count)
+      board_gameover(board);
+    else if(action % 8 == 7 && !(tile & TILE_BIT_SWEPT))
+      board_toggle_flag(board, idx);
+    else if(!(tile & (TILE_BIT_MINE | TILE_BIT_FLAG)) || action == 0)
+      board_sweep(board, idx);
+
+    //- nb: a frame's worth of reveal at a time, applied like the game does
+    do
+    {
+      u64 t0 = os_now_microseconds();
+      board_pyramid_apply(&kept, changes.records, changes.count);
+      apply_us += os_now_microseconds() - t0;
+      for(u64 i = 0; i < changes.count; i++)
+        changed_tiles += changes.records[i].run_length;
+      step_count += 1;
+      arena_clear(change_arena);
+      board_changes_begin(board, &changes, change_arena);
+    } while(board_reveal_step(board) || changes.count > 0);
+
+    if(action % check_every == 0 || action == action_count || !board->is_playable)
+    {
+      BoardPyramid built;
+      u64 t0 = os_now_microseconds();
+      board_pyramid_build(&built, board, big);
+      build_us += os_now_microseconds() - t0;
+      same = same && bench_pyramid_compare(&kept, &built, &snapshot);
+      if((u64)columns * rows <= 1000 * 1000)
+        same = same && bench_pyramid_count_tiles(board, &kept);
+      arena_pop_to(big, check_pos);
+      check_count += 1;
+    }
+  }
+  board_changes_end(board);
+  if(!same)
+    printf("  MISMATCH between the kept pyramid and the board\n");
+  Assert(same);
+  printf("  %5ux%-5u %8u mines: %2u levels, %6u steps changing %10llu tiles, applied in %8.3f ms total, "
+         "%4u rebuilds at %8.3f ms each\n",
+         columns, rows, mine_count, kept.level_count, step_count, (unsigned long long)changed_tiles, apply_us / 1000.0,
+         check_count, build_us / 1000.0 / check_count);
+  arena_release(change_arena);
+  arena_release(big);
+  board_release(board);
+}
+
+internal void
+bench_pyramid(Arena *arena)
+{
+  bench_pyramid_board(30, 16, 99, 200, 1);
+  bench_pyramid_board(123, 77, 1500, 2000, 1);
+  bench_pyramid_board(1000, 1000, 150000, 5000, 50);
+  bench_pyramid_board(4000, 4000, 2000000, 5000, 500);
+}
+
+////////////////////////////////
+//~ nb: Software renderer
+// A random scene (tile grid, quads on two layers, several textures with
+// every kind of alpha, wrapping uvs, fractional and offscreen edges) drawn
+// by the software renderer with one and with several threads, against a
+// per-pixel reference: cover by pixel center, point sample with wrap,
+// blend like main_blend_state. Then frame times of game-like frames.
+internal void
+bench_soft_dump(R_SoftState *soft, const char *name)
+{
+  const char *dir = getenv("BENCH_DUMP_DIR");
+  if(!dir)
+    return;
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/%s.ppm", dir, name);
+  if(r_soft_write_ppm(soft, path))
+    printf("  wrote %s\n", path);
+}
+
+typedef struct BenchTexture BenchTexture;
+struct BenchTexture
+{
+  u32 *texels;
+  u32 width;
+  u32 height;
+};
+
+internal u32
+bench_soft_sample(BenchTexture *texture, f32 u, f32 v)
+{
+  if(!texture)
+    return 0;
+  s64 x = (s64)floorf(u * texture->width) % (s64)texture->width;
+  s64 y = (s64)floorf(v * texture->height) % (s64)texture->height;
+  x += x < 0 ? texture->width : 0;
+  y += y < 0 ? texture->height : 0;
+  return texture->texels[(u64)y * texture->width + x];
+}
+
+internal void
+bench_soft_reference_quad(u32 *pixels, u32 width, u32 height, R_Quad *quad, BenchTexture *texture)
+{
+  f32 x0 = quad->pos[0], x1 = quad->pos[0] + quad->size[0];
+  f32 y0 = quad->pos[1], y1 = quad->pos[1] + quad->size[1];
+  f32 du = quad->uv_rect[2] / quad->size[0];
+  f32 dv = quad->uv_rect[3] / quad->size[1];
+  for(u32 y = 0; y < height; y++)
+  {
+    f32 center_y = (f32)y + 0.5f;
+    if(!(y0 <= center_y && center_y < y1))
+      continue;
+    for(u32 x = 0; x < width; x++)
+    {
+      f32 center_x = (f32)x + 0.5f;
+      if(!(x0 <= center_x && center_x < x1))
+        continue;
+      u32 src = bench_soft_sample(texture, quad->uv_rect[0] + (center_x - x0) * du, quad->uv_rect[1] + (center_y - y0) * dv);
+      u32 dst = pixels[(u64)y * width + x];
+      u32 a = src >> 24, out = src & 0xff000000;
+      for(u32 shift = 0; shift < 24; shift += 8)
+      {
+        f32 blended = (((src >> shift) & 0xff) * a + ((dst >> shift) & 0xff) * (255 - a)) / 255.0f;
+        out |= (u32)(blended + 0.5f) << shift;
+      }
+      pixels[(u64)y * width + x] = out;
+    }
+  }
+}
+
+internal void
+bench_soft_random_quad(R_Quad *quad, u64 *rng, u32 width, u32 height)
+{
+  quad->pos[0]     = (f32)((s32)(bench_rand(rng) % (width + 200)) - 100) + (bench_rand(rng) % 64) / 64.0f;
+  quad->pos[1]     = (f32)((s32)(bench_rand(rng) % (height + 200)) - 100) + (bench_rand(rng) % 64) / 64.0f;
+  quad->size[0]    = 1 + (bench_rand(rng) % 300) + (bench_rand(rng) % 64) / 64.0f;
+  quad->size[1]    = 1 + (bench_rand(rng) % 300) + (bench_rand(rng) % 64) / 64.0f;
+  quad->uv_rect[0] = ((s32)(bench_rand(rng) % 400) - 200) / 100.0f;
+  quad->uv_rect[1] = ((s32)(bench_rand(rng) % 400) - 200) / 100.0f;
+  quad->uv_rect[2] = (1 + bench_rand(rng) % 300) / 100.0f;
+  quad->uv_rect[3] = (1 + bench_rand(rng) % 300) / 100.0f;
+}
+
+internal void
+bench_soft_golden(u32 width, u32 height, u32 quad_count)
+{
+  Arena *big = arena_alloc_reserve(Gigabytes(4));
+  u64 rng = 77;
+
+  //- nb: textures: opaque, binary alpha, any alpha
+  BenchTexture textures[3] = {{0, 64, 64}, {0, 128, 96}, {0, 37, 53}};
+  for(u32 t = 0; t < ArrayCount(textures); t++)
+  {
+    BenchTexture *texture = &textures[t];
+    texture->texels = (u32*)arena_push(big, sizeof(u32) * texture->width * texture->height);
+    for(u32 i = 0; i < texture->width * texture->height; i++)
+    {
+      u32 color = (u32)bench_rand(&rng) & 0x00ffffff;
+      u32 alpha = t == 0 ? 255 : t == 1 ? (bench_rand(&rng) % 2) * 255 : (u32)bench_rand(&rng) & 0xff;
+      texture->texels[i] = color | (alpha << 24);
+    }
+  }
+
+  //- nb: a board, a tile byte picks one of 256 rects of texture 0
+  u32 columns = 40, rows = 25;
+  u8 *tiles = (u8*)arena_push(big, columns * rows);
+  for(u32 i = 0; i < columns * rows; i++)
+    tiles[i] = (u8)bench_rand(&rng);
+  R_TileGridConstants *grid = (R_TileGridConstants*)arena_push(big, sizeof(R_TileGridConstants));
+  grid->origin[0]       = -13.3f;
+  grid->origin[1]       = 7.7f;
+  grid->tile_size[0]    = 24.5f;
+  grid->tile_size[1]    = 19.25f;
+  grid->columns         = columns;
+  grid->visible_columns = 30;
+  grid->first_x         = 3;
+  grid->first_y         = 2;
+  u32 grid_count = 30 * 20;
+  for(u32 tile = 0; tile < 256; tile++)
+  {
+    grid->uv_rect_from_tile[tile][0] = (tile % 16) / 16.0f;
+    grid->uv_rect_from_tile[tile][1] = (tile / 16) / 16.0f;
+    grid->uv_rect_from_tile[tile][2] = 1 / 16.0f;
+    grid->uv_rect_from_tile[tile][3] = 1 / 16.0f;
+  }
+
+  //- nb: the quads, pushed the same way to the renderers and to a recorder
+  // that hands back the flushed order
+  u32 thread_counts[2] = {1, 7};
+  R_SoftState *softs[2];
+  R_Handle handles[2][4];
+  for(u32 r = 0; r < 2; r++)
+  {
+    softs[r] = r_soft_alloc(width, height, thread_counts[r]);
+    for(u32 t = 0; t < 3; t++)
+      handles[r][t] = r_soft_tex2d_alloc(softs[r], R_TEX2D_FORMAT_RGBA8, textures[t].width, textures[t].height, textures[t].texels);
+    handles[r][3] = R_Handle{};
+  }
+  R_CmdList *list = r_cmd_list_alloc();
+  R_DrawRecorder *recorder = r_draw_recorder_alloc();
+  const f32 clear_color[4] = {0.25f, 0.5f, 0.75f, 1.0f};
+  for(u32 r = 0; r < 2; r++)
+  {
+    r_soft_clear(softs[r], clear_color);
+    r_soft_submit_tile_grid(softs[r], grid, tiles, grid_count, handles[r][0]);
+  }
+  for(u32 i = 0; i < quad_count; i++)
+  {
+    R_Quad quad;
+    bench_soft_random_quad(&quad, &rng, width, height);
+    u32 texture = bench_rand(&rng) % 4;
+    R_Layer layer = (R_Layer)(bench_rand(&rng) % R_LAYER_COUNT);
+    for(u32 r = 0; r < 2; r++)
+      *r_soft_push_quads(softs[r], handles[r][texture], layer, 1) = quad;
+    R_Handle key = {{texture + 1ull}};
+    *r_cmd_push_quads(list, key, layer, 1) = quad;
+  }
+  u64 soft_us[2];
+  for(u32 r = 0; r < 2; r++)
+  {
+    u64 t0 = os_now_microseconds();
+    r_soft_present(softs[r]);
+    soft_us[r] = os_now_microseconds() - t0;
+  }
+  r_cmd_list_flush(list, &recorder->backend);
+
+  //- nb: the reference, clear, grid, then the recorded draws
+  u32 *pixels = (u32*)arena_push(big, sizeof(u32) * width * height);
+  for(u32 i = 0; i < width * height; i++)
+    pixels[i] = 0xffbf8040;
+  for(u32 i = 0; i < grid_count; i++)
+  {
+    R_TileGridVertex corner = r_tile_grid_vertex(grid, tiles, i, 0, 0);
+    u32 tile = tiles[(grid->first_y + i / grid->visible_columns) * columns + grid->first_x + i % grid->visible_columns];
+    R_Quad quad = {{corner.pos[0], corner.pos[1]}, {grid->tile_size[0], grid->tile_size[1]}, {0}};
+    memcpy(quad.uv_rect, grid->uv_rect_from_tile[tile], sizeof(quad.uv_rect));
+    bench_soft_reference_quad(pixels, width, height, &quad, &textures[0]);
+  }
+  for(u32 d = 0; d < recorder->draw_count; d++)
+  {
+    R_DrawRecord *draw = &recorder->draws[d];
+    u32 texture = (u32)draw->texture.U64[0] - 1;
+    for(u32 q = 0; q < draw->quad_count; q++)
+      bench_soft_reference_quad(pixels, width, height, &recorder->quads[draw->first_quad + q], texture < 3 ? &textures[texture] : 0);
+  }
+  u64 differ[2] = {0, 0};
+  for(u32 r = 0; r < 2; r++)
+  {
+    for(u32 i = 0; i < width * height; i++)
+      differ[r] += softs[r]->framebuffer[i] != pixels[i];
+  }
+  if(differ[0] || differ[1])
+    printf("  MISMATCH: %llu and %llu pixels differ from the reference\n", (unsigned long long)differ[0], (unsigned long long)differ[1]);
+  Assert(differ[0] == 0 && differ[1] == 0);
+  printf("  %4ux%-4u %5u quads + %u tiles, %u draws: matches the reference with 1 and 7 threads (%6.2f ms, %6.2f ms)\n",
+         width, height, quad_count, grid_count, softs[0]->last_frame_counters.draws,
+         soft_us[0] / 1000.0, soft_us[1] / 1000.0);
+  char name[64];
+  snprintf(name, sizeof(name), "soft_golden_%ux%u", width, height);
+  bench_soft_dump(softs[1], name);
+
+  r_draw_recorder_release(recorder);
+  r_cmd_list_release(list);
+  for(u32 r = 0; r < 2; r++)
+    r_soft_release(softs[r]);
+  arena_release(big);
+}
+
+//- nb: the game's frame: board tiles, two strings and the atlas preview
+internal void
+bench_soft_frames(u32 width, u32 height, f32 tile_size, u32 thread_count, u32 frame_count)
+{
+  Arena *big = arena_alloc_reserve(Gigabytes(4));
+  R_SoftState *soft = r_soft_alloc(width, height, thread_count);
+  u64 rng = 5;
+  u32 *texels = (u32*)arena_push(big, sizeof(u32) * 1024 * 1024);
+  for(u32 i = 0; i < 1024 * 1024; i++)
+    texels[i] = ((u32)bench_rand(&rng) & 0x00ffffff) | ((i % 3 ? 255u : (u32)bench_rand(&rng) & 0xff) << 24);
+  R_Handle sheet = r_soft_tex2d_alloc(soft, R_TEX2D_FORMAT_RGBA8, 128, 128, texels);
+  // nb: coverage only, like the font atlas
+  R_Handle atlas = r_soft_tex2d_alloc(soft, R_TEX2D_FORMAT_R8, 1024, 1024, texels);
+
+  u32 columns = (u32)(width / tile_size) + 1, rows = (u32)(height / tile_size) + 1;
+  u8 *tiles = (u8*)arena_push(big, columns * rows);
+  R_TileGridConstants *grid = (R_TileGridConstants*)arena_push(big, sizeof(R_TileGridConstants));
+  memset(grid, 0, sizeof(R_TileGridConstants));
+  grid->tile_size[0]    = tile_size;
+  grid->tile_size[1]    = tile_size;
+  grid->columns         = columns;
+  grid->visible_columns = columns;
+  for(u32 tile = 0; tile < 256; tile++)
+  {
+    grid->uv_rect_from_tile[tile][0] = (tile % 4) * 0.25f;
+    grid->uv_rect_from_tile[tile][1] = ((tile / 4) % 4) * 0.25f;
+    grid->uv_rect_from_tile[tile][2] = 0.25f;
+    grid->uv_rect_from_tile[tile][3] = 0.25f;
+  }
+
+  const f32 clear_color[4] = {0.25f, 0.25f, 0.25f, 1.0f};
+  u64 total_us = 0;
+  for(u32 frame = 0; frame < frame_count; frame++)
+  {
+    for(u32 i = 0; i < columns * rows; i++)
+      tiles[i] = (u8)bench_rand(&rng);
+    u64 t0 = os_now_microseconds();
+    r_soft_clear(soft, clear_color);
+    r_soft_submit_tile_grid(soft, grid, tiles, columns * rows, sheet);
+    R_Quad *glyphs = r_soft_push_quads(soft, atlas, R_LAYER_UI, 38);
+    for(u32 i = 0; i < 38; i++)
+    {
+      R_Quad glyph = {{20.0f + i * 14, 500.0f + (i / 10) * 58}, {14, 24}, {(i % 32) / 32.0f, 0, 1 / 32.0f, 1 / 32.0f}};
+      glyphs[i] = glyph;
+    }
+    R_Quad preview = {{20, 500}, {1024, 1024}, {0, 0, 1, 1}};
+    *r_soft_push_quads(soft, atlas, R_LAYER_UI, 1) = preview;
+    r_soft_present(soft);
+    total_us += os_now_microseconds() - t0;
+  }
+  printf("  %4ux%-4u %5.1f px tiles (%6u), %2u threads: %7.3f ms per frame\n",
+         width, height, tile_size, columns * rows, soft->thread_count, total_us / 1000.0 / frame_count);
+  char name[64];
+  snprintf(name, sizeof(name), "soft_frame_%u", (u32)tile_size);
+  bench_soft_dump(soft, name);
+  r_soft_release(soft);
+  arena_release(big);
+}
+
+internal void
+bench_soft(Arena *arena)
+{
+  bench_soft_golden(641, 479, 2000);
+  bench_soft_golden(1920, 1080, 300);
+  u32 cores = os_logical_core_count();
+  bench_soft_frames(1920, 1080, 32, 1, 50);
+  bench_soft_frames(1920, 1080, 32, cores, 50);
+  bench_soft_frames(1920, 1080, 8, 1, 20);
+  bench_soft_frames(1920, 1080, 8, cores, 20);
+}
+
+////////////////////////////////
+//~ nb: Tile map
+// The tile map splits dirty ranges into row boxes, which have to cover the
+// range and nothing else. Then the same board and cameras drawn by the
+// software renderer through the tile map's per-pixel resolve and through
+// the instanced tile grid, which have to agree pixel for pixel.
+internal void
+bench_tilemap_boxes(u32 range_count)
+{
+  u64 rng = 23;
+  u64 cells = 0;
+  u32 boxes_total = 0;
+  for(u32 i = 0; i < range_count; i++)
+  {
+    u32 columns = 1 + bench_rand(&rng) % 100;
+    u32 rows    = 1 + bench_rand(&rng) % 100;
+    u64 first = bench_rand(&rng) % ((u64)columns * rows);
+    u64 count = 1 + bench_rand(&rng) % ((u64)columns * rows - first);
+    R_TileMapBox boxes[3];
+    u32 box_count = r_tile_map_boxes(columns, first, count, boxes);
+    //- nb: in order and back to back, every box inside the board
+    u64 next = first;
+    b32 ok = box_count >= 1 && box_count <= 3;
+    for(u32 b = 0; b < box_count && ok; b++)
+    {
+      R_TileMapBox *box = &boxes[b];
+      ok = box->width > 0 && box->height > 0 && box->x + box->width <= columns && box->y + box->height <= rows &&
+           (box->height == 1 || (box->x == 0 && box->width == columns)) &&
+           (u64)box->y * columns + box->x == next;
+      next += (u64)box->width * box->height;
+    }
+    ok = ok && next == first + count;
+    if(!ok)
+      printf("  MISMATCH: %llu cells from %llu on %u columns\n", (unsigned long long)count, (unsigned long long)first, columns);
+    Assert(ok);
+    cells += count;
+    boxes_total += box_count;
+  }
+  printf("  %u ranges, %llu cells: %.2f boxes per range, all exact\n", range_count, (unsigned long long)cells, (f64)boxes_total / range_count);
+}
+
+//- nb: 1 when a pixel center sits on a texel edge of the sheet, where the
+// two paths' float math can round apart. 32 texels per tile, the f32 error
+// grows with the distance from the board's origin.
+internal b32
+bench_tilemap_on_edge(R_TileView *view, u64 x, u64 y)
+{
+  f64 texel_pixels = view->tile_size * view->zoom / 32;
+  f64 world_x = (x + 0.5) / view->zoom + view->x;
+  f64 world_y = (y + 0.5) / view->zoom + view->y;
+  f64 texel_x = world_x / view->tile_size * 32;
+  f64 texel_y = world_y / view->tile_size * 32;
+  f64 slack_x = (fabs(world_x * view->zoom) + x) * 1e-6 + 1e-3;
+  f64 slack_y = (fabs(world_y * view->zoom) + y) * 1e-6 + 1e-3;
+  return fabs(texel_x - floor(texel_x + 0.5)) * texel_pixels < slack_x ||
+         fabs(texel_y - floor(texel_y + 0.5)) * texel_pixels < slack_y;
+}
+
+internal void
+bench_tilemap_board(u32 columns, u32 rows, u32 mine_count, u32 width, u32 height, u32 view_count)
+{
+  Board *board = board_alloc();
+  board_reset(board, columns, rows, mine_count, 11);
+  u64 rng = 31;
+  for(u32 i = 0; i < 64 && board->is_playable; i++)
+  {
+    u32 idx = bench_rand(&rng) % board->tiles_count;
+    if(i % 4 == 3) board_toggle_flag(board, idx);
+    else if(!(board_tile(board, idx) & TILE_BIT_MINE) || i == 0) board_sweep(board, idx);
+  }
+  board_reveal_finish(board);
+
+  Arena *big = arena_alloc_reserve(Gigabytes(4));
+  u8 *tiles = (u8*)arena_push(big, board->tiles_count);
+  for(u32 y = 0; y < rows; y++)
+    board_tile_row(board, y, 0, columns, tiles + (u64)y * columns);
+
+  //- nb: a 4x4 sheet with some transparent texels, like the game's
+  R_SoftState *softs[2] = {r_soft_alloc(width, height, 0), r_soft_alloc(width, height, 0)};
+  u32 *texels = (u32*)arena_push(big, sizeof(u32) * 128 * 128);
+  for(u32 i = 0; i < 128 * 128; i++)
+    texels[i] = ((u32)bench_rand(&rng) & 0x00ffffff) | ((i % 5 ? 255u : (u32)bench_rand(&rng) & 0xff) << 24);
+  R_Handle sheets[2] = {r_soft_tex2d_alloc(softs[0], R_TEX2D_FORMAT_RGBA8, 128, 128, texels),
+                        r_soft_tex2d_alloc(softs[1], R_TEX2D_FORMAT_RGBA8, 128, 128, texels)};
+
+  R_TileGridConstants *grid = (R_TileGridConstants*)arena_push(big, sizeof(R_TileGridConstants));
+  R_TileMapConstants *map = (R_TileMapConstants*)arena_push(big, sizeof(R_TileMapConstants));
+  memset(grid, 0, sizeof(R_TileGridConstants));
+  memset(map, 0, sizeof(R_TileMapConstants));
+  grid->columns = columns;
+  map->columns  = columns;
+  map->rows     = rows;
+  for(u32 tile = 0; tile < 256; tile++)
+  {
+    u32 kind = tile_kind((Tile)tile);
+    f32 uv_rect[4] = {(kind % 4) * 0.25f, (kind / 4) * 0.25f, 0.25f, 0.25f};
+    memcpy(grid->uv_rect_from_tile[tile], uv_rect, sizeof(uv_rect));
+    memcpy(map->uv_rect_from_tile[tile], uv_rect, sizeof(uv_rect));
+  }
+
+  //- nb: powers of two first, then anything. Cameras get a fractional part
+  // after the first round.
+  static const f64 zooms[] = {1, 2, 0.5, 0.25, 4, 1.25, 0.8, 1.5625, 0.64, 3.0517578125};
+  const f32 clear_color[4] = {0.25f, 0.25f, 0.25f, 1.0f};
+  u64 differ = 0, edge_differ = 0, pixels = 0, grid_tiles = 0, grid_us = 0, map_us = 0;
+  for(u32 v = 0; v < view_count; v++)
+  {
+    R_TileView view;
+    view.zoom      = zooms[v % ArrayCount(zooms)];
+    view.tile_size = 32;
+    view.width     = width;
+    view.height    = height;
+    view.x = (f64)((s32)(bench_rand(&rng) % (columns * 32 + width)) - (s32)width / 2);
+    view.y = (f64)((s32)(bench_rand(&rng) % (rows * 32 + height)) - (s32)height / 2);
+    if(v >= ArrayCount(zooms))
+    {
+      view.x += (bench_rand(&rng) % 64) / 64.0;
+      view.y += (bench_rand(&rng) % 64) / 64.0;
+    }
+
+    //- nb: the tile grid, culled the way game_render_board does
+    u64 t0 = os_now_microseconds();
+    r_soft_clear(softs[0], clear_color);
+    R_TileRect board_rect = {0, 0, columns, rows};
+    R_TileRect rect = r_tile_rect_intersect(r_tile_view_rect(&view), board_rect);
+    u32 visible_columns = (u32)(rect.x1 - rect.x0);
+    u32 visible_rows    = (u32)(rect.y1 - rect.y0);
+    if(visible_columns > 0 && visible_rows > 0)
+    {
+      f64 origin_x, origin_y;
+      r_screen_from_tile(&view, 0, 0, &origin_x, &origin_y);
+      grid->origin[0]       = (f32)origin_x;
+      grid->origin[1]       = (f32)origin_y;
+      grid->tile_size[0]    = (f32)(32 * view.zoom);
+      grid->tile_size[1]    = (f32)(32 * view.zoom);
+      grid->visible_columns = visible_columns;
+      grid->first_x         = (u32)rect.x0;
+      grid->first_y         = (u32)rect.y0;
+      r_soft_submit_tile_grid(softs[0], grid, tiles, visible_columns * visible_rows, sheets[0]);
+      grid_tiles += visible_columns * visible_rows;
+    }
+    r_soft_present(softs[0]);
+    u64 t1 = os_now_microseconds();
+
+    //- nb: the tile map, one draw
+    r_soft_clear(softs[1], clear_color);
+    if(r_tile_map_set_view(map, &view))
+      r_soft_submit_tile_map(softs[1], map, tiles, sheets[1]);
+    r_soft_present(softs[1]);
+    u64 t2 = os_now_microseconds();
+    grid_us += t1 - t0;
+    map_us  += t2 - t1;
+
+    //- nb: whole zoom steps have to match exactly, others everywhere but
+    // on texel edges
+    b32 exact = v < 5;
+    u64 view_differ = 0;
+    for(u64 y = 0; y < height; y++)
+    {
+      for(u64 x = 0; x < width; x++)
+      {
+        if(softs[0]->framebuffer[y * width + x] == softs[1]->framebuffer[y * width + x])
+          continue;
+        if(!exact && bench_tilemap_on_edge(&view, x, y))
+          edge_differ += 1;
+        else
+          view_differ += 1;
+      }
+    }
+    if(view_differ)
+      printf("  MISMATCH: %llu pixels differ at zoom %g, camera %g %g\n", (unsigned long long)view_differ, view.zoom, view.x, view.y);
+    differ += view_differ;
+    pixels += (u64)width * height;
+  }
+  Assert(differ == 0);
+  printf("  %5ux%-5u %u views: tile map matches the tile grid on %llu pixels (%llu on texel edges differ), "
+         "%8.1f tiles vs 1 draw per frame (soft %6.2f ms vs %6.2f ms)\n",
+         columns, rows, view_count, (unsigned long long)pixels, (unsigned long long)edge_differ,
+         (f64)grid_tiles / view_count, grid_us / 1000.0 / view_count, map_us / 1000.0 / view_count);
+  char name[64];
+  snprintf(name, sizeof(name), "tilemap_%ux%u", columns, rows);
+  bench_soft_dump(softs[1], name);
+
+  r_soft_release(softs[0]);
+  r_soft_release(softs[1]);
+  arena_release(big);
+  board_release(board);
+}
+
+internal void
+bench_tilemap(Arena *arena)
+{
+  bench_tilemap_boxes(100000);
+  bench_tilemap_board(30, 16, 99, 1280, 720, 40);
+  bench_tilemap_board(300, 200, 12000, 1280, 720, 40);
+  bench_tilemap_board(2000, 2000, 400000, 1280, 720, 40);
+}
+
+////////////////////////////////
+//~ nb: Texture formats
+// Sizes from the format table, one and two channel texels through unpack
+// and pack, and a font-like atlas uploaded as RGBA8 and as R8 (allocated,
+// then partly updated) to the software renderer, which has to draw the
+// same glyphs from both.
+internal void
+bench_formats_sizes(void)
+{
+  static const u32 dims[][2] = {{1, 1}, {4, 4}, {5, 3}, {1024, 1024}, {1023, 17}};
+  b32 ok = 1;
+  for(u32 f = 0; f < R_TEX2D_FORMAT_COUNT; f++)
+  {
+    R_Tex2DFormat format = (R_Tex2DFormat)f;
+    R_Tex2DFormatInfo info = r_tex2d_format_info(format);
+    for(u32 d = 0; d < ArrayCount(dims); d++)
+    {
+      u64 blocks_x = (dims[d][0] + info.block_size - 1) / info.block_size;
+      u64 blocks_y = (dims[d][1] + info.block_size - 1) / info.block_size;
+      ok = ok && r_tex2d_row_pitch(format, dims[d][0]) == blocks_x * info.bytes_per_block;
+      ok = ok && r_tex2d_size(format, dims[d][0], dims[d][1]) == blocks_x * blocks_y * info.bytes_per_block;
+    }
+  }
+  if(!ok)
+    printf("  MISMATCH in the format table\n");
+  Assert(ok);
+  printf("  1024x1024: RGBA8 %6.2f MiB, R8 %6.2f MiB, RG8 %6.2f MiB, BC1 %6.2f MiB, BC4 %6.2f MiB, BC7 %6.2f MiB\n",
+         r_tex2d_size(R_TEX2D_FORMAT_RGBA8, 1024, 1024) / 1048576.0, r_tex2d_size(R_TEX2D_FORMAT_R8, 1024, 1024) / 1048576.0,
+         r_tex2d_size(R_TEX2D_FORMAT_RG8, 1024, 1024) / 1048576.0, r_tex2d_size(R_TEX2D_FORMAT_BC1, 1024, 1024) / 1048576.0,
+         r_tex2d_size(R_TEX2D_FORMAT_BC4, 1024, 1024) / 1048576.0, r_tex2d_size(R_TEX2D_FORMAT_BC7, 1024, 1024) / 1048576.0);
+}
+
+//- nb: packed texels survive unpack and pack, RGBA8 texels come back as
+// the expansion of what was kept
+internal void
+bench_formats_round_trip(Arena *arena, u32 count)
+{
+  u64 rng = 41;
+  u8 *packed   = (u8*)arena_push(arena, 2 * count);
+  u8 *repacked = (u8*)arena_push(arena, 2 * count);
+  u32 *rgba    = (u32*)arena_push(arena, sizeof(u32) * count);
+  u32 *texels  = (u32*)arena_push(arena, sizeof(u32) * count);
+  b32 ok = 1;
+  R_Tex2DFormat formats[2] = {R_TEX2D_FORMAT_R8, R_TEX2D_FORMAT_RG8};
+  for(u32 f = 0; f < 2; f++)
+  {
+    R_Tex2DFormat format = formats[f];
+    for(u32 i = 0; i < 2 * count; i++)
+      packed[i] = (u8)bench_rand(&rng);
+    r_tex2d_unpack(format, texels, packed, count);
+    r_tex2d_pack(format, repacked, texels, count);
+    ok = ok && memcmp(packed, repacked, r_tex2d_size(format, count, 1)) == 0;
+
+    for(u32 i = 0; i < count; i++)
+      rgba[i] = bench_rand(&rng);
+    r_tex2d_pack(format, packed, rgba, count);
+    r_tex2d_unpack(format, texels, packed, count);
+    for(u32 i = 0; i < count && ok; i++)
+    {
+      u32 a = rgba[i] >> 24, l = rgba[i] & 0xff;
+      u32 expected = format == R_TEX2D_FORMAT_R8 ? (0x00ffffff | (a << 24)) : (l | (l << 8) | (l << 16) | (a << 24));
+      ok = texels[i] == expected;
+    }
+  }
+  if(!ok)
+    printf("  MISMATCH in the R8/RG8 round trip\n");
+  Assert(ok);
+  printf("  %u texels: R8 and RG8 round trip exactly\n", count);
+}
+
+internal void
+bench_formats_atlas(u32 size, u32 glyph_count)
+{
+  Arena *big = arena_alloc_reserve(Gigabytes(1));
+  u64 rng = 43;
+  //- nb: coverage blobs, the old atlas wrote it as white with alpha
+  u8 *coverage = (u8*)arena_push(big, (u64)size * size);
+  u32 *rgba    = (u32*)arena_push(big, sizeof(u32) * size * size);
+  for(u32 i = 0; i < size * size; i++)
+  {
+    u32 x = i % size, y = i / size;
+    coverage[i] = ((x / 7 + y / 11) % 3 == 0) ? 0 : (u8)bench_rand(&rng);
+    rgba[i] = 0x00ffffff | ((u32)coverage[i] << 24);
+  }
+
+  R_SoftState *softs[2] = {r_soft_alloc(640, 480, 0), r_soft_alloc(640, 480, 0)};
+  R_Tex2DFormat formats[2] = {R_TEX2D_FORMAT_RGBA8, R_TEX2D_FORMAT_R8};
+  const void *datas[2] = {rgba, coverage};
+  R_Handle atlases[2];
+  for(u32 r = 0; r < 2; r++)
+    atlases[r] = r_soft_tex2d_alloc(softs[r], formats[r], size, size, datas[r]);
+
+  //- nb: a frame of glyphs, a second upload over part of the atlas, another frame
+  const f32 clear_color[4] = {0.1f, 0.2f, 0.3f, 1.0f};
+  u32 update_x = size / 4, update_y = size / 3, update_w = (size / 2) & ~3u, update_h = size / 5;
+  u8 *update_coverage = (u8*)arena_push(big, (u64)update_w * update_h);
+  u32 *update_rgba    = (u32*)arena_push(big, sizeof(u32) * update_w * update_h);
+  for(u32 i = 0; i < update_w * update_h; i++)
+  {
+    update_coverage[i] = (u8)bench_rand(&rng);
+    update_rgba[i] = 0x00ffffff | ((u32)update_coverage[i] << 24);
+  }
+  const void *update_datas[2] = {update_rgba, update_coverage};
+  b32 same = 1;
+  u64 update_bytes[2] = {0, 0};
+  for(u32 frame = 0; frame < 2; frame++)
+  {
+    u64 frame_rng = rng;
+    for(u32 r = 0; r < 2; r++)
+    {
+      u64 glyph_rng = frame_rng;
+      if(frame == 1)
+        r_soft_tex2d_update(softs[r], atlases[r], update_x, update_y, update_w, update_h, update_datas[r]);
+      r_soft_clear(softs[r], clear_color);
+      R_Quad *glyphs = r_soft_push_quads(softs[r], atlases[r], R_LAYER_UI, glyph_count);
+      for(u32 i = 0; i < glyph_count; i++)
+      {
+        f32 w = 8 + bench_rand(&glyph_rng) % 40, h = 12 + bench_rand(&glyph_rng) % 50;
+        f32 u = (bench_rand(&glyph_rng) % size) / (f32)size, v = (bench_rand(&glyph_rng) % size) / (f32)size;
+        R_Quad glyph = {{(f32)(bench_rand(&glyph_rng) % 640), (f32)(bench_rand(&glyph_rng) % 480)}, {w, h}, {u, v, w / size, h / size}};
+        glyphs[i] = glyph;
+      }
+      r_soft_present(softs[r]);
+      //- nb: the same glyphs both frames, the difference is the update
+      if(frame == 0)
+        update_bytes[r] -= softs[r]->last_frame_counters.bytes_uploaded;
+      else
+        update_bytes[r] += softs[r]->last_frame_counters.bytes_uploaded;
+      if(r == 1)
+        rng = glyph_rng;
+    }
+    same = same && memcmp(softs[0]->framebuffer, softs[1]->framebuffer, sizeof(u32) * 640 * 480) == 0;
+  }
+  if(!same)
+    printf("  MISMATCH between the RGBA8 and the R8 atlas\n");
+  Assert(same);
+  printf("  %4ux%-4u atlas, %u glyphs: R8 draws like RGBA8, %7.2f KiB vs %7.2f KiB, update %6.2f KiB vs %6.2f KiB\n",
+         size, size, glyph_count,
+         r_tex2d_size(R_TEX2D_FORMAT_RGBA8, size, size) / 1024.0, r_tex2d_size(R_TEX2D_FORMAT_R8, size, size) / 1024.0,
+         update_bytes[0] / 1024.0, update_bytes[1] / 1024.0);
+  bench_soft_dump(softs[1], "formats_atlas");
+  r_soft_release(softs[0]);
+  r_soft_release(softs[1]);
+  arena_release(big);
+}
+
+internal void
+bench_formats(Arena *arena)
+{
+  bench_formats_sizes();
+  bench_formats_round_trip(arena, 1 << 20);
+  bench_formats_atlas(1024, 2000);
+  bench_formats_atlas(97, 500);
+}
+
+////////////////////////////////
+//~ nb: Block compression
+typedef enum BenchBCImage
+{
+  BENCH_BC_IMAGE_SPRITES,         // flat colors, outlines, transparent around
+  BENCH_BC_IMAGE_GRADIENT,        // smooth color and alpha
+  BENCH_BC_IMAGE_NOISE,           // worst case, every texel random
+  BENCH_BC_IMAGE_GLYPHS,          // coverage atlas like font.cpp bakes
+  BENCH_BC_IMAGE_COUNT,
+}
+BenchBCImage;
+
+global const char *bench_bc_image_names[BENCH_BC_IMAGE_COUNT] = {"sprites", "gradient", "noise", "glyphs"};
+
+internal void
+bench_bc_image(BenchBCImage image, u32 width, u32 height, u32 *rgba)
+{
+  u64 rng = 47;
+  switch(image)
+  {
+    case BENCH_BC_IMAGE_SPRITES:
+    {
+      //- nb: 16x16 cells, a rounded body in one of a few colors with a
+      // darker outline, transparent corners
+      static const u32 colors[] = {0xff3050e0, 0xff20c040, 0xffe0c020, 0xffc0c0c0, 0xff8040a0, 0xff1080f0};
+      for(u32 y = 0; y < height; y++)
+      {
+        for(u32 x = 0; x < width; x++)
+        {
+          u32 cell = (y / 16) * (width / 16 + 1) + x / 16;
+          s32 dx = (s32)(x % 16) * 2 - 15, dy = (s32)(y % 16) * 2 - 15;
+          s32 d = dx * dx + dy * dy;
+          u32 color = colors[(cell * 7 + cell / 5) % ArrayCount(colors)];
+          u32 texel = 0;
+          if(d < 13 * 13)
+            texel = color;
+          else if(d < 15 * 15)
+            texel = 0xff000000 | ((color >> 1) & 0x007f7f7f);
+          rgba[(u64)y * width + x] = texel;
+        }
+      }
+    }
+    break;
+    case BENCH_BC_IMAGE_GRADIENT:
+    {
+      for(u32 y = 0; y < height; y++)
+      {
+        for(u32 x = 0; x < width; x++)
+        {
+          u32 r = x * 255 / ClampBot(width - 1, 1), g = y * 255 / ClampBot(height - 1, 1);
+          u32 b = (x + y) * 255 / ClampBot(width + height - 2, 1), a = 255 - g / 2;
+          rgba[(u64)y * width + x] = r | (g << 8) | (b << 16) | (a << 24);
+        }
+      }
+    }
+    break;
+    case BENCH_BC_IMAGE_NOISE:
+    {
+      for(u64 i = 0; i < (u64)width * height; i++)
+        rgba[i] = (u32)bench_rand(&rng);
+    }
+    break;
+    case BENCH_BC_IMAGE_GLYPHS:
+    {
+      //- nb: strokes with a one texel antialiased ramp, white under coverage
+      for(u32 y = 0; y < height; y++)
+      {
+        for(u32 x = 0; x < width; x++)
+        {
+          u32 cx = x % 24, cy = y % 32;
+          u32 glyph = (y / 32) * 131 + x / 24;
+          s32 stem = (s32)cx - (s32)(4 + glyph % 11);
+          s32 bar  = (s32)cy - (s32)(6 + glyph % 19);
+          s32 edge = Min(stem < 0 ? -stem : stem, bar < 0 ? -bar : bar);
+          u32 coverage = edge <= 1 ? 255 : edge == 2 ? 96 + (glyph % 5) * 24 : edge == 3 ? 16 + (glyph % 7) * 8 : 0;
+          if(cy < 3 || cy > 28)
+            coverage = 0;
+          rgba[(u64)y * width + x] = 0x00ffffff | (coverage << 24);
+        }
+      }
+    }
+    break;
+    default: break;
+  }
+}
+
+//- nb: what BC4 can carry of an image, the one channel R8 keeps
+internal void
+bench_bc_single_channel(u32 *rgba, u64 count)
+{
+  for(u64 i = 0; i < count; i++)
+    rgba[i] = 0x00ffffff | (rgba[i] & 0xff000000);
+}
+
+//- nb: encode and decode throughput and the error, per image and format.
+// Floors are well under what the encoder gets today, they catch breakage
+// not drift. 0 means no floor.
+internal void
+bench_bc_quality(u32 size)
+{
+  Arena *big = arena_alloc_reserve(Gigabytes(1));
+  u64 count = (u64)size * size;
+  u32 *source  = (u32*)arena_push(big, sizeof(u32) * count);
+  u32 *decoded = (u32*)arena_push(big, sizeof(u32) * count);
+  u8  *blocks  = (u8*)arena_push(big, r_tex2d_size(R_TEX2D_FORMAT_BC7, size, size));
+  u8  *again   = (u8*)arena_push(big, r_tex2d_size(R_TEX2D_FORMAT_BC7, size, size));
+  R_Tex2DFormat formats[3] = {R_TEX2D_FORMAT_BC1, R_TEX2D_FORMAT_BC4, R_TEX2D_FORMAT_BC7};
+  const char *format_names[3] = {"BC1", "BC4", "BC7"};
+  //- nb: [image][format], rgb then alpha
+  static const f64 floors[BENCH_BC_IMAGE_COUNT][3][2] =
+  {
+    {{38, 0}, {0, 45}, {48, 48}},   // sprites
+    {{36, 0}, {0, 45}, {40, 44}},   // gradient
+    {{0,  0}, {0, 30}, {0,  0}},    // noise
+    {{0,  0}, {0, 40}, {0, 40}},    // glyphs
+  };
+  for(u32 image = 0; image < BENCH_BC_IMAGE_COUNT; image++)
+  {
+    for(u32 f = 0; f < 3; f++)
+    {
+      R_Tex2DFormat format = formats[f];
+      bench_bc_image((BenchBCImage)image, size, size, source);
+      if(format == R_TEX2D_FORMAT_BC4)
+        bench_bc_single_channel(source, count);
+      u64 bytes = r_tex2d_size(format, size, size);
+
+      u64 begin = os_now_microseconds();
+      r_bc_encode(format, source, size, size, blocks);
+      u64 encode_us = ClampBot(os_now_microseconds() - begin, 1);
+      begin = os_now_microseconds();
+      r_bc_decode(format, blocks, size, size, decoded);
+      u64 decode_us = ClampBot(os_now_microseconds() - begin, 1);
+
+      //- nb: encoding is deterministic
+      r_bc_encode(format, source, size, size, again);
+      Assert(memcmp(blocks, again, bytes) == 0);
+
+      R_BCError error = r_bc_error(source, decoded, count);
+      printf("  %-8s %s: %8.2f MB/s encode, %8.2f MB/s decode, %5.2fx smaller, PSNR rgb %6.2f dB alpha %6.2f dB, max error %3u\n",
+             bench_bc_image_names[image], format_names[f],
+             sizeof(u32) * count / (f64)encode_us, sizeof(u32) * count / (f64)decode_us,
+             (f64)(sizeof(u32) * count) / (f64)bytes, error.psnr_rgb, error.psnr_alpha, error.max_error);
+      b32 ok = error.psnr_rgb >= floors[image][f][0] && error.psnr_alpha >= floors[image][f][1];
+      if(!ok)
+        printf("  BELOW the floor of %.0f dB rgb, %.0f dB alpha\n", floors[image][f][0], floors[image][f][1]);
+      Assert(ok);
+    }
+  }
+  arena_release(big);
+}
+
+//- nb: blocks with at most two colors that the endpoints hold exactly
+// come back exact
+internal void
+bench_bc_exact(u32 width, u32 height)
+{
+  Arena *big = arena_alloc_reserve(Gigabytes(1));
+  u64 count = (u64)width * height;
+  u32 *source  = (u32*)arena_push(big, sizeof(u32) * count);
+  u32 *decoded = (u32*)arena_push(big, sizeof(u32) * count);
+  u8  *blocks  = (u8*)arena_push(big, r_tex2d_size(R_TEX2D_FORMAT_BC7, width, height));
+  u64 rng = 53;
+  u32 block_width = (width + 3) / 4;
+  u32 pairs[2][2048];
+  for(u32 i = 0; i < ArrayCount(pairs[0]); i++)
+  {
+    //- nb: 565 colors widened the way BC1 widens them
+    for(u32 k = 0; k < 2; k++)
+    {
+      u32 r = bench_rand(&rng) & 31, g = bench_rand(&rng) & 63, b = bench_rand(&rng) & 31;
+      r = (r << 3) | (r >> 2);
+      g = (g << 2) | (g >> 4);
+      b = (b << 3) | (b >> 2);
+      pairs[k][i] = r | (g << 8) | (b << 16) | 0xff000000;
+    }
+  }
+  R_Tex2DFormat formats[3] = {R_TEX2D_FORMAT_BC1, R_TEX2D_FORMAT_BC4, R_TEX2D_FORMAT_BC7};
+  for(u32 f = 0; f < 3; f++)
+  {
+    for(u64 i = 0; i < count; i++)
+    {
+      u32 x = (u32)(i % width), y = (u32)(i / width);
+      u32 pair = ((y / 4) * block_width + x / 4) % ArrayCount(pairs[0]);
+      u32 texel = pairs[(x ^ y ^ (pair >> 3)) & 1][pair];
+      if(formats[f] == R_TEX2D_FORMAT_BC4)
+        texel = 0x00ffffff | (texel << 24);
+      //- nb: even channels, BC7 endpoints share their low bit
+      if(formats[f] == R_TEX2D_FORMAT_BC7)
+        texel &= 0xfefefefe;
+      source[i] = texel;
+    }
+    r_bc_encode(formats[f], source, width, height, blocks);
+    r_bc_decode(formats[f], blocks, width, height, decoded);
+    u64 wrong = 0;
+    for(u64 i = 0; i < count; i++)
+      wrong += source[i] != decoded[i];
+    if(wrong)
+      printf("  format %u: %llu of %llu texels not exact\n", formats[f], (unsigned long long)wrong, (unsigned long long)count);
+    Assert(wrong == 0);
+  }
+
+  //- nb: BC1's transparent texels decode to transparent black
+  for(u64 i = 0; i < count; i++)
+    source[i] = (i % 3 == 0) ? 0x00ffffff : 0xff4282c6;
+  r_bc_encode(R_TEX2D_FORMAT_BC1, source, width, height, blocks);
+  r_bc_decode(R_TEX2D_FORMAT_BC1, blocks, width, height, decoded);
+  for(u64 i = 0; i < count; i++)
+    Assert(decoded[i] == ((i % 3 == 0) ? 0 : 0xff4282c6));
+  printf("  %4ux%-4u two color blocks exact in BC1, BC4 and BC7, BC1 alpha cuts to transparent black\n", width, height);
+  arena_release(big);
+}
+
+//- nb: the software renderer takes the blocks, a compressed texture draws
+// like its decoded RGBA8 twin, also after a block aligned update
+internal void
+bench_bc_soft(u32 size, u32 quad_count)
+{
+  Arena *big = arena_alloc_reserve(Gigabytes(1));
+  u64 count = (u64)size * size;
+  u32 *source  = (u32*)arena_push(big, sizeof(u32) * count);
+  u32 *decoded = (u32*)arena_push(big, sizeof(u32) * count);
+  u8  *blocks  = (u8*)arena_push(big, r_tex2d_size(R_TEX2D_FORMAT_BC7, size, size));
+  u32 update_x = 8, update_y = 4, update_w = (size / 2) & ~3u, update_h = size - update_y;
+  u32 *update_source  = (u32*)arena_push(big, sizeof(u32) * update_w * update_h);
+  u32 *update_decoded = (u32*)arena_push(big, sizeof(u32) * update_w * update_h);
+  u8  *update_blocks  = (u8*)arena_push(big, r_tex2d_size(R_TEX2D_FORMAT_BC7, update_w, update_h));
+  R_Tex2DFormat formats[3] = {R_TEX2D_FORMAT_BC1, R_TEX2D_FORMAT_BC4, R_TEX2D_FORMAT_BC7};
+  const f32 clear_color[4] = {0.1f, 0.2f, 0.3f, 1.0f};
+  for(u32 f = 0; f < 3; f++)
+  {
+    R_Tex2DFormat format = formats[f];
+    bench_bc_image(BENCH_BC_IMAGE_SPRITES, size, size, source);
+    bench_bc_image(BENCH_BC_IMAGE_GRADIENT, update_w, update_h, update_source);
+    r_bc_encode(format, source, size, size, blocks);
+    r_bc_decode(format, blocks, size, size, decoded);
+    r_bc_encode(format, update_source, update_w, update_h, update_blocks);
+    r_bc_decode(format, update_blocks, update_w, update_h, update_decoded);
+
+    R_SoftState *softs[2] = {r_soft_alloc(320, 240, 0), r_soft_alloc(320, 240, 0)};
+    R_Handle textures[2] =
+    {
+      r_soft_tex2d_alloc(softs[0], R_TEX2D_FORMAT_RGBA8, size, size, decoded),
+      r_soft_tex2d_alloc(softs[1], format, size, size, blocks),
+    };
+    b32 same = 1;
+    for(u32 frame = 0; frame < 2; frame++)
+    {
+      if(frame == 1)
+      {
+        r_soft_tex2d_update(softs[0], textures[0], update_x, update_y, update_w, update_h, update_decoded);
+        r_soft_tex2d_update(softs[1], textures[1], update_x, update_y, update_w, update_h, update_blocks);
+      }
+      for(u32 r = 0; r < 2; r++)
+      {
+        u64 rng = 59;
+        r_soft_clear(softs[r], clear_color);
+        R_Quad *quads = r_soft_push_quads(softs[r], textures[r], R_LAYER_WORLD, quad_count);
+        for(u32 i = 0; i < quad_count; i++)
+          bench_soft_random_quad(&quads[i], &rng, 320, 240);
+        r_soft_present(softs[r]);
+      }
+      same = same && memcmp(softs[0]->framebuffer, softs[1]->framebuffer, sizeof(u32) * 320 * 240) == 0;
+    }
+    if(!same)
+      printf("  MISMATCH between format %u and its decoded texels\n", format);
+    Assert(same);
+    bench_soft_dump(softs[1], "bc_soft");
+    r_soft_release(softs[0]);
+    r_soft_release(softs[1]);
+  }
+  printf("  %4ux%-4u BC1, BC4 and BC7 textures draw like their decoded texels, before and after an update\n", size, size);
+  arena_release(big);
+}
+
+internal void
+bench_bc(Arena *arena)
+{
+  bench_bc_quality(1024);
+  bench_bc_quality(97);
+  bench_bc_exact(256, 256);
+  bench_bc_exact(37, 21);
+  bench_bc_soft(128, 300);
+  bench_bc_soft(70, 300);
+}
+
+////////////////////////////////
+//~ nb: Font cache
+internal void
+bench_fontcache_path(char *path, u64 size, const char *name)
+{
+  const char *dir = getenv("TMPDIR");
+  snprintf(path, size, "%s/%s", dir ? dir : "/tmp", name);
+}
+
+//- nb: a copy of the file at `path` with `patch` applied, written to `out`
+typedef void BenchFontCachePatch(u8 *file, u64 *size);
+
+internal void
+bench_fontcache_patched(Arena *arena, const char *path, const char *out, BenchFontCachePatch *patch)
+{
+  OS_FileMap map;
+  Assert(os_file_map(path, &map));
+  Temp temp = temp_begin(arena);
+  u64 size = map.size;
+  u8 *file = (u8*)arena_push(temp.arena, size);
+  memcpy(file, map.data, size);
+  os_file_unmap(&map);
+  patch(file, &size);
+  Assert(os_file_write(out, file, size));
+  temp_end(temp);
+}
+
+internal void bench_fontcache_patch_version(u8 *file, u64 *size) { ((Font_Cache_Header*)file)->version += 1; }
+internal void bench_fontcache_patch_magic(u8 *file, u64 *size)   { file[0] ^= 0xff; }
+internal void bench_fontcache_patch_atlas(u8 *file, u64 *size)   { file[*size - 1] ^= 1; }
+internal void bench_fontcache_patch_metric(u8 *file, u64 *size)  { file[sizeof(Font_Cache_Header) + 5] ^= 1; }
+internal void bench_fontcache_patch_short(u8 *file, u64 *size)   { *size -= 16; }
+internal void bench_fontcache_patch_header(u8 *file, u64 *size)  { *size = sizeof(Font_Cache_Header) / 2; }
+internal void bench_fontcache_patch_empty(u8 *file, u64 *size)   { *size = 0; }
+internal void bench_fontcache_patch_width(u8 *file, u64 *size)   { ((Font_Cache_Header*)file)->width += 4; }
+
+internal void
+bench_fontcache_rules(Arena *arena)
+{
+  char path[1024], other[1024];
+  bench_fontcache_path(path, sizeof(path), "minesweeper_bench_font_cache.bin");
+  bench_fontcache_path(other, sizeof(other), "minesweeper_bench_font_cache_patched.bin");
+  remove(path);
+
+  const u8 glyphs[] = "ABCabc 123";
+  Font_Cache_Key key = {"Segoe UI", 64.0f, 96.0f, 64, R_TEX2D_FORMAT_R8, glyphs, sizeof(glyphs) - 1};
+  u64 hash = font_cache_key_hash(&key);
+  Font_Glyph_Metrics metrics[FONT_GLYPH_COUNT];
+  for(u32 i = 0; i < FONT_GLYPH_COUNT; i++)
+  {
+    Font_Glyph_Metrics m = {i / 128.f, 0, (i + 1) / 128.f, 1, i, 2 * i, -(s32)i, (s32)i, 0, 0, (s32)i + 3};
+    metrics[i] = m;
+  }
+  u8 atlas[64 * 64];
+  for(u32 i = 0; i < sizeof(atlas); i++)
+    atlas[i] = (u8)(i * 7);
+
+  //- nb: nothing there yet, then a round trip
+  Font_Cache cache = font_cache_open(path, hash);
+  Assert(cache.status == FONT_CACHE_MISSING);
+  Assert(font_cache_write(arena, path, hash, R_TEX2D_FORMAT_R8, 64, 64, atlas, metrics));
+  cache = font_cache_open(path, hash);
+  Assert(cache.status == FONT_CACHE_HIT);
+  Assert(cache.format == R_TEX2D_FORMAT_R8 && cache.width == 64 && cache.height == 64);
+  Assert(memcmp(cache.atlas, atlas, sizeof(atlas)) == 0);
+  Assert(memcmp(cache.metrics, metrics, sizeof(metrics)) == 0);
+  font_cache_close(&cache);
+
+  //- nb: every field of the key invalidates
+  Font_Cache_Key keys[6] = {key, key, key, key, key, key};
+  keys[0].font_name  = "Segoe UI Variable";
+  keys[1].size       = 64.5f;
+  keys[2].dpi        = 144.0f;
+  keys[3].atlas_size = 128;
+  keys[4].format     = R_TEX2D_FORMAT_BC4;
+  keys[5].glyph_count -= 1;
+  for(u32 i = 0; i < ArrayCount(keys); i++)
+  {
+    u64 other_hash = font_cache_key_hash(&keys[i]);
+    Assert(other_hash != hash);
+    cache = font_cache_open(path, other_hash);
+    Assert(cache.status == FONT_CACHE_STALE_KEY && cache.map.data == 0);
+  }
+
+  //- nb: and so does anything off in the file itself
+  struct { BenchFontCachePatch *patch; Font_Cache_Status status; const char *name; } cases[] =
+  {
+    {bench_fontcache_patch_version, FONT_CACHE_STALE_VERSION, "version bumped"},
+    {bench_fontcache_patch_magic,   FONT_CACHE_CORRUPT,       "bad magic"},
+    {bench_fontcache_patch_atlas,   FONT_CACHE_CORRUPT,       "atlas byte flipped"},
+    {bench_fontcache_patch_metric,  FONT_CACHE_CORRUPT,       "metrics byte flipped"},
+    {bench_fontcache_patch_short,   FONT_CACHE_CORRUPT,       "truncated"},
+    {bench_fontcache_patch_header,  FONT_CACHE_CORRUPT,       "half a header"},
+    {bench_fontcache_patch_empty,   FONT_CACHE_CORRUPT,       "empty"},
+    {bench_fontcache_patch_width,   FONT_CACHE_CORRUPT,       "size mismatch"},
+  };
+  for(u32 i = 0; i < ArrayCount(cases); i++)
+  {
+    bench_fontcache_patched(arena, path, other, cases[i].patch);
+    cache = font_cache_open(other, hash);
+    if(cache.status != cases[i].status)
+      printf("  %s: %s, expected %s\n", cases[i].name, font_cache_status_string(cache.status), font_cache_status_string(cases[i].status));
+    Assert(cache.status == cases[i].status);
+  }
+
+  //- nb: a rewrite replaces the stale file
+  bench_fontcache_patched(arena, path, other, bench_fontcache_patch_version);
+  Assert(font_cache_write(arena, other, hash, R_TEX2D_FORMAT_R8, 64, 64, atlas, metrics));
+  cache = font_cache_open(other, hash);
+  Assert(cache.status == FONT_CACHE_HIT);
+  font_cache_close(&cache);
+  remove(path);
+  remove(other);
+  printf("  round trip exact, %u key changes and %u damaged files all miss, a rewrite hits again\n",
+         (u32)ArrayCount(keys), (u32)ArrayCount(cases));
+}
+
+//- nb: what a warm start costs, map, validate and upload, against writing
+// the cache after a bake. The bake itself is DirectWrite and not here.
+internal void
+bench_fontcache_warm(Arena *arena, R_Tex2DFormat format, u32 size, u32 runs)
+{
+  char path[1024];
+  bench_fontcache_path(path, sizeof(path), "minesweeper_bench_font_cache.bin");
+  Arena *big = arena_alloc_reserve(Gigabytes(1));
+  u64 count = (u64)size * size;
+  u32 *texels = (u32*)arena_push(big, sizeof(u32) * count);
+  bench_bc_image(BENCH_BC_IMAGE_GLYPHS, size, size, texels);
+  u64 atlas_size = r_tex2d_size(format, size, size);
+  u8 *atlas = (u8*)arena_push(big, atlas_size);
+  if(r_tex2d_format_is_compressed(format))
+    r_bc_encode(format, texels, size, size, atlas);
+  else
+    r_tex2d_pack(format, atlas, texels, count);
+  Font_Glyph_Metrics metrics[FONT_GLYPH_COUNT] = {0};
+  const u8 glyphs[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+  Font_Cache_Key key = {"Segoe UI", 64.0f, 96.0f, size, format, glyphs, sizeof(glyphs) - 1};
+  u64 hash = font_cache_key_hash(&key);
+
+  u64 begin = os_now_microseconds();
+  Assert(font_cache_write(big, path, hash, format, size, size, atlas, metrics));
+  u64 write_us = os_now_microseconds() - begin;
+
+  R_SoftState *soft = r_soft_alloc(64, 64, 1);
+  u64 best_open_us = ~0ull, best_upload_us = ~0ull;
+  for(u32 run = 0; run < runs; run++)
+  {
+    u64 open_begin = os_now_microseconds();
+    Font_Cache cache = font_cache_open(path, hash);
+    u64 open_us = os_now_microseconds() - open_begin;
+    Assert(cache.status == FONT_CACHE_HIT);
+    u64 upload_begin = os_now_microseconds();
+    R_Handle texture = r_soft_tex2d_alloc(soft, cache.format, cache.width, cache.height, cache.atlas);
+    u64 upload_us = os_now_microseconds() - upload_begin;
+    font_cache_close(&cache);
+    r_soft_tex2d_release(soft, texture);
+    best_open_us   = Min(best_open_us, open_us);
+    best_upload_us = Min(best_upload_us, upload_us);
+  }
+  printf("  %4ux%-4u %s atlas, %7.2f KiB: write %7.3f ms, warm open and check %7.3f ms, upload %7.3f ms (soft)\n",
+         size, size, format == R_TEX2D_FORMAT_BC4 ? "BC4" : "R8 ", atlas_size / 1024.0,
+         write_us / 1000.0, best_open_us / 1000.0, best_upload_us / 1000.0);
+  r_soft_release(soft);
+  remove(path);
+  arena_release(big);
+}
+
+internal void
+bench_fontcache(Arena *arena)
+{
+  bench_fontcache_rules(arena);
+  bench_fontcache_warm(arena, R_TEX2D_FORMAT_R8, 1024, 20);
+  bench_fontcache_warm(arena, R_TEX2D_FORMAT_BC4, 1024, 20);
+}
+
+////////////////////////////////
+//~ nb: Rectangle packing
+// Every strategy on the sizes atlases actually get: Latin glyphs at a few
+// sizes, CJK (near square, many), and sprites. Reports how full a bin gets
+// before the first miss, inserts per second, the smallest square atlas the
+// ASCII set bakes into, and misses under insert/remove churn. An owner grid
+// checks nothing overlaps or leaves the bin.
+typedef enum BenchPackSet
+{
+  BENCH_PACK_LATIN,
+  BENCH_PACK_CJK,
+  BENCH_PACK_SPRITES,
+  BENCH_PACK_SET_COUNT,
+}
+BenchPackSet;
+
+global const char *bench_pack_set_names[BENCH_PACK_SET_COUNT] = {"latin", "cjk", "sprites"};
+
+//- nb: padded sizes, 2 texels of padding like the baked atlas
+internal void
+bench_pack_size(BenchPackSet set, u64 *rng, u32 *width, u32 *height)
+{
+  switch(set)
+  {
+    case BENCH_PACK_LATIN:
+    {
+      static const u32 sizes[] = {16, 24, 32, 48, 64};
+      u32 size = sizes[bench_rand(rng) % ArrayCount(sizes)];
+      *width  = size * (25 + bench_rand(rng) % 55) / 100 + 4;
+      *height = size * (45 + bench_rand(rng) % 60) / 100 + 4;
+    }break;
+    case BENCH_PACK_CJK:
+    {
+      u32 size = (bench_rand(rng) % 4) ? 24 : 48;
+      *width  = size * (85 + bench_rand(rng) % 16) / 100 + 4;
+      *height = size * (88 + bench_rand(rng) % 13) / 100 + 4;
+    }break;
+    default:
+    {
+      static const u32 sides[] = {16, 16, 32, 32, 32, 64, 64, 128};
+      *width  = sides[bench_rand(rng) % ArrayCount(sides)];
+      *height = (bench_rand(rng) % 4) ? *width : *width / 2;
+    }break;
+  }
+}
+
+internal void
+bench_pack_claim(u32 *owner, u32 bin, Rect_Pack_Rect rect, u32 id)
+{
+  Assert(rect.x + rect.width <= bin && rect.y + rect.height <= bin);
+  for(u32 y = rect.y; y < rect.y + rect.height; y++)
+  {
+    for(u32 x = rect.x; x < rect.x + rect.width; x++)
+    {
+      Assert((owner[y * bin + x] == 0) == (id != 0));
+      owner[y * bin + x] = id;
+    }
+  }
+}
+
+//- nb: fill until the first miss
+internal void
+bench_rectpack_fill(Arena *arena, BenchPackSet set, u32 bin)
+{
+  for(u32 strategy = 0; strategy < RECT_PACK_STRATEGY_COUNT; strategy++)
+  {
+    Temp temp = temp_begin(arena);
+    u32 *owner = (u32*)arena_push(temp.arena, sizeof(u32) * bin * bin);
+    memset(owner, 0, sizeof(u32) * bin * bin);
+    Rect_Packer *packer = rect_pack_alloc(temp.arena, (Rect_Pack_Strategy)strategy, bin, bin, 1 << 16);
+    u64 rng = 17;
+    u32 count = 0;
+    u64 pack_us = 0;
+    for(;;)
+    {
+      u32 width, height;
+      bench_pack_size(set, &rng, &width, &height);
+      Rect_Pack_Rect rect;
+      u64 begin = os_now_microseconds();
+      b32 ok = rect_pack_insert(packer, width, height, &rect);
+      pack_us += os_now_microseconds() - begin;
+      if(!ok)
+        break;
+      count += 1;
+      bench_pack_claim(owner, bin, rect, count);
+    }
+    printf("  %-7s %4u bin %-10s %5u rects, %5.1f%% full at the first miss, %8.1f ns/insert\n",
+           bench_pack_set_names[set], bin, rect_pack_strategy_string((Rect_Pack_Strategy)strategy),
+           count, 100.0f * rect_pack_occupancy(packer), pack_us * 1000.0 / Max(count, 1u));
+    temp_end(temp);
+  }
+}
+
+//- nb: the baked ASCII set at 64 px, as the bake meets it and tallest first
+internal void
+bench_rectpack_atlas(Arena *arena)
+{
+  u32 widths[95], heights[95], order[95];
+  u64 rng = 5;
+  u64 area = 0;
+  for(u32 i = 0; i < 95; i++)
+  {
+    widths[i]  = 64 * (25 + bench_rand(&rng) % 55) / 100 + 4;
+    heights[i] = 64 * (45 + bench_rand(&rng) % 60) / 100 + 4;
+    area += widths[i] * heights[i];
+    order[i] = i;
+  }
+  for(u32 i = 1; i < 95; i++)
+  {
+    for(u32 j = i; j > 0 && heights[order[j - 1]] < heights[order[j]]; j--)
+    {
+      u32 t = order[j]; order[j] = order[j - 1]; order[j - 1] = t;
+    }
+  }
+  for(u32 strategy = 0; strategy < RECT_PACK_STRATEGY_COUNT; strategy++)
+  {
+    u32 smallest[2] = {0};
+    for(u32 sorted = 0; sorted < 2; sorted++)
+    {
+      for(u32 bin = 32; bin <= 1024 && !smallest[sorted]; bin += 8)
+      {
+        Temp temp = temp_begin(arena);
+        Rect_Packer *packer = rect_pack_alloc(temp.arena, (Rect_Pack_Strategy)strategy, bin, bin, 95);
+        u32 i = 0;
+        for(; i < 95; i++)
+        {
+          u32 g = sorted ? order[i] : i;
+          Rect_Pack_Rect rect;
+          if(!rect_pack_insert(packer, widths[g], heights[g], &rect))
+            break;
+        }
+        if(i == 95)
+          smallest[sorted] = bin;
+        temp_end(temp);
+      }
+    }
+    printf("  ascii@64 %-10s smallest square %4u as met, %4u tallest first (%.0f%% and %.0f%% full)\n",
+           rect_pack_strategy_string((Rect_Pack_Strategy)strategy), smallest[0], smallest[1],
+           100.0 * area / ((f64)smallest[0] * smallest[0]), 100.0 * area / ((f64)smallest[1] * smallest[1]));
+  }
+}
+
+//- nb: steady state, a random live rect goes and a new one comes, and a
+// miss drops one more like a cache would
+internal void
+bench_rectpack_churn(Arena *arena, BenchPackSet set, u32 bin, u32 live, u32 steps)
+{
+  for(u32 strategy = 0; strategy < RECT_PACK_STRATEGY_COUNT; strategy++)
+  {
+    Temp temp = temp_begin(arena);
+    u32 *owner = (u32*)arena_push(temp.arena, sizeof(u32) * bin * bin);
+    memset(owner, 0, sizeof(u32) * bin * bin);
+    Rect_Pack_Rect *rects = (Rect_Pack_Rect*)arena_push(temp.arena, sizeof(Rect_Pack_Rect) * live);
+    Rect_Packer *packer = rect_pack_alloc(temp.arena, (Rect_Pack_Strategy)strategy, bin, bin, live);
+    u64 rng = 3;
+    u32 count = 0, misses = 0;
+    f64 occupancy = 0;
+    u64 pack_us = 0;
+    for(u32 step = 0; step < steps; step++)
+    {
+      u32 width, height;
+      bench_pack_size(set, &rng, &width, &height);
+      u32 evict = (count == live);
+      for(u32 pass = 0; pass < 2; pass++)
+      {
+        if(evict && count > 0)
+        {
+          u32 victim = bench_rand(&rng) % count;
+          bench_pack_claim(owner, bin, rects[victim], 0);
+          u64 begin = os_now_microseconds();
+          rect_pack_remove(packer, rects[victim]);
+          pack_us += os_now_microseconds() - begin;
+          rects[victim] = rects[--count];
+        }
+        if(pass == 1)
+          break;
+        u64 begin = os_now_microseconds();
+        b32 ok = rect_pack_insert(packer, width, height, &rects[count]);
+        pack_us += os_now_microseconds() - begin;
+        if(ok)
+        {
+          bench_pack_claim(owner, bin, rects[count], 1);
+          count += 1;
+          break;
+        }
+        misses += 1;
+        evict = 1;
+      }
+      occupancy += rect_pack_occupancy(packer);
+    }
+    printf("  %-7s %4u bin %-10s churn at %4u live: %5.2f%% misses, %5.1f%% full on average, %8.1f ns/step\n",
+           bench_pack_set_names[set], bin, rect_pack_strategy_string((Rect_Pack_Strategy)strategy), live,
+           100.0 * misses / steps, 100.0 * occupancy / steps, pack_us * 1000.0 / steps);
+    temp_end(temp);
+  }
+}
+
+internal void
+bench_rectpack(Arena *arena)
+{
+  bench_rectpack_atlas(arena);
+  bench_rectpack_fill(arena, BENCH_PACK_LATIN, 1024);
+  bench_rectpack_fill(arena, BENCH_PACK_CJK, 1024);
+  bench_rectpack_fill(arena, BENCH_PACK_SPRITES, 1024);
+  bench_rectpack_churn(arena, BENCH_PACK_LATIN, 512, 300, 20000);
+  bench_rectpack_churn(arena, BENCH_PACK_SPRITES, 512, 60, 20000);
+}
+
+////////////////////////////////
+//~ nb: Glyph distance fields
+// Binary shapes against a brute force distance (exact up to rounding),
+// antialiased discs and half planes against their true distance, the same
+// fields from one and from several threads, and a disc drawn 6x up from
+// its field against the same disc drawn 6x up from plain coverage.
+internal void
+bench_sdf_coverage_disc(u8 *coverage, u32 width, u32 height, f32 cx, f32 cy, f32 r)
+{
+  for(u32 y = 0; y < height; y++)
+  {
+    for(u32 x = 0; x < width; x++)
+    {
+      u32 inside = 0;
+      for(u32 sy = 0; sy < 16; sy++)
+      {
+        for(u32 sx = 0; sx < 16; sx++)
+        {
+          f32 px = x + (sx + 0.5f) / 16.0f - cx, py = y + (sy + 0.5f) / 16.0f - cy;
+          inside += px * px + py * py < r * r;
+        }
+      }
+      coverage[y * width + x] = (u8)((inside * 255 + 128) / 256);
+    }
+  }
+}
+
+internal void
+bench_sdf_binary(Arena *arena, u32 width, u32 height, u32 pad)
+{
+  Temp temp = temp_begin(arena);
+  u32 out_w = width + pad * 2, out_h = height + pad * 2;
+  u8 *coverage = (u8*)arena_push(temp.arena, width * height);
+  u8 *sdf      = (u8*)arena_push(temp.arena, out_w * out_h);
+  u8 *inside   = (u8*)arena_push(temp.arena, out_w * out_h);
+  //- nb: blobs, a few random rects on and off
+  u64 rng = 77;
+  memset(coverage, 0, width * height);
+  for(u32 i = 0; i < 12; i++)
+  {
+    u32 x0 = bench_rand(&rng) % width, y0 = bench_rand(&rng) % height;
+    u32 x1 = Min(width, x0 + 1 + bench_rand(&rng) % (width / 2));
+    u32 y1 = Min(height, y0 + 1 + bench_rand(&rng) % (height / 2));
+    for(u32 y = y0; y < y1; y++)
+      for(u32 x = x0; x < x1; x++)
+        coverage[y * width + x] = (i % 4 == 3) ? 0 : 255;
+  }
+  for(u32 y = 0; y < out_h; y++)
+  {
+    for(u32 x = 0; x < out_w; x++)
+    {
+      u32 cx = x - pad, cy = y - pad;
+      inside[y * out_w + x] = x >= pad && y >= pad && cx < width && cy < height && coverage[cy * width + cx];
+    }
+  }
+  Glyph_SDF_Job job = {coverage, width, height, width, pad, sdf, out_w};
+  glyph_sdf_build(temp.arena, &job);
+
+  u32 exact = 0, off = 0;
+  for(u32 y = 0; y < out_h; y++)
+  {
+    for(u32 x = 0; x < out_w; x++)
+    {
+      //- nb: to the nearest texel center on the other side
+      b32 in = inside[y * out_w + x];
+      u32 best = 0xffffffffu;
+      for(u32 oy = 0; oy < out_h; oy++)
+      {
+        for(u32 ox = 0; ox < out_w; ox++)
+        {
+          if(inside[oy * out_w + ox] == in)
+            continue;
+          u32 dx = ox > x ? ox - x : x - ox, dy = oy > y ? oy - y : y - oy;
+          best = Min(best, dx * dx + dy * dy);
+        }
+      }
+      f32 d = best == 0xffffffffu ? 1e10f : sqrtf((f32)best);
+      f32 value = 127.5f + (in ? d : -d) * (255.0f / R_TEX2D_SDF_RANGE);
+      s32 expected = (s32)Clamp(0.0f, value + 0.5f, 255.0f);
+      s32 diff = (s32)sdf[y * out_w + x] - expected;
+      exact += diff == 0;
+      off = Max(off, (u32)(diff < 0 ? -diff : diff));
+    }
+  }
+  printf("  %ux%u binary, pad %u: %u of %u texels match brute force exactly, worst off by %u\n",
+         width, height, pad, exact, out_w * out_h, off);
+  Assert(off <= 1 && exact * 100 >= out_w * out_h * 99);
+  temp_end(temp);
+}
+
+//- nb: antialiased shapes, errors in texels where the field isn't clamped
+internal void
+bench_sdf_analytic(Arena *arena)
+{
+  Temp temp = temp_begin(arena);
+  u32 size = 48, pad = 4, out = size + pad * 2;
+  u8 *coverage = (u8*)arena_push(temp.arena, size * size);
+  u8 *sdf      = (u8*)arena_push(temp.arena, out * out);
+  f32 worst = 0, sum = 0, near_sum = 0;
+  u32 count = 0, near_count = 0;
+  for(u32 shape = 0; shape < 8; shape++)
+  {
+    b32 disc = shape < 4;
+    f32 cx = 20.0f + shape * 1.37f, cy = 24.0f - shape * 0.61f, r = 6.0f + shape * 2.3f;
+    f32 nx = cosf(0.4f * shape), ny = sinf(0.4f * shape);
+    if(disc)
+    {
+      bench_sdf_coverage_disc(coverage, size, size, cx, cy, r);
+    }
+    else
+    {
+      //- nb: n.p < c, supersampled like the discs
+      for(u32 y = 0; y < size; y++)
+      {
+        for(u32 x = 0; x < size; x++)
+        {
+          u32 in = 0;
+          for(u32 sy = 0; sy < 16; sy++)
+            for(u32 sx = 0; sx < 16; sx++)
+              in += nx * (x + (sx + 0.5f) / 16.0f) + ny * (y + (sy + 0.5f) / 16.0f) < cx;
+          coverage[y * size + x] = (u8)((in * 255 + 128) / 256);
+        }
+      }
+    }
+    Glyph_SDF_Job job = {coverage, size, size, size, pad, sdf, out};
+    glyph_sdf_build(temp.arena, &job);
+    for(u32 y = 0; y < out; y++)
+    {
+      for(u32 x = 0; x < out; x++)
+      {
+        f32 px = (f32)x - pad + 0.5f, py = (f32)y - pad + 0.5f;
+        f32 truth = disc ? r - sqrtf((px - cx) * (px - cx) + (py - cy) * (py - cy)) : cx - (nx * px + ny * py);
+        // nb: the bitmap cuts the half planes off at its border
+        b32 away_from_border = px > 4 && py > 4 && px < size - 4 && py < size - 4;
+        if(fabsf(truth) > R_TEX2D_SDF_RANGE / 2 - 1.0f || (!disc && !away_from_border))
+          continue;
+        f32 error = fabsf(glyph_sdf_distance(sdf[y * out + x]) - truth);
+        worst = Max(worst, error);
+        sum += error;
+        count += 1;
+        // nb: what an edge drawn at any scale depends on
+        if(fabsf(truth) < 1.0f)
+        {
+          near_sum   += error;
+          near_count += 1;
+        }
+      }
+    }
+  }
+  printf("  antialiased discs and half planes: %u texels, mean error %.3f (%.3f within a texel of the edge), worst %.3f texels\n",
+         count, sum / count, near_sum / near_count, worst);
+  Assert(near_sum / near_count < 0.06f && sum / count < 0.1f && worst < 0.75f);
+  temp_end(temp);
+}
+
+//- nb: the same glyphs from one thread and from several
+internal void
+bench_sdf_threads(Arena *arena, u32 glyphs, u32 thread_count)
+{
+  Temp temp = temp_begin(arena);
+  u32 size = 40, pad = 4, out = size + pad * 2;
+  u8 *coverage = (u8*)arena_push(temp.arena, (u64)glyphs * size * size);
+  u8 *sdf[2];
+  sdf[0] = (u8*)arena_push(temp.arena, (u64)glyphs * out * out);
+  sdf[1] = (u8*)arena_push(temp.arena, (u64)glyphs * out * out);
+  Glyph_SDF_Job *jobs = (Glyph_SDF_Job*)arena_push(temp.arena, sizeof(Glyph_SDF_Job) * glyphs);
+  for(u32 i = 0; i < glyphs; i++)
+    bench_sdf_coverage_disc(coverage + (u64)i * size * size, size, size, 20.0f + (i % 7) * 0.3f, 19.5f, 4.0f + (i % 15));
+  u64 us[2];
+  for(u32 run = 0; run < 2; run++)
+  {
+    for(u32 i = 0; i < glyphs; i++)
+    {
+      Glyph_SDF_Job job = {coverage + (u64)i * size * size, size, size, size, pad, sdf[run] + (u64)i * out * out, out};
+      jobs[i] = job;
+    }
+    u64 begin = os_now_microseconds();
+    glyph_sdf_build_jobs(temp.arena, jobs, glyphs, run == 0 ? 1 : thread_count);
+    us[run] = os_now_microseconds() - begin;
+  }
+  Assert(memcmp(sdf[0], sdf[1], (u64)glyphs * out * out) == 0);
+  printf("  %u glyphs %ux%u: %.2f ms on 1 thread, %.2f ms on %u (%.1f us a glyph), identical\n",
+         glyphs, out, out, us[0] / 1000.0, us[1] / 1000.0, thread_count, (f64)us[0] / glyphs);
+  temp_end(temp);
+}
+
+//- nb: bilinear, clamped, like linear_sampler on the texel grid
+internal f32
+bench_sdf_sample(const u8 *texels, u32 width, u32 height, f32 x, f32 y)
+{
+  x = Clamp(0.0f, x - 0.5f, (f32)width - 1.0f);
+  y = Clamp(0.0f, y - 0.5f, (f32)height - 1.0f);
+  u32 x0 = (u32)x, y0 = (u32)y;
+  u32 x1 = Min(x0 + 1, width - 1), y1 = Min(y0 + 1, height - 1);
+  f32 fx = x - x0, fy = y - y0;
+  f32 top    = texels[y0 * width + x0] * (1 - fx) + texels[y0 * width + x1] * fx;
+  f32 bottom = texels[y1 * width + x0] * (1 - fx) + texels[y1 * width + x1] * fx;
+  return top * (1 - fy) + bottom * fy;
+}
+
+//- nb: ps_sdf on the CPU against bilinear coverage, both scaled up, over
+// the pixels near the edge
+internal void
+bench_sdf_scaled(Arena *arena, u32 scale)
+{
+  Temp temp = temp_begin(arena);
+  u32 size = 24, pad = 4, out = size + pad * 2;
+  f32 cx = 12.3f, cy = 11.8f, r = 7.4f;
+  u8 *inner    = (u8*)arena_push(temp.arena, size * size);
+  u8 *coverage = (u8*)arena_push(temp.arena, out * out);
+  u8 *sdf      = (u8*)arena_push(temp.arena, out * out);
+  bench_sdf_coverage_disc(inner, size, size, cx, cy, r);
+  bench_sdf_coverage_disc(coverage, out, out, cx + pad, cy + pad, r);
+  Glyph_SDF_Job job = {inner, size, size, size, pad, sdf, out};
+  glyph_sdf_build(temp.arena, &job);
+
+  u32 pixels = out * scale;
+  u8 *truth = (u8*)arena_push(temp.arena, pixels * pixels);
+  bench_sdf_coverage_disc(truth, pixels, pixels, (cx + pad) * scale, (cy + pad) * scale, r * scale);
+  f64 sdf_error = 0, coverage_error = 0;
+  u32 edge = 0;
+  for(u32 y = 0; y < pixels; y++)
+  {
+    for(u32 x = 0; x < pixels; x++)
+    {
+      f32 px = (x + 0.5f) / scale - (cx + pad), py = (y + 0.5f) / scale - (cy + pad);
+      if(fabsf(sqrtf(px * px + py * py) - r) * scale > 2.0f)
+        continue;
+      f32 u = (x + 0.5f) / scale, v = (y + 0.5f) / scale;
+      f32 texels = (bench_sdf_sample(sdf, out, out, u, v) / 255.0f - 0.5f) * R_TEX2D_SDF_RANGE;
+      f32 a_sdf = Clamp(0.0f, texels * scale + 0.5f, 1.0f);
+      f32 a_cov = bench_sdf_sample(coverage, out, out, u, v) / 255.0f;
+      f32 t = truth[y * pixels + x] / 255.0f;
+      sdf_error      += fabsf(a_sdf - t);
+      coverage_error += fabsf(a_cov - t);
+      edge += 1;
+    }
+  }
+  printf("  disc drawn %ux up, %u edge pixels: mean coverage error %.3f from the field, %.3f from bilinear coverage\n",
+         scale, edge, sdf_error / edge, coverage_error / edge);
+  Assert(sdf_error < coverage_error * 0.5);
+  temp_end(temp);
+}
+
+internal void
+bench_sdf(Arena *arena)
+{
+  bench_sdf_binary(arena, 40, 30, 4);
+  bench_sdf_binary(arena, 17, 53, 3);
+  bench_sdf_analytic(arena);
+  bench_sdf_threads(arena, 500, 4);
+  bench_sdf_scaled(arena, 6);
+}
+
+////////////////////////////////
+//~ nb: Glyph cache
+// A stub rasterizer with sizes and coverage made up from the glyph id, and
+// pages kept on the CPU so every glyph drawn in a frame can be checked
+// against what it should hold at the end of that frame.
+typedef struct BenchGlyphRasterizer BenchGlyphRasterizer;
+struct BenchGlyphRasterizer
+{
+  Glyph_Rasterizer rasterizer;
+  u8               coverage[64 * 64];
+  u32              calls;
+};
+
+#define BENCH_GLYPH_MAX_PAGES 8
+typedef struct BenchGlyphPages BenchGlyphPages;
+struct BenchGlyphPages
+{
+  Glyph_PageBackend backend;
+  u8                *texels[BENCH_GLYPH_MAX_PAGES];
+  u32               size;
+  u32               count;
+  u32               released;
+};
+
+//- nb: 0 to 63 wide and tall, every 37th glyph is blank like a space
+internal void
+bench_glyph_shape(u32 glyph, u32 *width, u32 *height)
+{
+  u64 h = (glyph + 1) * 0x9e3779b97f4a7c15ull;
+  *width  = (glyph % 37 == 0) ? 0 : 4 + (u32)((h >> 20) % 28) + (glyph % 5 == 0 ? 28 : 0);
+  *height = (glyph % 37 == 0) ? 0 : 6 + (u32)((h >> 40) % 30);
+}
+
+internal inline u8
+bench_glyph_texel(u32 glyph, u32 x, u32 y)
+{
+  return (u8)(1 + (glyph * 31 + x * 7 + y * 13) % 255);
+}
+
+internal b32
+bench_glyph_rasterize(Glyph_Rasterizer *rasterizer, Glyph_Key key, Glyph_Bitmap *bitmap)
+{
+  BenchGlyphRasterizer *stub = (BenchGlyphRasterizer*)rasterizer;
+  stub->calls += 1;
+  u32 width, height;
+  bench_glyph_shape(key.glyph, &width, &height);
+  for(u32 y = 0; y < height; y++)
+    for(u32 x = 0; x < width; x++)
+      stub->coverage[y * 64 + x] = bench_glyph_texel(key.glyph, x, y);
+  bitmap->width        = width;
+  bitmap->height       = height;
+  bitmap->pitch        = 64;
+  bitmap->coverage     = stub->coverage;
+  bitmap->left_bearing = 1;
+  bitmap->top_bearing  = 2;
+  bitmap->advance      = (s32)width + 2;
+  return 1;
+}
+
+internal R_Handle
+bench_glyph_page_alloc(Glyph_PageBackend *backend, u32 size)
+{
+  BenchGlyphPages *pages = (BenchGlyphPages*)backend;
+  Assert(pages->count < BENCH_GLYPH_MAX_PAGES);
+  pages->size = size;
+  pages->texels[pages->count] = (u8*)calloc((u64)size * size, 1);
+  R_Handle handle = {0};
+  handle.U64[0] = ++pages->count;
+  return handle;
+}
+
+internal void
+bench_glyph_page_update(Glyph_PageBackend *backend, R_Handle page, u32 x, u32 y, u32 width, u32 height, const u8 *coverage)
+{
+  BenchGlyphPages *pages = (BenchGlyphPages*)backend;
+  Assert(page.U64[0] >= 1 && page.U64[0] <= pages->count);
+  Assert(x + width <= pages->size && y + height <= pages->size);
+  u8 *texels = pages->texels[page.U64[0] - 1];
+  for(u32 row = 0; row < height; row++)
+    memcpy(texels + (u64)(y + row) * pages->size + x, coverage + (u64)row * width, width);
+}
+
+internal void
+bench_glyph_page_release(Glyph_PageBackend *backend, R_Handle page)
+{
+  BenchGlyphPages *pages = (BenchGlyphPages*)backend;
+  free(pages->texels[page.U64[0] - 1]);
+  pages->texels[page.U64[0] - 1] = 0;
+  pages->released += 1;
+}
+
+internal void
+bench_glyph_init(BenchGlyphRasterizer *stub, BenchGlyphPages *pages)
+{
+  memset(stub, 0, sizeof(*stub));
+  memset(pages, 0, sizeof(*pages));
+  stub->rasterizer.rasterize = bench_glyph_rasterize;
+  pages->backend.alloc       = bench_glyph_page_alloc;
+  pages->backend.update      = bench_glyph_page_update;
+  pages->backend.release     = bench_glyph_page_release;
+}
+
+//- nb: the slot's texels are the glyph's coverage inside a clear border
+internal void
+bench_glyph_check(BenchGlyphPages *pages, Glyph_Cache_Params *params, u32 glyph, const Glyph_Slot *slot)
+{
+  u32 width, height;
+  bench_glyph_shape(glyph, &width, &height);
+  Assert(slot->advance == (s32)width + 2);
+  if(width == 0)
+  {
+    Assert(slot->page.U64[0] == 0);
+    return;
+  }
+  Assert(slot->page.U64[0] >= 1 && slot->page.U64[0] <= pages->count);
+  Assert(slot->width == width + params->padding * 2 && slot->height == height + params->padding * 2);
+  Assert(slot->left_bearing == 1 - (s32)params->padding && slot->top_bearing == 2 - (s32)params->padding);
+  u8 *texels = pages->texels[slot->page.U64[0] - 1];
+  u32 x0 = (u32)(slot->uv_rect[0] * pages->size + 0.5f);
+  u32 y0 = (u32)(slot->uv_rect[1] * pages->size + 0.5f);
+  for(u32 y = 0; y < slot->height; y++)
+  {
+    for(u32 x = 0; x < slot->width; x++)
+    {
+      u32 p = params->padding;
+      b32 inside = x >= p && y >= p && x < p + width && y < p + height;
+      u8 expected = inside ? bench_glyph_texel(glyph, x - p, y - p) : 0;
+      Assert(texels[(u64)(y0 + y) * pages->size + x0 + x] == expected);
+    }
+  }
+}
+
+//- nb: text drawn as Zipf distributed glyphs, most frames reuse a few
+// hundred common ones and a tail keeps missing
+internal u32
+bench_glyph_zipf(u64 *rng, f64 *cdf, u32 count)
+{
+  f64 r = (bench_rand(rng) % 1000000) / 1000000.0 * cdf[count - 1];
+  u32 lo = 0, hi = count - 1;
+  while(lo < hi)
+  {
+    u32 mid = (lo + hi) / 2;
+    if(cdf[mid] < r)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+internal void
+bench_glyphcache_basic(void)
+{
+  BenchGlyphRasterizer stub;
+  BenchGlyphPages pages;
+  bench_glyph_init(&stub, &pages);
+  Glyph_Cache_Params params = glyph_cache_default_params();
+  Glyph_Cache *cache = glyph_cache_alloc(params, &stub.rasterizer, &pages.backend);
+
+  //- nb: misses once, hits after, other sizes and fonts are other glyphs
+  for(u32 pass = 0; pass < 3; pass++)
+  {
+    for(u32 glyph = 0; glyph < 500; glyph++)
+    {
+      Glyph_Key key = {glyph % 2, 48 * 64, glyph};
+      bench_glyph_check(&pages, &params, glyph, glyph_cache_get(cache, key));
+    }
+    glyph_cache_frame(cache);
+  }
+  Glyph_Key other_size = {0, 24 * 64, 10};
+  glyph_cache_get(cache, other_size);
+  Glyph_Cache_Stats stats = glyph_cache_stats(cache);
+  u32 blank = 500 / 37 + 1;
+  Assert(stats.misses == 501 && stats.hits == 1000);
+  Assert(stats.uploads == 501 - blank && stub.calls == 501);
+  Assert(stats.evictions == 0 && stats.failures == 0);
+  Assert(glyph_cache_glyph_count(cache) == 501);
+  printf("  500 glyphs: %u page(s), %.1f KiB uploaded\n", glyph_cache_page_count(cache), stats.upload_bytes / 1024.0);
+  glyph_cache_release(cache);
+  Assert(pages.released == pages.count);
+}
+
+internal void
+bench_glyphcache_churn(Arena *arena, Rect_Pack_Strategy strategy, u32 page_size, u32 max_pages, u32 max_glyphs,
+                       u32 alphabet, u32 per_frame, u32 frames)
+{
+  Temp temp = temp_begin(arena);
+  BenchGlyphRasterizer stub;
+  BenchGlyphPages pages;
+  bench_glyph_init(&stub, &pages);
+  Glyph_Cache_Params params = {page_size, max_pages, max_glyphs, 1, strategy};
+  Glyph_Cache *cache = glyph_cache_alloc(params, &stub.rasterizer, &pages.backend);
+
+  f64 *cdf = (f64*)arena_push(temp.arena, sizeof(f64) * alphabet);
+  f64 sum = 0;
+  for(u32 i = 0; i < alphabet; i++)
+  {
+    sum += 1.0 / (i + 1);
+    cdf[i] = sum;
+  }
+  u32 *frame_glyphs = (u32*)arena_push(temp.arena, sizeof(u32) * per_frame);
+  const Glyph_Slot **frame_slots = (const Glyph_Slot**)arena_push(temp.arena, sizeof(Glyph_Slot*) * per_frame);
+  u64 rng = 99;
+  u64 get_us = 0;
+  for(u32 frame = 0; frame < frames; frame++)
+  {
+    u64 begin = os_now_microseconds();
+    for(u32 i = 0; i < per_frame; i++)
+    {
+      // nb: glyph ids scattered so neighbours in rank differ in shape
+      frame_glyphs[i] = bench_glyph_zipf(&rng, cdf, alphabet) * 2654435761u % 65521;
+      Glyph_Key key = {0, 32 * 64, frame_glyphs[i]};
+      frame_slots[i] = glyph_cache_get(cache, key);
+    }
+    get_us += os_now_microseconds() - begin;
+    //- nb: nothing handed out this frame was evicted or overwritten
+    for(u32 i = 0; i < per_frame; i++)
+    {
+      if(frame_slots[i]->page.U64[0] == 0 && frame_slots[i]->width == 0 &&
+         frame_slots[i]->advance != 0 && frame_glyphs[i] % 37 != 0)
+        continue;  // no room this frame
+      bench_glyph_check(&pages, &params, frame_glyphs[i], frame_slots[i]);
+    }
+    glyph_cache_frame(cache);
+  }
+  Glyph_Cache_Stats stats = glyph_cache_stats(cache);
+  u64 gets = (u64)per_frame * frames;
+  Assert(stats.hits + stats.misses == gets);
+  Assert(glyph_cache_glyph_count(cache) <= max_glyphs && glyph_cache_page_count(cache) <= max_pages);
+  printf("  %-10s %4u x%u pages, %5u glyphs max, %5u of %5u a frame: hit %5.1f%%, %6llu evicted, %4llu page resets, %4llu failed, %7.1f ns/get\n",
+         rect_pack_strategy_string(strategy), page_size, max_pages, max_glyphs, per_frame, alphabet,
+         100.0 * stats.hits / gets, (unsigned long long)stats.evictions, (unsigned long long)stats.page_resets,
+         (unsigned long long)stats.failures, get_us * 1000.0 / gets);
+  glyph_cache_release(cache);
+  temp_end(temp);
+}
+
+//- nb: the hot path, every get a hit
+internal void
+bench_glyphcache_hits(u32 glyphs, u32 runs)
+{
+  BenchGlyphRasterizer stub;
+  BenchGlyphPages pages;
+  bench_glyph_init(&stub, &pages);
+  Glyph_Cache *cache = glyph_cache_alloc(glyph_cache_default_params(), &stub.rasterizer, &pages.backend);
+  u64 miss_begin = os_now_microseconds();
+  for(u32 glyph = 0; glyph < glyphs; glyph++)
+  {
+    Glyph_Key key = {0, 32 * 64, glyph};
+    glyph_cache_get(cache, key);
+  }
+  u64 miss_us = os_now_microseconds() - miss_begin;
+  u64 begin = os_now_microseconds();
+  u64 advance = 0;
+  for(u32 run = 0; run < runs; run++)
+  {
+    for(u32 i = 0; i < glyphs; i++)
+    {
+      Glyph_Key key = {0, 32 * 64, (i * 7919) % glyphs};
+      advance += glyph_cache_get(cache, key)->advance;
+    }
+    glyph_cache_frame(cache);
+  }
+  u64 us = os_now_microseconds() - begin;
+  Assert(glyph_cache_stats(cache).hits == (u64)glyphs * runs && advance > 0);
+  printf("  %u glyphs: miss with stub raster and upload %.2f us, hit %.1f ns\n",
+         glyphs, (f64)miss_us / glyphs, us * 1000.0 / ((f64)glyphs * runs));
+  glyph_cache_release(cache);
+}
+
+internal void
+bench_glyphcache(Arena *arena)
+{
+  bench_glyphcache_basic();
+  bench_glyphcache_hits(1000, 200);
+  //- nb: roomy, tight enough to evict, and more per frame than fits
+  bench_glyphcache_churn(arena, GLYPH_CACHE_PACKING, 1024, 4, 4096, 4000, 400, 200);
+  for(u32 strategy = 0; strategy < RECT_PACK_STRATEGY_COUNT; strategy++)
+    bench_glyphcache_churn(arena, (Rect_Pack_Strategy)strategy, 256, 2, 1024, 4000, 100, 300);
+  bench_glyphcache_churn(arena, GLYPH_CACHE_PACKING, 256, 1, 1024, 4000, 300, 100);
+}
+
+////////////////////////////////
+//~ nb: Text run cache
+// A HUD drawn for many frames: static labels, a timer that ticks every 60
+// frames and a counter that changes every frame, laid out with a stub font
+// (made up metrics, letters and digits on two textures, '~' standing in for
+// a glyph cache glyph). Every frame's quads are checked against a fresh
+// layout, and the same frames are timed with and without the cache.
+internal void
+bench_text_layout(Arena *arena, Text_Run_Key key, const char *str, Text_Run *run)
+{
+  u32 length = (u32)strlen(str);
+  R_Handle *textures = (R_Handle*)arena_push(arena, sizeof(R_Handle) * ClampBot(length, 1u));
+  run->quads   = (R_Quad*)arena_push(arena, sizeof(R_Quad) * ClampBot(length, 1u));
+  run->batches = (Text_Run_Batch*)arena_push(arena, sizeof(Text_Run_Batch) * ClampBot(length, 1u));
+  run->quad_count = run->batch_count = 0;
+  run->transient = 0;
+  f32 scale = key.size / (32.0f * 64.0f);
+  f32 cursor_x = key.x;
+  for(u32 i = 0; i < length; i++)
+  {
+    u8 c = (u8)str[i];
+    f32 advance = (8 + c % 7) * scale;
+    run->transient |= c == '~';
+    if(c != ' ')
+    {
+      R_Handle texture = {0};
+      texture.U64[0] = (c >= '0' && c <= '9') ? 2 : (c == '~') ? 3 : 1;
+      textures[run->quad_count] = texture;
+      R_Quad *quad = &run->quads[run->quad_count++];
+      quad->pos[0]  = cursor_x + (c % 3) * scale;
+      quad->pos[1]  = key.y + (c % 5) * scale;
+      quad->size[0] = advance;
+      quad->size[1] = 24 * scale;
+      quad->uv_rect[0] = (c % 16) / 16.0f;
+      quad->uv_rect[1] = (c / 16) / 16.0f;
+      quad->uv_rect[2] = quad->uv_rect[3] = 1 / 16.0f;
+    }
+    cursor_x += advance;
+  }
+  for(u32 first = 0; first < run->quad_count;)
+  {
+    u32 last = first + 1;
+    while(last < run->quad_count && textures[last].U64[0] == textures[first].U64[0])
+      last += 1;
+    Text_Run_Batch batch = {textures[first], first, last - first};
+    run->batches[run->batch_count++] = batch;
+    first = last;
+  }
+  run->advance = cursor_x - key.x;
+}
+
+//- nb: the run as r_push_quads would see it, appended to `out`
+internal u32
+bench_text_emit(const Text_Run *run, R_Quad *out, u64 *textures)
+{
+  u32 count = 0;
+  for(u32 b = 0; b < run->batch_count; b++)
+  {
+    const Text_Run_Batch *batch = &run->batches[b];
+    memcpy(out + count, run->quads + batch->first_quad, sizeof(R_Quad) * batch->quad_count);
+    for(u32 i = 0; i < batch->quad_count; i++)
+      textures[count + i] = batch->texture.U64[0];
+    count += batch->quad_count;
+  }
+  return count;
+}
+
+internal u32
+bench_text_hud(u32 frame, char lines[][64], Text_Run_Key *keys)
+{
+  const char *labels[] =
+  {
+    "Mines", "Flags", "Best time", "Games won", "Games lost", "Streak",
+    "Board 30 x 16", "Seed", "Infinite mode off", "Press R to restart", "Esc for the menu", "v0.3",
+  };
+  u32 count = 0;
+  for(u32 i = 0; i < ArrayCount(labels); i++)
+  {
+    snprintf(lines[count], 64, "%s", labels[i]);
+    Text_Run_Key key = {0, 32 * 64, 20.0f, 20.0f + i * 30.0f};
+    keys[count++] = key;
+  }
+  snprintf(lines[count], 64, "Time %u:%02u", frame / 3600, (frame / 60) % 60);
+  Text_Run_Key timer = {0, 48 * 64, 600.0f, 20.0f};
+  keys[count++] = timer;
+  snprintf(lines[count], 64, "Frame %u", frame);
+  Text_Run_Key counter = {1, 32 * 64, 600.0f, 80.0f};
+  keys[count++] = counter;
+  //- nb: never kept, its glyphs could move
+  snprintf(lines[count], 64, "~ %u", frame % 3);
+  Text_Run_Key other = {0, 32 * 64, 600.0f, 120.0f};
+  keys[count++] = other;
+  return count;
+}
+
+internal void
+bench_textcache_hud(Arena *arena, u32 frames)
+{
+  Temp temp = temp_begin(arena);
+  char lines[16][64];
+  Text_Run_Key keys[16];
+  R_Quad *expected = (R_Quad*)arena_push(temp.arena, sizeof(R_Quad) * 1024);
+  R_Quad *got      = (R_Quad*)arena_push(temp.arena, sizeof(R_Quad) * 1024);
+  u64 *expected_textures = (u64*)arena_push(temp.arena, sizeof(u64) * 1024);
+  u64 *got_textures      = (u64*)arena_push(temp.arena, sizeof(u64) * 1024);
+
+  //- nb: correctness, every frame against a fresh layout
+  Text_Cache *cache = text_cache_alloc(text_cache_default_params());
+  for(u32 frame = 0; frame < frames; frame++)
+  {
+    u32 line_count = bench_text_hud(frame, lines, keys);
+    u32 expected_count = 0, got_count = 0;
+    for(u32 i = 0; i < line_count; i++)
+    {
+      Temp line_temp = temp_begin(temp.arena);
+      Text_Run fresh = {0};
+      bench_text_layout(line_temp.arena, keys[i], lines[i], &fresh);
+      expected_count += bench_text_emit(&fresh, expected + expected_count, expected_textures + expected_count);
+      const Text_Run *run = text_cache_get(cache, keys[i], lines[i]);
+      if(!run)
+      {
+        Text_Run laid_out = {0};
+        bench_text_layout(line_temp.arena, keys[i], lines[i], &laid_out);
+        run = text_cache_put(cache, keys[i], lines[i], &laid_out);
+      }
+      Assert(run->advance == fresh.advance);
+      got_count += bench_text_emit(run, got + got_count, got_textures + got_count);
+      temp_end(line_temp);
+    }
+    Assert(got_count == expected_count);
+    Assert(memcmp(got, expected, sizeof(R_Quad) * got_count) == 0);
+    Assert(memcmp(got_textures, expected_textures, sizeof(u64) * got_count) == 0);
+    text_cache_frame(cache);
+
+    //- nb: once warm only the counter, the transient line and a ticking
+    // timer are laid out
+    Text_Cache_Stats stats = text_cache_frame_stats(cache);
+    if(frame > 0)
+    {
+      u32 tick = frame % 60 == 0;
+      Assert(stats.hits == line_count - 2 - tick);
+      Assert(stats.misses == 2 + tick);
+    }
+  }
+  Text_Cache_Stats last = text_cache_frame_stats(cache);
+  Text_Cache_Stats stats = text_cache_stats(cache);
+  // nb: the stale counters make way, the labels never go
+  Assert(stats.resets == 0 && stats.evictions > 0);
+  printf("  hud, %u frames: last frame %llu hits, %llu glyphs from the cache, %llu laid out; %u runs kept, %llu evicted\n",
+         frames, (unsigned long long)last.hits, (unsigned long long)last.glyphs_cached,
+         (unsigned long long)last.glyphs_laid_out, text_cache_run_count(cache), (unsigned long long)stats.evictions);
+  text_cache_release(cache);
+
+  //- nb: timing, the same frames laid out every time and through the
+  // cache, with the strings made up front
+  char (*frame_lines)[16][64] = (char(*)[16][64])arena_push(temp.arena, sizeof(lines) * frames);
+  u32 line_count = 0;
+  for(u32 frame = 0; frame < frames; frame++)
+    line_count = bench_text_hud(frame, frame_lines[frame], keys);
+  u64 us[2];
+  u64 sink = 0;
+  for(u32 cached = 0; cached < 2; cached++)
+  {
+    cache = text_cache_alloc(text_cache_default_params());
+    u64 begin = os_now_microseconds();
+    for(u32 frame = 0; frame < frames; frame++)
+    {
+      u32 count = 0;
+      for(u32 i = 0; i < line_count; i++)
+      {
+        Temp line_temp = temp_begin(temp.arena);
+        const char *line = frame_lines[frame][i];
+        const Text_Run *run = cached ? text_cache_get(cache, keys[i], line) : 0;
+        Text_Run laid_out = {0};
+        if(!run)
+        {
+          bench_text_layout(line_temp.arena, keys[i], line, &laid_out);
+          run = cached ? text_cache_put(cache, keys[i], line, &laid_out) : &laid_out;
+        }
+        count += bench_text_emit(run, got + count, got_textures + count);
+        temp_end(line_temp);
+      }
+      sink += count;
+      text_cache_frame(cache);
+    }
+    us[cached] = os_now_microseconds() - begin;
+    text_cache_release(cache);
+  }
+  Assert(sink > 0);
+  printf("  hud, %u frames: %.2f us a frame laid out every time, %.2f us through the cache\n",
+         frames, (f64)us[0] / frames, (f64)us[1] / frames);
+  temp_end(temp);
+}
+
+//- nb: more strings than runs, and a data budget too small for all of them
+internal void
+bench_textcache_churn(Arena *arena, u32 max_runs, u64 max_bytes, u32 strings, u32 per_frame, u32 frames)
+{
+  Temp temp = temp_begin(arena);
+  Text_Cache_Params params = {max_runs, max_bytes};
+  Text_Cache *cache = text_cache_alloc(params);
+  u64 rng = 99;
+  char str[64];
+  for(u32 frame = 0; frame < frames; frame++)
+  {
+    for(u32 i = 0; i < per_frame; i++)
+    {
+      u32 pick = bench_rand(&rng) % strings;
+      u32 length = 1 + pick % 40;
+      for(u32 c = 0; c < length; c++)
+        str[c] = (char)('a' + (pick * 31 + c * 7) % 26);
+      str[length] = 0;
+      Text_Run_Key key = {pick % 3, 32 * 64, 10.0f * (pick % 5), 5.0f};
+      Temp line_temp = temp_begin(temp.arena);
+      Text_Run fresh = {0};
+      bench_text_layout(line_temp.arena, key, str, &fresh);
+      const Text_Run *run = text_cache_get(cache, key, str);
+      if(!run)
+        run = text_cache_put(cache, key, str, &fresh);
+      Assert(run->quad_count == fresh.quad_count && run->batch_count == fresh.batch_count);
+      Assert(memcmp(run->quads, fresh.quads, sizeof(R_Quad) * fresh.quad_count) == 0);
+      Assert(memcmp(run->batches, fresh.batches, sizeof(Text_Run_Batch) * fresh.batch_count) == 0);
+      temp_end(line_temp);
+    }
+    Assert(text_cache_run_count(cache) <= max_runs);
+    text_cache_frame(cache);
+  }
+  Text_Cache_Stats stats = text_cache_stats(cache);
+  u64 gets = stats.hits + stats.misses;
+  printf("  %4u runs, %6.1f KiB: %u strings, %u a frame: hit %5.1f%%, %llu evicted, %llu resets\n",
+         max_runs, max_bytes / 1024.0, strings, per_frame, 100.0 * stats.hits / gets,
+         (unsigned long long)stats.evictions, (unsigned long long)stats.resets);
+  text_cache_release(cache);
+  temp_end(temp);
+}
+
+internal void
+bench_textcache(Arena *arena)
+{
+  bench_textcache_hud(arena, 600);
+  bench_textcache_churn(arena, TEXT_CACHE_MAX_RUNS, TEXT_CACHE_MAX_BYTES, 200, 50, 200);
+  bench_textcache_churn(arena, 32, TEXT_CACHE_MAX_BYTES, 200, 20, 200);
+  bench_textcache_churn(arena, TEXT_CACHE_MAX_RUNS, 16 << 10, 200, 50, 200);
+}
+
+////////////////////////////////
+//~ nb: Entry point
+global Bench benches[] =
+{
+  {"play",  bench_play},
+  {"tiles", bench_tiles},
+  {"counts", bench_counts},
+  {"fill", bench_fill},
+  {"place", bench_place},
+  {"openings", bench_openings},
+  {"reveal", bench_reveal},
+  {"chunks", bench_chunks},
+  {"changes", bench_changes},
+  {"upload", bench_upload},
+  {"tilegrid", bench_tilegrid},
+  {"cull", bench_cull},
+  {"cmdlist", bench_cmdlist},
+  {"ring", bench_ring},
+  {"pyramid", bench_pyramid},
+  {"soft", bench_soft},
+  {"tilemap", bench_tilemap},
+  {"formats", bench_formats},
+  {"bc", bench_bc},
+  {"fontcache", bench_fontcache},
+  {"rectpack", bench_rectpack},
+  {"glyphcache", bench_glyphcache},
+  {"sdf", bench_sdf},
+  {"textcache", bench_textcache},
+};
+
+int
+main(int argc, char **argv)
+{
+  Arena *arena = arena_alloc();
+  for(u32 i = 0; i < ArrayCount(benches); i++)
+  {
+    b32 selected = (argc <= 1);
+    for(int arg = 1; arg < argc; arg++)
+    {
+      if(strcmp(argv[arg], benches[i].name) == 0)
+        selected = 1;
+    }
+    if(!selected)
+      continue;
+
+    printf("%s:\n", benches[i].name);
+    Temp temp = temp_begin(arena);
+    benches[i].func(arena);
+    temp_end(temp);
+  }
+  arena_release(arena);
+  return 0;
+}
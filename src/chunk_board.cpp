@@ -0,0 +1,446 @@
+#include "chunk_board.h"
+
+#define CHUNK_BOARD_RESERVE_SIZE Gigabytes(64)
+#define CHUNK_BOARD_FIRST_SLOTS  1024
+#define CHUNK_MASK               (CHUNK_SIZE - 1)
+
+internal BoardChunk *chunk_board_get(ChunkBoard *board, s64 chunk_x, s64 chunk_y);
+internal b32  chunk_board_reveal_tile(ChunkBoard *board, s64 tile_x, s64 tile_y);
+internal void chunk_board_fill_run(ChunkBoard *board);
+
+////////////////////////////////
+//~ nb: Mine layout
+// Every row gets its own key, every tile in it is one counter of that key.
+// The first sweep's 3x3 is cleared on top, once it is known.
+internal u64
+chunk_board_mine_bits(ChunkBoard *board, s64 tile_y, s64 tile_x, u32 count)
+{
+  u64 row_key = rng_hash_u64(board->seed, (u64)tile_y);
+  u64 bits = 0;
+  for(u32 i = 0; i < count; i++)
+  {
+    u64 hash = rng_hash_u64(row_key, (u64)(tile_x + i));
+    bits |= (u64)((hash >> 11) < board->mine_threshold) << i;
+  }
+  if(board->mines_placed && tile_y >= board->safe_y - 1 && tile_y <= board->safe_y + 1)
+  {
+    for(s64 x = board->safe_x - 1; x <= board->safe_x + 1; x++)
+    {
+      if(x >= tile_x && x < tile_x + count)
+        bits &= ~(1ull << (x - tile_x));
+    }
+  }
+  return bits;
+}
+
+b32
+chunk_board_is_mine(ChunkBoard *board, s64 tile_x, s64 tile_y)
+{
+  return (b32)(chunk_board_mine_bits(board, tile_y, tile_x, 1) & 1);
+}
+
+//- nb: Mines, zero tiles and neighbor counts of one chunk. The counts need
+// a one tile apron around the chunk, which comes straight from the hash, so
+// the neighboring chunks don't have to exist. Reuses the board's count
+// kernel on 66 byte rows.
+internal void
+chunk_board_build_chunk(ChunkBoard *board, BoardChunk *chunk)
+{
+  s64 x0 = chunk->chunk_x * CHUNK_SIZE;
+  s64 y0 = chunk->chunk_y * CHUNK_SIZE;
+
+  // nb: byte i of a row is tile x0 - 1 + i, padded for whole vector loads
+  u8 mine_rows[CHUNK_SIZE + 2][CHUNK_SIZE * 2];
+  u8 sum_rows[CHUNK_SIZE + 2][CHUNK_SIZE * 2];
+  memset(mine_rows, 0, sizeof(mine_rows));
+  for(u32 r = 0; r < CHUNK_SIZE + 2; r++)
+  {
+    s64 tile_y = y0 - 1 + r;
+    u64 center = chunk_board_mine_bits(board, tile_y, x0, CHUNK_SIZE);
+    if(r >= 1 && r <= CHUNK_SIZE)
+      chunk->mine_plane[r - 1] = center;
+    u8 *row = mine_rows[r];
+    board_expand_bits(&center, 1, row + 1);
+    row[0]              = (u8)chunk_board_mine_bits(board, tile_y, x0 - 1, 1);
+    row[CHUNK_SIZE + 1] = (u8)chunk_board_mine_bits(board, tile_y, x0 + CHUNK_SIZE, 1);
+    board_add3(sum_rows[r], row, row + 1, row + 2, CHUNK_SIZE);
+  }
+
+  for(u32 r = 0; r < CHUNK_SIZE; r++)
+  {
+    u8 *counts = chunk->neighbor_counts + r * CHUNK_SIZE;
+    board_count_row(counts, sum_rows[r], sum_rows[r + 1], sum_rows[r + 2], mine_rows[r + 1] + 1, CHUNK_SIZE);
+    u64 zeros = 0;
+    for(u32 x = 0; x < CHUNK_SIZE; x++)
+    {
+      zeros |= (u64)(counts[x] == 0) << x;
+    }
+    chunk->zero_plane[r] = zeros & ~chunk->mine_plane[r];
+  }
+}
+
+////////////////////////////////
+//~ nb: Chunk map
+internal inline u64
+chunk_board_slot_hash(s64 chunk_x, s64 chunk_y)
+{
+  return rng_hash_u64((u64)chunk_x, (u64)chunk_y);
+}
+
+internal BoardChunk *
+chunk_board_find(ChunkBoard *board, s64 chunk_x, s64 chunk_y)
+{
+  u64 mask = board->chunk_slot_count - 1;
+  for(u64 slot = chunk_board_slot_hash(chunk_x, chunk_y) & mask;; slot = (slot + 1) & mask)
+  {
+    BoardChunk *chunk = board->chunk_slots[slot];
+    if(chunk == 0 || (chunk->chunk_x == chunk_x && chunk->chunk_y == chunk_y))
+      return chunk;
+  }
+}
+
+internal void
+chunk_board_insert(ChunkBoard *board, BoardChunk *chunk)
+{
+  u64 mask = board->chunk_slot_count - 1;
+  u64 slot = chunk_board_slot_hash(chunk->chunk_x, chunk->chunk_y) & mask;
+  while(board->chunk_slots[slot] != 0)
+  {
+    slot = (slot + 1) & mask;
+  }
+  board->chunk_slots[slot] = chunk;
+}
+
+//- nb: finds a chunk, materializing it on first touch
+internal BoardChunk *
+chunk_board_get(ChunkBoard *board, s64 chunk_x, s64 chunk_y)
+{
+  BoardChunk *chunk = chunk_board_find(board, chunk_x, chunk_y);
+  if(chunk)
+    return chunk;
+
+  //- nb: keep the map at most half full
+  if((board->chunk_count + 1) * 2 > board->chunk_slot_count)
+  {
+    BoardChunk **old_slots = board->chunk_slots;
+    u64 old_slot_count = board->chunk_slot_count;
+    board->chunk_slot_count *= 2;
+    board->chunk_slots = (BoardChunk**)arena_push(board->arena, sizeof(BoardChunk*) * board->chunk_slot_count);
+    memset(board->chunk_slots, 0, sizeof(BoardChunk*) * board->chunk_slot_count);
+    for(u64 i = 0; i < old_slot_count; i++)
+    {
+      if(old_slots[i])
+        chunk_board_insert(board, old_slots[i]);
+    }
+  }
+
+  chunk = (BoardChunk*)arena_push(board->arena, sizeof(BoardChunk));
+  memset(chunk, 0, sizeof(BoardChunk));
+  chunk->chunk_x = chunk_x;
+  chunk->chunk_y = chunk_y;
+  chunk_board_build_chunk(board, chunk);
+  chunk_board_insert(board, chunk);
+  board->chunk_count += 1;
+  return chunk;
+}
+
+////////////////////////////////
+//~ nb: Board functions
+ChunkBoard *
+chunk_board_alloc(void)
+{
+  Arena *arena = arena_alloc_reserve(CHUNK_BOARD_RESERVE_SIZE);
+  ChunkBoard *board = (ChunkBoard*)arena_push(arena, sizeof(ChunkBoard));
+  memset(board, 0, sizeof(ChunkBoard));
+  board->arena = arena;
+  board->arena_reset_pos = arena->pos;
+  return board;
+}
+
+void
+chunk_board_release(ChunkBoard *board)
+{
+  arena_release(board->arena);
+}
+
+void
+chunk_board_reset(ChunkBoard *board, f64 mine_density, u64 seed)
+{
+  arena_pop_to(board->arena, board->arena_reset_pos);
+
+  board->is_playable      = 1;
+  board->mines_placed     = 0;
+  board->seed             = seed;
+  board->mine_density     = Clamp(CHUNK_BOARD_MIN_DENSITY, mine_density, CHUNK_BOARD_MAX_DENSITY);
+  board->mine_threshold   = (u64)(board->mine_density * 9007199254740992.0);
+  board->safe_x           = 0;
+  board->safe_y           = 0;
+  board->has_exploded     = 0;
+  board->swept_count      = 0;
+  board->flag_count       = 0;
+  board->fill_first       = 0;
+  board->fill_last        = 0;
+  board->chunk_count      = 0;
+  board->chunk_slot_count = CHUNK_BOARD_FIRST_SLOTS;
+  board->chunk_slots      = (BoardChunk**)arena_push(board->arena, sizeof(BoardChunk*) * board->chunk_slot_count);
+  memset(board->chunk_slots, 0, sizeof(BoardChunk*) * board->chunk_slot_count);
+}
+
+b32
+chunk_board_sweep(ChunkBoard *board, s64 tile_x, s64 tile_y)
+{
+  if(!board->is_playable)
+    return 0;
+
+  // nb: first sweep protection. Chunks flagged before it were built without
+  // the safe area, so build them again.
+  if(!board->mines_placed)
+  {
+    board->safe_x = tile_x;
+    board->safe_y = tile_y;
+    board->mines_placed = 1;
+    for(u64 i = 0; i < board->chunk_slot_count; i++)
+    {
+      if(board->chunk_slots[i])
+        chunk_board_build_chunk(board, board->chunk_slots[i]);
+    }
+  }
+  b32 hit_mine = chunk_board_reveal_tile(board, tile_x, tile_y);
+  if(hit_mine)
+  {
+    chunk_board_gameover(board);
+  }
+  return hit_mine;
+}
+
+void
+chunk_board_toggle_flag(ChunkBoard *board, s64 tile_x, s64 tile_y)
+{
+  if(!board->is_playable)
+    return;
+
+  BoardChunk *chunk = chunk_board_get(board, tile_x >> CHUNK_SIZE_LOG2, tile_y >> CHUNK_SIZE_LOG2);
+  u32 row = (u32)(tile_y & CHUNK_MASK);
+  u64 bit = 1ull << (tile_x & CHUNK_MASK);
+  // nb: Don't allow a flag to be placed on a swept tile
+  if(chunk->swept_plane[row] & bit)
+    return;
+  if(chunk->flag_plane[row] & bit)
+    board->flag_count -= 1;
+  else
+    board->flag_count += 1;
+  chunk->flag_plane[row] ^= bit;
+}
+
+void
+chunk_board_gameover(ChunkBoard *board)
+{
+  // nb: Reveal the mines of every chunk that exists, the rest were never seen
+  for(u64 i = 0; i < board->chunk_slot_count; i++)
+  {
+    BoardChunk *chunk = board->chunk_slots[i];
+    if(chunk == 0)
+      continue;
+    for(u32 r = 0; r < CHUNK_SIZE; r++)
+    {
+      chunk->swept_plane[r] |= chunk->mine_plane[r];
+    }
+  }
+  board->is_playable = 0;
+}
+
+Tile
+chunk_board_tile(ChunkBoard *board, s64 tile_x, s64 tile_y)
+{
+  Tile tile = 0;
+  chunk_board_tile_row(board, tile_y, tile_x, 1, &tile);
+  return tile;
+}
+
+void
+chunk_board_tile_row(ChunkBoard *board, s64 tile_y, s64 tile_x, u32 count, Tile *out)
+{
+  s64 chunk_y = tile_y >> CHUNK_SIZE_LOG2;
+  u32 row = (u32)(tile_y & CHUNK_MASK);
+  for(u32 i = 0; i < count;)
+  {
+    s64 x = tile_x + i;
+    u32 local_x = (u32)(x & CHUNK_MASK);
+    u32 run = ClampTop(CHUNK_SIZE - local_x, count - i);
+    BoardChunk *chunk = chunk_board_find(board, x >> CHUNK_SIZE_LOG2, chunk_y);
+    if(chunk == 0)
+    {
+      // nb: untouched, hidden
+      memset(out + i, 0, run);
+    }
+    else
+    {
+      u8 *counts = chunk->neighbor_counts + row * CHUNK_SIZE;
+      for(u32 lx = local_x; lx < local_x + run; lx++)
+      {
+        Tile tile = counts[lx];
+        tile |= (Tile)(((chunk->mine_plane[row]  >> lx) & 1) << 4);
+        tile |= (Tile)(((chunk->flag_plane[row]  >> lx) & 1) << 5);
+        tile |= (Tile)(((chunk->swept_plane[row] >> lx) & 1) << 6);
+        out[i + lx - local_x] = tile;
+      }
+    }
+    i += run;
+  }
+  if(board->has_exploded && board->exploded_y == tile_y &&
+     board->exploded_x >= tile_x && board->exploded_x < tile_x + count)
+  {
+    out[board->exploded_x - tile_x] |= TILE_BIT_EXPLODED;
+  }
+}
+
+////////////////////////////////
+//~ nb: Sweeping
+//- nb: sweeps the hidden, unflagged tiles in `mask` of one chunk row, zero
+// tiles among them are queued to spread
+internal void
+chunk_board_sweep_bits(ChunkBoard *board, BoardChunk *chunk, u32 row, u64 mask)
+{
+  u64 fresh = mask & ~(chunk->swept_plane[row] | chunk->flag_plane[row] | chunk->mine_plane[row]);
+  if(fresh == 0)
+    return;
+  chunk->swept_plane[row] |= fresh;
+  board->swept_count += count_bits_u64(fresh);
+  u64 zeros = fresh & chunk->zero_plane[row];
+  if(zeros == 0)
+    return;
+  chunk->fill_pending[row] |= zeros;
+  if(!chunk->fill_queued)
+  {
+    chunk->fill_queued = 1;
+    chunk->fill_next = 0;
+    if(board->fill_last)
+      board->fill_last->fill_next = chunk;
+    else
+      board->fill_first = chunk;
+    board->fill_last = chunk;
+  }
+}
+
+internal b32
+chunk_board_reveal_tile(ChunkBoard *board, s64 tile_x, s64 tile_y)
+{
+  BoardChunk *chunk = chunk_board_get(board, tile_x >> CHUNK_SIZE_LOG2, tile_y >> CHUNK_SIZE_LOG2);
+  u32 row = (u32)(tile_y & CHUNK_MASK);
+  u32 local_x = (u32)(tile_x & CHUNK_MASK);
+  u64 bit = 1ull << local_x;
+
+  // nb: Disallow a flagged tile from being swept
+  if(chunk->flag_plane[row] & bit)
+    return 0;
+
+  if(chunk->mine_plane[row] & bit)
+  {
+    chunk->swept_plane[row] |= bit;
+    board->has_exploded = 1;
+    board->exploded_x = tile_x;
+    board->exploded_y = tile_y;
+    return 1;
+  }
+
+  if(!(chunk->swept_plane[row] & bit))
+  {
+    chunk_board_sweep_bits(board, chunk, row, bit);
+  }
+  else
+  {
+    // Nothing to chord
+    u32 neighbor_count = chunk->neighbor_counts[row * CHUNK_SIZE + local_x];
+    if(neighbor_count == 0)
+      return 0;
+
+    //- nb: Chording, same rule as the fixed board
+    u32 flag_count = 0;
+    for(s64 dy = -1; dy <= 1; dy++)
+    {
+      for(s64 dx = -1; dx <= 1; dx++)
+      {
+        if(chunk_board_tile(board, tile_x + dx, tile_y + dy) & TILE_BIT_FLAG)
+          flag_count += 1;
+      }
+    }
+    if(flag_count == neighbor_count)
+    {
+      for(s64 dy = -1; dy <= 1; dy++)
+      {
+        for(s64 dx = -1; dx <= 1; dx++)
+        {
+          Tile tile = chunk_board_tile(board, tile_x + dx, tile_y + dy);
+          if(!(tile & (TILE_BIT_SWEPT | TILE_BIT_FLAG)))
+          {
+            if(chunk_board_reveal_tile(board, tile_x + dx, tile_y + dy))
+              return 1;
+          }
+        }
+      }
+    }
+  }
+
+  ////////////////////////////////
+  //- nb: Flood fill
+  chunk_board_fill_run(board);
+  return 0;
+}
+
+////////////////////////////////
+//~ nb: Flood fill
+// Works a chunk row at a time. The pending zero tiles of a row spread to the
+// row itself and the rows above and below as one shifted mask; bits that
+// fall off an edge of the chunk go to the matching neighbor, which gets
+// materialized if needed and queued if it gains pending tiles in turn.
+
+internal BoardChunk *
+chunk_board_fill_neighbor(ChunkBoard *board, BoardChunk *around[3][3], u32 ny, u32 nx)
+{
+  if(around[ny][nx] == 0)
+  {
+    BoardChunk *center = around[1][1];
+    around[ny][nx] = chunk_board_get(board, center->chunk_x + nx - 1, center->chunk_y + ny - 1);
+  }
+  return around[ny][nx];
+}
+
+internal void
+chunk_board_fill_run(ChunkBoard *board)
+{
+  while(board->fill_first)
+  {
+    // nb: Pop a chunk
+    BoardChunk *chunk = board->fill_first;
+    board->fill_first = chunk->fill_next;
+    if(board->fill_first == 0)
+      board->fill_last = 0;
+    chunk->fill_queued = 0;
+
+    BoardChunk *around[3][3] = {0};
+    around[1][1] = chunk;
+    for(u32 r = 0; r < CHUNK_SIZE; r++)
+    {
+      u64 pending = chunk->fill_pending[r];
+      if(pending == 0)
+        continue;
+      chunk->fill_pending[r] = 0;
+
+      u64 span = pending | (pending << 1) | (pending >> 1);
+      // nb: tile 0 of the chunk to the east, tile 63 of the one to the west
+      u64 east = pending >> (CHUNK_SIZE - 1);
+      u64 west = pending << (CHUNK_SIZE - 1);
+      for(s32 dy = -1; dy <= 1; dy++)
+      {
+        s32 y = (s32)r + dy;
+        u32 ny = y < 0 ? 0 : (y >= CHUNK_SIZE ? 2 : 1);
+        u32 target_row = (u32)y & CHUNK_MASK;
+        chunk_board_sweep_bits(board, chunk_board_fill_neighbor(board, around, ny, 1), target_row, span);
+        if(east)
+          chunk_board_sweep_bits(board, chunk_board_fill_neighbor(board, around, ny, 2), target_row, east);
+        if(west)
+          chunk_board_sweep_bits(board, chunk_board_fill_neighbor(board, around, ny, 0), target_row, west);
+      }
+    }
+  }
+}
@@ -0,0 +1,99 @@
+#ifndef CHUNK_BOARD_H
+#define CHUNK_BOARD_H
+
+////////////////////////////////
+//~ nb: Chunked board
+// Unbounded board mode. Tiles are addressed by signed 64-bit coordinates
+// and grouped into 64x64 chunks that only exist once a sweep, flag or flood
+// fill touches them. Whether a tile is a mine is a pure function of the seed
+// and its coordinates (see chunk_board_is_mine), so chunks nobody touched
+// cost nothing and memory grows with the explored area only.
+// Lives next to the board core and uses the same packed Tile format.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHUNK_SIZE_LOG2   6
+#define CHUNK_SIZE        (1 << CHUNK_SIZE_LOG2)
+// nb: below this the zero regions can go on forever and a single click
+// would flood the whole plane, so densities get clamped up to it
+#define CHUNK_BOARD_MIN_DENSITY 0.15
+#define CHUNK_BOARD_MAX_DENSITY 0.90
+
+typedef struct BoardChunk BoardChunk;
+struct BoardChunk
+{
+  s64           chunk_x;
+  s64           chunk_y;
+
+  ////////////////////////////////
+  // nb: One u64 per row, bit x is tile x of the chunk
+  u64           mine_plane[CHUNK_SIZE];
+  u64           flag_plane[CHUNK_SIZE];
+  u64           swept_plane[CHUNK_SIZE];
+  // nb: tiles without mines around them (and not mines themselves)
+  u64           zero_plane[CHUNK_SIZE];
+  // nb: swept zero tiles that still have to spread during a flood fill
+  u64           fill_pending[CHUNK_SIZE];
+  u8            neighbor_counts[CHUNK_SIZE * CHUNK_SIZE];
+
+  // nb: flood fill work list
+  BoardChunk    *fill_next;
+  b32           fill_queued;
+};
+
+typedef struct ChunkBoard ChunkBoard;
+struct ChunkBoard
+{
+  Arena         *arena;
+  // nb: everything pushed past this point is thrown away on reset
+  u64           arena_reset_pos;
+
+  ////////////////////////////////
+  // nb: Open addressing chunk map, keyed by chunk coordinates. Kept at most
+  // half full, outgrown tables are left behind in the arena.
+  BoardChunk    **chunk_slots;
+  u64           chunk_slot_count;
+  u64           chunk_count;
+
+  BoardChunk    *fill_first;
+  BoardChunk    *fill_last;
+
+  ////////////////////////////////
+  // nb: Variables
+  b32           is_playable;
+  b32           mines_placed;
+  u64           seed;
+  f64           mine_density;
+  // nb: a tile is a mine if the top 53 bits of its hash are below this
+  u64           mine_threshold;
+  // nb: the 3x3 around the first sweep never has a mine
+  s64           safe_x;
+  s64           safe_y;
+  b32           has_exploded;
+  s64           exploded_x;
+  s64           exploded_y;
+  u64           swept_count;
+  u64           flag_count;
+};
+
+ChunkBoard *chunk_board_alloc(void);
+void        chunk_board_release(ChunkBoard *board);
+void        chunk_board_reset(ChunkBoard *board, f64 mine_density, u64 seed);
+
+// nb: Same rules as board_sweep/board_toggle_flag, on unbounded coordinates.
+b32         chunk_board_sweep(ChunkBoard *board, s64 tile_x, s64 tile_y);
+void        chunk_board_toggle_flag(ChunkBoard *board, s64 tile_x, s64 tile_y);
+void        chunk_board_gameover(ChunkBoard *board);
+
+// nb: Queries, these never create chunks.
+b32         chunk_board_is_mine(ChunkBoard *board, s64 tile_x, s64 tile_y);
+Tile        chunk_board_tile(ChunkBoard *board, s64 tile_x, s64 tile_y);
+void        chunk_board_tile_row(ChunkBoard *board, s64 tile_y, s64 tile_x, u32 count, Tile *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CHUNK_BOARD_H
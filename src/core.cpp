@@ -0,0 +1,1539 @@
+#include "core.h"
+
+#if defined(__AVX2__)
+# include <immintrin.h>
+# define BOARD_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+# include <emmintrin.h>
+# define BOARD_SIMD_SSE2 1
+#endif
+
+#define BOARD_RESERVE_SIZE Gigabytes(64)
+// nb: every row buffer of the count kernel is padded to this, so the
+// vector loops never need a scalar tail
+#define BOARD_ROW_ALIGN    64
+// nb: mine placement work unit, in allowed tiles. Fixed so the layout does
+// not depend on the thread count; 2^18 bits of mine plane stay in L2.
+#define BOARD_PLACE_CHUNK_TILES (1u << 18)
+#define BOARD_PLACE_MAX_THREADS 64
+// nb: clicks that can wait for one reveal, far more than a player makes
+#define BOARD_DEFERRED_ACTIONS_MAX 256
+
+internal void board_get_neighbors(Board *board, u32 tile_x, u32 tile_y, u32 neighbor_idx_list[8], u32 *neighbor_idx_list_count);
+internal void board_get_neighbors_by_idx(Board *board, u32 idx, u32 neighbor_idx_list[8], u32 *neighbor_idx_list_count);
+internal void board_place_mines(Board *board, u32 safe_idx);
+internal b32  board_reveal_tile_by_idx(Board *board, u32 idx);
+internal void board_fill_push(Board *board, u32 tile_x, u32 tile_y);
+internal void board_fill_row(Board *board);
+internal u32  board_opening_from_xy(Board *board, u32 tile_x, u32 tile_y);
+enum BoardPaint
+{
+  BOARD_PAINT_SET,
+  BOARD_PAINT_CLEAR,
+  // nb: set and record, for the swept plane
+  BOARD_PAINT_REVEAL,
+};
+internal u32  board_paint_run(Board *board, BoardRun *run, u64 *plane, u64 *skip, BoardPaint paint);
+internal u32  board_paint_opening(Board *board, u32 opening, u64 *plane, u64 *skip, BoardPaint paint);
+internal void board_reveal_opening(Board *board, u32 opening);
+internal b32  board_reveal_step_from(Board *board, u32 start_swept, u64 start_us);
+
+////////////////////////////////
+//~ nb: Bit-plane helpers
+internal inline u64 *
+board_plane_word(Board *board, u64 *plane, u32 idx, u64 *mask)
+{
+  u32 tile_x = idx % board->columns;
+  u32 tile_y = idx / board->columns;
+  *mask = 1ull << (tile_x & 63);
+  return &plane[(u64)tile_y * board->words_per_row + (tile_x >> 6)];
+}
+
+internal inline b32
+board_test(Board *board, u64 *plane, u32 idx)
+{
+  u64 mask;
+  u64 *word = board_plane_word(board, plane, idx, &mask);
+  return (*word & mask) != 0;
+}
+
+internal inline void
+board_set(Board *board, u64 *plane, u32 idx)
+{
+  u64 mask;
+  u64 *word = board_plane_word(board, plane, idx, &mask);
+  *word |= mask;
+}
+
+internal inline void
+board_toggle(Board *board, u64 *plane, u32 idx)
+{
+  u64 mask;
+  u64 *word = board_plane_word(board, plane, idx, &mask);
+  *word ^= mask;
+}
+
+////////////////////////////////
+//~ nb: Change records
+void
+board_changes_begin(Board *board, BoardChangeList *list, Arena *arena)
+{
+  list->arena    = arena;
+  list->records  = 0;
+  list->count    = 0;
+  list->capacity = 0;
+  board->changes = list;
+}
+
+void
+board_changes_end(Board *board)
+{
+  board->changes = 0;
+}
+
+//- nb: appends a run, or grows the last one if it continues it
+internal void
+board_record_change(Board *board, u32 first_idx, u32 run_length, Tile old_state, Tile new_state)
+{
+  BoardChangeList *list = board->changes;
+  if(list->count > 0)
+  {
+    BoardChange *last = &list->records[list->count - 1];
+    if(last->first_idx + last->run_length == first_idx &&
+       last->old_state == old_state && last->new_state == new_state)
+    {
+      last->run_length += run_length;
+      return;
+    }
+  }
+  if(list->count == list->capacity)
+  {
+    u64 capacity = list->capacity ? list->capacity * 2 : 256;
+    // nb: nothing was pushed after the records, grow them in place
+    Arena *arena = list->arena;
+    if(list->records && (u8*)(list->records + list->capacity) == (u8*)arena + arena->pos)
+    {
+      arena_push(arena, sizeof(BoardChange) * (capacity - list->capacity));
+    }
+    else
+    {
+      BoardChange *records = (BoardChange*)arena_push(arena, sizeof(BoardChange) * capacity);
+      if(list->count)
+        memcpy(records, list->records, sizeof(BoardChange) * list->count);
+      list->records = records;
+    }
+    list->capacity = capacity;
+  }
+  BoardChange *change = &list->records[list->count++];
+  change->first_idx  = first_idx;
+  change->run_length = run_length;
+  change->old_state  = old_state;
+  change->new_state  = new_state;
+}
+
+//- nb: one record per run of set bits in word `w` of row `tile_y`
+internal void
+board_record_bits(Board *board, u32 tile_y, u32 w, u64 bits, Tile old_state, Tile new_state)
+{
+  u32 row_idx = tile_y * board->columns + w * 64;
+  while(bits)
+  {
+    u32 start = ctz_u64(bits);
+    u64 rest  = ~(bits >> start);
+    u32 length = rest ? ctz_u64(rest) : 64 - start;
+    board_record_change(board, row_idx + start, length, old_state, new_state);
+    bits &= (length + start >= 64) ? 0 : (~0ull << (start + length));
+  }
+}
+
+////////////////////////////////
+//~ nb: Helper functions
+internal void
+board_get_neighbors_by_idx(Board *board, u32 idx, u32 neighbor_idx_list[8], u32 *neighbor_idx_list_count)
+{
+  u32 tile_x = idx % board->columns;
+  u32 tile_y = idx / board->columns;
+  board_get_neighbors(board, tile_x, tile_y, neighbor_idx_list, neighbor_idx_list_count);
+}
+
+////////////////////////////////
+// nb: This table shows the corresponding 1D array neighbor mappings
+//       1D ARRAY                2D ARRAY
+// [-W -1] [-W] [-W +1]  [-1, -1] [0, -1] [1, -1]
+// [   -1] [ n] [   +1]  [-1,  0] [    n] [1,  0]
+// [+W -1] [+W] [+W +1]  [-1,  1] [0,  1] [1,  1]
+////////////////////////////////
+internal void
+board_get_neighbors(Board *board, u32 tile_x, u32 tile_y, u32 neighbor_idx_list[8], u32 *neighbor_idx_list_count)
+{
+  u32 count = 0;
+
+  for(s32 dy = -1; dy <= 1; dy++)
+  {
+    for(s32 dx = -1; dx <= 1; dx++)
+    {
+      // nb: skip current tile
+      if(dx == 0 && dy == 0)
+        continue;
+
+      s64 nx = (s64)tile_x + dx;
+      s64 ny = (s64)tile_y + dy;
+
+      // nb: bounds check
+      if(nx >= 0 && nx < board->columns && ny >= 0 && ny < board->rows)
+      {
+        u32 neighbor_idx = (u32)ny * board->columns + (u32)nx;
+        neighbor_idx_list[count] = neighbor_idx;
+        count++;
+      }
+    }
+  }
+  *neighbor_idx_list_count = count;
+}
+
+u32
+board_idx_from_xy(Board *board, u32 tile_x, u32 tile_y)
+{
+  if(tile_x >= board->columns || tile_y >= board->rows)
+    return BOARD_IDX_NIL;
+  return tile_y * board->columns + tile_x;
+}
+
+Tile
+board_tile(Board *board, u32 idx)
+{
+  Assert(idx < board->tiles_count);
+  u64 mask;
+  u64 *mine = board_plane_word(board, board->mine_plane, idx, &mask);
+  u64 word_offset = mine - board->mine_plane;
+  Tile tile = board->neighbor_counts[idx];
+  if(*mine & mask)                            tile |= TILE_BIT_MINE;
+  if(board->flag_plane[word_offset] & mask)   tile |= TILE_BIT_FLAG;
+  if(board->swept_plane[word_offset] & mask)  tile |= TILE_BIT_SWEPT;
+  if(idx == board->exploded_idx)              tile |= TILE_BIT_EXPLODED;
+  return tile;
+}
+
+void
+board_tile_row(Board *board, u32 tile_y, u32 tile_x, u32 count, Tile *out)
+{
+  Assert(tile_y < board->rows && tile_x + count <= board->columns);
+  u64 row_offset = (u64)tile_y * board->words_per_row;
+  u32 row_start  = tile_y * board->columns;
+  u8 *counts     = board->neighbor_counts + row_start;
+  for(u32 x = tile_x; x < tile_x + count; x++)
+  {
+    u32 shift = x & 63;
+    u64 w = row_offset + (x >> 6);
+    Tile tile = counts[x];
+    tile |= (Tile)(((board->mine_plane[w]  >> shift) & 1) << 4);
+    tile |= (Tile)(((board->flag_plane[w]  >> shift) & 1) << 5);
+    tile |= (Tile)(((board->swept_plane[w] >> shift) & 1) << 6);
+    out[x - tile_x] = tile;
+  }
+  u32 exploded_idx = board->exploded_idx;
+  if(exploded_idx != BOARD_IDX_NIL && exploded_idx >= row_start + tile_x && exploded_idx < row_start + tile_x + count)
+  {
+    out[exploded_idx - row_start - tile_x] |= TILE_BIT_EXPLODED;
+  }
+}
+
+////////////////////////////////
+//~ nb: Neighbor count kernel
+// Mines are expanded row by row into 0/1 bytes. A horizontal pass adds each
+// row to itself shifted by one to the left and right, a vertical pass then
+// adds three of those sums and subtracts the center. All rows are padded so
+// the loops always run in whole vectors.
+
+//- nb: bits of one plane row -> one byte per bit
+internal void
+board_expand_bits(u64 *words, u32 word_count, u8 *out)
+{
+  for(u32 w = 0; w < word_count; w++)
+  {
+    u64 bits = words[w];
+    u8 *dst = out + w * 64;
+    if(bits == 0)
+    {
+      memset(dst, 0, 64);
+      continue;
+    }
+#if BOARD_SIMD_AVX2
+    const __m256i shuffle = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                             2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i bit_mask = _mm256_set1_epi64x(0x8040201008040201ll);
+    const __m256i one = _mm256_set1_epi8(1);
+    for(u32 half = 0; half < 2; half++)
+    {
+      __m256i v = _mm256_set1_epi32((s32)(u32)(bits >> (half * 32)));
+      v = _mm256_shuffle_epi8(v, shuffle);
+      v = _mm256_cmpeq_epi8(_mm256_and_si256(v, bit_mask), bit_mask);
+      _mm256_storeu_si256((__m256i*)(dst + half * 32), _mm256_and_si256(v, one));
+    }
+#elif BOARD_SIMD_SSE2
+    const __m128i bit_mask = _mm_set1_epi64x(0x8040201008040201ll);
+    const __m128i one = _mm_set1_epi8(1);
+    for(u32 quarter = 0; quarter < 4; quarter++)
+    {
+      // nb: no pshufb in SSE2, widen byte 0 and byte 1 to 8 copies each
+      __m128i v = _mm_cvtsi32_si128((s32)((bits >> (quarter * 16)) & 0xffff));
+      v = _mm_unpacklo_epi8(v, v);
+      v = _mm_unpacklo_epi16(v, v);
+      v = _mm_unpacklo_epi32(v, v);
+      v = _mm_cmpeq_epi8(_mm_and_si128(v, bit_mask), bit_mask);
+      _mm_storeu_si128((__m128i*)(dst + quarter * 16), _mm_and_si128(v, one));
+    }
+#else
+    for(u32 i = 0; i < 64; i++)
+    {
+      dst[i] = (u8)((bits >> i) & 1);
+    }
+#endif
+  }
+}
+
+//- nb: dst[i] = a[i] + b[i] + c[i], n is a multiple of BOARD_ROW_ALIGN
+internal void
+board_add3(u8 *dst, const u8 *a, const u8 *b, const u8 *c, u32 n)
+{
+#if BOARD_SIMD_AVX2
+  for(u32 i = 0; i < n; i += 32)
+  {
+    __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+    __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+    __m256i vc = _mm256_loadu_si256((const __m256i*)(c + i));
+    _mm256_storeu_si256((__m256i*)(dst + i), _mm256_add_epi8(_mm256_add_epi8(va, vb), vc));
+  }
+#elif BOARD_SIMD_SSE2
+  for(u32 i = 0; i < n; i += 16)
+  {
+    __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+    __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+    __m128i vc = _mm_loadu_si128((const __m128i*)(c + i));
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_add_epi8(_mm_add_epi8(va, vb), vc));
+  }
+#else
+  for(u32 i = 0; i < n; i++)
+  {
+    dst[i] = a[i] + b[i] + c[i];
+  }
+#endif
+}
+
+//- nb: dst[i] = mine[i] ? 0 : (up[i] + mid[i] + down[i] - mine[i])
+internal void
+board_count_row(u8 *dst, const u8 *up, const u8 *mid, const u8 *down, const u8 *mine, u32 n)
+{
+#if BOARD_SIMD_AVX2
+  const __m256i zero = _mm256_setzero_si256();
+  for(u32 i = 0; i < n; i += 32)
+  {
+    __m256i vu = _mm256_loadu_si256((const __m256i*)(up + i));
+    __m256i vm = _mm256_loadu_si256((const __m256i*)(mid + i));
+    __m256i vd = _mm256_loadu_si256((const __m256i*)(down + i));
+    __m256i vx = _mm256_loadu_si256((const __m256i*)(mine + i));
+    __m256i sum = _mm256_sub_epi8(_mm256_add_epi8(_mm256_add_epi8(vu, vm), vd), vx);
+    sum = _mm256_and_si256(sum, _mm256_cmpeq_epi8(vx, zero));
+    _mm256_storeu_si256((__m256i*)(dst + i), sum);
+  }
+#elif BOARD_SIMD_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  for(u32 i = 0; i < n; i += 16)
+  {
+    __m128i vu = _mm_loadu_si128((const __m128i*)(up + i));
+    __m128i vm = _mm_loadu_si128((const __m128i*)(mid + i));
+    __m128i vd = _mm_loadu_si128((const __m128i*)(down + i));
+    __m128i vx = _mm_loadu_si128((const __m128i*)(mine + i));
+    __m128i sum = _mm_sub_epi8(_mm_add_epi8(_mm_add_epi8(vu, vm), vd), vx);
+    sum = _mm_and_si128(sum, _mm_cmpeq_epi8(vx, zero));
+    _mm_storeu_si128((__m128i*)(dst + i), sum);
+  }
+#else
+  for(u32 i = 0; i < n; i++)
+  {
+    u8 sum = up[i] + mid[i] + down[i] - mine[i];
+    dst[i] = mine[i] ? 0 : sum;
+  }
+#endif
+}
+
+//- nb: bit i set where counts[i] == 0
+internal inline u64
+board_zero_bits(const u8 *counts)
+{
+#if BOARD_SIMD_AVX2
+  const __m256i zero = _mm256_setzero_si256();
+  u64 lo = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)counts), zero));
+  u64 hi = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(counts + 32)), zero));
+  return lo | (hi << 32);
+#elif BOARD_SIMD_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  u64 bits = 0;
+  for(u32 i = 0; i < 4; i++)
+  {
+    u64 mask = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(counts + i * 16)), zero));
+    bits |= mask << (i * 16);
+  }
+  return bits;
+#else
+  u64 bits = 0;
+  for(u32 i = 0; i < 64; i++)
+  {
+    bits |= (u64)(counts[i] == 0) << i;
+  }
+  return bits;
+#endif
+}
+
+void
+board_compute_neighbor_counts(Board *board)
+{
+  u32 columns = board->columns;
+  u32 rows    = board->rows;
+  if(columns == 0 || rows == 0)
+    return;
+
+  // nb: mine rows keep one zero byte in front (x = -1), so x-1, x and x+1
+  // are three unaligned loads at offsets 0, 1 and 2
+  u32 n      = AlignPow2(columns, BOARD_ROW_ALIGN);
+  u32 stride = AlignPow2(board->words_per_row * 64 + 2, BOARD_ROW_ALIGN) + BOARD_ROW_ALIGN;
+  u64 last_word_mask = (columns & 63) ? ~0ull >> (64 - (columns & 63)) : ~0ull;
+
+  Temp temp = temp_begin(board->arena);
+  u8 *scratch = (u8*)arena_push(temp.arena, (u64)stride * 7);
+  memset(scratch, 0, (u64)stride * 7);
+  u8 *mine_rows[3] = {scratch, scratch + stride, scratch + stride * 2};
+  u8 *sum_rows[3]  = {scratch + stride * 3, scratch + stride * 4, scratch + stride * 5};
+  u8 *zero_row     = scratch + stride * 6;
+
+  for(u32 y = 0; y <= rows; y++)
+  {
+    //- nb: bring in row y, horizontal sums
+    if(y < rows)
+    {
+      u8 *mine_row = mine_rows[y % 3];
+      board_expand_bits(board->mine_plane + (u64)y * board->words_per_row, board->words_per_row, mine_row + 1);
+      board_add3(sum_rows[y % 3], mine_row, mine_row + 1, mine_row + 2, n);
+    }
+    //- nb: vertical sums for row y-1
+    if(y > 0)
+    {
+      u32 cy = y - 1;
+      u8 *up   = cy > 0        ? sum_rows[(cy - 1) % 3] : zero_row;
+      u8 *down = cy + 1 < rows ? sum_rows[(cy + 1) % 3] : zero_row;
+      // nb: writes run past the row end into the next row (or the slack
+      // after the last one), which gets overwritten on the next iteration
+      u8 *counts = board->neighbor_counts + (u64)cy * columns;
+      board_count_row(counts, up, sum_rows[cy % 3], down, mine_rows[cy % 3] + 1, n);
+
+      //- nb: zero plane, read by the flood fill and board_build_openings.
+      // The last word reads into the next row (or the slack), masked off.
+      u64 *zero = board->zero_plane + (u64)cy * board->words_per_row;
+      u64 *mine = board->mine_plane + (u64)cy * board->words_per_row;
+      for(u32 w = 0; w < board->words_per_row; w++)
+      {
+        u64 z = board_zero_bits(counts + w * 64) & ~mine[w];
+        if(w + 1 == board->words_per_row)
+          z &= last_word_mask;
+        zero[w] = z;
+      }
+    }
+  }
+  temp_end(temp);
+}
+
+////////////////////////////////
+//~ nb: Board functions
+Board *
+board_alloc(void)
+{
+  Arena *arena = arena_alloc_reserve(BOARD_RESERVE_SIZE);
+  Board *board = (Board*)arena_push(arena, sizeof(Board));
+  memset(board, 0, sizeof(Board));
+  board->arena = arena;
+  board->arena_reset_pos = arena->pos;
+  return board;
+}
+
+void
+board_release(Board *board)
+{
+  arena_release(board->arena);
+}
+
+void
+board_reset(Board *board, u32 columns, u32 rows, u32 mine_count, u64 seed)
+{
+  arena_pop_to(board->arena, board->arena_reset_pos);
+
+  ////////////////////////////////
+  //- nb: Default values
+  board->is_playable     = 1;
+  board->mines_placed    = 0;
+  board->columns         = columns;
+  board->rows            = rows;
+  board->tiles_count     = columns * rows;
+  // nb: first sweep protection keeps a 3x3 area free of mines
+  board->mine_count      = ClampTop(mine_count, board->tiles_count > 9 ? board->tiles_count - 9 : 0);
+  board->swept_count     = 0;
+  board->flag_count      = 0;
+  board->exploded_idx    = BOARD_IDX_NIL;
+  board->seed            = seed;
+  board->fill_queue_head  = 0;
+  board->fill_queue_count = 0;
+  board->opening_runs          = 0;
+  board->opening_row_first     = 0;
+  board->opening_run_list      = 0;
+  board->opening_first         = 0;
+  board->opening_flagged_zeros = 0;
+  board->opening_count         = 0;
+  board->largest_opening       = 0;
+  board->bbbv                  = 0;
+  board->reveal_opening_queue  = 0;
+  board->reveal_opening_queued = 0;
+  board->reveal_queue_head     = 0;
+  board->reveal_queue_tail     = 0;
+  board->reveal_run_cursor     = 0;
+  board->deferred_head         = 0;
+  board->deferred_count        = 0;
+  board->words_per_row   = (columns + 63) / 64;
+
+  u64 plane_size = sizeof(u64) * board->words_per_row * rows;
+  board->mine_plane      = (u64*)arena_push(board->arena, plane_size);
+  board->flag_plane      = (u64*)arena_push(board->arena, plane_size);
+  board->swept_plane     = (u64*)arena_push(board->arena, plane_size);
+  board->zero_plane      = (u64*)arena_push(board->arena, plane_size);
+  // nb: slack at the end for the count kernel's whole-vector stores
+  board->neighbor_counts = (u8*)arena_push(board->arena, (u64)board->tiles_count + BOARD_ROW_ALIGN);
+  board->fill_row_queue  = (u32*)arena_push(board->arena, sizeof(u32) * rows);
+  board->fill_row_min    = (u32*)arena_push(board->arena, sizeof(u32) * rows);
+  board->fill_row_max    = (u32*)arena_push(board->arena, sizeof(u32) * rows);
+  board->deferred_actions = (BoardAction*)arena_push(board->arena, sizeof(BoardAction) * BOARD_DEFERRED_ACTIONS_MAX);
+
+  // nb: Populate board
+  memset(board->mine_plane,  0, plane_size);
+  memset(board->flag_plane,  0, plane_size);
+  memset(board->swept_plane, 0, plane_size);
+  memset(board->zero_plane,  0, plane_size);
+  memset(board->neighbor_counts, 0, board->tiles_count);
+  // nb: min > max marks a row as not queued
+  memset(board->fill_row_min, 0xff, sizeof(u32) * rows);
+  memset(board->fill_row_max, 0, sizeof(u32) * rows);
+}
+
+//- nb: the n-th tile that is not excluded, exclude is sorted ascending
+internal inline u32
+board_allowed_tile(u32 n, u32 *exclude, u32 exclude_count)
+{
+  u32 idx = n;
+  for(u32 i = 0; i < exclude_count; i++)
+  {
+    if(exclude[i] <= idx)
+      idx += 1;
+  }
+  return idx;
+}
+
+typedef struct Board_Place_Chunk Board_Place_Chunk;
+struct Board_Place_Chunk
+{
+  u32 allowed_first;
+  u32 allowed_count;
+  u32 mine_count;
+};
+
+typedef struct Board_Place_Job Board_Place_Job;
+struct Board_Place_Job
+{
+  Board             *board;
+  Board_Place_Chunk *chunks;
+  u32               chunk_count;
+  u32               *exclude;
+  u32               exclude_count;
+  u32               thread_idx;
+  u32               thread_count;
+};
+
+//- nb: Floyd's sampling over the chunk's allowed tiles. The mine plane
+// doubles as the "already picked" set, so this is O(mine_count) time with
+// no extra memory. Chunks are contiguous in tile order, so only the first
+// and last plane word can be shared with a neighbor and need an atomic OR.
+internal void
+board_place_chunk(Board_Place_Job *job, u32 chunk_idx)
+{
+  Board *board = job->board;
+  Board_Place_Chunk *chunk = &job->chunks[chunk_idx];
+  if(chunk->mine_count == 0)
+    return;
+
+  u64 mask;
+  u64 *first_word = board_plane_word(board, board->mine_plane,
+                                     board_allowed_tile(chunk->allowed_first, job->exclude, job->exclude_count), &mask);
+  u64 *last_word  = board_plane_word(board, board->mine_plane,
+                                     board_allowed_tile(chunk->allowed_first + chunk->allowed_count - 1, job->exclude, job->exclude_count), &mask);
+
+  Rng_Stream stream = rng_stream(board->seed, chunk_idx);
+  u32 n = chunk->allowed_count;
+  for(u32 j = n - chunk->mine_count; j < n; j++)
+  {
+    u32 pick = rng_stream_range_u32(&stream, j + 1);
+    u64 *word = board_plane_word(board, board->mine_plane,
+                                 board_allowed_tile(chunk->allowed_first + pick, job->exclude, job->exclude_count), &mask);
+    if(atomic_load_u64(word) & mask)
+    {
+      word = board_plane_word(board, board->mine_plane,
+                              board_allowed_tile(chunk->allowed_first + j, job->exclude, job->exclude_count), &mask);
+    }
+    if(word == first_word || word == last_word)
+      atomic_or_u64(word, mask);
+    else
+      *word |= mask;
+  }
+}
+
+internal void
+board_place_thread(void *params)
+{
+  Board_Place_Job *job = (Board_Place_Job*)params;
+  for(u32 chunk_idx = job->thread_idx; chunk_idx < job->chunk_count; chunk_idx += job->thread_count)
+  {
+    board_place_chunk(job, chunk_idx);
+  }
+}
+
+internal void
+board_place_mines(Board *board, u32 safe_idx)
+{
+  //- nb: the 3x3 grid around the first sweep never gets a mine
+  u32 exclude[9];
+  u32 exclude_count = 0;
+  u32 safe_x = safe_idx % board->columns;
+  u32 safe_y = safe_idx / board->columns;
+  for(u32 y = (safe_y > 0 ? safe_y - 1 : 0); y <= safe_y + 1 && y < board->rows; y++)
+  {
+    for(u32 x = (safe_x > 0 ? safe_x - 1 : 0); x <= safe_x + 1 && x < board->columns; x++)
+    {
+      exclude[exclude_count++] = y * board->columns + x;
+    }
+  }
+  u32 allowed_count = board->tiles_count - exclude_count;
+  u32 mine_count    = ClampTop(board->mine_count, allowed_count);
+  board->mine_count = mine_count;
+
+  Temp temp = temp_begin(board->arena);
+
+  //- nb: Split the allowed tiles into fixed chunks and hand each its share
+  // of the mines. Drawing chunk by chunk from what is left, each count is
+  // hypergeometric given the ones before it, which together is exactly the
+  // multivariate hypergeometric split a uniform placement would produce.
+  u32 chunk_count = (allowed_count + BOARD_PLACE_CHUNK_TILES - 1) / BOARD_PLACE_CHUNK_TILES;
+  Board_Place_Chunk *chunks = (Board_Place_Chunk*)arena_push(temp.arena, sizeof(Board_Place_Chunk) * Max(chunk_count, 1));
+  {
+    Rng rng = rng_from_seed(board->seed);
+    u32 tiles_left = allowed_count;
+    u32 mines_left = mine_count;
+    for(u32 i = 0; i < chunk_count; i++)
+    {
+      Board_Place_Chunk *chunk = &chunks[i];
+      chunk->allowed_first = i * BOARD_PLACE_CHUNK_TILES;
+      chunk->allowed_count = ClampTop(BOARD_PLACE_CHUNK_TILES, tiles_left);
+      chunk->mine_count    = (u32)rng_hypergeometric(&rng, tiles_left, mines_left, chunk->allowed_count);
+      tiles_left -= chunk->allowed_count;
+      mines_left -= chunk->mine_count;
+    }
+    Assert(mines_left == 0);
+  }
+
+  //- nb: Fill the chunks. Every chunk has its own stream, so which thread
+  // runs it does not matter. A board that is all first sweep has no chunks,
+  // the calling thread still gets its (empty) job.
+  u32 thread_count = board->thread_count ? board->thread_count : os_logical_core_count();
+  thread_count = Clamp(1, thread_count, Max(Min(chunk_count, BOARD_PLACE_MAX_THREADS), 1));
+  Board_Place_Job *jobs = (Board_Place_Job*)arena_push(temp.arena, sizeof(Board_Place_Job) * thread_count);
+  OS_Thread *threads = (OS_Thread*)arena_push(temp.arena, sizeof(OS_Thread) * thread_count);
+  for(u32 i = 0; i < thread_count; i++)
+  {
+    Board_Place_Job *job = &jobs[i];
+    job->board         = board;
+    job->chunks        = chunks;
+    job->chunk_count   = chunk_count;
+    job->exclude       = exclude;
+    job->exclude_count = exclude_count;
+    job->thread_idx    = i;
+    job->thread_count  = thread_count;
+  }
+  // nb: the calling thread takes the first share itself
+  u64 fill_begin_us = os_now_microseconds();
+  for(u32 i = 1; i < thread_count; i++)
+  {
+    os_thread_launch(&threads[i], board_place_thread, &jobs[i]);
+  }
+  board_place_thread(&jobs[0]);
+  for(u32 i = 1; i < thread_count; i++)
+  {
+    os_thread_join(&threads[i]);
+  }
+  board->place_fill_us = os_now_microseconds() - fill_begin_us;
+  temp_end(temp);
+
+  //- nb: Set the neighboring mine count for all tiles
+  board_compute_neighbor_counts(board);
+  board_build_openings(board);
+  board->mines_placed = 1;
+}
+
+internal b32
+board_sweep_tile(Board *board, u32 idx)
+{
+  if(!board->is_playable)
+    return 0;
+
+  // nb: first sweep protection
+  if(!board->mines_placed)
+  {
+    board_place_mines(board, idx);
+  }
+  b32 hit_mine = board_reveal_tile_by_idx(board, idx);
+  if(hit_mine)
+  {
+    // nb: whatever waited behind this sweep comes too late
+    board->deferred_head  = 0;
+    board->deferred_count = 0;
+    board_gameover(board);
+  }
+  return hit_mine;
+}
+
+internal void
+board_flag_tile(Board *board, u32 idx)
+{
+  if(!board->is_playable)
+    return;
+
+  // nb: Don't allow a flag to be placed on a swept mine
+  if(board_test(board, board->swept_plane, idx))
+    return;
+  // nb: Place flag
+  s32 delta = board_test(board, board->flag_plane, idx) ? -1 : 1;
+  board->flag_count += delta;
+  board_toggle(board, board->flag_plane, idx);
+  if(board->changes)
+    board_record_change(board, idx, 1, delta > 0 ? 0 : TILE_BIT_FLAG, delta > 0 ? TILE_BIT_FLAG : 0);
+
+  // nb: a flag on a zero tile splits its opening, keep track so the bulk
+  // reveal can step aside
+  if(board->opening_row_first && board_test(board, board->zero_plane, idx))
+  {
+    u32 opening = board_opening_from_xy(board, idx % board->columns, idx / board->columns);
+    board->opening_flagged_zeros[opening] += delta;
+  }
+}
+
+//- nb: Queues an action behind the reveal in flight. When the queue is full
+// the reveal is finished instead and 0 returned, the caller goes ahead.
+internal b32
+board_defer_action(Board *board, u32 idx, b32 flag)
+{
+  if(board->deferred_count == BOARD_DEFERRED_ACTIONS_MAX)
+  {
+    board_reveal_finish(board);
+    return 0;
+  }
+  BoardAction *action = &board->deferred_actions[board->deferred_count++];
+  action->idx  = idx;
+  action->flag = flag;
+  return 1;
+}
+
+b32
+board_sweep(Board *board, u32 idx)
+{
+  if(!board->is_playable || idx >= board->tiles_count)
+    return 0;
+  // nb: a deferred flag goes first
+  if(board->deferred_count > 0 && board_defer_action(board, idx, 0))
+    return 0;
+
+  //- nb: the sweep counts against the step's budget, mine placement doesn't
+  if(!board->mines_placed)
+  {
+    board_place_mines(board, idx);
+  }
+  u32 start_swept = board->swept_count;
+  u64 start_us = board->reveal_budget_us ? os_now_microseconds() : 0;
+  b32 hit_mine = board_sweep_tile(board, idx);
+  board_reveal_step_from(board, start_swept, start_us);
+  return hit_mine;
+}
+
+void
+board_toggle_flag(Board *board, u32 idx)
+{
+  if(!board->is_playable || idx >= board->tiles_count)
+    return;
+  if(board_reveal_pending(board) && board_defer_action(board, idx, 1))
+    return;
+  board_flag_tile(board, idx);
+}
+
+internal b32
+board_reveal_tile_by_idx(Board *board, u32 idx)
+{
+  // nb: Disallow a flagged tile from being swept
+  if(board_test(board, board->flag_plane, idx))
+    return 0;
+
+  if(board_test(board, board->mine_plane, idx))
+  {
+    board_set(board, board->swept_plane, idx);
+    board->exploded_idx = idx;
+    if(board->changes)
+      board_record_change(board, idx, 1, 0, TILE_BIT_SWEPT | TILE_BIT_EXPLODED);
+    return 1;
+  }
+
+  u32 neighbor_count = board->neighbor_counts[idx];
+  if(!board_test(board, board->swept_plane, idx))
+  {
+    board_set(board, board->swept_plane, idx);
+    board->swept_count += 1;
+    if(board->changes)
+      board_record_change(board, idx, 1, 0, TILE_BIT_SWEPT);
+    if(neighbor_count == 0)
+    {
+      // nb: untouched openings are one bulk write, flagged ones take the
+      // flood fill, which stops at the flags
+      u32 tile_x = idx % board->columns;
+      u32 tile_y = idx / board->columns;
+      u32 opening = board->opening_row_first ? board_opening_from_xy(board, tile_x, tile_y) : BOARD_IDX_NIL;
+      if(opening != BOARD_IDX_NIL && board->opening_flagged_zeros[opening] == 0)
+        board_reveal_opening(board, opening);
+      else
+        board_fill_push(board, tile_x, tile_y);
+    }
+    else
+    {
+      return 0;
+    }
+  }
+  else
+  {
+    // Nothing to chord
+    if(neighbor_count == 0)
+      return 0;
+
+    //- nb: Chording logic
+    u32 flag_count = 0;
+    u32 neighbor_idx_list[8] = {0};
+    u32 neighbor_idx_list_count = 0;
+    board_get_neighbors_by_idx(board, idx, neighbor_idx_list, &neighbor_idx_list_count);
+
+    // TODO(nb): Fix bug where chording can occur even if the flags were incorrectly placed..
+    // This occurs because chording starts northwest, then north, then northeast, then west etc...
+    // So it's possible that two valid tiles will be swept even if there are multiple mines within
+    // the chord range.
+    for(u32 i = 0; i < neighbor_idx_list_count; i++)
+    {
+      if(board_test(board, board->flag_plane, neighbor_idx_list[i]))
+        flag_count += 1;
+    }
+    // nb: Allow chording if flags placed == neighbor count
+    if(flag_count == neighbor_count)
+    {
+      for(u32 i = 0; i < neighbor_idx_list_count; i++)
+      {
+        u32 nb = neighbor_idx_list[i];
+        if(!board_test(board, board->swept_plane, nb) && !board_test(board, board->flag_plane, nb))
+        {
+          if(board_reveal_tile_by_idx(board, nb))
+            return 1;
+        }
+      }
+    }
+  }
+
+  return 0;
+}
+
+////////////////////////////////
+//~ nb: Reveal job
+internal void
+board_reveal_opening(Board *board, u32 opening)
+{
+  u64 bit = 1ull << (opening & 63);
+  if(board->reveal_opening_queued[opening >> 6] & bit)
+    return;
+  board->reveal_opening_queued[opening >> 6] |= bit;
+  if(board->reveal_queue_head == board->reveal_queue_tail)
+    board->reveal_run_cursor = board->opening_first[opening];
+  board->reveal_opening_queue[board->reveal_queue_tail++] = opening;
+}
+
+b32
+board_reveal_pending(Board *board)
+{
+  return (board->reveal_queue_head < board->reveal_queue_tail || board->fill_queue_count > 0 ||
+          board->deferred_head < board->deferred_count);
+}
+
+//- nb: checked after every painted run or filled row, so each step makes
+// some progress even on a tiny budget
+internal inline b32
+board_reveal_budget_spent(Board *board, u32 start_swept, u64 start_us)
+{
+  if(board->reveal_budget_tiles && board->swept_count - start_swept >= board->reveal_budget_tiles)
+    return 1;
+  if(board->reveal_budget_us && os_now_microseconds() - start_us >= board->reveal_budget_us)
+    return 1;
+  return 0;
+}
+
+//- nb: a step whose budget started at `start_us`, with `start_swept` tiles
+internal b32
+board_reveal_step_from(Board *board, u32 start_swept, u64 start_us)
+{
+  for(;;)
+  {
+    //- nb: queued openings, one run at a time
+    while(board->reveal_queue_head < board->reveal_queue_tail)
+    {
+      u32 opening = board->reveal_opening_queue[board->reveal_queue_head];
+      u32 run_end = board->opening_first[opening + 1];
+      while(board->reveal_run_cursor < run_end)
+      {
+        BoardRun *run = &board->opening_runs[board->opening_run_list[board->reveal_run_cursor]];
+        board->swept_count += board_paint_run(board, run, board->swept_plane, board->flag_plane, BOARD_PAINT_REVEAL);
+        board->reveal_run_cursor += 1;
+        if(board->reveal_run_cursor < run_end && board_reveal_budget_spent(board, start_swept, start_us))
+          return 1;
+      }
+      board->reveal_queue_head += 1;
+      if(board->reveal_queue_head < board->reveal_queue_tail)
+      {
+        board->reveal_run_cursor = board->opening_first[board->reveal_opening_queue[board->reveal_queue_head]];
+        if(board_reveal_budget_spent(board, start_swept, start_us))
+          return 1;
+      }
+    }
+
+    //- nb: flood fill, one row at a time
+    while(board->fill_queue_count > 0)
+    {
+      board_fill_row(board);
+      if(board->fill_queue_count > 0 && board_reveal_budget_spent(board, start_swept, start_us))
+        return 1;
+    }
+
+    //- nb: the reveal drained, the next deferred action goes. A sweep
+    // queues more of it for the next round.
+    if(board->deferred_head == board->deferred_count)
+      return 0;
+    BoardAction action = board->deferred_actions[board->deferred_head++];
+    if(board->deferred_head == board->deferred_count)
+      board->deferred_head = board->deferred_count = 0;
+    if(action.flag) board_flag_tile(board, action.idx);
+    else            board_sweep_tile(board, action.idx);
+    if(board_reveal_pending(board) && board_reveal_budget_spent(board, start_swept, start_us))
+      return 1;
+  }
+}
+
+b32
+board_reveal_step(Board *board)
+{
+  u64 start_us = board->reveal_budget_us ? os_now_microseconds() : 0;
+  return board_reveal_step_from(board, board->swept_count, start_us);
+}
+
+void
+board_reveal_finish(Board *board)
+{
+  u32 budget_tiles = board->reveal_budget_tiles;
+  u32 budget_us    = board->reveal_budget_us;
+  board->reveal_budget_tiles = 0;
+  board->reveal_budget_us    = 0;
+  board_reveal_step(board);
+  board->reveal_budget_tiles = budget_tiles;
+  board->reveal_budget_us    = budget_us;
+}
+
+////////////////////////////////
+//~ nb: Flood fill
+// Scanline fill over the bit-planes. A queued row carries the x range of
+// zero tiles that were swept but haven't spread yet. Popping a row walks
+// that range, grows every zero run to its full horizontal extent and then
+// sweeps the run plus a one tile border on the row itself and the rows
+// above and below, a whole word at a time. Zero tiles swept in the
+// neighboring rows queue those rows in turn.
+
+internal void
+board_fill_push(Board *board, u32 tile_x, u32 tile_y)
+{
+  if(board->fill_row_min[tile_y] > board->fill_row_max[tile_y])
+  {
+    u32 slot = (board->fill_queue_head + board->fill_queue_count) % board->rows;
+    board->fill_row_queue[slot] = tile_y;
+    board->fill_queue_count += 1;
+    board->fill_row_min[tile_y] = tile_x;
+    board->fill_row_max[tile_y] = tile_x;
+  }
+  else
+  {
+    board->fill_row_min[tile_y] = Min(board->fill_row_min[tile_y], tile_x);
+    board->fill_row_max[tile_y] = Max(board->fill_row_max[tile_y], tile_x);
+  }
+}
+
+//- nb: sweeps every hidden, unflagged tile in [x0, x1] of one row. Returns
+// the x range of the zero tiles that got swept through zero_min/zero_max.
+internal void
+board_fill_sweep_span(Board *board, u32 tile_y, u32 x0, u32 x1, u32 *zero_min, u32 *zero_max)
+{
+  u64 row_offset = (u64)tile_y * board->words_per_row;
+  u64 *mine  = board->mine_plane  + row_offset;
+  u64 *flag  = board->flag_plane  + row_offset;
+  u64 *swept = board->swept_plane + row_offset;
+  u64 *zero  = board->zero_plane  + row_offset;
+  for(u32 w = x0 >> 6; w <= (x1 >> 6); w++)
+  {
+    u64 mask = ~0ull;
+    if(w == (x0 >> 6)) mask &= ~0ull << (x0 & 63);
+    if(w == (x1 >> 6)) mask &= ~0ull >> (63 - (x1 & 63));
+    u64 fresh = mask & ~swept[w] & ~flag[w] & ~mine[w];
+    if(fresh == 0)
+      continue;
+    swept[w] |= fresh;
+    board->swept_count += count_bits_u64(fresh);
+    if(board->changes)
+      board_record_bits(board, tile_y, w, fresh, 0, TILE_BIT_SWEPT);
+    u64 zeros = fresh & zero[w];
+    if(zeros != 0)
+    {
+      *zero_min = Min(*zero_min, w * 64 + ctz_u64(zeros));
+      *zero_max = Max(*zero_max, w * 64 + 63 - clz_u64(zeros));
+    }
+  }
+}
+
+//- nb: the ends of the run of open (zero, unflagged) tiles holding x, found
+// a word at a time. Bits past `columns` are never set, so they close it.
+internal inline u32
+board_fill_run_min(u64 *zero, u64 *flag, u32 x)
+{
+  u32 w = x >> 6;
+  u64 closed = ~(zero[w] & ~flag[w]) & (~0ull >> (63 - (x & 63)));
+  while(closed == 0 && w > 0)
+  {
+    w -= 1;
+    closed = ~(zero[w] & ~flag[w]);
+  }
+  return closed == 0 ? 0 : w * 64 + 64 - clz_u64(closed);
+}
+
+internal inline u32
+board_fill_run_max(u64 *zero, u64 *flag, u32 words_per_row, u32 x)
+{
+  u32 w = x >> 6;
+  u64 closed = ~(zero[w] & ~flag[w]) & (~0ull << (x & 63));
+  while(closed == 0 && w + 1 < words_per_row)
+  {
+    w += 1;
+    closed = ~(zero[w] & ~flag[w]);
+  }
+  return closed == 0 ? w * 64 + 63 : w * 64 + ctz_u64(closed) - 1;
+}
+
+//- nb: pops one queued row and spreads its pending zero tiles
+internal void
+board_fill_row(Board *board)
+{
+  u32 columns = board->columns;
+  // nb: Pop a row
+  u32 tile_y = board->fill_row_queue[board->fill_queue_head];
+  board->fill_queue_head = (board->fill_queue_head + 1) % board->rows;
+  board->fill_queue_count -= 1;
+  u32 x_min = board->fill_row_min[tile_y];
+  u32 x_max = board->fill_row_max[tile_y];
+  board->fill_row_min[tile_y] = 0xffffffff;
+  board->fill_row_max[tile_y] = 0;
+
+  u64 row_offset = (u64)tile_y * board->words_per_row;
+  u64 *flag  = board->flag_plane  + row_offset;
+  u64 *swept = board->swept_plane + row_offset;
+  u64 *zero  = board->zero_plane  + row_offset;
+
+  for(u32 x = x_min; x <= x_max;)
+  {
+    // nb: only swept zero tiles spread, whole words without one are skipped
+    u32 w = x >> 6;
+    u64 pending = zero[w] & ~flag[w] & swept[w] & (~0ull << (x & 63));
+    if(w == (x_max >> 6))
+      pending &= ~0ull >> (63 - (x_max & 63));
+    if(pending == 0)
+    {
+      x = (w + 1) * 64;
+      continue;
+    }
+    x = w * 64 + ctz_u64(pending);
+
+    //- nb: grow the zero run, hidden zero tiles on the way join it
+    u32 run_min = board_fill_run_min(zero, flag, x);
+    u32 run_max = board_fill_run_max(zero, flag, board->words_per_row, x);
+
+    //- nb: sweep the run and its border on all three rows
+    u32 span_min = run_min > 0 ? run_min - 1 : 0;
+    u32 span_max = run_max + 1 < columns ? run_max + 1 : run_max;
+    u32 zero_min = 0xffffffff;
+    u32 zero_max = 0;
+    board_fill_sweep_span(board, tile_y, span_min, span_max, &zero_min, &zero_max);
+    for(s32 dy = -1; dy <= 1; dy += 2)
+    {
+      s64 ny = (s64)tile_y + dy;
+      if(ny < 0 || ny >= board->rows)
+        continue;
+      zero_min = 0xffffffff;
+      zero_max = 0;
+      board_fill_sweep_span(board, (u32)ny, span_min, span_max, &zero_min, &zero_max);
+      if(zero_min <= zero_max)
+      {
+        board_fill_push(board, zero_min, (u32)ny);
+        board_fill_push(board, zero_max, (u32)ny);
+      }
+    }
+    x = run_max + 1;
+  }
+}
+
+////////////////////////////////
+//~ nb: Openings
+// Zero tiles are found 64 at a time, cut into horizontal runs, and runs on
+// neighboring rows that touch (diagonals included) are merged with
+// union-find. A run's `opening` doubles as its parent link while merging;
+// links always point at an earlier run, so the root is the first run of
+// each opening and ids come out in row order.
+
+internal inline u32
+board_run_find(BoardRun *runs, u32 run)
+{
+  while(runs[run].opening != run)
+  {
+    // nb: path halving
+    runs[run].opening = runs[runs[run].opening].opening;
+    run = runs[run].opening;
+  }
+  return run;
+}
+
+internal inline void
+board_run_union(BoardRun *runs, u32 a, u32 b)
+{
+  a = board_run_find(runs, a);
+  b = board_run_find(runs, b);
+  if(a < b)
+    runs[b].opening = a;
+  else if(b < a)
+    runs[a].opening = b;
+}
+
+internal u32
+board_opening_from_xy(Board *board, u32 tile_x, u32 tile_y)
+{
+  u32 lo = board->opening_row_first[tile_y];
+  u32 hi = board->opening_row_first[tile_y + 1];
+  while(lo < hi)
+  {
+    u32 mid = lo + (hi - lo) / 2;
+    BoardRun *run = &board->opening_runs[mid];
+    if(tile_x < run->x0)
+      hi = mid;
+    else if(tile_x > run->x1)
+      lo = mid + 1;
+    else
+      return run->opening;
+  }
+  return BOARD_IDX_NIL;
+}
+
+//- nb: Sets (or clears) the tiles a run reveals in `plane`: the run and its
+// one tile border on the rows above and below. Bits set in `skip` are left
+// alone. Returns how many bits were newly set.
+internal u32
+board_paint_run(Board *board, BoardRun *run, u64 *plane, u64 *skip, BoardPaint paint)
+{
+  u32 columns = board->columns;
+  u32 painted = 0;
+  u32 x0 = run->x0 > 0 ? run->x0 - 1 : 0;
+  u32 x1 = run->x1 + 1 < columns ? run->x1 + 1 : run->x1;
+  u32 y0 = run->y > 0 ? run->y - 1 : 0;
+  u32 y1 = run->y + 1 < board->rows ? run->y + 1 : run->y;
+  for(u32 y = y0; y <= y1; y++)
+  {
+    u64 row_offset = (u64)y * board->words_per_row;
+    for(u32 w = x0 >> 6; w <= (x1 >> 6); w++)
+    {
+      u64 mask = ~0ull;
+      if(w == (x0 >> 6)) mask &= ~0ull << (x0 & 63);
+      if(w == (x1 >> 6)) mask &= ~0ull >> (63 - (x1 & 63));
+      if(skip)
+        mask &= ~skip[row_offset + w];
+      if(paint == BOARD_PAINT_CLEAR)
+      {
+        plane[row_offset + w] &= ~mask;
+        continue;
+      }
+      u64 fresh = mask & ~plane[row_offset + w];
+      plane[row_offset + w] |= fresh;
+      painted += count_bits_u64(fresh);
+      if(paint == BOARD_PAINT_REVEAL && board->changes)
+        board_record_bits(board, y, w, fresh, 0, TILE_BIT_SWEPT);
+    }
+  }
+  return painted;
+}
+
+internal u32
+board_paint_opening(Board *board, u32 opening, u64 *plane, u64 *skip, BoardPaint paint)
+{
+  u32 painted = 0;
+  for(u32 i = board->opening_first[opening]; i < board->opening_first[opening + 1]; i++)
+  {
+    painted += board_paint_run(board, &board->opening_runs[board->opening_run_list[i]], plane, skip, paint);
+  }
+  return painted;
+}
+
+void
+board_build_openings(Board *board)
+{
+  u32 columns = board->columns;
+  u32 rows    = board->rows;
+  u32 words_per_row = board->words_per_row;
+  u64 word_count = (u64)words_per_row * rows;
+  u64 last_word_mask = (columns & 63) ? ~0ull >> (64 - (columns & 63)) : ~0ull;
+
+  //- nb: run count, the zero plane came with the counts
+  u64 run_count = 0;
+  for(u32 y = 0; y < rows; y++)
+  {
+    u64 *zero = board->zero_plane + (u64)y * words_per_row;
+    u64 carry = 0;
+    for(u32 w = 0; w < words_per_row; w++)
+    {
+      u64 z = zero[w];
+      run_count += count_bits_u64(z & ~((z << 1) | carry));
+      carry = z >> 63;
+    }
+  }
+  Assert(run_count < BOARD_IDX_NIL);
+
+  //- nb: cut the runs, merge with the touching runs of the row above
+  board->opening_row_first = (u32*)arena_push(board->arena, sizeof(u32) * (rows + 1));
+  board->opening_runs      = (BoardRun*)arena_push(board->arena, sizeof(BoardRun) * Max(run_count, 1));
+  BoardRun *runs = board->opening_runs;
+  u32 run_total = 0;
+  for(u32 y = 0; y < rows; y++)
+  {
+    board->opening_row_first[y] = run_total;
+    u64 *zero = board->zero_plane + (u64)y * words_per_row;
+    // nb: the k-th run start of a row pairs with its k-th run end
+    u32 start_total = run_total;
+    u32 end_total   = run_total;
+    for(u32 w = 0; w < words_per_row; w++)
+    {
+      u64 z = zero[w];
+      u64 prev_top = w > 0 ? zero[w - 1] >> 63 : 0;
+      u64 next_low = w + 1 < words_per_row ? zero[w + 1] & 1 : 0;
+      for(u64 starts = z & ~((z << 1) | prev_top); starts != 0; starts &= starts - 1)
+      {
+        BoardRun *run = &runs[start_total];
+        run->y = y;
+        run->x0 = w * 64 + ctz_u64(starts);
+        run->opening = start_total;
+        start_total += 1;
+      }
+      for(u64 ends = z & ~((z >> 1) | (next_low << 63)); ends != 0; ends &= ends - 1)
+      {
+        runs[end_total].x1 = w * 64 + ctz_u64(ends);
+        end_total += 1;
+      }
+    }
+    run_total = start_total;
+
+    if(y > 0)
+    {
+      u32 above = board->opening_row_first[y - 1];
+      u32 above_end = board->opening_row_first[y];
+      for(u32 r = board->opening_row_first[y]; r < run_total; r++)
+      {
+        while(above < above_end && runs[above].x1 + 1 < runs[r].x0)
+          above += 1;
+        // nb: the run is still its own root, the first touching run above
+        // can adopt it without a second find
+        u32 a = above;
+        if(a < above_end && runs[a].x0 <= runs[r].x1 + 1)
+        {
+          runs[r].opening = board_run_find(runs, a);
+          a += 1;
+        }
+        for(; a < above_end && runs[a].x0 <= runs[r].x1 + 1; a++)
+        {
+          board_run_union(runs, a, r);
+        }
+      }
+    }
+  }
+  board->opening_row_first[rows] = run_total;
+
+  //- nb: parent links -> opening ids, a root is always visited before the
+  // runs pointing at it
+  u32 opening_count = 0;
+  for(u32 r = 0; r < run_total; r++)
+  {
+    u32 parent = runs[r].opening;
+    runs[r].opening = (parent == r) ? opening_count++ : runs[parent].opening;
+  }
+  board->opening_count = opening_count;
+
+  //- nb: group the runs per opening, count the flags already on zero tiles
+  board->opening_first         = (u32*)arena_push(board->arena, sizeof(u32) * (opening_count + 1));
+  board->opening_run_list      = (u32*)arena_push(board->arena, sizeof(u32) * Max(run_total, 1));
+  board->opening_flagged_zeros = (u32*)arena_push(board->arena, sizeof(u32) * Max(opening_count, 1));
+  board->reveal_opening_queue  = (u32*)arena_push(board->arena, sizeof(u32) * Max(opening_count, 1));
+  board->reveal_opening_queued = (u64*)arena_push(board->arena, sizeof(u64) * (opening_count / 64 + 1));
+  memset(board->reveal_opening_queued, 0, sizeof(u64) * (opening_count / 64 + 1));
+  board->reveal_queue_head = 0;
+  board->reveal_queue_tail = 0;
+  memset(board->opening_first, 0, sizeof(u32) * (opening_count + 1));
+  memset(board->opening_flagged_zeros, 0, sizeof(u32) * Max(opening_count, 1));
+  for(u32 r = 0; r < run_total; r++)
+  {
+    board->opening_first[runs[r].opening + 1] += 1;
+  }
+  for(u32 i = 0; i < opening_count; i++)
+  {
+    board->opening_first[i + 1] += board->opening_first[i];
+  }
+  Temp temp = temp_begin(board->arena);
+  u32 *cursor = (u32*)arena_push(temp.arena, sizeof(u32) * Max(opening_count, 1));
+  memcpy(cursor, board->opening_first, sizeof(u32) * opening_count);
+  for(u32 r = 0; r < run_total; r++)
+  {
+    BoardRun *run = &runs[r];
+    board->opening_run_list[cursor[run->opening]++] = r;
+    if(board->flag_count)
+    {
+      u64 *flag = board->flag_plane + (u64)run->y * words_per_row;
+      for(u32 w = run->x0 >> 6; w <= (run->x1 >> 6); w++)
+      {
+        u64 mask = ~0ull;
+        if(w == (run->x0 >> 6)) mask &= ~0ull << (run->x0 & 63);
+        if(w == (run->x1 >> 6)) mask &= ~0ull >> (63 - (run->x1 & 63));
+        board->opening_flagged_zeros[run->opening] += count_bits_u64(flag[w] & mask);
+      }
+    }
+  }
+
+  //- nb: largest opening, painted one at a time into a scratch plane since
+  // border tiles can be shared. Openings that can't beat the current best
+  // even with every border tile counted are skipped.
+  u64 *scratch = (u64*)arena_push(temp.arena, sizeof(u64) * word_count);
+  memset(scratch, 0, sizeof(u64) * word_count);
+  u32 largest = 0;
+  for(u32 i = 0; i < opening_count; i++)
+  {
+    u64 bound = 0;
+    for(u32 j = board->opening_first[i]; j < board->opening_first[i + 1]; j++)
+    {
+      BoardRun *run = &runs[board->opening_run_list[j]];
+      bound += 3 * (u64)(run->x1 - run->x0 + 3);
+    }
+    if(bound <= largest)
+      continue;
+    u32 size = board_paint_opening(board, i, scratch, 0, BOARD_PAINT_SET);
+    board_paint_opening(board, i, scratch, 0, BOARD_PAINT_CLEAR);
+    largest = Max(largest, size);
+  }
+
+  //- nb: 3BV, one click per opening plus one per numbered tile that no
+  // opening uncovers, i.e. that has no zero tile around it
+  u64 *spread = scratch;
+  for(u64 w = 0; w < word_count; w++)
+  {
+    u32 x_word = (u32)(w % words_per_row);
+    u64 z = board->zero_plane[w];
+    u64 left  = x_word > 0 ? board->zero_plane[w - 1] >> 63 : 0;
+    u64 right = x_word + 1 < words_per_row ? board->zero_plane[w + 1] << 63 : 0;
+    spread[w] = z | (z << 1) | left | (z >> 1) | right;
+  }
+  u32 isolated = 0;
+  for(u32 y = 0; y < rows; y++)
+  {
+    u64 row_offset = (u64)y * words_per_row;
+    for(u32 w = 0; w < words_per_row; w++)
+    {
+      u64 covered = spread[row_offset + w];
+      if(y > 0)        covered |= spread[row_offset - words_per_row + w];
+      if(y + 1 < rows) covered |= spread[row_offset + words_per_row + w];
+      u64 valid = (w + 1 == words_per_row) ? last_word_mask : ~0ull;
+      isolated += count_bits_u64(valid & ~covered & ~board->mine_plane[row_offset + w]);
+    }
+  }
+  temp_end(temp);
+  board->largest_opening = largest;
+  board->bbbv = opening_count + isolated;
+}
+
+void
+board_gameover(Board *board)
+{
+  // nb: The reveal in flight can carry on, it only sweeps tiles that are
+  // not mines and the flags no longer change. Actions waiting behind it
+  // came first though.
+  if(board->deferred_count > 0)
+    board_reveal_finish(board);
+  // nb: Reveal all mines, the one that was hit keeps its exploded bit.
+  // Mines don't count towards swept_count.
+  u64 word_count = (u64)board->words_per_row * board->rows;
+  for(u64 i = 0; i < word_count; i++)
+  {
+    u64 fresh = board->mine_plane[i] & ~board->swept_plane[i];
+    board->swept_plane[i] |= fresh;
+    if(board->changes && fresh)
+    {
+      u32 tile_y = (u32)(i / board->words_per_row);
+      u32 w      = (u32)(i % board->words_per_row);
+      u64 flagged = fresh & board->flag_plane[i];
+      board_record_bits(board, tile_y, w, fresh & ~flagged, 0, TILE_BIT_SWEPT);
+      board_record_bits(board, tile_y, w, flagged, TILE_BIT_FLAG, TILE_BIT_FLAG | TILE_BIT_SWEPT);
+    }
+  }
+  board->is_playable = 0;
+}
+
+////////////////////////////////
+//~ nb: Summary pyramid
+//- nb: which count a tile state goes to
+internal u32 *
+board_block_count(BoardBlock *block, Tile state)
+{
+  if(state & TILE_BIT_SWEPT)
+    return &block->swept;
+  return (state & TILE_BIT_FLAG) ? &block->flagged : &block->hidden;
+}
+
+internal void
+board_pyramid_mark_dirty(BoardPyramidLevel *level, u32 x0, u32 y0, u32 x1, u32 y1)
+{
+  if(level->dirty_x0 >= level->dirty_x1)
+  {
+    level->dirty_x0 = x0;
+    level->dirty_y0 = y0;
+    level->dirty_x1 = x1;
+    level->dirty_y1 = y1;
+    return;
+  }
+  level->dirty_x0 = Min(level->dirty_x0, x0);
+  level->dirty_y0 = Min(level->dirty_y0, y0);
+  level->dirty_x1 = Max(level->dirty_x1, x1);
+  level->dirty_y1 = Max(level->dirty_y1, y1);
+}
+
+void
+board_pyramid_build(BoardPyramid *pyramid, Board *board, Arena *arena)
+{
+  memset(pyramid, 0, sizeof(BoardPyramid));
+  pyramid->columns = board->columns;
+  pyramid->rows    = board->rows;
+  u32 side = 1 << BOARD_PYRAMID_SHIFT;
+  for(u32 l = 0; l < BOARD_PYRAMID_MAX_LEVELS; l++)
+  {
+    BoardPyramidLevel *level = &pyramid->levels[l];
+    level->shift   = (l + 1) * BOARD_PYRAMID_SHIFT;
+    u64 block_side = 1ull << level->shift;
+    level->columns = (u32)((board->columns + block_side - 1) >> level->shift);
+    level->rows    = (u32)((board->rows    + block_side - 1) >> level->shift);
+    level->blocks  = (BoardBlock*)arena_push(arena, sizeof(BoardBlock) * level->columns * level->rows);
+    memset(level->blocks, 0, sizeof(BoardBlock) * level->columns * level->rows);
+    board_pyramid_mark_dirty(level, 0, 0, level->columns, level->rows);
+    pyramid->level_count += 1;
+    if(level->columns <= 1 && level->rows <= 1)
+      break;
+  }
+
+  //- nb: Level 0, a byte of each plane per block row
+  BoardPyramidLevel *base = &pyramid->levels[0];
+  for(u32 y = 0; y < board->rows; y++)
+  {
+    BoardBlock *row_blocks = base->blocks + (u64)(y >> BOARD_PYRAMID_SHIFT) * base->columns;
+    u64 row_offset = (u64)y * board->words_per_row;
+    for(u32 bx = 0; bx < base->columns; bx++)
+    {
+      u32 x = bx * side;
+      u32 w = x / 64;
+      u32 bit = x % 64;
+      u64 swept = (board->swept_plane[row_offset + w] >> bit) & 0xff;
+      u64 flag  = (board->flag_plane[row_offset + w]  >> bit) & 0xff;
+      u32 cells = Min(side, board->columns - x);
+      u32 swept_count   = count_bits_u64(swept);
+      u32 flagged_count = count_bits_u64(flag & ~swept);
+      row_blocks[bx].swept   += swept_count;
+      row_blocks[bx].flagged += flagged_count;
+      row_blocks[bx].hidden  += cells - swept_count - flagged_count;
+    }
+  }
+
+  //- nb: Every level above sums the one below
+  for(u32 l = 1; l < pyramid->level_count; l++)
+  {
+    BoardPyramidLevel *child  = &pyramid->levels[l - 1];
+    BoardPyramidLevel *parent = &pyramid->levels[l];
+    for(u32 y = 0; y < child->rows; y++)
+    {
+      for(u32 x = 0; x < child->columns; x++)
+      {
+        BoardBlock *from = &child->blocks[(u64)y * child->columns + x];
+        BoardBlock *to   = &parent->blocks[(u64)(y >> BOARD_PYRAMID_SHIFT) * parent->columns + (x >> BOARD_PYRAMID_SHIFT)];
+        to->swept   += from->swept;
+        to->flagged += from->flagged;
+        to->hidden  += from->hidden;
+      }
+    }
+  }
+}
+
+void
+board_pyramid_apply(BoardPyramid *pyramid, BoardChange *changes, u64 count)
+{
+  for(u64 i = 0; i < count; i++)
+  {
+    BoardChange *change = &changes[i];
+    u32 tile_y = change->first_idx / pyramid->columns;
+    u32 tile_x = change->first_idx % pyramid->columns;
+    u32 left = change->run_length;
+    //- nb: row by row, every level gets the overlap of the row with each block
+    while(left > 0)
+    {
+      u32 x0 = tile_x;
+      u32 x1 = tile_x + Min(left, pyramid->columns - tile_x);
+      for(u32 l = 0; l < pyramid->level_count; l++)
+      {
+        BoardPyramidLevel *level = &pyramid->levels[l];
+        u32 by  = tile_y >> level->shift;
+        u32 bx0 = x0 >> level->shift;
+        u32 bx1 = ((x1 - 1) >> level->shift) + 1;
+        BoardBlock *row_blocks = level->blocks + (u64)by * level->columns;
+        for(u32 bx = bx0; bx < bx1; bx++)
+        {
+          u32 first = Max(x0, bx << level->shift);
+          u32 last  = (u32)Min((u64)x1, (u64)(bx + 1) << level->shift);
+          *board_block_count(&row_blocks[bx], change->old_state) -= last - first;
+          *board_block_count(&row_blocks[bx], change->new_state) += last - first;
+        }
+        board_pyramid_mark_dirty(level, bx0, by, bx1, by + 1);
+      }
+      left  -= x1 - x0;
+      tile_x = 0;
+      tile_y += 1;
+    }
+  }
+}
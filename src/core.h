@@ -0,0 +1,303 @@
+#ifndef CORE_H
+#define CORE_H
+
+////////////////////////////////
+//~ nb: Board core
+// Headless board logic: mine placement, sweeping, flood fill, chording and
+// game over. Only depends on base.h, so it builds without Win32 (build.sh).
+// The API is plain C so it can be driven from servers, tools and benchmarks.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//- nb: A map of the spritesheet tiles
+enum TileKind
+{
+  TILE_ONE,
+  TILE_TWO,
+  TILE_THREE,
+  TILE_FOUR,
+  TILE_FIVE,
+  TILE_SIX,
+  TILE_SEVEN,
+  TILE_EIGHT,
+  TILE_EMPTY,
+  TILE_DEFAULT,
+  TILE_FLAG,
+  TILE_MINECROSS,
+  TILE_QUESTIONMARK,
+  TILE_DEFAULTQUESTIONMARK,
+  TILE_MINE,
+  TILE_MINERED,
+  TILE_END
+};
+
+////////////////////////////////
+//~ nb: Packed tile
+// One byte per cell, the format tile state is handed out in. The board
+// itself keeps bit-planes (see Board), board_tile/board_tile_row pack them.
+// The sprite is not stored, it is derived from the state bits when
+// rendering (see tile_kind).
+//   bits 0-3  neighbor count (0-8)
+//   bit  4    mine
+//   bit  5    flag
+//   bit  6    swept
+//   bit  7    exploded, the mine that ended the game
+typedef u8 Tile;
+
+#define TILE_COUNT_MASK    0x0f
+#define TILE_BIT_MINE      (1 << 4)
+#define TILE_BIT_FLAG      (1 << 5)
+#define TILE_BIT_SWEPT     (1 << 6)
+#define TILE_BIT_EXPLODED  (1 << 7)
+
+static inline u32
+tile_kind(Tile tile)
+{
+  if(tile & TILE_BIT_SWEPT)
+  {
+    if(tile & TILE_BIT_MINE)
+      return (tile & TILE_BIT_EXPLODED) ? TILE_MINERED : TILE_MINE;
+    // nb: the sprite sheet starts at "1", so the count maps straight onto it
+    u32 count = tile & TILE_COUNT_MASK;
+    return count ? TILE_ONE + count - 1 : TILE_EMPTY;
+  }
+  return (tile & TILE_BIT_FLAG) ? TILE_FLAG : TILE_DEFAULT;
+}
+
+#define BOARD_IDX_NIL 0xffffffff
+
+////////////////////////////////
+//~ nb: Change records
+// Every state change a board call makes, as runs of consecutive tile indices
+// that all went from the same old state to the same new one. States are the
+// mutable bits of a Tile (flag, swept, exploded); counts and mines never
+// change after placement, board_tile has them. Replaying the records on top
+// of the old states gives the new ones, so renderers, replays, undo and
+// observers can work in O(changes).
+#define TILE_STATE_MASK (TILE_BIT_FLAG | TILE_BIT_SWEPT | TILE_BIT_EXPLODED)
+
+typedef struct BoardChange BoardChange;
+struct BoardChange
+{
+  u32  first_idx;
+  u32  run_length;
+  Tile old_state;
+  Tile new_state;
+};
+
+// nb: Records live in the caller's arena and grow by doubling, in place
+// while nothing else was pushed after them, otherwise into a fresh block
+// (the old one stays behind). `records` is contiguous.
+typedef struct BoardChangeList BoardChangeList;
+struct BoardChangeList
+{
+  Arena        *arena;
+  BoardChange  *records;
+  u64          count;
+  u64          capacity;
+};
+
+//- nb: a horizontal run of zero tiles, part of one opening
+typedef struct BoardRun BoardRun;
+struct BoardRun
+{
+  u32 y;
+  u32 x0;
+  u32 x1;
+  u32 opening;
+};
+
+//- nb: a sweep or flag toggle that waits for the reveal in flight
+typedef struct BoardAction BoardAction;
+struct BoardAction
+{
+  u32 idx;
+  b32 flag;
+};
+
+typedef struct Board Board;
+struct Board
+{
+  Arena         *arena;
+  // nb: everything pushed past this point is thrown away on reset
+  u64           arena_reset_pos;
+
+  ////////////////////////////////
+  // nb: Bit-planes, row-major, one bit per cell. Every row starts on a
+  // fresh u64 and the bits past `columns` are always zero.
+  u64           *mine_plane;
+  u64           *flag_plane;
+  u64           *swept_plane;
+  // nb: tiles with no mine around them, filled in with the counts
+  u64           *zero_plane;
+  u32           words_per_row;
+  // nb: neighboring mine count per cell, 0 for mines
+  u8            *neighbor_counts;
+  u32           exploded_idx;
+
+  ////////////////////////////////
+  // nb: Flood fill work list. Rows are queued at most once, together with
+  // the x range of freshly swept zero tiles that still have to spread, so
+  // the memory is bounded by the board height.
+  u32           *fill_row_queue;
+  u32           fill_queue_head;
+  u32           fill_queue_count;
+  u32           *fill_row_min;
+  u32           *fill_row_max;
+
+  ////////////////////////////////
+  // nb: Openings, built once the mines are placed (board_build_openings).
+  // An opening is an 8-connected region of zero tiles; sweeping it reveals
+  // its zero runs plus a one tile border. Runs are kept in row order for
+  // lookups and grouped per opening for reveals.
+  BoardRun      *opening_runs;
+  u32           *opening_row_first;       // rows + 1, into opening_runs
+  u32           *opening_run_list;        // run indices, grouped by opening
+  u32           *opening_first;           // opening_count + 1, into opening_run_list
+  // nb: flagged zero tiles per opening, they block the bulk reveal
+  u32           *opening_flagged_zeros;
+  u32           opening_count;
+  u32           largest_opening;
+  // nb: minimum number of clicks to clear the board
+  u32           bbbv;
+
+  ////////////////////////////////
+  // nb: Reveal job. Sweeps only queue the openings they hit (and flood fill
+  // rows, see above), board_reveal_step works them off within the budget so
+  // a huge opening can be spread over several frames.
+  u32           *reveal_opening_queue;    // each opening is queued at most once
+  u64           *reveal_opening_queued;   // one bit per opening
+  u32           reveal_queue_head;
+  u32           reveal_queue_tail;
+  u32           reveal_run_cursor;        // next run of the head opening, into opening_run_list
+  // nb: Flags steer the reveal, so a flag toggled while one is in flight
+  // waits for it to drain, and so does every sweep after it. The step
+  // applies them in order between reveals.
+  BoardAction   *deferred_actions;
+  u32           deferred_head;
+  u32           deferred_count;
+  // nb: per step limits, 0 means unlimited. Kept across resets.
+  u32           reveal_budget_tiles;
+  u32           reveal_budget_us;
+
+  // nb: where changes are recorded, 0 when nobody listens
+  BoardChangeList *changes;
+
+  ////////////////////////////////
+  // nb: Variables
+  b32           is_playable;
+  b32           mines_placed;
+  // nb: the whole mine layout follows from this and the first sweep,
+  // whatever thread_count is
+  u64           seed;
+  // nb: worker threads for mine placement, 0 picks one per logical core.
+  // Kept across resets.
+  u32           thread_count;
+  // nb: time the last placement spent filling the chunks, without the
+  // serial counts and openings after it
+  u64           place_fill_us;
+  u32           mine_count;
+  u32           swept_count;
+  u32           flag_count;
+  u32           columns;
+  u32           rows;
+  u32           tiles_count;
+};
+
+Board *board_alloc(void);
+void   board_release(Board *board);
+void   board_reset(Board *board, u32 columns, u32 rows, u32 mine_count, u64 seed);
+
+// nb: Sweeps a tile. The first sweep of a board places the mines around it
+// (first sweep protection). Returns 1 if a mine was hit, which also ends
+// the game. What the sweep uncovers is revealed by one board_reveal_step,
+// anything past the budget is left queued.
+b32    board_sweep(Board *board, u32 idx);
+// nb: Flags steer the flood fill, so a flag toggled while a reveal is in
+// flight is deferred until it drains, and sweeps after it wait as well
+// (those return 0, a mine they hit ends the game in a later step). Other
+// sweeps just queue behind the reveal, reveals only ever add swept tiles
+// so their order doesn't matter. Either way the board ends up as if every
+// reveal had finished right away.
+void   board_toggle_flag(Board *board, u32 idx);
+// nb: A reveal in flight carries on in later steps.
+void   board_gameover(Board *board);
+
+// nb: Every sweep, chord, reveal step, flag toggle and game over between
+// these appends to `list`. Grouping is up to the caller, e.g. by noting
+// list->count around each call.
+void   board_changes_begin(Board *board, BoardChangeList *list, Arena *arena);
+void   board_changes_end(Board *board);
+
+// nb: Works off queued reveal work until the budget runs out. Returns 1 if
+// work is left for the next step.
+b32    board_reveal_step(Board *board);
+b32    board_reveal_pending(Board *board);
+void   board_reveal_finish(Board *board);
+
+// nb: Rebuilds neighbor_counts and zero_plane from mine_plane in one
+// vectorized pass (AVX2, SSE2 or scalar, picked at compile time).
+void   board_compute_neighbor_counts(Board *board);
+// nb: Labels the zero regions by union-find over their runs and fills in
+// the opening tables and statistics. Called after mine placement, needs
+// neighbor_counts.
+void   board_build_openings(Board *board);
+
+////////////////////////////////
+//~ nb: Summary pyramid
+// Per block counts of swept, flagged and hidden tiles, for drawing a board
+// that is zoomed out too far for single tiles. Level 0 blocks are 8x8
+// tiles, each level above is 8x8 blocks of the one below, up to the level
+// where one block covers the board. Built once from the bit-planes, then
+// kept up to date from change records.
+#define BOARD_PYRAMID_SHIFT       3
+#define BOARD_PYRAMID_MAX_LEVELS  11
+
+//- nb: flagged means flagged and not swept, hidden neither
+typedef struct BoardBlock BoardBlock;
+struct BoardBlock
+{
+  u32 swept;
+  u32 flagged;
+  u32 hidden;
+};
+
+typedef struct BoardPyramidLevel BoardPyramidLevel;
+struct BoardPyramidLevel
+{
+  BoardBlock    *blocks;          // row-major
+  u32           columns;          // in blocks
+  u32           rows;
+  u32           shift;            // log2 of the block side, in tiles
+  // nb: blocks changed since the owner last cleared this, [x0, x1) x [y0, y1)
+  u32           dirty_x0;
+  u32           dirty_y0;
+  u32           dirty_x1;
+  u32           dirty_y1;
+};
+
+typedef struct BoardPyramid BoardPyramid;
+struct BoardPyramid
+{
+  BoardPyramidLevel levels[BOARD_PYRAMID_MAX_LEVELS];
+  u32           level_count;
+  u32           columns;          // of the board, in tiles
+  u32           rows;
+};
+
+// nb: Allocates in `arena` and counts every tile. All levels start dirty.
+void   board_pyramid_build(BoardPyramid *pyramid, Board *board, Arena *arena);
+void   board_pyramid_apply(BoardPyramid *pyramid, BoardChange *changes, u64 count);
+
+u32    board_idx_from_xy(Board *board, u32 tile_x, u32 tile_y);
+Tile   board_tile(Board *board, u32 idx);
+// nb: Packs `count` tiles of row `tile_y`, starting at `tile_x`, into `out`.
+void   board_tile_row(Board *board, u32 tile_y, u32 tile_x, u32 count, Tile *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CORE_H
@@ -1,18 +1,83 @@
 
-// TODO(nb): need to cache this
-
 #include "font.h"
 
+#define FONT_FAMILY_NAME L"Segoe UI"
+// nb: the largest the baked atlas may get, it is as small as the glyphs allow
 #define FONT_ATLAS_SIZE 1024
+#define FONT_ATLAS_PACKING RECT_PACK_MAXRECTS
 #define FONT_SIZE 48 * 96.0f / 72.0f
+#define FONT_PIXELS_PER_DIP 1.0f
+// nb: R8, or BC4 for half the memory, encoded after baking
+#define FONT_ATLAS_FORMAT R_TEX2D_FORMAT_R8
+// nb: the baked atlas, next to sheet.png. Delete it to force a rebake, a
+// stale or broken one is rebaked on its own (see font_cache.h).
+#define FONT_CACHE_PATH "font_cache.bin"
+// nb: em size the distance fields are baked at, font_draw_text_sized scales
+// from it. The field reaches R_TEX2D_SDF_RANGE / 2 texels past the edges.
+#define FONT_SDF_SIZE 32.0f
+#define FONT_SDF_PAD (u32)(R_TEX2D_SDF_RANGE / 2)
+// nb: the baked distance fields, same file format as FONT_CACHE_PATH
+#define FONT_SDF_CACHE_PATH "font_sdf_cache.bin"
+// nb: font ids in the text cache's keys
+#define FONT_RUN_ATLAS 0
+#define FONT_RUN_SDF   1
+
+global const u8 font_ascii_glyphs[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz 1234567890!-_/\\':;,.+-=*%";
+
+//- nb: GDI target the glyphs are drawn into, only needed when baking
+internal void
+font_create_rasterizer()
+{
+  font_dwrite_state->factory->CreateRenderingParams(&font_dwrite_state->base_rendering_params);
+  font_dwrite_state->factory->GetGdiInterop(&font_dwrite_state->gdi_interop);
+  font_dwrite_state->bitmap_render_target_dim = DirectX::XMINT2(2048, 256);
+  font_dwrite_state->gdi_interop->CreateBitmapRenderTarget(0, 
+                                                           font_dwrite_state->bitmap_render_target_dim.x, 
+                                                           font_dwrite_state->bitmap_render_target_dim.y, 
+                                                           &font_dwrite_state->bitmap_render_target);
+  font_dwrite_state->bitmap_render_target->SetPixelsPerDip(FONT_PIXELS_PER_DIP);
+}
+
+//- nb: tallest first into the smallest square atlas that takes them all
+// (see the "rectpack" bench), returns its size
+internal u32
+font_pack_atlas(Arena *arena, const u32 *width, const u32 *height, u32 count, Rect_Pack_Rect *rects)
+{
+  Temp temp = temp_begin(arena);
+  u32 *order = (u32*)arena_push(temp.arena, sizeof(u32) * count);
+  for(u32 i = 0; i < count; i++)
+  {
+    order[i] = i;
+    for(u32 j = i; j > 0 && height[order[j - 1]] < height[order[j]]; j--)
+    {
+      u32 swap = order[j]; order[j] = order[j - 1]; order[j - 1] = swap;
+    }
+  }
+  u32 atlas_size = 128;
+  for(;; atlas_size *= 2)
+  {
+    Temp pack_temp = temp_begin(temp.arena);
+    Rect_Packer *packer = rect_pack_alloc(pack_temp.arena, FONT_ATLAS_PACKING, atlas_size, atlas_size, count);
+    u32 packed = 0;
+    while(packed < count && rect_pack_insert(packer, width[order[packed]], height[order[packed]], &rects[order[packed]]))
+      packed += 1;
+    temp_end(pack_temp);
+    if(packed == count)
+      break;
+    // nb: doesn't fit at all, the glyphs are too big for FONT_ATLAS_SIZE
+    if(atlas_size >= FONT_ATLAS_SIZE)
+      __debugbreak();
+  }
+  temp_end(temp);
+  return atlas_size;
+}
 
 internal void
 font_bake_ascii_atlas()
 {
-  const u8 text[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz 1234567890!-_/\\':;,.+-=*%";
-  const u32 count = sizeof(text) / sizeof(text[0]) - 1;
+  const u8 *text = font_ascii_glyphs;
+  const u32 count = sizeof(font_ascii_glyphs) - 1;
   
-  u8 *atlas_buffer = (u8*)arena_push(font_dwrite_state->arena, FONT_ATLAS_SIZE * FONT_ATLAS_SIZE * 4);
   Temp temp = temp_begin(font_dwrite_state->frame_arena);
   u32 *codepoints = (u32*)arena_push(temp.arena, sizeof(u32) * count);
   for(u32 i = 0; i < count; i++)
@@ -33,6 +98,27 @@ font_bake_ascii_atlas()
   f32 ascent  = font_metrics.ascent * scale;
   f32 descent = font_metrics.descent * scale;
   
+  u32 padding = 2;
+  u32 *padded_w = (u32*)arena_push(temp.arena, sizeof(u32) * count);
+  u32 *padded_h = (u32*)arena_push(temp.arena, sizeof(u32) * count);
+  for(u32 i = 0; i < count; i++)
+  {
+    f32 tsb     = (f32)glyph_metrics[i].topSideBearing * scale;
+    f32 bsb     = (f32)glyph_metrics[i].bottomSideBearing * scale;
+    f32 glyph_w = (f32)(glyph_metrics[i].advanceWidth - 
+                        glyph_metrics[i].leftSideBearing - 
+                        glyph_metrics[i].rightSideBearing) * scale;
+    f32 glyph_h = (f32)(font_metrics.ascent + font_metrics.descent) * scale - tsb - bsb;
+    padded_w[i] = (u32)ceilf(Max(glyph_w, 0.0f)) + (padding * 2);
+    padded_h[i] = (u32)ceilf(Max(glyph_h, 0.0f)) + (padding * 2);
+  }
+  Rect_Pack_Rect *rects = (Rect_Pack_Rect*)arena_push(temp.arena, sizeof(Rect_Pack_Rect) * count);
+  u32 atlas_size = font_pack_atlas(temp.arena, padded_w, padded_h, count, rects);
+  
+  //- nb: coverage only, the sprite shader puts it under white
+  u8 *atlas_buffer = (u8*)arena_push(temp.arena, atlas_size * atlas_size);
+  memset(atlas_buffer, 0, atlas_size * atlas_size);
+  
   HDC dc = font_dwrite_state->bitmap_render_target->GetMemoryDC();
   HBRUSH black_brush = CreateSolidBrush(RGB(0, 0, 0));
   DIBSECTION dib = {0};
@@ -41,56 +127,27 @@ font_bake_ascii_atlas()
   u8 *src_pixels = (u8*)dib.dsBm.bmBits;
   u32 src_pitch  = dib.dsBm.bmWidthBytes;
   
-  // TODO(nb): store in atlas struct for multiple atlases
-  u32 shelf_x = 0;
-  u32 shelf_y = 0;
-  u32 shelf_h = 0;
-  u32 padding = 2;
   for(u32 i = 0; i < count; i++)
   {
-    // if (is_cached(glyph_idx[i])) continue;
-    
     f32 lsb     = (f32)glyph_metrics[i].leftSideBearing * scale;
     f32 tsb     = (f32)glyph_metrics[i].topSideBearing * scale;
-    f32 bsb     = (f32)glyph_metrics[i].bottomSideBearing * scale;
     f32 advance = (f32)glyph_metrics[i].advanceWidth * scale;
-    f32 glyph_w = (f32)(glyph_metrics[i].advanceWidth - 
-                        glyph_metrics[i].leftSideBearing - 
-                        glyph_metrics[i].rightSideBearing) * scale;
-    f32 glyph_h = (f32)(font_metrics.ascent + font_metrics.descent) * scale - tsb - bsb;
-    u32 padded_w  = (u32)ceilf(glyph_w)  + (padding * 2);
-    u32 padded_h  = (u32)ceilf(glyph_h)  + (padding * 2);
+    Rect_Pack_Rect *slot = &rects[i];
     
-    if(shelf_x + padded_w > FONT_ATLAS_SIZE)
-    {
-      shelf_x = 0;
-      shelf_y += shelf_h;
-      shelf_h = 0;
-    }
-    if(shelf_y + padded_h > FONT_ATLAS_SIZE)
-    {
-      // TODO(nb): atlas is full, create a new one
-      //__debugbreak();
-      break;
-    }
-    if(padded_h > shelf_h)
-    {
-      shelf_h = padded_h;
-    }
     // nb: store metrics
-    const f32 uv_size = 1.0f / FONT_ATLAS_SIZE;
+    const f32 uv_size = 1.0f / atlas_size;
     font_glyph_metrics[text[i]].left_bearing = roundf(lsb - padding);
     font_glyph_metrics[text[i]].top_bearing  = roundf(tsb - padding);
     font_glyph_metrics[text[i]].advance      = advance;
-    font_glyph_metrics[text[i]].width        = padded_w;
-    font_glyph_metrics[text[i]].height       = padded_h;
-    font_glyph_metrics[text[i]].u0           = (f32)shelf_x * uv_size;
-    font_glyph_metrics[text[i]].v0           = (f32)shelf_y * uv_size;
-    font_glyph_metrics[text[i]].u1           = (f32)(shelf_x + padded_w) * uv_size;
-    font_glyph_metrics[text[i]].v1           = (f32)(shelf_y + padded_h) * uv_size;
+    font_glyph_metrics[text[i]].width        = slot->width;
+    font_glyph_metrics[text[i]].height       = slot->height;
+    font_glyph_metrics[text[i]].u0           = (f32)slot->x * uv_size;
+    font_glyph_metrics[text[i]].v0           = (f32)slot->y * uv_size;
+    font_glyph_metrics[text[i]].u1           = (f32)(slot->x + slot->width) * uv_size;
+    font_glyph_metrics[text[i]].v1           = (f32)(slot->y + slot->height) * uv_size;
     
     ////////////////////////////////
-    RECT fill_rect = {0, 0, (LONG)padded_w, (LONG)padded_h};
+    RECT fill_rect = {0, 0, (LONG)slot->width, (LONG)slot->height};
     FillRect(dc, &fill_rect, black_brush);
     DWRITE_GLYPH_RUN glyph_run = {0};
     {
@@ -109,68 +166,482 @@ font_bake_ascii_atlas()
                                                           font_dwrite_state->base_rendering_params,
                                                           0xFFFFFF,
                                                           &rect);
-    for(u32 y = 0; y < padded_h; y++)
+    for(u32 y = 0; y < slot->height; y++)
     {
-      for(u32 x = 0; x < padded_w; x++)
+      for(u32 x = 0; x < slot->width; x++)
       {
         u8 *src_pixel = src_pixels + (y * src_pitch) + (x * 4);
         u8 intensity = src_pixel[0];
-        u32 atlas_idx = ((shelf_y + y) * FONT_ATLAS_SIZE + (shelf_x + x)) * 4;
-        atlas_buffer[atlas_idx + 0] = 255;
-        atlas_buffer[atlas_idx + 1] = 255;
-        atlas_buffer[atlas_idx + 2] = 255;
-        atlas_buffer[atlas_idx + 3] = intensity;
+        u32 atlas_idx = (slot->y + y) * atlas_size + (slot->x + x);
+        atlas_buffer[atlas_idx] = intensity;
       }
     }
-    shelf_x += padded_w;
   }
   
   DeleteObject(black_brush);
-  temp_end(temp);
   
   // Update the GPU texture with the new buffer contents
-  R_Handle handle = r_tex2d_alloc({FONT_ATLAS_SIZE, FONT_ATLAS_SIZE}, atlas_buffer);
+  void *atlas_data = atlas_buffer;
+  if(r_tex2d_format_is_compressed(FONT_ATLAS_FORMAT))
+  {
+    u32 *texels = (u32*)arena_push(temp.arena, sizeof(u32) * atlas_size * atlas_size);
+    r_tex2d_unpack(R_TEX2D_FORMAT_R8, texels, atlas_buffer, atlas_size * atlas_size);
+    atlas_data = arena_push(temp.arena, r_tex2d_size(FONT_ATLAS_FORMAT, atlas_size, atlas_size));
+    r_bc_encode(FONT_ATLAS_FORMAT, texels, atlas_size, atlas_size, atlas_data);
+  }
+  R_Handle handle = r_tex2d_alloc(FONT_ATLAS_FORMAT, {atlas_size, atlas_size}, atlas_data);
+  font_cache_write(font_dwrite_state->frame_arena, FONT_CACHE_PATH, font_dwrite_state->cache_key, FONT_ATLAS_FORMAT,
+                   atlas_size, atlas_size, atlas_data, font_glyph_metrics);
+  temp_end(temp);
   font_dwrite_state->ascii_atlas = handle;
 }
 
+//- nb: The cache keeps Font_Glyph_Metrics, the distance field glyphs fit
+// them with the advance in 1/64 pixels. Everything else is whole texels.
+internal void
+font_sdf_glyphs_to_metrics(Font_Glyph_Metrics *metrics)
+{
+  for(u32 c = 0; c < FONT_GLYPH_COUNT; c++)
+  {
+    Font_SDF_Glyph *glyph = &font_sdf_glyphs[c];
+    Font_Glyph_Metrics *m = &metrics[c];
+    memset(m, 0, sizeof(*m));
+    m->u0 = glyph->u0; m->v0 = glyph->v0;
+    m->u1 = glyph->u1; m->v1 = glyph->v1;
+    m->width        = (u32)glyph->width;
+    m->height       = (u32)glyph->height;
+    m->left_bearing = (s32)glyph->left_bearing;
+    m->top_bearing  = (s32)glyph->top_bearing;
+    m->advance      = (s32)roundf(glyph->advance * 64.0f);
+  }
+}
+
+internal void
+font_sdf_glyphs_from_metrics(const Font_Glyph_Metrics *metrics)
+{
+  for(u32 c = 0; c < FONT_GLYPH_COUNT; c++)
+  {
+    Font_SDF_Glyph *glyph = &font_sdf_glyphs[c];
+    const Font_Glyph_Metrics *m = &metrics[c];
+    glyph->u0 = m->u0; glyph->v0 = m->v0;
+    glyph->u1 = m->u1; glyph->v1 = m->v1;
+    glyph->width        = (f32)m->width;
+    glyph->height       = (f32)m->height;
+    glyph->left_bearing = (f32)m->left_bearing;
+    glyph->top_bearing  = (f32)m->top_bearing;
+    glyph->advance      = (f32)m->advance / 64.0f;
+  }
+}
 
-// NOTE(nb): very cude, dont use this
-void
-draw_ascii_text(const char *str, f32 start_x, f32 start_y)
+//- nb: the ASCII set through font_rasterize_glyph at FONT_SDF_SIZE, packed
+// first so every glyph's field is built straight into its slot, on every
+// core. The gaps stay 0, as far outside as the field goes.
+internal void
+font_bake_sdf_atlas()
 {
-  u32 len = strlen(str);
-  InstanceData *instance_data = (InstanceData*)arena_push(font_dwrite_state->frame_arena, sizeof(InstanceData) * len);
+  const u8 *text = font_ascii_glyphs;
+  const u32 count = sizeof(font_ascii_glyphs) - 1;
   
-  f32 cursor_x = start_x;
-  for(int i = 0; str[i] != '\0'; i++)
-  {
-    Font_Glyph_Metrics *glyph = &font_glyph_metrics[str[i]];
-    f32 x = cursor_x + (f32)glyph->left_bearing;
-    f32 y = start_y + (f32)glyph->top_bearing;
-    f32 uv_w = glyph->u1 - glyph->u0;
-    f32 uv_h = glyph->v1 - glyph->v0;
-    instance_data[i] = 
+  Temp temp = temp_begin(font_dwrite_state->frame_arena);
+  u32 *codepoints = (u32*)arena_push(temp.arena, sizeof(u32) * count);
+  for(u32 i = 0; i < count; i++)
+  {
+    codepoints[i] = text[i];
+  }
+  u16 *glyph_idx = (u16*)arena_push(temp.arena, sizeof(u16) * count);
+  font_dwrite_state->font_face->GetGlyphIndices(codepoints, count, glyph_idx);
+  DWRITE_GLYPH_METRICS *glyph_metrics = (DWRITE_GLYPH_METRICS*)arena_push(temp.arena, sizeof(DWRITE_GLYPH_METRICS) * count);
+  font_dwrite_state->font_face->GetDesignGlyphMetrics(glyph_idx, count, glyph_metrics);
+  DWRITE_FONT_METRICS font_metrics = {0};
+  font_dwrite_state->font_face->GetMetrics(&font_metrics);
+  f32 scale = FONT_SDF_SIZE / (f32)font_metrics.designUnitsPerEm;
+  
+  //- nb: coverage first, the rasterizer reuses one buffer
+  Glyph_Bitmap  *bitmaps  = (Glyph_Bitmap*)arena_push(temp.arena, sizeof(Glyph_Bitmap) * count);
+  Glyph_SDF_Job *jobs     = (Glyph_SDF_Job*)arena_push(temp.arena, sizeof(Glyph_SDF_Job) * count);
+  u32           *job_of   = (u32*)arena_push(temp.arena, sizeof(u32) * count);
+  u32           *padded_w = (u32*)arena_push(temp.arena, sizeof(u32) * count);
+  u32           *padded_h = (u32*)arena_push(temp.arena, sizeof(u32) * count);
+  u32 job_count = 0;
+  for(u32 i = 0; i < count; i++)
+  {
+    Glyph_Key key = {0, (u32)(FONT_SDF_SIZE * 64.0f), glyph_idx[i]};
+    Glyph_Bitmap *bitmap = &bitmaps[i];
+    memset(bitmap, 0, sizeof(*bitmap));
+    job_of[i] = count;
+    if(!font_rasterize_glyph(&font_dwrite_state->glyph_rasterizer, key, bitmap) || bitmap->width == 0)
+      continue;
+    u8 *coverage = (u8*)arena_push(temp.arena, (u64)bitmap->width * bitmap->height);
+    for(u32 y = 0; y < bitmap->height; y++)
+    {
+      memcpy(coverage + y * bitmap->width, bitmap->coverage + y * bitmap->pitch, bitmap->width);
+    }
+    Glyph_SDF_Job *job = &jobs[job_count];
+    memset(job, 0, sizeof(*job));
+    job->coverage = coverage;
+    job->width    = bitmap->width;
+    job->height   = bitmap->height;
+    job->pitch    = bitmap->width;
+    job->pad      = FONT_SDF_PAD;
+    padded_w[job_count] = bitmap->width + FONT_SDF_PAD * 2;
+    padded_h[job_count] = bitmap->height + FONT_SDF_PAD * 2;
+    job_of[i] = job_count++;
+  }
+  Rect_Pack_Rect *rects = (Rect_Pack_Rect*)arena_push(temp.arena, sizeof(Rect_Pack_Rect) * ClampBot(job_count, 1u));
+  u32 atlas_size = font_pack_atlas(temp.arena, padded_w, padded_h, job_count, rects);
+  u8 *atlas_buffer = (u8*)arena_push(temp.arena, atlas_size * atlas_size);
+  memset(atlas_buffer, 0, atlas_size * atlas_size);
+  for(u32 j = 0; j < job_count; j++)
+  {
+    jobs[j].sdf       = atlas_buffer + rects[j].y * atlas_size + rects[j].x;
+    jobs[j].sdf_pitch = atlas_size;
+  }
+  glyph_sdf_build_jobs(temp.arena, jobs, job_count, 0);
+  
+  const f32 uv_size = 1.0f / atlas_size;
+  for(u32 i = 0; i < count; i++)
+  {
+    Font_SDF_Glyph *glyph = &font_sdf_glyphs[text[i]];
+    memset(glyph, 0, sizeof(*glyph));
+    glyph->advance = (f32)glyph_metrics[i].advanceWidth * scale;
+    if(job_of[i] == count)
+      continue;
+    Rect_Pack_Rect *slot = &rects[job_of[i]];
+    glyph->left_bearing = (f32)(bitmaps[i].left_bearing - (s32)FONT_SDF_PAD);
+    glyph->top_bearing  = (f32)(bitmaps[i].top_bearing - (s32)FONT_SDF_PAD);
+    glyph->width        = (f32)slot->width;
+    glyph->height       = (f32)slot->height;
+    glyph->u0           = (f32)slot->x * uv_size;
+    glyph->v0           = (f32)slot->y * uv_size;
+    glyph->u1           = (f32)(slot->x + slot->width) * uv_size;
+    glyph->v1           = (f32)(slot->y + slot->height) * uv_size;
+  }
+  font_dwrite_state->sdf_atlas = r_tex2d_alloc(R_TEX2D_FORMAT_SDF8, {atlas_size, atlas_size}, atlas_buffer);
+  Font_Glyph_Metrics *metrics = (Font_Glyph_Metrics*)arena_push(temp.arena, sizeof(Font_Glyph_Metrics) * FONT_GLYPH_COUNT);
+  font_sdf_glyphs_to_metrics(metrics);
+  font_cache_write(font_dwrite_state->frame_arena, FONT_SDF_CACHE_PATH, font_dwrite_state->sdf_cache_key,
+                   R_TEX2D_FORMAT_SDF8, atlas_size, atlas_size, atlas_buffer, metrics);
+  temp_end(temp);
+}
+
+////////////////////////////////
+//~ nb: Glyph cache backends
+//- nb: one glyph id through the same GDI target as the bake
+internal b32
+font_rasterize_glyph(Glyph_Rasterizer *rasterizer, Glyph_Key key, Glyph_Bitmap *bitmap)
+{
+  if(!font_dwrite_state->bitmap_render_target)
+    font_create_rasterizer();
+  
+  u16 glyph_idx = (u16)key.glyph;
+  DWRITE_GLYPH_METRICS glyph_metrics = {0};
+  if(FAILED(font_dwrite_state->font_face->GetDesignGlyphMetrics(&glyph_idx, 1, &glyph_metrics)))
+    return 0;
+  DWRITE_FONT_METRICS font_metrics = {0};
+  font_dwrite_state->font_face->GetMetrics(&font_metrics);
+  
+  f32 em_size = (f32)key.size / 64.0f;
+  f32 scale   = em_size / (f32)font_metrics.designUnitsPerEm;
+  f32 ascent  = font_metrics.ascent * scale;
+  f32 lsb     = (f32)glyph_metrics.leftSideBearing * scale;
+  f32 tsb     = (f32)glyph_metrics.topSideBearing * scale;
+  f32 bsb     = (f32)glyph_metrics.bottomSideBearing * scale;
+  f32 glyph_w = (f32)((s32)glyph_metrics.advanceWidth - 
+                      glyph_metrics.leftSideBearing - 
+                      (s32)glyph_metrics.rightSideBearing) * scale;
+  f32 glyph_h = (f32)(font_metrics.ascent + font_metrics.descent) * scale - tsb - bsb;
+  bitmap->advance = (s32)roundf((f32)glyph_metrics.advanceWidth * scale);
+  if(glyph_w <= 0.0f || glyph_h <= 0.0f)
+  {
+    bitmap->width  = 0;
+    bitmap->height = 0;
+    return 1;
+  }
+  
+  // nb: antialiasing bleeds a texel past the design box, and the pen is
+  // snapped to whole texels below so the box may move by half of one
+  u32 padding  = 1;
+  u32 padded_w = (u32)ceilf(glyph_w) + 1 + padding * 2;
+  u32 padded_h = (u32)ceilf(glyph_h) + 1 + padding * 2;
+  if(padded_w > (u32)font_dwrite_state->bitmap_render_target_dim.x ||
+     padded_h > (u32)font_dwrite_state->bitmap_render_target_dim.y)
+    return 0;
+  
+  HDC dc = font_dwrite_state->bitmap_render_target->GetMemoryDC();
+  HBRUSH black_brush = CreateSolidBrush(RGB(0, 0, 0));
+  DIBSECTION dib = {0};
+  HBITMAP gdi_bitmap = (HBITMAP)GetCurrentObject(dc, OBJ_BITMAP);
+  GetObject(gdi_bitmap, sizeof(dib), &dib);
+  u8 *src_pixels = (u8*)dib.dsBm.bmBits;
+  u32 src_pitch  = dib.dsBm.bmWidthBytes;
+  
+  RECT fill_rect = {0, 0, (LONG)padded_w, (LONG)padded_h};
+  FillRect(dc, &fill_rect, black_brush);
+  DeleteObject(black_brush);
+  DWRITE_GLYPH_RUN glyph_run = {0};
+  {
+    glyph_run.fontFace = font_dwrite_state->font_face;
+    glyph_run.fontEmSize = em_size;
+    glyph_run.glyphCount = 1;
+    glyph_run.glyphIndices = &glyph_idx;
+  }
+  RECT rect = {0};
+  font_dwrite_state->bitmap_render_target->DrawGlyphRun(padding - roundf(lsb),
+                                                        padding + ascent - roundf(tsb),
+                                                        DWRITE_MEASURING_MODE_NATURAL,
+                                                        &glyph_run,
+                                                        font_dwrite_state->base_rendering_params,
+                                                        0xFFFFFF,
+                                                        &rect);
+  
+  if(!font_dwrite_state->glyph_coverage)
+  {
+    u64 size = (u64)font_dwrite_state->bitmap_render_target_dim.x * font_dwrite_state->bitmap_render_target_dim.y;
+    font_dwrite_state->glyph_coverage = (u8*)arena_push(font_dwrite_state->arena, size);
+  }
+  u8 *coverage = font_dwrite_state->glyph_coverage;
+  for(u32 y = 0; y < padded_h; y++)
+  {
+    for(u32 x = 0; x < padded_w; x++)
+    {
+      coverage[y * padded_w + x] = src_pixels[y * src_pitch + x * 4];
+    }
+  }
+  bitmap->width        = padded_w;
+  bitmap->height       = padded_h;
+  bitmap->pitch        = padded_w;
+  bitmap->coverage     = coverage;
+  bitmap->left_bearing = (s32)roundf(lsb) - (s32)padding;
+  bitmap->top_bearing  = (s32)roundf(tsb) - (s32)padding;
+  return 1;
+}
+
+internal R_Handle
+font_glyph_page_alloc(Glyph_PageBackend *backend, u32 size)
+{
+  Temp temp = temp_begin(font_dwrite_state->frame_arena);
+  void *zeros = arena_push(temp.arena, (u64)size * size);
+  memset(zeros, 0, (u64)size * size);
+  R_Handle page = r_tex2d_alloc(R_TEX2D_FORMAT_R8, {size, size}, zeros);
+  temp_end(temp);
+  return page;
+}
+
+internal void
+font_glyph_page_update(Glyph_PageBackend *backend, R_Handle page, u32 x, u32 y, u32 width, u32 height, const u8 *coverage)
+{
+  r_tex2d_update(page, x, y, width, height, coverage);
+}
+
+internal void
+font_glyph_page_release(Glyph_PageBackend *backend, R_Handle page)
+{
+  r_tex2d_release(page);
+}
+
+////////////////////////////////
+//~ nb: Text
+//- nb: next codepoint, malformed bytes come out as U+FFFD one at a time
+internal u32
+font_utf8_decode(const u8 *str, u32 *advance)
+{
+  u32 c = str[0];
+  u32 length = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xe ? 3 : (c >> 3) == 0x1e ? 4 : 0;
+  if(length == 0)
+  {
+    *advance = 1;
+    return 0xfffd;
+  }
+  u32 codepoint = length == 1 ? c : c & (0x7f >> length);
+  for(u32 i = 1; i < length; i++)
+  {
+    if((str[i] & 0xc0) != 0x80)
+    {
+      *advance = i;
+      return 0xfffd;
+    }
+    codepoint = (codepoint << 6) | (str[i] & 0x3f);
+  }
+  *advance = length;
+  return codepoint;
+}
+
+//- nb: codepoints and their glyph ids, on `arena`
+internal u32
+font_decode_glyphs(Arena *arena, const char *utf8, u32 **codepoints_out, u16 **glyph_idx_out)
+{
+  u32 len = (u32)strlen(utf8);
+  u32 *codepoints = (u32*)arena_push(arena, sizeof(u32) * ClampBot(len, 1u));
+  u32 count = 0;
+  for(u32 at = 0; at < len;)
+  {
+    u32 advance = 0;
+    codepoints[count++] = font_utf8_decode((const u8*)utf8 + at, &advance);
+    at += advance;
+  }
+  u16 *glyph_idx = (u16*)arena_push(arena, sizeof(u16) * ClampBot(count, 1u));
+  font_dwrite_state->font_face->GetGlyphIndices(codepoints, count, glyph_idx);
+  *codepoints_out = codepoints;
+  *glyph_idx_out  = glyph_idx;
+  return count;
+}
+
+//- nb: a glyph outside the baked set, through the glyph cache at `size`
+internal f32
+font_push_cached_glyph(u16 glyph_idx, f32 size, f32 x, f32 y, R_Handle *texture, R_Quad *quad, u32 *quad_count)
+{
+  Glyph_Key key = {0, (u32)(size * 64.0f), glyph_idx};
+  const Glyph_Slot *slot = glyph_cache_get(font_dwrite_state->glyph_cache, key);
+  if(slot->page.U64[0] != 0)
+  {
+    *texture = slot->page;
+    *quad = 
     {
-      {x, y},
-      {(f32)glyph->width, (f32)glyph->height}, 
-      {glyph->u0, glyph->v0, uv_w, uv_h}
+      {x + (f32)slot->left_bearing, y + (f32)slot->top_bearing},
+      {(f32)slot->width, (f32)slot->height}, 
+      {slot->uv_rect[0], slot->uv_rect[1], slot->uv_rect[2], slot->uv_rect[3]}
     };
-    
-    cursor_x += (f32)glyph->advance;
+    *quad_count += 1;
+  }
+  return (f32)slot->advance;
+}
+
+//- nb: ASCII from the baked atlas, or the distance field atlas scaled to
+// `size`, everything else through the glyph cache. Quads on the same
+// texture next to each other become one batch.
+internal void
+font_layout_text(Arena *arena, const char *utf8, f32 start_x, f32 start_y, f32 size, u32 font, Text_Run *run)
+{
+  u32 *codepoints = 0;
+  u16 *glyph_idx  = 0;
+  u32 count = font_decode_glyphs(arena, utf8, &codepoints, &glyph_idx);
+  
+  R_Handle *textures = (R_Handle*)arena_push(arena, sizeof(R_Handle) * ClampBot(count, 1u));
+  R_Quad *quads = (R_Quad*)arena_push(arena, sizeof(R_Quad) * ClampBot(count, 1u));
+  u32 quad_count = 0;
+  b32 transient = 0;
+  f32 scale = size / FONT_SDF_SIZE;
+  f32 cursor_x = start_x;
+  for(u32 i = 0; i < count; i++)
+  {
+    u32 c = codepoints[i];
+    if(font == FONT_RUN_ATLAS && c < FONT_GLYPH_COUNT && font_glyph_metrics[c].width > 0)
+    {
+      Font_Glyph_Metrics *glyph = &font_glyph_metrics[c];
+      textures[quad_count] = font_dwrite_state->ascii_atlas;
+      quads[quad_count++] = 
+      {
+        {cursor_x + (f32)glyph->left_bearing, start_y + (f32)glyph->top_bearing},
+        {(f32)glyph->width, (f32)glyph->height}, 
+        {glyph->u0, glyph->v0, glyph->u1 - glyph->u0, glyph->v1 - glyph->v0}
+      };
+      cursor_x += (f32)glyph->advance;
+      continue;
+    }
+    if(font == FONT_RUN_SDF && c < FONT_GLYPH_COUNT && font_sdf_glyphs[c].advance > 0.0f)
+    {
+      Font_SDF_Glyph *glyph = &font_sdf_glyphs[c];
+      if(glyph->width > 0.0f)
+      {
+        textures[quad_count] = font_dwrite_state->sdf_atlas;
+        quads[quad_count++] = 
+        {
+          {cursor_x + glyph->left_bearing * scale, start_y + glyph->top_bearing * scale},
+          {glyph->width * scale, glyph->height * scale}, 
+          {glyph->u0, glyph->v0, glyph->u1 - glyph->u0, glyph->v1 - glyph->v0}
+        };
+      }
+      cursor_x += glyph->advance * scale;
+      continue;
+    }
+    // nb: glyph cache slots can move once their frame is over
+    transient = 1;
+    cursor_x += font_push_cached_glyph(glyph_idx[i], size, cursor_x, start_y,
+                                       &textures[quad_count], &quads[quad_count], &quad_count);
+  }
+  
+  Text_Run_Batch *batches = (Text_Run_Batch*)arena_push(arena, sizeof(Text_Run_Batch) * ClampBot(quad_count, 1u));
+  u32 batch_count = 0;
+  for(u32 first = 0; first < quad_count;)
+  {
+    u32 last = first + 1;
+    while(last < quad_count && textures[last].U64[0] == textures[first].U64[0])
+      last += 1;
+    batches[batch_count++] = {textures[first], first, last - first};
+    first = last;
+  }
+  run->quads       = quads;
+  run->quad_count  = quad_count;
+  run->batches     = batches;
+  run->batch_count = batch_count;
+  run->advance     = cursor_x - start_x;
+  run->transient   = transient;
+}
+
+//- nb: the run from the text cache, laid out again only when the string,
+// font, size or position changed
+internal void
+font_draw_run(const char *utf8, f32 start_x, f32 start_y, f32 size, u32 font)
+{
+  Text_Run_Key key = {font, (u32)(size * 64.0f), start_x, start_y};
+  Temp temp = temp_begin(font_dwrite_state->frame_arena);
+  const Text_Run *run = text_cache_get(font_dwrite_state->text_cache, key, utf8);
+  if(!run)
+  {
+    Text_Run laid_out = {0};
+    font_layout_text(temp.arena, utf8, start_x, start_y, size, font, &laid_out);
+    run = text_cache_put(font_dwrite_state->text_cache, key, utf8, &laid_out);
+  }
+  for(u32 b = 0; b < run->batch_count; b++)
+  {
+    const Text_Run_Batch *batch = &run->batches[b];
+    InstanceData *instance_data = r_push_quads(batch->texture, R_LAYER_UI, batch->quad_count);
+    memcpy(instance_data, run->quads + batch->first_quad, sizeof(R_Quad) * batch->quad_count);
   }
-  r_submit_batch(instance_data, len, font_dwrite_state->ascii_atlas);
+  temp_end(temp);
+}
+
+void
+font_draw_text(const char *utf8, f32 start_x, f32 start_y)
+{
+  font_draw_run(utf8, start_x, start_y, FONT_SIZE, FONT_RUN_ATLAS);
+}
+
+//- nb: `size` is the em size in pixels. ASCII comes from the distance
+// field atlas scaled to it (ps_sdf keeps the edges sharp), everything else
+// is rasterized at that size by the glyph cache.
+void
+font_draw_text_sized(const char *utf8, f32 start_x, f32 start_y, f32 size)
+{
+  font_draw_run(utf8, start_x, start_y, size, FONT_RUN_SDF);
+}
+
+Text_Cache_Stats
+font_text_frame_stats()
+{
+  return text_cache_frame_stats(font_dwrite_state->text_cache);
+}
+
+void
+draw_ascii_text(const char *str, f32 start_x, f32 start_y)
+{
+  font_draw_text(str, start_x, start_y);
 }
 
 void font_frame()
 {
   arena_clear(font_dwrite_state->frame_arena);
+  glyph_cache_frame(font_dwrite_state->glyph_cache);
+  text_cache_frame(font_dwrite_state->text_cache);
 }
 
 void 
 font_init()
 {
+  u64 begin = os_now_microseconds();
   Arena *arena = arena_alloc();
   font_dwrite_state = (Font_DWrite_State*)arena_push(arena, sizeof(Font_DWrite_State));
+  memset(font_dwrite_state, 0, sizeof(Font_DWrite_State));
   font_dwrite_state->arena = arena;
   
   Arena *frame_arena = arena_alloc();
@@ -183,22 +654,12 @@ font_init()
   if(FAILED(hr))
     __debugbreak();
   
-  font_dwrite_state->factory->CreateRenderingParams(&font_dwrite_state->base_rendering_params);
-  font_dwrite_state->factory->GetGdiInterop(&font_dwrite_state->gdi_interop);
-  font_dwrite_state->bitmap_render_target_dim = DirectX::XMINT2(2048, 256);
-  font_dwrite_state->gdi_interop->CreateBitmapRenderTarget(0, 
-                                                           font_dwrite_state->bitmap_render_target_dim.x, 
-                                                           font_dwrite_state->bitmap_render_target_dim.y, 
-                                                           &font_dwrite_state->bitmap_render_target);
-  font_dwrite_state->bitmap_render_target->SetPixelsPerDip(1.0);
-  
-  
   //- nb: Get font
   IDWriteFontCollection* system_collection = NULL;
   font_dwrite_state->factory->GetSystemFontCollection(&system_collection, FALSE);
   uint32_t index = 0;
   BOOL exists = FALSE;
-  system_collection->FindFamilyName(L"Segoe UI", &index, &exists);
+  system_collection->FindFamilyName(FONT_FAMILY_NAME, &index, &exists);
   
   // nb: Font fallback
   if(!exists) 
@@ -217,13 +678,83 @@ font_init()
   IDWriteFontFace* font_face = NULL;
   font->CreateFontFace(&font_face);
   font_dwrite_state->font_face = font_face;
+  
+  //- nb: the family we got, not the one asked for, keys the cache
+  char family_name[256] = {0};
+  IDWriteLocalizedStrings *names = NULL;
+  if(SUCCEEDED(family->GetFamilyNames(&names)))
+  {
+    wchar_t wide_name[256] = {0};
+    names->GetString(0, wide_name, ArrayCount(wide_name));
+    WideCharToMultiByte(CP_UTF8, 0, wide_name, -1, family_name, sizeof(family_name), NULL, NULL);
+    names->Release();
+  }
   ////////////////////////////////
   
   font->Release();
   family->Release();
   system_collection->Release();
   
-  font_bake_ascii_atlas();
+  Font_Cache_Key key = {0};
+  key.font_name   = family_name;
+  key.size        = FONT_SIZE;
+  key.dpi         = 96.0f * FONT_PIXELS_PER_DIP;
+  key.atlas_size  = FONT_ATLAS_SIZE;
+  key.format      = FONT_ATLAS_FORMAT;
+  key.glyphs      = font_ascii_glyphs;
+  key.glyph_count = sizeof(font_ascii_glyphs) - 1;
+  font_dwrite_state->cache_key = font_cache_key_hash(&key);
+  
+  //- nb: a warm cache goes straight from the mapped file to the GPU
+  Font_Cache cache = font_cache_open(FONT_CACHE_PATH, font_dwrite_state->cache_key);
+  font_dwrite_state->cache_status = cache.status;
+  if(cache.status == FONT_CACHE_HIT)
+  {
+    memcpy(font_glyph_metrics, cache.metrics, sizeof(font_glyph_metrics));
+    font_dwrite_state->ascii_atlas = r_tex2d_alloc(cache.format, {cache.width, cache.height}, (void*)cache.atlas);
+    font_cache_close(&cache);
+  }
+  else
+  {
+    font_create_rasterizer();
+    font_bake_ascii_atlas();
+  }
+  font_dwrite_state->atlas_load_us = os_now_microseconds() - begin;
+  
+  font_dwrite_state->glyph_rasterizer.rasterize = font_rasterize_glyph;
+  font_dwrite_state->glyph_pages.alloc          = font_glyph_page_alloc;
+  font_dwrite_state->glyph_pages.update         = font_glyph_page_update;
+  font_dwrite_state->glyph_pages.release        = font_glyph_page_release;
+  font_dwrite_state->glyph_cache = glyph_cache_alloc(glyph_cache_default_params(),
+                                                     &font_dwrite_state->glyph_rasterizer,
+                                                     &font_dwrite_state->glyph_pages);
+  font_dwrite_state->text_cache = text_cache_alloc(text_cache_default_params());
+  
+  //- nb: the distance fields the same way, baking them mid-frame would
+  // hitch the first sized text
+  u64 sdf_begin = os_now_microseconds();
+  key.size   = FONT_SDF_SIZE;
+  key.format = R_TEX2D_FORMAT_SDF8;
+  font_dwrite_state->sdf_cache_key = font_cache_key_hash(&key);
+  Font_Cache sdf_cache = font_cache_open(FONT_SDF_CACHE_PATH, font_dwrite_state->sdf_cache_key);
+  font_dwrite_state->sdf_cache_status = sdf_cache.status;
+  if(sdf_cache.status == FONT_CACHE_HIT)
+  {
+    font_sdf_glyphs_from_metrics(sdf_cache.metrics);
+    font_dwrite_state->sdf_atlas = r_tex2d_alloc(sdf_cache.format, {sdf_cache.width, sdf_cache.height}, (void*)sdf_cache.atlas);
+    font_cache_close(&sdf_cache);
+  }
+  else
+  {
+    font_bake_sdf_atlas();
+  }
+  font_dwrite_state->sdf_load_us = os_now_microseconds() - sdf_begin;
+  
+  char buff[128] = {};
+  sprintf_s(buff, sizeof(buff), "font_init: cache %s, %.2f ms, sdf cache %s, %.2f ms\n",
+            font_cache_status_string(font_dwrite_state->cache_status), font_dwrite_state->atlas_load_us / 1000.0,
+            font_cache_status_string(font_dwrite_state->sdf_cache_status), font_dwrite_state->sdf_load_us / 1000.0);
+  OutputDebugString(buff);
 }
 
 void
@@ -231,11 +762,18 @@ font_destroy()
 {
   font_dwrite_state->font_face->Release();
   font_dwrite_state->factory->Release();
-  font_dwrite_state->base_rendering_params->Release();
-  font_dwrite_state->gdi_interop->Release();
-  font_dwrite_state->bitmap_render_target->Release();
+  // nb: the rasterizer only exists when the atlas was baked this run
+  if(font_dwrite_state->base_rendering_params)
+    font_dwrite_state->base_rendering_params->Release();
+  if(font_dwrite_state->gdi_interop)
+    font_dwrite_state->gdi_interop->Release();
+  if(font_dwrite_state->bitmap_render_target)
+    font_dwrite_state->bitmap_render_target->Release();
+  glyph_cache_release(font_dwrite_state->glyph_cache);
+  text_cache_release(font_dwrite_state->text_cache);
   r_tex2d_release(font_dwrite_state->ascii_atlas);
   r_tex2d_release(font_dwrite_state->atlas);
+  r_tex2d_release(font_dwrite_state->sdf_atlas);
   arena_release(font_dwrite_state->frame_arena);
   arena_release(font_dwrite_state->arena);
 }
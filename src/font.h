@@ -7,19 +7,6 @@
 
 #include <dwrite_3.h>
 
-typedef struct Font_Glyph_Metrics ont_Glyph_Metrics;
-struct Font_Glyph_Metrics
-{
-  f32 u0, v0, u1, v1; // uv
-  u32 width;
-  u32 height;
-  s32 left_bearing;
-  s32 top_bearing;
-  s32 offset_x;
-  s32 offset_y;
-  s32 advance;
-};
-
 typedef struct Font_DWrite_State Font_DWrite_State;
 struct Font_DWrite_State
 {
@@ -34,6 +21,40 @@ struct Font_DWrite_State
   IDWriteFontFace           *font_face;
   R_Handle                  ascii_atlas;
   R_Handle                  atlas;
+  
+  // nb: how the atlas came to be this run, see font_cache.h
+  u64                       cache_key;
+  Font_Cache_Status         cache_status;
+  u64                       atlas_load_us;
+  
+  // nb: everything outside the baked ASCII set, see glyph_cache.h
+  Glyph_Rasterizer          glyph_rasterizer;
+  Glyph_PageBackend         glyph_pages;
+  Glyph_Cache               *glyph_cache;
+  u8                        *glyph_coverage;
+  
+  // nb: laid out strings kept across frames, see text_cache.h
+  Text_Cache                *text_cache;
+  
+  // nb: the ASCII set again as distance fields, for text at any size, see
+  // glyph_sdf.h. Loaded or baked by font_init like the atlas, in a cache
+  // file of its own.
+  R_Handle                  sdf_atlas;
+  u64                       sdf_cache_key;
+  Font_Cache_Status         sdf_cache_status;
+  u64                       sdf_load_us;
+};
+
+// nb: in FONT_SDF_SIZE pixels, font_draw_text_sized scales them to any size
+typedef struct Font_SDF_Glyph Font_SDF_Glyph;
+struct Font_SDF_Glyph
+{
+  f32 u0, v0, u1, v1; // uv
+  f32 width;
+  f32 height;
+  f32 left_bearing;
+  f32 top_bearing;
+  f32 advance;
 };
 
 ////////////////////////////////
@@ -41,14 +62,30 @@ struct Font_DWrite_State
 void font_init();
 void font_destroy();
 void draw_ascii_text(const char *str, f32 x, f32 y);
+void font_draw_text(const char *utf8, f32 x, f32 y);
+void font_draw_text_sized(const char *utf8, f32 x, f32 y, f32 size);
 void font_frame();
+// nb: text cache hits and glyphs laid out in the last frame
+Text_Cache_Stats font_text_frame_stats();
 
+internal void font_create_rasterizer();
+internal u32  font_pack_atlas(Arena *arena, const u32 *width, const u32 *height, u32 count, Rect_Pack_Rect *rects);
 internal void font_bake_ascii_atlas();
+internal void font_sdf_glyphs_to_metrics(Font_Glyph_Metrics *metrics);
+internal void font_sdf_glyphs_from_metrics(const Font_Glyph_Metrics *metrics);
+internal void font_bake_sdf_atlas();
+internal void font_layout_text(Arena *arena, const char *utf8, f32 x, f32 y, f32 size, u32 font, Text_Run *run);
+internal void font_draw_run(const char *utf8, f32 x, f32 y, f32 size, u32 font);
+internal b32  font_rasterize_glyph(Glyph_Rasterizer *rasterizer, Glyph_Key key, Glyph_Bitmap *bitmap);
+internal R_Handle font_glyph_page_alloc(Glyph_PageBackend *backend, u32 size);
+internal void font_glyph_page_update(Glyph_PageBackend *backend, R_Handle page, u32 x, u32 y, u32 width, u32 height, const u8 *coverage);
+internal void font_glyph_page_release(Glyph_PageBackend *backend, R_Handle page);
 
 ////////////////////////////////
 //~ nb: Globals
 global Font_DWrite_State *font_dwrite_state = {0};
 // ASCII lookup table
-global Font_Glyph_Metrics font_glyph_metrics[128];
+global Font_Glyph_Metrics font_glyph_metrics[FONT_GLYPH_COUNT];
+global Font_SDF_Glyph     font_sdf_glyphs[FONT_GLYPH_COUNT];
 
 #endif //FONT_H
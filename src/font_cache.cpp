@@ -0,0 +1,146 @@
+#include "font_cache.h"
+
+global const char *font_cache_status_strings[FONT_CACHE_STATUS_COUNT] =
+{
+  "hit",
+  "missing",
+  "corrupt",
+  "stale version",
+  "stale key",
+};
+
+////////////////////////////////
+//~ nb: Hashing
+// nb: eight bytes a step, a multiply and a fold, fast enough that checking a
+// warm cache costs far less than mapping it
+u64
+font_cache_hash(const void *data, u64 size, u64 seed)
+{
+  const u64 k = 0x9e3779b97f4a7c15ull;
+  const u8 *bytes = (const u8*)data;
+  u64 h = seed ^ (size * k);
+  u64 at = 0;
+  for(; at + 8 <= size; at += 8)
+  {
+    u64 word;
+    memcpy(&word, bytes + at, 8);
+    h = (h ^ word) * k;
+    h ^= h >> 32;
+  }
+  u64 tail = 0;
+  memcpy(&tail, bytes + at, size - at);
+  h = (h ^ tail) * k;
+  h ^= h >> 29;
+  return h;
+}
+
+u64
+font_cache_key_hash(Font_Cache_Key *key)
+{
+  u64 h = font_cache_hash(key->font_name, strlen(key->font_name), 0);
+  u32 params[4];
+  memcpy(&params[0], &key->size, 4);
+  memcpy(&params[1], &key->dpi, 4);
+  params[2] = key->atlas_size;
+  params[3] = (u32)key->format;
+  h = font_cache_hash(params, sizeof(params), h);
+  h = font_cache_hash(key->glyphs, key->glyph_count, h);
+  return h;
+}
+
+////////////////////////////////
+//~ nb: Reading and writing
+b32
+font_cache_write(Arena *scratch, const char *path, u64 key, R_Tex2DFormat format, u32 width, u32 height,
+                 const void *atlas, const Font_Glyph_Metrics *metrics)
+{
+  Font_Cache_Header header = {0};
+  header.magic          = FONT_CACHE_MAGIC;
+  header.version        = FONT_CACHE_VERSION;
+  header.key            = key;
+  header.format         = (u32)format;
+  header.width          = width;
+  header.height         = height;
+  header.glyph_count    = FONT_GLYPH_COUNT;
+  header.metrics_offset = sizeof(Font_Cache_Header);
+  header.atlas_offset   = AlignPow2(header.metrics_offset + sizeof(Font_Glyph_Metrics) * FONT_GLYPH_COUNT, 64);
+  header.atlas_size     = r_tex2d_size(format, width, height);
+
+  Temp temp = temp_begin(scratch);
+  u64 size = header.atlas_offset + header.atlas_size;
+  u8 *file = (u8*)arena_push(temp.arena, size);
+  memset(file, 0, header.atlas_offset);
+  memcpy(file + header.metrics_offset, metrics, sizeof(Font_Glyph_Metrics) * FONT_GLYPH_COUNT);
+  memcpy(file + header.atlas_offset, atlas, header.atlas_size);
+  header.checksum = font_cache_hash(file + sizeof(header), size - sizeof(header), header.key);
+  memcpy(file, &header, sizeof(header));
+  b32 ok = os_file_write(path, file, size);
+  temp_end(temp);
+  return ok;
+}
+
+//- nb: checks in order of cost, the checksum last
+internal Font_Cache_Status
+font_cache_check(OS_FileMap *map, u64 key, Font_Cache_Header *header)
+{
+  memset(header, 0, sizeof(*header));
+  if(map->size >= sizeof(*header))
+    memcpy(header, map->data, sizeof(*header));
+  if(header->magic != FONT_CACHE_MAGIC)
+    return FONT_CACHE_CORRUPT;
+  if(header->version != FONT_CACHE_VERSION)
+    return FONT_CACHE_STALE_VERSION;
+  if(header->key != key)
+    return FONT_CACHE_STALE_KEY;
+  u64 metrics_size = sizeof(Font_Glyph_Metrics) * FONT_GLYPH_COUNT;
+  b32 sizes_ok = (header->format < R_TEX2D_FORMAT_COUNT &&
+                  header->glyph_count == FONT_GLYPH_COUNT &&
+                  header->metrics_offset >= sizeof(*header) &&
+                  header->metrics_offset % 4 == 0 &&
+                  header->metrics_offset + metrics_size <= header->atlas_offset &&
+                  header->atlas_offset <= map->size &&
+                  header->atlas_size == r_tex2d_size((R_Tex2DFormat)header->format, header->width, header->height) &&
+                  header->atlas_offset + header->atlas_size == map->size);
+  if(!sizes_ok)
+    return FONT_CACHE_CORRUPT;
+  const u8 *bytes = (const u8*)map->data;
+  if(font_cache_hash(bytes + sizeof(*header), map->size - sizeof(*header), header->key) != header->checksum)
+    return FONT_CACHE_CORRUPT;
+  return FONT_CACHE_HIT;
+}
+
+Font_Cache
+font_cache_open(const char *path, u64 key)
+{
+  Font_Cache cache = {FONT_CACHE_MISSING};
+  if(!os_file_map(path, &cache.map))
+    return cache;
+  Font_Cache_Header header;
+  cache.status = font_cache_check(&cache.map, key, &header);
+  if(cache.status != FONT_CACHE_HIT)
+  {
+    os_file_unmap(&cache.map);
+    return cache;
+  }
+  const u8 *bytes = (const u8*)cache.map.data;
+  cache.format  = (R_Tex2DFormat)header.format;
+  cache.width   = header.width;
+  cache.height  = header.height;
+  cache.atlas   = bytes + header.atlas_offset;
+  cache.metrics = (const Font_Glyph_Metrics*)(bytes + header.metrics_offset);
+  return cache;
+}
+
+void
+font_cache_close(Font_Cache *cache)
+{
+  os_file_unmap(&cache->map);
+  cache->atlas   = 0;
+  cache->metrics = 0;
+}
+
+const char *
+font_cache_status_string(Font_Cache_Status status)
+{
+  return status < FONT_CACHE_STATUS_COUNT ? font_cache_status_strings[status] : "?";
+}
@@ -0,0 +1,107 @@
+#ifndef FONT_CACHE_H
+#define FONT_CACHE_H
+
+////////////////////////////////
+//~ nb: Font cache
+// The baked glyph atlas and its metrics on disk, so a start with a warm
+// cache maps the file and uploads it instead of rasterizing every glyph.
+// Everything here is plain data and files, the baking itself stays in
+// font.cpp (DirectWrite).
+//
+// File layout: Font_Cache_Header, then the glyph metrics, then the atlas
+// blocks in the header's format. A cache is only used when its magic,
+// version and key match, its sizes add up and its checksum holds; anything
+// else reads as a miss and gets rebaked and rewritten.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FONT_GLYPH_COUNT    128     // ASCII
+#define FONT_CACHE_MAGIC    0x43544e46u   // "FNTC"
+// nb: bump whenever the layout, Font_Glyph_Metrics or the baking changes
+#define FONT_CACHE_VERSION  2
+
+typedef struct Font_Glyph_Metrics Font_Glyph_Metrics;
+struct Font_Glyph_Metrics
+{
+  f32 u0, v0, u1, v1; // uv
+  u32 width;
+  u32 height;
+  s32 left_bearing;
+  s32 top_bearing;
+  s32 offset_x;
+  s32 offset_y;
+  s32 advance;
+};
+
+// nb: everything the baked pixels depend on
+typedef struct Font_Cache_Key Font_Cache_Key;
+struct Font_Cache_Key
+{
+  const char    *font_name;       // UTF-8 family name
+  f32           size;             // em size in DIPs
+  f32           dpi;
+  u32           atlas_size;      // the largest the bake may use
+  R_Tex2DFormat format;
+  const u8      *glyphs;          // the baked characters, in order
+  u32           glyph_count;
+};
+
+typedef struct Font_Cache_Header Font_Cache_Header;
+struct Font_Cache_Header
+{
+  u32 magic;
+  u32 version;
+  u64 key;                        // font_cache_key_hash
+  u32 format;                     // R_Tex2DFormat
+  u32 width;
+  u32 height;
+  u32 glyph_count;                // FONT_GLYPH_COUNT
+  u64 metrics_offset;
+  u64 atlas_offset;
+  u64 atlas_size;
+  u64 checksum;                   // of everything after the header
+};
+
+typedef enum Font_Cache_Status
+{
+  FONT_CACHE_HIT,
+  FONT_CACHE_MISSING,
+  FONT_CACHE_CORRUPT,             // short, wrong magic, sizes or checksum off
+  FONT_CACHE_STALE_VERSION,
+  FONT_CACHE_STALE_KEY,           // other font, size, DPI, format or glyphs
+  FONT_CACHE_STATUS_COUNT,
+}
+Font_Cache_Status;
+
+// nb: An open cache. On a hit `atlas` and `metrics` point into the mapped
+// file and stay valid until font_cache_close, anything else holds nothing.
+typedef struct Font_Cache Font_Cache;
+struct Font_Cache
+{
+  Font_Cache_Status        status;
+  OS_FileMap               map;
+  R_Tex2DFormat            format;
+  u32                      width;
+  u32                      height;
+  const void               *atlas;
+  const Font_Glyph_Metrics *metrics;
+};
+
+u64         font_cache_hash(const void *data, u64 size, u64 seed);
+u64         font_cache_key_hash(Font_Cache_Key *key);
+
+// nb: `atlas` is r_tex2d_size(format, width, height) bytes, `metrics` is
+// FONT_GLYPH_COUNT entries. `scratch` holds the file while it is written.
+b32         font_cache_write(Arena *scratch, const char *path, u64 key, R_Tex2DFormat format, u32 width, u32 height,
+                             const void *atlas, const Font_Glyph_Metrics *metrics);
+Font_Cache  font_cache_open(const char *path, u64 key);
+void        font_cache_close(Font_Cache *cache);
+const char *font_cache_status_string(Font_Cache_Status status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //FONT_CACHE_H
@@ -1,7 +1,5 @@
 #include "game.h"
 
-#include <time.h>
-
 // TODO(nb): better system for this? spritesheet system?
 //- nb: Static uv offsets for every tile in the sheet
 static const DirectX::XMFLOAT2 sprites[] =
@@ -15,82 +13,43 @@ static const DirectX::XMFLOAT2 sprites[] =
 
 ////////////////////////////////
 //~ nb: Helper functions
-internal void 
-game_get_neighbors_by_idx(u32 idx, u32 neighbor_idx_list[8], u32 *neighbor_idx_list_count)
-{
-  u32 tile_x = idx % g_game->columns;
-  u32 tile_y = idx / g_game->columns;
-  game_get_neighbors(tile_x, tile_y, neighbor_idx_list, neighbor_idx_list_count);
-}
-
-////////////////////////////////
-// nb: This table shows the corresponding 1D array neighbor mappings
-//       1D ARRAY                2D ARRAY
-// [-W -1] [-W] [-W +1]  [-1, -1] [0, -1] [1, -1]
-// [   -1] [ n] [   +1]  [-1,  0] [    n] [1,  0]
-// [+W -1] [+W] [+W +1]  [-1,  1] [0,  1] [1,  1]
-////////////////////////////////
-internal void
-game_get_neighbors(u32 tile_x, u32 tile_y, u32 neighbor_idx_list[8], u32 *neighbor_idx_list_count)
-{
-  u32 count = 0;
-  
-  for (int dy = -1; dy <= 1; dy++) 
-  {
-    for (int dx = -1; dx <= 1; dx++) 
-    {
-      // nb: skip current tile
-      if (dx == 0 && dy == 0) 
-        continue;
-      
-      int nx = tile_x + dx;
-      int ny = tile_y + dy;
-      
-      // nb: bounds check
-      if (nx >= 0 && nx < g_game->columns && ny >= 0 && ny < g_game->rows) 
-      {
-        u32 neighbor_idx = ny * g_game->columns + nx;
-        neighbor_idx_list[count] = neighbor_idx;
-        count++;
-      }
-    }
-  }
-  *neighbor_idx_list_count = count;
-}
-
-internal Tile *
-game_get_tile(u32 tile_x, u32 tile_y)
+//- nb: the camera is the world position of the window's top left corner.
+// Drawing and picking both go through this.
+internal R_TileView
+game_tile_view()
 {
-  Assert(tile_x < g_game->columns && tile_y < g_game->rows);
-  u32 idx = tile_y * g_game->columns + tile_x;
-  return game_get_tile_by_idx(idx);
+  R_TileView view;
+  view.x         = g_game->camera.x;
+  view.y         = g_game->camera.y;
+  view.zoom      = g_game->camera.zoom;
+  view.tile_size = TILE_SIZE;
+  view.width     = r_d3d11_state->width;
+  view.height    = r_d3d11_state->height;
+  return view;
 }
 
-internal Tile *
-game_get_tile_by_idx(u32 idx)
+internal u32
+game_get_idx_by_screen_pos(u32 screen_x, u32 screen_y)
 {
-  Assert(idx < g_game->tiles_count);
-  return &g_game->tiles[idx];
+  s64 tile_x, tile_y;
+  game_get_tile_by_screen_pos(screen_x, screen_y, &tile_x, &tile_y);
+  Board *board = g_game->board;
+  if(tile_x < 0 || tile_y < 0 || tile_x >= board->columns || tile_y >= board->rows)
+    return BOARD_IDX_NIL;
+  return board_idx_from_xy(board, (u32)tile_x, (u32)tile_y);
 }
 
-internal u32
-game_get_idx_by_screen_pos(u32 screen_x, u32 screen_y)
+internal void
+game_get_tile_by_screen_pos(u32 screen_x, u32 screen_y, s64 *tile_x, s64 *tile_y)
 {
-  u32 tile_x = screen_x / g_game->camera.zoom / TILE_SIZE;
-  u32 tile_y = screen_y / g_game->camera.zoom / TILE_SIZE;
-  u32 idx = tile_y * g_game->columns + tile_x;
-  return idx;
+  R_TileView view = game_tile_view();
+  r_tile_from_screen(&view, screen_x, screen_y, tile_x, tile_y);
 }
 
-internal Tile *
-game_get_tile_by_screen_pos(u32 screen_x, u32 screen_y)
+internal b32
+game_is_playable()
 {
-  u32 tile_x = screen_x / g_game->camera.zoom / TILE_SIZE;
-  u32 tile_y = screen_y / g_game->camera.zoom / TILE_SIZE;
-  u32 idx = tile_y * g_game->columns + tile_x;
-  if(tile_x >= g_game->columns || tile_y >= g_game->rows)
-    return &game_tile_nil;
-  return game_get_tile_by_idx(idx);
+  return g_game->infinite_mode ? g_game->chunk_board->is_playable : g_game->board->is_playable;
 }
 
 
@@ -104,26 +63,42 @@ game_init()
   g_game->arena = arena;
   g_game->scratch_arena = arena_alloc();
   g_game->frame_arena = arena_alloc();
+  g_game->change_arena = arena_alloc();
   
   g_game->camera          = {0};
   g_game->camera.zoom     = 1.0f;
+  g_game->board           = board_alloc();
+  g_game->chunk_board     = chunk_board_alloc();
+  g_game->board->reveal_budget_us = GAME_REVEAL_BUDGET_US;
+  g_game->board_use_map    = 1;
+  g_game->show_text_stats  = 0;
+  
+  // TODO(nb): dont hardcode the tilesheet uv sizes
+  for(u32 tile = 0; tile < ArrayCount(g_game->uv_rect_from_tile); tile++)
+  {
+    DirectX::XMFLOAT2 sprite = sprites[tile_kind((Tile)tile)];
+    g_game->uv_rect_from_tile[tile] = {sprite.x, sprite.y, 0.25, 0.25};
+  }
   
   game_reset();
   
   ////////////////////////////////
   //- nb: Resources
-  g_game->spritesheet_handle  = r_tex2d_load_file(L"sheet.png");
-  g_game->floodfill_queue = (u32*)arena_push(g_game->arena, g_game->tiles_count);
-  
+  g_game->spritesheet_handle  = r_tex2d_load_file(L"sheet.png", GAME_SHEET_FORMAT);
 }
 
 void 
 game_destroy()
 {
   r_tex2d_release(g_game->spritesheet_handle);
+  for(u32 i = 0; i < BOARD_PYRAMID_MAX_LEVELS; i++)
+    r_tex2d_release(g_game->board_lod_textures[i]);
   
+  board_release(g_game->board);
+  chunk_board_release(g_game->chunk_board);
   arena_release(g_game->scratch_arena);
   arena_release(g_game->frame_arena);
+  arena_release(g_game->change_arena);
 }
 
 void 
@@ -135,8 +110,19 @@ game_set_window(void *window_handle, u32 width, u32 height)
 void 
 game_on_mouse_down(MouseButton button, u32 x, u32 y)
 {
+  if(g_game->infinite_mode)
+  {
+    s64 tile_x, tile_y;
+    game_get_tile_by_screen_pos(x, y, &tile_x, &tile_y);
+    if(button == RIGHT_CLICK)
+      chunk_board_toggle_flag(g_game->chunk_board, tile_x, tile_y);
+    return;
+  }
+  
   //- nb: Get tile index
-  Tile *tile = game_get_tile_by_screen_pos(x, y);
+  u32 idx = game_get_idx_by_screen_pos(x, y);
+  if(idx == BOARD_IDX_NIL)
+    return;
   
   switch(button)
   {
@@ -147,20 +133,7 @@ game_on_mouse_down(MouseButton button, u32 x, u32 y)
     
     case RIGHT_CLICK:
     {
-      // nb: Don't allow a flag to be placed on a swept mine
-      if(tile->is_swept)
-        break;
-      // nb: Place flag
-      if(!tile->has_flag)
-      {
-        tile->has_flag = true;
-        tile->sprite = sprites[TILE_FLAG];
-      }
-      else
-      {
-        tile->has_flag = false;
-        tile->sprite = sprites[TILE_DEFAULT];
-      }
+      board_toggle_flag(g_game->board, idx);
     }
     break;
   }
@@ -169,85 +142,29 @@ game_on_mouse_down(MouseButton button, u32 x, u32 y)
 void 
 game_on_mouse_up(MouseButton button, u32 x, u32 y)
 {
-  if(!g_game->is_playable)
+  if(!game_is_playable())
   {
     game_reset();
     return;
   }
-  // bounds check needed, ugly
-  Tile *tile = game_get_tile_by_screen_pos(x, y);
-  if(tile == &game_tile_nil)
+  if(g_game->infinite_mode)
+  {
+    s64 tile_x, tile_y;
+    game_get_tile_by_screen_pos(x, y, &tile_x, &tile_y);
+    if(button == LEFT_CLICK)
+      chunk_board_sweep(g_game->chunk_board, tile_x, tile_y);
     return;
+  }
   //- nb: Get tile index
   u32 idx = game_get_idx_by_screen_pos(x, y);
+  if(idx == BOARD_IDX_NIL)
+    return;
   switch(button)
   {
     case LEFT_CLICK:
     {
-      // nb: first sweep protection
-      if(g_game->swept_count == 0)
-      {
-        u32 neighbor_idx_list[8];
-        u32 neighbor_idx_list_count;
-        game_get_neighbors_by_idx(idx, neighbor_idx_list, &neighbor_idx_list_count);
-        // nb: populate mine list, excluding the 3x3 grid around the first initial click
-        u32 tile_counter = 0;
-        for(int i = 0; i < g_game->tiles_count; i++)
-        {
-          bool hit = false;
-          for(int j = 0; j < neighbor_idx_list_count; j++)
-          {
-            // nb: is this in our 3x3 grid? if so, skip this tile as a mine candidate
-            if(i == neighbor_idx_list[j] || i == idx)
-            {
-              hit = true;
-              break;
-            }
-          }
-          if(!hit)
-          {
-            g_game->mine_indices[tile_counter++] = i;
-          }
-        }
-        // nb: shuffle index list
-        for(int i = g_game->tiles_count - 1; i > 0; i--)
-        {
-          int j = rand() % (i + 1);
-          int temp = g_game->mine_indices[i];
-          g_game->mine_indices[i] = g_game->mine_indices[j];
-          g_game->mine_indices[j] = temp;
-        }
-        // nb: Select n mines at random
-        for(int i = 0; i < g_game->mine_count; i++)
-        {
-          int index = g_game->mine_indices[i];
-          Tile *tile = &g_game->tiles[index];
-          tile->is_mine = true;
-          //tile->sprite = sprites[TILE_MINE];
-        }
-        
-        ////////////////////////////////
-        //- nb: Set the neighboring mine count for all tiles
-        for(int i = 0; i < g_game->mine_count; i++)
-        {
-          u32 neighbor_idx_list[8] = {0};
-          u32 neighbor_idx_list_count = 0;
-          game_get_neighbors_by_idx(g_game->mine_indices[i], neighbor_idx_list, &neighbor_idx_list_count);
-          for(int j = 0; j < neighbor_idx_list_count; j++)
-          {
-            if(!g_game->tiles[neighbor_idx_list[j]].is_mine)
-              g_game->tiles[neighbor_idx_list[j]].neighbor_count++;
-          }
-        }
-        game_reveal_tile_by_idx(idx);
-      }
-      else
-      {
-        if(game_reveal_tile_by_idx(idx))
-        {
-          game_gameover();
-        }
-      }
+      // nb: hitting a mine ends the game inside the board
+      board_sweep(g_game->board, idx);
     }
     break;
     
@@ -259,220 +176,332 @@ game_on_mouse_up(MouseButton button, u32 x, u32 y)
   }
 }
 
+//- nb: zooms around the cursor, the tile under it stays put
+void
+game_on_mouse_wheel(s32 delta, u32 x, u32 y)
+{
+  Camera *camera = &g_game->camera;
+  f32 zoom = delta > 0 ? camera->zoom * GAME_ZOOM_STEP : camera->zoom / GAME_ZOOM_STEP;
+  zoom = Clamp(g_game->infinite_mode ? GAME_ZOOM_MIN_TILES : GAME_ZOOM_MIN, zoom, GAME_ZOOM_MAX);
+  camera->x += x / camera->zoom - x / zoom;
+  camera->y += y / camera->zoom - y / zoom;
+  camera->zoom = zoom;
+}
+
 void 
 game_on_size_changed(u32 width, u32 height)
 {
   r_window_size_changed(width, height);
 }
 
+void 
+game_on_key_down(u32 key)
+{
+  switch(key)
+  {
+    case 'I':
+    {
+      g_game->infinite_mode = !g_game->infinite_mode;
+      g_game->camera.zoom = ClampBot(g_game->camera.zoom, GAME_ZOOM_MIN_TILES);
+      game_reset();
+    }
+    break;
+    
+    //- nb: the other path has to get every tile again
+    case 'M':
+    {
+      g_game->board_use_map = !g_game->board_use_map;
+      if(!g_game->infinite_mode)
+        r_dirty_mark_all(g_game->board_dirty);
+    }
+    break;
+    
+    case 'T':
+    {
+      g_game->show_text_stats = !g_game->show_text_stats;
+    }
+    break;
+    
+    //- nb: pan by a few tiles on screen
+    case VK_LEFT:  g_game->camera.x -= 4 * TILE_SIZE / g_game->camera.zoom; break;
+    case VK_RIGHT: g_game->camera.x += 4 * TILE_SIZE / g_game->camera.zoom; break;
+    case VK_UP:    g_game->camera.y -= 4 * TILE_SIZE / g_game->camera.zoom; break;
+    case VK_DOWN:  g_game->camera.y += 4 * TILE_SIZE / g_game->camera.zoom; break;
+  }
+}
+
 void 
 game_reset()
 {
   arena_clear(g_game->scratch_arena);
-  g_game->floodfill_queue_count = 0;
-  
-  ////////////////////////////////
-  //- nb: Default values
-  g_game->is_playable       = true;
-  g_game->columns           = 30;
-  g_game->rows              = 16;
-  g_game->mine_count        = 90;
-  g_game->swept_count       = 0;
-  g_game->flag_count        = 0;
-  g_game->first_sweep_protection_idx = 0;
-  g_game->tiles = (Tile*)arena_push(g_game->arena, sizeof(Tile) * g_game->rows * g_game->columns);
-  g_game->tiles_count = g_game->columns * g_game->rows;
   
-  // nb: Index array for shuffling, used for mine selection
-  g_game->mine_indices = (u32*)arena_push(g_game->arena, (sizeof(u32) * g_game->tiles_count));
-  
-  srand(time(NULL));
-  // nb: Populate board
-  for(int i = 0; i < g_game->tiles_count; i++)
+  g_game->camera.x = 0;
+  g_game->camera.y = 0;
+  if(g_game->infinite_mode)
+  {
+    // nb: expert density
+    chunk_board_reset(g_game->chunk_board, 0.206, os_now_microseconds());
+  }
+  else
   {
-    Tile tile;
-    tile.sprite = sprites[TILE_DEFAULT];
-    g_game->tiles[i] = tile;
+    Board *board = g_game->board;
+    board_reset(board, 30, 16, 90, os_now_microseconds());
+    
+    //- nb: Positions come from the tile index, the sprite from the tile byte
+    g_game->board_tiles = (Tile*)arena_push(g_game->scratch_arena, board->tiles_count);
+    g_game->board_dirty = r_dirty_alloc(g_game->scratch_arena, board->tiles_count);
+    memset(g_game->board_tiles, 0, board->tiles_count);
+    R_TileGridConstants *grid = &g_game->board_grid;
+    grid->columns      = board->columns;
+    memcpy(grid->uv_rect_from_tile, g_game->uv_rect_from_tile, sizeof(grid->uv_rect_from_tile));
+    R_TileMapConstants *map = &g_game->board_map;
+    map->columns       = board->columns;
+    map->rows          = board->rows;
+    memcpy(map->uv_rect_from_tile, g_game->uv_rect_from_tile, sizeof(map->uv_rect_from_tile));
+    
+    //- nb: Summaries for zoomed out views, the textures follow on demand
+    board_pyramid_build(&g_game->board_pyramid, board, g_game->scratch_arena);
+    for(u32 i = 0; i < BOARD_PYRAMID_MAX_LEVELS; i++)
+    {
+      r_tex2d_release(g_game->board_lod_textures[i]);
+      g_game->board_lod_textures[i] = {0};
+    }
+    arena_clear(g_game->change_arena);
+    board_changes_begin(board, &g_game->board_changes, g_game->change_arena);
   }
 }
 
+//- nb: refreshes `count` tiles starting at `first`
+internal void
+game_update_board_tiles(u32 first, u32 count)
+{
+  Board *board = g_game->board;
+  u32 tile_y = first / board->columns;
+  u32 tile_x = first % board->columns;
+  Tile *tiles = g_game->board_tiles + first;
+  while(count > 0)
+  {
+    u32 row_count = Min(count, board->columns - tile_x);
+    board_tile_row(board, tile_y, tile_x, row_count, tiles);
+    tiles    += row_count;
+    count    -= row_count;
+    tile_x    = 0;
+    tile_y   += 1;
+  }
+}
 
-internal bool 
-game_reveal_tile_by_idx(u32 idx)
+internal void
+game_render_board()
 {
-  Tile &tile = g_game->tiles[idx];
+  Board *board = g_game->board;
+  R_DirtyCells *dirty = g_game->board_dirty;
   
-  // nb: Disallow a flagged tile from being swept
-  if(tile.has_flag)
-    return false;
+  //- nb: Mark what changed since the last frame
+  BoardChangeList *changes = &g_game->board_changes;
+  for(u64 i = 0; i < changes->count; i++)
+  {
+    r_dirty_mark(dirty, changes->records[i].first_idx, changes->records[i].run_length);
+  }
+  board_pyramid_apply(&g_game->board_pyramid, changes->records, changes->count);
+  arena_clear(g_game->change_arena);
+  board_changes_begin(board, changes, g_game->change_arena);
+  b32 use_map = (g_game->board_use_map &&
+                 board->columns <= R_TILE_MAP_MAX_SIZE && board->rows <= R_TILE_MAP_MAX_SIZE);
+  b32 created = use_map ? r_board_map_reserve(board->columns, board->rows) : r_board_tiles_reserve(board->tiles_count);
+  if(created)
+    r_dirty_mark_all(dirty);
   
-  if(tile.is_mine)
+  //- nb: Refresh and upload the dirty ranges only
+  R_UploadPlan plan = r_dirty_plan(dirty, g_game->frame_arena);
+  for(u32 i = 0; i < plan.range_count; i++)
   {
-    tile.sprite = sprites[TILE_MINERED];
-    return true;
-  };
+    game_update_board_tiles(plan.ranges[i].first, plan.ranges[i].count);
+  }
+  if(use_map)
+    r_board_map_upload(&plan, g_game->board_tiles);
+  else
+    r_board_tiles_upload(&plan, g_game->board_tiles);
   
+  //- nb: Draw the tiles inside the window only
+  R_TileView view = game_tile_view();
+  if(TILE_SIZE * view.zoom < GAME_LOD_TILE_PIXELS)
+  {
+    game_render_board_overview(&view);
+    return;
+  }
+  if(use_map)
+  {
+    if(r_tile_map_set_view(&g_game->board_map, &view))
+      r_submit_tile_map(&g_game->board_map, g_game->spritesheet_handle);
+    return;
+  }
+  R_TileRect board_rect = {0, 0, board->columns, board->rows};
+  R_TileRect rect = r_tile_rect_intersect(r_tile_view_rect(&view), board_rect);
+  u32 visible_columns = (u32)(rect.x1 - rect.x0);
+  u32 visible_rows    = (u32)(rect.y1 - rect.y0);
+  if(visible_columns == 0 || visible_rows == 0)
+    return;
+  R_TileGridConstants *grid = &g_game->board_grid;
+  f64 origin_x, origin_y;
+  r_screen_from_tile(&view, 0, 0, &origin_x, &origin_y);
+  grid->origin[0]       = (f32)origin_x;
+  grid->origin[1]       = (f32)origin_y;
+  grid->tile_size[0]    = (f32)(TILE_SIZE * view.zoom);
+  grid->tile_size[1]    = (f32)(TILE_SIZE * view.zoom);
+  grid->visible_columns = visible_columns;
+  grid->first_x         = (u32)rect.x0;
+  grid->first_y         = (u32)rect.y0;
+  r_submit_tile_grid(grid, visible_columns * visible_rows, g_game->spritesheet_handle);
+}
+
+//- nb: hidden gray, swept light gray and flagged red, mixed by share
+internal u32
+game_lod_texel(BoardBlock *block)
+{
+  u64 cells = (u64)block->swept + block->flagged + block->hidden;
+  u32 r = (u32)((block->hidden * 0x80ull + block->swept * 0xc0ull + block->flagged * 0xe0ull) / cells);
+  u32 g = (u32)((block->hidden * 0x80ull + block->swept * 0xc0ull + block->flagged * 0x30ull) / cells);
+  return 0xff000000 | (g << 16) | (g << 8) | r;
+}
+
+//- nb: the whole board as one quad, one texel per block. Costs the same at
+// any zoom, only blocks that changed are uploaded.
+internal void
+game_render_board_overview(R_TileView *view)
+{
+  BoardPyramid *pyramid = &g_game->board_pyramid;
+  f64 tile_pixels = TILE_SIZE * view->zoom;
+  u32 l = 0;
+  while(l + 1 < pyramid->level_count &&
+        (tile_pixels * (1ull << pyramid->levels[l].shift) < GAME_LOD_BLOCK_PIXELS ||
+         Max(pyramid->levels[l].columns, pyramid->levels[l].rows) > GAME_LOD_MAX_TEXTURE))
+  {
+    l += 1;
+  }
+  BoardPyramidLevel *level = &pyramid->levels[l];
+  R_Handle *texture = &g_game->board_lod_textures[l];
   
-  if(!tile.is_swept)
+  //- nb: Refresh the dirty blocks, or all of them for a new texture
+  b32 create = (texture->U64[0] == 0);
+  if(create)
   {
-    tile.is_swept = true;
-    g_game->swept_count += 1;
-    if(tile.neighbor_count == 0)
-    {
-      tile.sprite = sprites[TILE_EMPTY];
-      g_game->floodfill_queue[g_game->floodfill_queue_count] = idx;
-      g_game->floodfill_queue_count++;
-    } 
-    else
-    {
-      tile.sprite = sprites[tile.neighbor_count - 1];
-      return false;
-    }
+    level->dirty_x0 = 0;
+    level->dirty_y0 = 0;
+    level->dirty_x1 = level->columns;
+    level->dirty_y1 = level->rows;
   }
-  else
+  if(level->dirty_x0 < level->dirty_x1)
   {
-    // Nothing to chord
-    if(tile.neighbor_count == 0)
-      return false;
-    
-    //- nb: Chording logic
-    u32 flag_count = 0;
-    u32 mine_count = 0;
-    u32 neighbor_idx_list[8] = {0};
-    u32 neighbor_idx_list_count = 0;
-    game_get_neighbors_by_idx(idx, neighbor_idx_list, &neighbor_idx_list_count);
-    
-    // TODO(nb): Fix bug where chording can occur even if the flags were incorrectly placed..
-    // This occurs because chording starts northwest, then north, then northeast, then west etc...
-    // So it's possible that two valid tiles will be swept even if there are multiple mines within
-    // the chord range.
-    for(int i = 0; i < neighbor_idx_list_count; i++)
-    {
-      if(g_game->tiles[neighbor_idx_list[i]].has_flag)
-        flag_count += 1;
-    }
-    // nb: Allow chording if flags placed == neighbor count
-    if(flag_count == tile.neighbor_count)
+    u32 width  = level->dirty_x1 - level->dirty_x0;
+    u32 height = level->dirty_y1 - level->dirty_y0;
+    u32 *texels = (u32*)arena_push(g_game->frame_arena, sizeof(u32) * width * height);
+    for(u32 y = 0; y < height; y++)
     {
-      for(int i = 0; i < neighbor_idx_list_count; i++)
-      {
-        Tile &nb = g_game->tiles[neighbor_idx_list[i]];
-        if(!nb.is_swept && !nb.has_flag)
-        {
-          if (game_reveal_tile_by_idx(neighbor_idx_list[i]))
-            return true;
-        }
-      }
+      BoardBlock *row_blocks = level->blocks + (u64)(level->dirty_y0 + y) * level->columns + level->dirty_x0;
+      for(u32 x = 0; x < width; x++)
+        texels[y * width + x] = game_lod_texel(&row_blocks[x]);
     }
+    if(create)
+      *texture = r_tex2d_alloc(R_TEX2D_FORMAT_RGBA8, {width, height}, texels);
+    else
+      r_tex2d_update(*texture, level->dirty_x0, level->dirty_y0, width, height, texels);
+    level->dirty_x0 = level->dirty_x1 = 0;
   }
   
-  ////////////////////////////////
-  //- nb: Flood fill
-  while(g_game->floodfill_queue_count > 0)
+  //- nb: edge blocks are partly past the board, the uvs stop at its edge
+  f64 origin_x, origin_y;
+  r_screen_from_tile(view, 0, 0, &origin_x, &origin_y);
+  f32 block_tiles = (f32)(1ull << level->shift);
+  InstanceData *data = r_push_quads(*texture, R_LAYER_WORLD, 1);
+  data[0] = {{(f32)origin_x, (f32)origin_y},
+             {(f32)(pyramid->columns * tile_pixels), (f32)(pyramid->rows * tile_pixels)},
+             {0, 0, pyramid->columns / (level->columns * block_tiles), pyramid->rows / (level->rows * block_tiles)}};
+}
+
+//- nb: only the tiles inside the window, chunks that don't exist read as hidden
+internal void
+game_render_chunk_board()
+{
+  ChunkBoard *board = g_game->chunk_board;
+  f32 tile_size = TILE_SIZE * g_game->camera.zoom;
+  R_TileView view = game_tile_view();
+  R_TileRect rect = r_tile_view_rect(&view);
+  s64 first_x = rect.x0, first_y = rect.y0;
+  u32 columns = (u32)(rect.x1 - rect.x0);
+  u32 rows    = (u32)(rect.y1 - rect.y0);
+  f64 screen_x, screen_y;
+  r_screen_from_tile(&view, first_x, first_y, &screen_x, &screen_y);
+  f32 offset_x = (f32)screen_x;
+  f32 offset_y = (f32)screen_y;
+  
+  InstanceData *instance_data = r_push_quads(g_game->spritesheet_handle, R_LAYER_WORLD, columns * rows);
+  Tile *row_tiles = (Tile*)arena_push(g_game->frame_arena, sizeof(Tile) * columns);
+  for (u32 y = 0; y < rows; y++)
   {
-    // nb: Pop a tile
-    u32 tile_idx = g_game->floodfill_queue[g_game->floodfill_queue_count - 1];
-    g_game->floodfill_queue_count--;
-    
-    // nb: Sweep the current tile
-    g_game->tiles[tile_idx].is_swept = true;
-    g_game->tiles[tile_idx].sprite = sprites[TILE_EMPTY];
-    
-    u32 neighbor_idx_list[8] = {0};
-    u32 neighbor_idx_list_count = 0;
-    game_get_neighbors_by_idx(tile_idx, neighbor_idx_list, &neighbor_idx_list_count);
-    // nb: Sweep every neighboring tile
-    for(int i = 0; i < neighbor_idx_list_count; i++)
+    chunk_board_tile_row(board, first_y + y, first_x, columns, row_tiles);
+    InstanceData *row_instances = instance_data + y * columns;
+    for (u32 x = 0; x < columns; x++)
     {
-      Tile &neighbor = g_game->tiles[neighbor_idx_list[i]];
-      if(neighbor.is_mine || neighbor.is_swept)
-        continue;
-      
-      neighbor.is_swept = true;
-      
-      // nb: Keep filling until there are no more tiles with 0 neighbors
-      if(neighbor.neighbor_count == 0)
-      {
-        neighbor.sprite = sprites[TILE_EMPTY];
-        g_game->floodfill_queue[g_game->floodfill_queue_count] = neighbor_idx_list[i];
-        g_game->floodfill_queue_count++;
-      }else
-      {
-        // nb: We can use [neighbor_count - 1] to set the sprite,
-        // as the sprite sheet is logically set up in such a way
-        // that the first sprite is "1", second sprite is "2", etc.
-        neighbor.sprite = sprites[neighbor.neighbor_count - 1];
-      }
+      DirectX::XMFLOAT4 iuv_rect = g_game->uv_rect_from_tile[row_tiles[x]];
+      row_instances[x] = { {offset_x + x * tile_size, offset_y + y * tile_size}, {tile_size, tile_size}, iuv_rect};
     }
   }
-  return false;
 }
 
-internal bool 
-game_reveal_tile(u32 tile_x, u32 tile_y)
+b32 
+game_has_pending_work()
 {
-  u32 idx = tile_y * g_game->columns + tile_x;
-  return game_reveal_tile_by_idx(idx);
+  return !g_game->infinite_mode && board_reveal_pending(g_game->board);
 }
 
-void 
-game_gameover()
-{
-  // nb: Reveal all mines
-  for(int i = 0; i < g_game->mine_count; i++)
-  {
-    if(g_game->mine_indices[i] != g_game->first_sweep_protection_idx)
-      g_game->tiles[g_game->mine_indices[i]].sprite = sprites[TILE_MINE];
-  }
-  g_game->is_playable = false;
-};
-
-
 void 
 game_render()
 {
+  //- nb: carry on with a reveal from an earlier click
+  if(game_has_pending_work())
+    board_reveal_step(g_game->board);
+  
   arena_clear(g_game->frame_arena);
   const f32 color[4]{0.25f, 0.25f, 0.25f, 1.0f};
   r_clear(color);
   
   //- nb: Draw tiles
-  InstanceData *instance_data = (InstanceData*)arena_push(g_game->frame_arena, sizeof(InstanceData) * g_game->tiles_count);
-  for (int i = 0; i < g_game->tiles_count; i++)
-  {
-    u32 x = i % g_game->columns;
-    u32 y = i / g_game->columns;
-    
-    Tile *tile = &g_game->tiles[i];
-    
-    // TODO(nb): dont hardcode the tilesheet uv sizes
-    DirectX::XMFLOAT4 iuv_rect = {tile->sprite.x, tile->sprite.y, 0.25, 0.25};
-    instance_data[i] = { {(float)x * TILE_SIZE,(float)y * TILE_SIZE}, {TILE_SIZE, TILE_SIZE}, iuv_rect};
-  }
-  
-  r_submit_batch(instance_data, g_game->tiles_count, g_game->spritesheet_handle);
-  
-  
+  if(g_game->infinite_mode)
+    game_render_chunk_board();
+  else
+    game_render_board();
   
-  if(!g_game->is_playable)
+  if(!game_is_playable())
   {
-    draw_ascii_text("Game over!", 20, 500);
+    // nb: from the distance field atlas, at the baked atlas' size
+    font_draw_text_sized("Game over!", 20, 500, FONT_SIZE);
     draw_ascii_text("Click anywhere to start over", 20, 558);
   }
   
-  InstanceData *data = (InstanceData*)arena_push(g_game->frame_arena, sizeof(InstanceData) * 1);
+  InstanceData *data = r_push_quads(font_dwrite_state->atlas, R_LAYER_UI, 1);
   data[0] = {{20, 500}, {1024, 1024}, {0, 0, 1, 1} };
-  r_submit_batch(data, 1, font_dwrite_state->atlas);
   
   
 #if 0
   // nb: render font atlas
-  InstanceData *data2 = (InstanceData*)arena_push(g_game->frame_arena, sizeof(InstanceData) * 1);
+  InstanceData *data2 = r_push_quads(font_dwrite_state->ascii_atlas, R_LAYER_UI, 1);
   data2[0] = {{100, 100}, {1024, 1024}, {0, 0, 1, 1} };
-  r_submit_batch(data2, 1, font_dwrite_state->ascii_atlas);
   draw_ascii_text("ef", 0, 0);
   draw_ascii_text("This is a rendering test", 0, 500);
 #endif
   
+  //- nb: text cache, runs reused and glyphs laid out last frame. The line
+  // only changes with the numbers, so it is a cache hit itself most frames.
+  if(g_game->show_text_stats)
+  {
+    Text_Cache_Stats text_stats = font_text_frame_stats();
+    char text_line[128] = {};
+    sprintf_s(text_line, sizeof(text_line), "text: %llu hits, %llu misses, %llu glyphs laid out",
+              (unsigned long long)text_stats.hits, (unsigned long long)text_stats.misses,
+              (unsigned long long)text_stats.glyphs_laid_out);
+    font_draw_text_sized(text_line, 20, 20, FONT_SIZE * 0.5f);
+  }
+  
   r_present();
   font_frame();
 }
\ No newline at end of file
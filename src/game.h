@@ -2,9 +2,9 @@
 #define GAME_H
 
 ////////////////////////////////
-//~ nb: Mouse Input 
+//~ nb: Mouse Input
 // Left click to sweep, right click to plant a flag.
-// NOTE(nb): Left click should operate on BUTTONUP 
+// NOTE(nb): Left click should operate on BUTTONUP
 // to avoid accidental sweeps.
 enum MouseButton
 {
@@ -12,17 +12,6 @@ enum MouseButton
   RIGHT_CLICK
 };
 
-typedef struct Tile Tile;
-struct Tile
-{
-  u32               neighbor_count = 0;
-  bool              has_flag       = false;
-  bool              is_mine        = false;
-  bool              is_swept       = false;
-  
-  DirectX::XMFLOAT2 sprite; // uv offset
-};
-
 typedef struct Camera Camera;
 struct Camera
 {
@@ -32,38 +21,67 @@ struct Camera
 
 // TODO(nb): make a system for this
 #define TILE_SIZE 32
+// nb: zoom range, the mouse wheel steps by GAME_ZOOM_STEP. The infinite
+// board always draws single tiles, so it stops at GAME_ZOOM_MIN_TILES.
+#define GAME_ZOOM_MIN       (1.0f / 1024)
+#define GAME_ZOOM_MIN_TILES 0.0625f
+#define GAME_ZOOM_MAX       8.0f
+#define GAME_ZOOM_STEP      1.25f
+// nb: below this many pixels per tile the board is drawn from its summary
+// pyramid, one texel per block of the finest level whose blocks still
+// cover a pixel
+#define GAME_LOD_TILE_PIXELS  1.0f
+#define GAME_LOD_BLOCK_PIXELS 1.0f
+#define GAME_LOD_MAX_TEXTURE  2048
+// nb: the sprite sheet is encoded to this when it loads. RGBA8 keeps the
+// pixel art exact, BC7 would only save 12 KiB on a 64x64 sheet.
+#define GAME_SHEET_FORMAT R_TEX2D_FORMAT_RGBA8
+// nb: time a frame may spend revealing, the rest waits for the next one
+#define GAME_REVEAL_BUDGET_US 4000
 
 typedef struct Game Game;
 struct Game
 {
-  
+
   ////////////////////////////////
   // nb: Arenas
   Arena         *arena;
   Arena         *scratch_arena;
   Arena         *frame_arena;
-  
-  
+  // nb: board change records since the last frame
+  Arena         *change_arena;
+
+
   ////////////////////////////////
   R_Handle      spritesheet_handle;
-  u32           *floodfill_queue;
-  u32           floodfill_queue_count = 0;
-  u32           *mine_indices;
-  // nb: if first sweep protection happened, store the idx of the mine 
-  u32           first_sweep_protection_idx;
-  
+  // nb: sprite uv rect for every possible packed tile byte
+  DirectX::XMFLOAT4 uv_rect_from_tile[256];
+  // nb: the board as drawn, one packed tile byte each, kept between
+  // frames. Only the tiles the change records touched are refreshed and
+  // uploaded.
+  Tile          *board_tiles;
+  R_DirtyCells  *board_dirty;
+  R_TileGridConstants board_grid;
+  // nb: the board drawn as one quad over a texture of tile bytes instead of
+  // one instance per visible tile, when it fits in a texture
+  R_TileMapConstants board_map;
+  b32           board_use_map;
+  BoardChangeList board_changes;
+  // nb: block summaries for zoomed out views, with one texture per level,
+  // made the first time the level is drawn
+  BoardPyramid  board_pyramid;
+  R_Handle      board_lod_textures[BOARD_PYRAMID_MAX_LEVELS];
+
   ////////////////////////////////
   // nb: Variables
   Camera        camera;
-  bool          is_playable;
   f64           elapsed_time;
-  u32           mine_count;
-  u32           swept_count;
-  u32           flag_count;
-  u32           columns;
-  u32           rows;
-  Tile          *tiles;
-  u32           tiles_count;
+  Board         *board;
+  // nb: unbounded board, played instead of `board` while infinite_mode is on
+  ChunkBoard    *chunk_board;
+  b32           infinite_mode;
+  // nb: text cache hits and glyphs laid out, drawn over the board
+  b32           show_text_stats;
 };
 
 
@@ -71,28 +89,33 @@ void game_init();
 void game_destroy();
 
 void game_set_window(void *window_handle, u32 width, u32 height);
-void game_on_mouse_up(u32 x, u32 y);
-void game_on_mouse_down(u32 x, u32 y);
-void game_size_changed(u32 w, u32 h);
-
-void game_gameover();
+void game_on_mouse_up(MouseButton button, u32 x, u32 y);
+void game_on_mouse_down(MouseButton button, u32 x, u32 y);
+void game_on_mouse_wheel(s32 delta, u32 x, u32 y);
+void game_on_size_changed(u32 width, u32 height);
+// nb: I toggles the infinite board, M switches the board between the tile
+// map and the tile grid, T shows the text cache statistics, the arrow keys
+// pan, the wheel zooms
+void game_on_key_down(u32 key);
 
 void game_reset();
 void game_render();
+// nb: 1 while a reveal is still spreading, the main loop keeps drawing
+// frames instead of waiting for messages
+b32  game_has_pending_work();
 
 ////////////////////////////////
 //~ nb: Helper functions
-internal void game_get_neighbors(u32 tile_x, u32 tile_y, u32 *neighbor_idx_list, u32 *neighbor_idx_list_count);
-internal void game_get_neighbors_by_idx(u32 idx, u32 *neighbor_idx_list, u32 *neighbor_idx_list_count);
-internal Tile *game_get_tile(u32 tile_x, u32 tile_y);
-internal Tile *game_get_tile_by_idx(u32 idx);
+internal R_TileView game_tile_view();
 internal u32  game_get_idx_by_screen_pos(u32 screen_x, u32 screen_y);
-internal Tile *game_get_tile_by_screen_pos(u32 screen_x, u32 screen_y);
-
-internal bool game_reveal_tile(u32 tile_x, u32 tile_y);
-internal bool game_reveal_tile_by_idx(u32 idx);
+internal void game_get_tile_by_screen_pos(u32 screen_x, u32 screen_y, s64 *tile_x, s64 *tile_y);
+internal b32  game_is_playable();
+internal void game_render_board();
+internal void game_render_board_overview(R_TileView *view);
+internal u32  game_lod_texel(BoardBlock *block);
+internal void game_update_board_tiles(u32 first, u32 count);
+internal void game_render_chunk_board();
 
-global Tile game_tile_nil = {0};
 global Game *g_game = {0};
 
 #endif //GAME_H
@@ -0,0 +1,392 @@
+#include "glyph_cache.h"
+
+#define GLYPH_NO_PAGE 0xffffffffu
+
+////////////////////////////////
+//~ nb: Types
+typedef struct Glyph_Page Glyph_Page;
+struct Glyph_Page
+{
+  R_Handle    texture;
+  Rect_Packer *packer;
+  u32         glyph_count;
+  u64         last_used_frame;
+};
+
+typedef struct Glyph_Entry Glyph_Entry;
+struct Glyph_Entry
+{
+  Glyph_Slot  slot;
+  Glyph_Key   key;
+  u32         page;               // GLYPH_NO_PAGE when it has no texels
+  Rect_Pack_Rect rect;            // padded, in the page
+  u64         last_used_frame;
+  // nb: most recently used first, also the free list through next
+  Glyph_Entry *prev;
+  Glyph_Entry *next;
+};
+
+struct Glyph_Cache
+{
+  Arena              *arena;
+  // nb: upload staging, and the slots of misses that found no room
+  Arena              *scratch;
+  Arena              *frame_arena;
+  Glyph_Cache_Params params;
+  Glyph_Rasterizer   *rasterizer;
+  Glyph_PageBackend  *backend;
+  Glyph_Page         *pages;
+  u32                page_count;
+  Glyph_Entry        *entries;
+  Glyph_Entry        *first_free;
+  u32                glyph_count;
+  // nb: open addressing, entry index + 1, 0 is empty
+  u32                *table;
+  u32                table_mask;
+  Glyph_Entry        lru;
+  u64                frame;
+  Glyph_Cache_Stats  stats;
+};
+
+////////////////////////////////
+//~ nb: Helper functions
+internal u64
+glyph_key_hash(Glyph_Key key)
+{
+  u64 h = ((u64)key.font << 32 | key.size) * 0x9e3779b97f4a7c15ull;
+  h = (h ^ key.glyph ^ (h >> 31)) * 0xbf58476d1ce4e5b9ull;
+  return h ^ (h >> 29);
+}
+
+internal inline b32
+glyph_key_equal(Glyph_Key a, Glyph_Key b)
+{
+  return a.font == b.font && a.size == b.size && a.glyph == b.glyph;
+}
+
+//- nb: LRU list
+internal void
+glyph_lru_remove(Glyph_Entry *entry)
+{
+  entry->prev->next = entry->next;
+  entry->next->prev = entry->prev;
+}
+
+internal void
+glyph_lru_push_front(Glyph_Cache *cache, Glyph_Entry *entry)
+{
+  entry->prev = &cache->lru;
+  entry->next = cache->lru.next;
+  entry->next->prev = entry;
+  cache->lru.next = entry;
+}
+
+//- nb: hash map
+internal u32
+glyph_table_find(Glyph_Cache *cache, Glyph_Key key)
+{
+  for(u32 i = (u32)glyph_key_hash(key) & cache->table_mask;; i = (i + 1) & cache->table_mask)
+  {
+    u32 value = cache->table[i];
+    if(value == 0 || glyph_key_equal(cache->entries[value - 1].key, key))
+      return i;
+  }
+}
+
+//- nb: backward shift, so lookups never need tombstones
+internal void
+glyph_table_remove(Glyph_Cache *cache, Glyph_Key key)
+{
+  u32 hole = glyph_table_find(cache, key);
+  Assert(cache->table[hole] != 0);
+  for(u32 i = (hole + 1) & cache->table_mask; cache->table[i]; i = (i + 1) & cache->table_mask)
+  {
+    u32 home = (u32)glyph_key_hash(cache->entries[cache->table[i] - 1].key) & cache->table_mask;
+    // nb: can the entry at i move back to the hole without passing its home
+    b32 movable = (hole <= i) ? (home <= hole || home > i) : (home <= hole && home > i);
+    if(movable)
+    {
+      cache->table[hole] = cache->table[i];
+      hole = i;
+    }
+  }
+  cache->table[hole] = 0;
+}
+
+////////////////////////////////
+//~ nb: Eviction
+internal void
+glyph_cache_evict(Glyph_Cache *cache, Glyph_Entry *entry, b32 keep_rect)
+{
+  glyph_table_remove(cache, entry->key);
+  glyph_lru_remove(entry);
+  if(entry->page != GLYPH_NO_PAGE)
+  {
+    Glyph_Page *page = &cache->pages[entry->page];
+    page->glyph_count -= 1;
+    if(keep_rect)
+      rect_pack_remove(page->packer, entry->rect);
+  }
+  // nb: no prev marks it free for glyph_cache_reset_page
+  entry->prev = 0;
+  entry->next = cache->first_free;
+  cache->first_free = entry;
+  cache->glyph_count -= 1;
+  cache->stats.evictions += 1;
+}
+
+//- nb: the least recently used glyph, if it wasn't used this frame
+internal Glyph_Entry *
+glyph_cache_evictable(Glyph_Cache *cache)
+{
+  Glyph_Entry *entry = cache->lru.prev;
+  if(entry == &cache->lru || entry->last_used_frame >= cache->frame)
+    return 0;
+  return entry;
+}
+
+//- nb: every glyph on the page goes, none of them were used this frame
+internal void
+glyph_cache_reset_page(Glyph_Cache *cache, u32 page_index)
+{
+  Glyph_Page *page = &cache->pages[page_index];
+  for(u32 i = 0; i < cache->params.max_glyphs && page->glyph_count > 0; i++)
+  {
+    Glyph_Entry *entry = &cache->entries[i];
+    if(entry->page == page_index && entry->prev)
+      glyph_cache_evict(cache, entry, 0);
+  }
+  rect_pack_reset(page->packer);
+  cache->stats.page_resets += 1;
+}
+
+//- nb: room for a padded glyph, cheapest first: the pages as they are, a
+// new page, evicting LRU glyphs, and last clearing the page used longest ago
+internal b32
+glyph_cache_place(Glyph_Cache *cache, u32 width, u32 height, u32 *page_index, Rect_Pack_Rect *rect)
+{
+  for(u32 p = 0; p < cache->page_count; p++)
+  {
+    if(rect_pack_insert(cache->pages[p].packer, width, height, rect))
+    {
+      *page_index = p;
+      return 1;
+    }
+  }
+  if(cache->page_count < cache->params.max_pages)
+  {
+    Glyph_Page *page = &cache->pages[cache->page_count];
+    page->texture = cache->backend->alloc(cache->backend, cache->params.page_size);
+    *page_index = cache->page_count++;
+    return rect_pack_insert(page->packer, width, height, rect);
+  }
+  for(u32 i = 0; i < GLYPH_CACHE_EVICT_SCAN; i++)
+  {
+    Glyph_Entry *entry = glyph_cache_evictable(cache);
+    if(!entry)
+      break;
+    u32 p = entry->page;
+    glyph_cache_evict(cache, entry, 1);
+    if(p != GLYPH_NO_PAGE && rect_pack_insert(cache->pages[p].packer, width, height, rect))
+    {
+      *page_index = p;
+      return 1;
+    }
+  }
+  u32 oldest = GLYPH_NO_PAGE;
+  for(u32 p = 0; p < cache->page_count; p++)
+  {
+    if(cache->pages[p].last_used_frame < cache->frame &&
+       (oldest == GLYPH_NO_PAGE || cache->pages[p].last_used_frame < cache->pages[oldest].last_used_frame))
+      oldest = p;
+  }
+  if(oldest == GLYPH_NO_PAGE)
+    return 0;
+  glyph_cache_reset_page(cache, oldest);
+  *page_index = oldest;
+  return rect_pack_insert(cache->pages[oldest].packer, width, height, rect);
+}
+
+////////////////////////////////
+//~ nb: Glyph cache
+Glyph_Cache_Params
+glyph_cache_default_params(void)
+{
+  Glyph_Cache_Params params = {GLYPH_CACHE_PAGE_SIZE, GLYPH_CACHE_MAX_PAGES, GLYPH_CACHE_MAX_GLYPHS, GLYPH_CACHE_PADDING,
+                               GLYPH_CACHE_PACKING};
+  return params;
+}
+
+Glyph_Cache *
+glyph_cache_alloc(Glyph_Cache_Params params, Glyph_Rasterizer *rasterizer, Glyph_PageBackend *pages)
+{
+  Arena *arena = arena_alloc();
+  Glyph_Cache *cache = (Glyph_Cache*)arena_push(arena, sizeof(Glyph_Cache));
+  memset(cache, 0, sizeof(Glyph_Cache));
+  cache->arena       = arena;
+  cache->scratch     = arena_alloc();
+  cache->frame_arena = arena_alloc();
+  cache->params      = params;
+  cache->rasterizer  = rasterizer;
+  cache->backend     = pages;
+  cache->lru.prev = cache->lru.next = &cache->lru;
+  // nb: frame 0 is before anything was used
+  cache->frame = 1;
+
+  cache->pages = (Glyph_Page*)arena_push(arena, sizeof(Glyph_Page) * params.max_pages);
+  memset(cache->pages, 0, sizeof(Glyph_Page) * params.max_pages);
+  for(u32 p = 0; p < params.max_pages; p++)
+    cache->pages[p].packer = rect_pack_alloc(arena, params.strategy, params.page_size, params.page_size, params.max_glyphs);
+
+  cache->entries = (Glyph_Entry*)arena_push(arena, sizeof(Glyph_Entry) * params.max_glyphs);
+  memset(cache->entries, 0, sizeof(Glyph_Entry) * params.max_glyphs);
+  for(u32 i = params.max_glyphs; i > 0; i--)
+  {
+    cache->entries[i - 1].next = cache->first_free;
+    cache->first_free = &cache->entries[i - 1];
+  }
+
+  //- nb: at most half full
+  u32 table_size = 16;
+  while(table_size < params.max_glyphs * 2)
+    table_size *= 2;
+  cache->table = (u32*)arena_push(arena, sizeof(u32) * table_size);
+  memset(cache->table, 0, sizeof(u32) * table_size);
+  cache->table_mask = table_size - 1;
+  return cache;
+}
+
+void
+glyph_cache_release(Glyph_Cache *cache)
+{
+  for(u32 p = 0; p < cache->page_count; p++)
+    cache->backend->release(cache->backend, cache->pages[p].texture);
+  arena_release(cache->frame_arena);
+  arena_release(cache->scratch);
+  arena_release(cache->arena);
+}
+
+void
+glyph_cache_frame(Glyph_Cache *cache)
+{
+  cache->frame += 1;
+  arena_clear(cache->frame_arena);
+}
+
+const Glyph_Slot *
+glyph_cache_get(Glyph_Cache *cache, Glyph_Key key)
+{
+  u32 bucket = glyph_table_find(cache, key);
+  if(cache->table[bucket])
+  {
+    Glyph_Entry *entry = &cache->entries[cache->table[bucket] - 1];
+    entry->last_used_frame = cache->frame;
+    if(entry->page != GLYPH_NO_PAGE)
+      cache->pages[entry->page].last_used_frame = cache->frame;
+    glyph_lru_remove(entry);
+    glyph_lru_push_front(cache, entry);
+    cache->stats.hits += 1;
+    return &entry->slot;
+  }
+  cache->stats.misses += 1;
+
+  //- nb: rasterize, then find it a home
+  Glyph_Bitmap bitmap = {0};
+  if(!cache->rasterizer->rasterize(cache->rasterizer, key, &bitmap))
+  {
+    cache->stats.failures += 1;
+    Glyph_Slot *slot = (Glyph_Slot*)arena_push(cache->frame_arena, sizeof(Glyph_Slot));
+    memset(slot, 0, sizeof(Glyph_Slot));
+    return slot;
+  }
+  Glyph_Slot slot = {0};
+  u32 pad = cache->params.padding;
+  slot.advance      = bitmap.advance;
+  slot.left_bearing = bitmap.left_bearing - (s32)pad;
+  slot.top_bearing  = bitmap.top_bearing - (s32)pad;
+  u32 page_index = GLYPH_NO_PAGE;
+  Rect_Pack_Rect rect = {0};
+  b32 placed = 1;
+  if(bitmap.width > 0 && bitmap.height > 0)
+  {
+    u32 width  = bitmap.width + pad * 2;
+    u32 height = bitmap.height + pad * 2;
+    placed = width <= cache->params.page_size && height <= cache->params.page_size &&
+      glyph_cache_place(cache, width, height, &page_index, &rect);
+  }
+  if(!cache->first_free)
+  {
+    Glyph_Entry *victim = glyph_cache_evictable(cache);
+    if(victim)
+      glyph_cache_evict(cache, victim, 1);
+  }
+  if(!placed || !cache->first_free)
+  {
+    //- nb: no room, the advance still counts this frame
+    cache->stats.failures += 1;
+    if(placed && page_index != GLYPH_NO_PAGE)
+      rect_pack_remove(cache->pages[page_index].packer, rect);
+    Glyph_Slot *failed = (Glyph_Slot*)arena_push(cache->frame_arena, sizeof(Glyph_Slot));
+    memset(failed, 0, sizeof(Glyph_Slot));
+    failed->advance = slot.advance;
+    return failed;
+  }
+
+  //- nb: upload with the clear padding, an evicted glyph may have left
+  // texels there
+  if(page_index != GLYPH_NO_PAGE)
+  {
+    Glyph_Page *page = &cache->pages[page_index];
+    Temp temp = temp_begin(cache->scratch);
+    u8 *texels = (u8*)arena_push(temp.arena, (u64)rect.width * rect.height);
+    memset(texels, 0, (u64)rect.width * rect.height);
+    for(u32 y = 0; y < bitmap.height; y++)
+      memcpy(texels + (u64)(y + pad) * rect.width + pad, bitmap.coverage + (u64)y * bitmap.pitch, bitmap.width);
+    cache->backend->update(cache->backend, page->texture, rect.x, rect.y, rect.width, rect.height, texels);
+    temp_end(temp);
+    cache->stats.uploads      += 1;
+    cache->stats.upload_bytes += (u64)rect.width * rect.height;
+
+    f32 inv_size = 1.0f / (f32)cache->params.page_size;
+    slot.page       = page->texture;
+    slot.uv_rect[0] = (f32)rect.x * inv_size;
+    slot.uv_rect[1] = (f32)rect.y * inv_size;
+    slot.uv_rect[2] = (f32)rect.width * inv_size;
+    slot.uv_rect[3] = (f32)rect.height * inv_size;
+    slot.width      = rect.width;
+    slot.height     = rect.height;
+    page->glyph_count += 1;
+    page->last_used_frame = cache->frame;
+  }
+
+  Glyph_Entry *entry = cache->first_free;
+  cache->first_free = entry->next;
+  memset(entry, 0, sizeof(Glyph_Entry));
+  entry->slot            = slot;
+  entry->key             = key;
+  entry->page            = page_index;
+  entry->rect            = rect;
+  entry->last_used_frame = cache->frame;
+  glyph_lru_push_front(cache, entry);
+  cache->table[glyph_table_find(cache, key)] = (u32)(entry - cache->entries) + 1;
+  cache->glyph_count += 1;
+  return &entry->slot;
+}
+
+Glyph_Cache_Stats
+glyph_cache_stats(Glyph_Cache *cache)
+{
+  return cache->stats;
+}
+
+u32
+glyph_cache_glyph_count(Glyph_Cache *cache)
+{
+  return cache->glyph_count;
+}
+
+u32
+glyph_cache_page_count(Glyph_Cache *cache)
+{
+  return cache->page_count;
+}
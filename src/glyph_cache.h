@@ -0,0 +1,129 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+////////////////////////////////
+//~ nb: Glyph cache
+// Glyphs rasterized on first use into R8 atlas pages. A hash map takes
+// (font, size, glyph id) to a slot, each page packs its slots with a
+// Rect_Packer (skyline by default), and when every page is full the least
+// recently used glyphs give their room back. Glyphs used in the current frame are never evicted, so
+// slots handed out stay valid until the next glyph_cache_frame.
+//
+// Rasterizing and the atlas textures sit behind backends (first member of
+// the owner, like R_DrawBackend), DirectWrite and D3D11 in font.cpp, stubs
+// in the bench.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GLYPH_CACHE_PAGE_SIZE   1024
+#define GLYPH_CACHE_MAX_PAGES   4
+#define GLYPH_CACHE_MAX_GLYPHS  4096
+// nb: clear texels around every glyph so filtering doesn't pick up its
+// neighbours
+#define GLYPH_CACHE_PADDING     1
+// nb: how many LRU glyphs a miss may evict one by one before it clears a
+// whole page
+#define GLYPH_CACHE_EVICT_SCAN    32
+// nb: see the "rectpack" bench, skyline fills nearly as well as maxrects
+// on glyphs at a fraction of the cost, and holds up better under churn
+#define GLYPH_CACHE_PACKING       RECT_PACK_SKYLINE
+
+typedef struct Glyph_Key Glyph_Key;
+struct Glyph_Key
+{
+  u32 font;                       // the rasterizer's font id
+  u32 size;                       // em size in 1/64 pixels
+  u32 glyph;                      // glyph id within the font
+};
+
+//- nb: what a rasterizer hands back, `coverage` stays valid until its next
+// call. Bearings are from the pen position to the bitmap's top left.
+typedef struct Glyph_Bitmap Glyph_Bitmap;
+struct Glyph_Bitmap
+{
+  u32      width;
+  u32      height;
+  u32      pitch;
+  const u8 *coverage;
+  s32      left_bearing;
+  s32      top_bearing;
+  s32      advance;
+};
+
+typedef struct Glyph_Rasterizer Glyph_Rasterizer;
+typedef b32 Glyph_Rasterize_Func(Glyph_Rasterizer *rasterizer, Glyph_Key key, Glyph_Bitmap *bitmap);
+struct Glyph_Rasterizer
+{
+  Glyph_Rasterize_Func *rasterize;
+};
+
+//- nb: R8 pages, `size` x `size`, cleared to 0. Updates are sub-rectangles
+// of tightly packed coverage.
+typedef struct Glyph_PageBackend Glyph_PageBackend;
+typedef R_Handle Glyph_Page_Alloc_Func(Glyph_PageBackend *backend, u32 size);
+typedef void     Glyph_Page_Update_Func(Glyph_PageBackend *backend, R_Handle page, u32 x, u32 y, u32 width, u32 height, const u8 *coverage);
+typedef void     Glyph_Page_Release_Func(Glyph_PageBackend *backend, R_Handle page);
+struct Glyph_PageBackend
+{
+  Glyph_Page_Alloc_Func   *alloc;
+  Glyph_Page_Update_Func  *update;
+  Glyph_Page_Release_Func *release;
+};
+
+//- nb: A cached glyph, drawn as a `width` x `height` quad at the pen
+// position plus the bearings. A zero page means nothing to draw (spaces,
+// or no room left), the advance still holds.
+typedef struct Glyph_Slot Glyph_Slot;
+struct Glyph_Slot
+{
+  R_Handle page;
+  f32      uv_rect[4];
+  u32      width;
+  u32      height;
+  s32      left_bearing;
+  s32      top_bearing;
+  s32      advance;
+};
+
+typedef struct Glyph_Cache_Params Glyph_Cache_Params;
+struct Glyph_Cache_Params
+{
+  u32 page_size;
+  u32 max_pages;
+  u32 max_glyphs;
+  u32 padding;
+  Rect_Pack_Strategy strategy;
+};
+
+typedef struct Glyph_Cache_Stats Glyph_Cache_Stats;
+struct Glyph_Cache_Stats
+{
+  u64 hits;
+  u64 misses;
+  u64 evictions;                  // glyphs dropped to make room
+  u64 page_resets;                // pages cleared whole
+  u64 uploads;
+  u64 upload_bytes;
+  u64 failures;                   // misses that got no slot
+};
+
+typedef struct Glyph_Cache Glyph_Cache;
+
+Glyph_Cache_Params glyph_cache_default_params(void);
+Glyph_Cache       *glyph_cache_alloc(Glyph_Cache_Params params, Glyph_Rasterizer *rasterizer, Glyph_PageBackend *pages);
+void               glyph_cache_release(Glyph_Cache *cache);
+// nb: Starts a frame, glyphs not used since become evictable.
+void               glyph_cache_frame(Glyph_Cache *cache);
+// nb: Rasterizes and uploads on a miss. Valid until the next frame.
+const Glyph_Slot  *glyph_cache_get(Glyph_Cache *cache, Glyph_Key key);
+Glyph_Cache_Stats  glyph_cache_stats(Glyph_Cache *cache);
+u32                glyph_cache_glyph_count(Glyph_Cache *cache);
+u32                glyph_cache_page_count(Glyph_Cache *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GLYPH_CACHE_H
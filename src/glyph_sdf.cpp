@@ -0,0 +1,287 @@
+#include "glyph_sdf.h"
+
+#define GLYPH_SDF_INF 1e20f
+
+////////////////////////////////
+//~ nb: Distance transform
+typedef struct Glyph_SDF_Scratch Glyph_SDF_Scratch;
+struct Glyph_SDF_Scratch
+{
+  f32 *outer;                     // squared distance to the inside
+  f32 *inner;                     // squared distance to the outside
+  u32 *outer_from;                // the seed each came from
+  u32 *inner_from;
+  f32 *edge_x;                    // where a seed's edge is, from its center
+  f32 *edge_y;
+  f32 *f;
+  f32 *z;
+  u32 *v;
+  u32 *from;
+};
+
+//- nb: lower envelope of the parabolas rooted at each sample, `n` samples
+// `stride` apart in `grid`, in place, carrying along which seed won
+internal void
+glyph_sdf_edt_1d(f32 *grid, u32 *grid_from, u32 offset, u32 stride, u32 n, Glyph_SDF_Scratch *s)
+{
+  for(u32 q = 0; q < n; q++)
+  {
+    s->f[q]    = grid[offset + q * stride];
+    s->from[q] = grid_from[offset + q * stride];
+  }
+  u32 k = 0;
+  s->v[0] = 0;
+  s->z[0] = -GLYPH_SDF_INF;
+  s->z[1] = GLYPH_SDF_INF;
+  for(u32 q = 1; q < n; q++)
+  {
+    f32 fq = s->f[q] + (f32)q * q;
+    f32 at;
+    for(;;)
+    {
+      u32 r = s->v[k];
+      at = (fq - s->f[r] - (f32)r * r) / (f32)(2 * (q - r));
+      // nb: z[0] is -inf, so this stops at the first parabola
+      if(at > s->z[k])
+        break;
+      k -= 1;
+    }
+    k += 1;
+    s->v[k]     = q;
+    s->z[k]     = at;
+    s->z[k + 1] = GLYPH_SDF_INF;
+  }
+  k = 0;
+  for(u32 q = 0; q < n; q++)
+  {
+    while(s->z[k + 1] < (f32)q)
+      k += 1;
+    u32 r = s->v[k];
+    f32 dq = (f32)q - (f32)r;
+    grid[offset + q * stride]      = dq * dq + s->f[r];
+    grid_from[offset + q * stride] = s->from[r];
+  }
+}
+
+internal void
+glyph_sdf_edt(f32 *grid, u32 *grid_from, u32 width, u32 height, Glyph_SDF_Scratch *s)
+{
+  for(u32 x = 0; x < width; x++)
+    glyph_sdf_edt_1d(grid, grid_from, x, width, height, s);
+  for(u32 y = 0; y < height; y++)
+    glyph_sdf_edt_1d(grid, grid_from, y * width, 1, width, s);
+}
+
+//- nb: how far a texel's center is from the edge crossing it, positive
+// outside, for an edge with normal (gx, gy) and coverage a (Gustavson)
+internal f32
+glyph_sdf_edge_offset(f32 gx, f32 gy, f32 a)
+{
+  if(gx == 0.0f || gy == 0.0f)
+    return 0.5f - a;
+  gx = fabsf(gx);
+  gy = fabsf(gy);
+  if(gx < gy)
+  {
+    f32 t = gx; gx = gy; gy = t;
+  }
+  f32 a1 = 0.5f * gy / gx;
+  if(a < a1)
+    return 0.5f * (gx + gy) - sqrtf(2.0f * gx * gy * a);
+  if(a < 1.0f - a1)
+    return (0.5f - a) * gx;
+  return -0.5f * (gx + gy) + sqrtf(2.0f * gx * gy * (1.0f - a));
+}
+
+internal Glyph_SDF_Scratch
+glyph_sdf_scratch_alloc(Arena *arena, u64 max_area, u32 max_side)
+{
+  Glyph_SDF_Scratch s = {0};
+  s.outer      = (f32*)arena_push(arena, sizeof(f32) * max_area);
+  s.inner      = (f32*)arena_push(arena, sizeof(f32) * max_area);
+  s.outer_from = (u32*)arena_push(arena, sizeof(u32) * max_area);
+  s.inner_from = (u32*)arena_push(arena, sizeof(u32) * max_area);
+  s.edge_x     = (f32*)arena_push(arena, sizeof(f32) * max_area);
+  s.edge_y     = (f32*)arena_push(arena, sizeof(f32) * max_area);
+  s.f     = (f32*)arena_push(arena, sizeof(f32) * max_side);
+  s.z     = (f32*)arena_push(arena, sizeof(f32) * (max_side + 1));
+  s.v     = (u32*)arena_push(arena, sizeof(u32) * max_side);
+  s.from  = (u32*)arena_push(arena, sizeof(u32) * max_side);
+  return s;
+}
+
+internal inline f32
+glyph_sdf_coverage(Glyph_SDF_Job *job, s32 x, s32 y)
+{
+  s32 cx = x - (s32)job->pad, cy = y - (s32)job->pad;
+  if(cx < 0 || cy < 0 || cx >= (s32)job->width || cy >= (s32)job->height)
+    return 0.0f;
+  return job->coverage[cy * job->pitch + cx] / 255.0f;
+}
+
+//- nb: 0 on the seed's own side, else from (x, y) to the seed's edge
+internal inline f32
+glyph_sdf_seed_distance(Glyph_SDF_Scratch *s, u32 seed, f32 squared, u32 width, u32 x, u32 y)
+{
+  if(squared == 0.0f || squared >= GLYPH_SDF_INF)
+    return squared == 0.0f ? 0.0f : sqrtf(squared);
+  f32 dx = (f32)(seed % width) + s->edge_x[seed] - (f32)x;
+  f32 dy = (f32)(seed / width) + s->edge_y[seed] - (f32)y;
+  return sqrtf(dx * dx + dy * dy);
+}
+
+internal void
+glyph_sdf_build_with(Glyph_SDF_Job *job, Glyph_SDF_Scratch *s)
+{
+  u32 width  = job->width + job->pad * 2;
+  u32 height = job->height + job->pad * 2;
+
+  //- nb: seeds, fully in or out is on its side, partial coverage sits
+  // its edge offset past the edge. The transforms only pick the nearest
+  // seed, the distance is then taken to where that seed's edge is.
+  for(u32 y = 0; y < height; y++)
+  {
+    for(u32 x = 0; x < width; x++)
+    {
+      f32 a = glyph_sdf_coverage(job, x, y);
+      u32 i = y * width + x;
+      s->outer_from[i] = i;
+      s->inner_from[i] = i;
+      s->edge_x[i] = 0.0f;
+      s->edge_y[i] = 0.0f;
+      if(a >= 1.0f)
+      {
+        s->outer[i] = 0.0f;
+        s->inner[i] = GLYPH_SDF_INF;
+      }
+      else if(a <= 0.0f)
+      {
+        s->outer[i] = GLYPH_SDF_INF;
+        s->inner[i] = 0.0f;
+      }
+      else
+      {
+        //- nb: Sobel, the normal points into the glyph
+        f32 gx = 0.0f, gy = 0.0f;
+        for(s32 dy = -1; dy <= 1; dy++)
+        {
+          for(s32 dx = -1; dx <= 1; dx++)
+          {
+            f32 weight = (dx == 0 || dy == 0) ? 2.0f : 1.0f;
+            f32 c = glyph_sdf_coverage(job, x + dx, y + dy);
+            gx += dx * weight * c;
+            gy += dy * weight * c;
+          }
+        }
+        f32 length = sqrtf(gx * gx + gy * gy);
+        f32 offset = 0.5f - a;
+        if(length > 0.0f)
+        {
+          gx /= length;
+          gy /= length;
+          offset = glyph_sdf_edge_offset(gx, gy, a);
+        }
+        s->edge_x[i] = gx * offset;
+        s->edge_y[i] = gy * offset;
+        f32 out = ClampBot(offset, 0.0f);
+        f32 in  = ClampBot(-offset, 0.0f);
+        s->outer[i] = out * out;
+        s->inner[i] = in * in;
+      }
+    }
+  }
+  glyph_sdf_edt(s->outer, s->outer_from, width, height, s);
+  glyph_sdf_edt(s->inner, s->inner_from, width, height, s);
+
+  f32 scale = 255.0f / R_TEX2D_SDF_RANGE;
+  for(u32 y = 0; y < height; y++)
+  {
+    u8 *row = job->sdf + (u64)y * job->sdf_pitch;
+    for(u32 x = 0; x < width; x++)
+    {
+      u32 i = y * width + x;
+      f32 d = glyph_sdf_seed_distance(s, s->inner_from[i], s->inner[i], width, x, y) -
+        glyph_sdf_seed_distance(s, s->outer_from[i], s->outer[i], width, x, y);
+      f32 value = 127.5f + d * scale;
+      row[x] = (u8)Clamp(0.0f, value + 0.5f, 255.0f);
+    }
+  }
+}
+
+////////////////////////////////
+//~ nb: Building
+void
+glyph_sdf_build(Arena *scratch, Glyph_SDF_Job *job)
+{
+  u32 width  = job->width + job->pad * 2;
+  u32 height = job->height + job->pad * 2;
+  Temp temp = temp_begin(scratch);
+  Glyph_SDF_Scratch s = glyph_sdf_scratch_alloc(temp.arena, (u64)width * height, Max(width, height));
+  glyph_sdf_build_with(job, &s);
+  temp_end(temp);
+}
+
+typedef struct Glyph_SDF_Thread Glyph_SDF_Thread;
+struct Glyph_SDF_Thread
+{
+  Glyph_SDF_Job     *jobs;
+  u32               count;
+  u32               thread_idx;
+  u32               thread_count;
+  Glyph_SDF_Scratch scratch;
+};
+
+internal void
+glyph_sdf_thread(void *params)
+{
+  Glyph_SDF_Thread *thread = (Glyph_SDF_Thread*)params;
+  for(u32 i = thread->thread_idx; i < thread->count; i += thread->thread_count)
+    glyph_sdf_build_with(&thread->jobs[i], &thread->scratch);
+}
+
+void
+glyph_sdf_build_jobs(Arena *scratch, Glyph_SDF_Job *jobs, u32 count, u32 thread_count)
+{
+  if(thread_count == 0)
+    thread_count = os_logical_core_count();
+  thread_count = Clamp(1u, thread_count, ClampBot(count, 1u));
+
+  //- nb: every thread gets scratch for the biggest glyph
+  u64 max_area = 1;
+  u32 max_side = 1;
+  for(u32 i = 0; i < count; i++)
+  {
+    u32 width  = jobs[i].width + jobs[i].pad * 2;
+    u32 height = jobs[i].height + jobs[i].pad * 2;
+    max_area = Max(max_area, (u64)width * height);
+    max_side = Max(max_side, Max(width, height));
+  }
+  Temp temp = temp_begin(scratch);
+  Glyph_SDF_Thread *threads = (Glyph_SDF_Thread*)arena_push(temp.arena, sizeof(Glyph_SDF_Thread) * thread_count);
+  OS_Thread *os_threads = (OS_Thread*)arena_push(temp.arena, sizeof(OS_Thread) * thread_count);
+  for(u32 i = 0; i < thread_count; i++)
+  {
+    threads[i].jobs         = jobs;
+    threads[i].count        = count;
+    threads[i].thread_idx   = i;
+    threads[i].thread_count = thread_count;
+    threads[i].scratch      = glyph_sdf_scratch_alloc(temp.arena, max_area, max_side);
+  }
+  // nb: the calling thread takes the first share itself
+  for(u32 i = 1; i < thread_count; i++)
+  {
+    os_thread_launch(&os_threads[i], glyph_sdf_thread, &threads[i]);
+  }
+  glyph_sdf_thread(&threads[0]);
+  for(u32 i = 1; i < thread_count; i++)
+  {
+    os_thread_join(&os_threads[i]);
+  }
+  temp_end(temp);
+}
+
+f32
+glyph_sdf_distance(u8 value)
+{
+  return ((f32)value - 127.5f) * (R_TEX2D_SDF_RANGE / 255.0f);
+}
@@ -0,0 +1,48 @@
+#ifndef GLYPH_SDF_H
+#define GLYPH_SDF_H
+
+////////////////////////////////
+//~ nb: Glyph distance fields
+// Signed distance fields from rasterized coverage, so one small atlas draws
+// text at any size (R_TEX2D_FORMAT_SDF8, ps_sdf). Two exact Euclidean
+// distance transforms (Felzenszwalb and Huttenlocher), one to the inside
+// and one to the outside, find every texel's nearest edge texel. Edge
+// texels are the partly covered ones, their edge is placed from the
+// coverage and its Sobel gradient (Gustavson's edge offset), and the
+// distance is taken to that point, so edges keep their sub-texel position.
+// Fully covered texels next to empty ones are edges at their centers.
+//
+// Output bytes are 255 * (0.5 + d / R_TEX2D_SDF_RANGE), d in texels and
+// positive inside, so 128 is the edge. Only depends on base.h and
+// render_core.h.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// nb: one glyph, the field is `pad` texels bigger than the coverage on
+// every side so the outside falls off before the quad ends
+typedef struct Glyph_SDF_Job Glyph_SDF_Job;
+struct Glyph_SDF_Job
+{
+  const u8 *coverage;
+  u32      width;
+  u32      height;
+  u32      pitch;
+  u32      pad;
+  u8       *sdf;                  // (width + 2 pad) x (height + 2 pad)
+  u32      sdf_pitch;
+};
+
+void glyph_sdf_build(Arena *scratch, Glyph_SDF_Job *job);
+// nb: Jobs go round robin to the threads, the calling thread takes the
+// first share. `thread_count` 0 picks one per logical core.
+void glyph_sdf_build_jobs(Arena *scratch, Glyph_SDF_Job *jobs, u32 count, u32 thread_count);
+// nb: texels from the edge, positive inside
+f32  glyph_sdf_distance(u8 value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //GLYPH_SDF_H
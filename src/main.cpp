@@ -5,130 +5,27 @@
 #pragma comment(lib, "user32")
 #pragma comment(lib, "ole32")
 
-#include <intrin.h>
-#define Assert(cond) do{ if(!(cond)) __debugbreak(); } while(0)
+#include "base.h"
+#include "base.cpp"
 
-//#define _DEBUG
-
-#include <stdint.h>
-typedef int8_t      s8;
-typedef uint8_t     u8;
-typedef int16_t     s16;
-typedef uint16_t    u16;
-typedef int32_t     s32;
-typedef uint32_t    u32;
-typedef int64_t     s64;
-typedef uint64_t    u64;
-typedef float       f32;
-typedef double      f64; 
-
-#define internal    static
-#define global      static
-
-#define Kilobytes(x) x*1024
-#define Megabytes(x) x*1024*1024
-
-#define RESERVE_SIZE Megabytes(64)
-#define COMMIT_SIZE  Kilobytes(64)
-#define PAGE_SIZE    4096
-
-#define AlignPow2(pos, align) (((pos) + (align) - 1) & ~((align) - 1))
-#define Min(A,B) (((A)<(B))?(A):(B))
-#define Max(A,B) (((A)>(B))?(A):(B))
-#define ClampTop(A,X) Min(A,X)
-#define ClampBot(X,B) Max(X,B)
-#define Clamp(A,X,B) (((X)<(A))?(A):((X)>(B))?(B):(X))
-
-////////////////////////////////
-//~ nb: Arena
-typedef struct Arena Arena;
-struct Arena 
-{
-  void *base_ptr;
-  u64  reserved;
-  u64  committed;
-  u64  pos;
-  
-  u64 base_pos;
-  u64 reserve_size;
-  u64 commit_size;
-};
-Arena *arena_alloc()
-{
-  void *ptr = VirtualAlloc(0, RESERVE_SIZE, MEM_RESERVE, PAGE_READWRITE);
-  VirtualAlloc(ptr, COMMIT_SIZE, MEM_COMMIT, PAGE_READWRITE);
-  
-  Arena *arena = (Arena*)ptr;
-  {
-    arena->pos          = AlignPow2(sizeof(Arena), 16);
-    arena->base_pos     = 0;
-    arena->reserved     = RESERVE_SIZE;
-    arena->reserve_size = RESERVE_SIZE;
-    arena->committed    = COMMIT_SIZE;
-    arena->commit_size  = COMMIT_SIZE;
-  }
-  
-  return arena;
-}
-void arena_release(Arena *arena)
-{
-  VirtualFree(arena, 0, MEM_RELEASE);
-}
-void *arena_push(Arena *arena, u64 size)
-{
-  u64 pos_pre = AlignPow2(arena->pos, 16);
-  u64 pos_pst = pos_pre + size;
-  // TODO(nb): chain more arenas
-  if(pos_pst > arena->reserved)
-  {
-    __debugbreak();
-  }
-  // nb: commit new pages
-  if(arena->committed < pos_pst)
-  {
-    //__debugbreak();
-    u64 cmt_pst_aligned = pos_pst + arena->commit_size - 1;
-    cmt_pst_aligned -= cmt_pst_aligned % arena->commit_size;
-    u64 cmt_pst_clamped = ClampTop(cmt_pst_aligned, arena->reserved);
-    u64 cmt_size = cmt_pst_clamped - arena->committed;
-    u8 *cmt_ptr = (u8 *)arena + arena->committed;
-    VirtualAlloc(cmt_ptr, cmt_size, MEM_COMMIT, PAGE_READWRITE);
-    arena->committed = cmt_pst_clamped;
-  }
-  // nb: return the start of the allocation, then update the cursor
-  void *result = (u8*)arena + pos_pre;
-  arena->pos = pos_pst;
-  return result;
-}
-void arena_pop_to(Arena *arena, u64 pos)
-{
-  u64 big_pos = ClampBot(AlignPow2(sizeof(Arena), 16), pos);
-  u64 new_pos = big_pos - arena->base_pos;
-  Assert(new_pos <= arena->pos);
-  arena->pos = new_pos;
-}
-void arena_clear(Arena *arena)
-{
-  arena_pop_to(arena, 0);
-}
-typedef struct Temp Temp;
-struct Temp
-{
-  Arena *arena;
-  u64 pos;
-};
-Temp temp_begin(Arena *arena)
-{
-  Temp temp = {0};
-  temp.arena = arena;
-  temp.pos = arena->pos;
-  return temp;
-}
-void temp_end(Temp temp)
-{
-  arena_pop_to(temp.arena, temp.pos);
-}
-////////////////////////////////
+#include "core.h"
+#include "core.cpp"
+#include "chunk_board.h"
+#include "chunk_board.cpp"
+#include "render_core.h"
+#include "render_core.cpp"
+#include "render_bc.h"
+#include "render_bc.cpp"
+#include "font_cache.h"
+#include "font_cache.cpp"
+#include "rect_pack.h"
+#include "rect_pack.cpp"
+#include "glyph_sdf.h"
+#include "glyph_sdf.cpp"
+#include "glyph_cache.h"
+#include "glyph_cache.cpp"
+#include "text_cache.h"
+#include "text_cache.cpp"
 
 #include "render.cpp"
 #include "font.cpp"
@@ -161,6 +58,9 @@ LRESULT CALLBACK WndProc(HWND hwnd,
     }else if(wParam == 'R')
     {
       game_reset();
+    }else
+    {
+      game_on_key_down((u32)wParam);
     }
     break;
     
@@ -179,6 +79,17 @@ LRESULT CALLBACK WndProc(HWND hwnd,
     game_on_mouse_up(MouseButton::RIGHT_CLICK, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
     break;
     
+    case WM_MOUSEWHEEL:
+    {
+      // nb: the wheel reports screen coordinates
+      POINT point = {GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam)};
+      ScreenToClient(hwnd, &point);
+      point.x = ClampBot(point.x, 0);
+      point.y = ClampBot(point.y, 0);
+      game_on_mouse_wheel(GET_WHEEL_DELTA_WPARAM(wParam), point.x, point.y);
+    }
+    break;
+    
     case WM_SIZE:
     if(wParam == SIZE_MINIMIZED)
     {
@@ -297,7 +208,8 @@ int WINAPI wWinMain(HINSTANCE hInstance,
     }else
     {
       game_render();
-      WaitMessage();
+      if(!game_has_pending_work())
+        WaitMessage();
     }
   }
   
@@ -0,0 +1,28 @@
+////////////////////////////////
+//~ nb: Headless board core
+// Unity build of everything that does not need Win32. build.sh turns this
+// into libminesweeper_core.a, main.cpp pulls the same files in directly.
+
+#include "base.h"
+#include "base.cpp"
+
+#include "core.h"
+#include "core.cpp"
+#include "chunk_board.h"
+#include "chunk_board.cpp"
+#include "render_core.h"
+#include "render_core.cpp"
+#include "render_bc.h"
+#include "render_bc.cpp"
+#include "font_cache.h"
+#include "font_cache.cpp"
+#include "rect_pack.h"
+#include "rect_pack.cpp"
+#include "glyph_sdf.h"
+#include "glyph_sdf.cpp"
+#include "glyph_cache.h"
+#include "glyph_cache.cpp"
+#include "text_cache.h"
+#include "text_cache.cpp"
+#include "render_soft.h"
+#include "render_soft.cpp"
@@ -0,0 +1,421 @@
+#include "rect_pack.h"
+
+global const char *rect_pack_strategy_strings[RECT_PACK_STRATEGY_COUNT] =
+{
+  "shelf",
+  "skyline",
+  "guillotine",
+  "maxrects",
+};
+
+////////////////////////////////
+//~ nb: Free rects
+internal inline b32
+rect_pack_contains(Rect_Pack_Rect outer, Rect_Pack_Rect inner)
+{
+  return inner.x >= outer.x && inner.y >= outer.y &&
+    inner.x + inner.width <= outer.x + outer.width &&
+    inner.y + inner.height <= outer.y + outer.height;
+}
+
+internal void
+rect_pack_free_remove(Rect_Packer *packer, u32 index)
+{
+  packer->free_rects[index] = packer->free_rects[--packer->free_count];
+}
+
+//- nb: grows back into free neighbours sharing a whole edge, until none is
+// left, so space freed piece by piece comes back as one rect
+internal void
+rect_pack_free_push(Rect_Packer *packer, Rect_Pack_Rect rect)
+{
+  if(rect.width == 0 || rect.height == 0)
+    return;
+  for(u32 i = 0; i < packer->free_count;)
+  {
+    Rect_Pack_Rect other = packer->free_rects[i];
+    b32 stacked = other.x == rect.x && other.width == rect.width &&
+      (other.y + other.height == rect.y || rect.y + rect.height == other.y);
+    b32 beside = other.y == rect.y && other.height == rect.height &&
+      (other.x + other.width == rect.x || rect.x + rect.width == other.x);
+    if(stacked)
+    {
+      rect.y       = Min(rect.y, other.y);
+      rect.height += other.height;
+    }
+    else if(beside)
+    {
+      rect.x      = Min(rect.x, other.x);
+      rect.width += other.width;
+    }
+    else
+    {
+      i += 1;
+      continue;
+    }
+    rect_pack_free_remove(packer, i);
+    i = 0;
+  }
+  if(packer->free_count < packer->free_capacity)
+    packer->free_rects[packer->free_count++] = rect;
+}
+
+//- nb: best area fit, the rest split along the shorter leftover axis so
+// the bigger piece stays whole
+internal b32
+rect_pack_guillotine_insert(Rect_Packer *packer, u32 width, u32 height, Rect_Pack_Rect *rect)
+{
+  u32 best = 0xffffffffu;
+  u64 best_area = ~0ull;
+  u32 best_side = 0xffffffffu;
+  for(u32 i = 0; i < packer->free_count; i++)
+  {
+    Rect_Pack_Rect free = packer->free_rects[i];
+    if(free.width < width || free.height < height)
+      continue;
+    u64 area = (u64)free.width * free.height - (u64)width * height;
+    u32 side = Min(free.width - width, free.height - height);
+    if(area < best_area || (area == best_area && side < best_side))
+    {
+      best      = i;
+      best_area = area;
+      best_side = side;
+    }
+  }
+  if(best == 0xffffffffu)
+    return 0;
+
+  Rect_Pack_Rect free = packer->free_rects[best];
+  rect_pack_free_remove(packer, best);
+  u32 right_w = free.width - width;
+  u32 below_h = free.height - height;
+  Rect_Pack_Rect right, below;
+  if(right_w < below_h)
+  {
+    right = {free.x + width, free.y, right_w, height};
+    below = {free.x, free.y + height, free.width, below_h};
+  }
+  else
+  {
+    right = {free.x + width, free.y, right_w, free.height};
+    below = {free.x, free.y + height, width, below_h};
+  }
+  rect_pack_free_push(packer, right);
+  rect_pack_free_push(packer, below);
+  *rect = {free.x, free.y, width, height};
+  return 1;
+}
+
+////////////////////////////////
+//~ nb: Shelf
+internal b32
+rect_pack_shelf_insert(Rect_Packer *packer, u32 width, u32 height, Rect_Pack_Rect *rect)
+{
+  if(rect_pack_guillotine_insert(packer, width, height, rect))
+    return 1;
+  u32 best = 0xffffffffu;
+  for(u32 i = 0; i < packer->shelf_count; i++)
+  {
+    Rect_Pack_Shelf *shelf = &packer->shelves[i];
+    if(shelf->height >= height && shelf->used + width <= packer->width &&
+       (best == 0xffffffffu || shelf->height < packer->shelves[best].height))
+      best = i;
+  }
+  //- nb: a new shelf when the best one would waste more than the rect
+  u32 top = 0;
+  if(packer->shelf_count > 0)
+  {
+    Rect_Pack_Shelf *last = &packer->shelves[packer->shelf_count - 1];
+    top = last->y + last->height;
+  }
+  b32 room = top + height <= packer->height && packer->shelf_count < packer->shelf_capacity;
+  if(room && (best == 0xffffffffu || packer->shelves[best].height - height > height))
+  {
+    best = packer->shelf_count++;
+    packer->shelves[best] = {top, height, 0};
+  }
+  if(best == 0xffffffffu)
+    return 0;
+  Rect_Pack_Shelf *shelf = &packer->shelves[best];
+  *rect = {shelf->used, shelf->y, width, height};
+  shelf->used += width;
+  return 1;
+}
+
+////////////////////////////////
+//~ nb: Skyline
+//- nb: lowest y a `width` wide rect can sit at starting at node `index`,
+// -1 when it runs off the bin
+internal s32
+rect_pack_skyline_fit(Rect_Packer *packer, u32 index, s32 width, s32 height)
+{
+  if(packer->nodes[index].x + width > (s32)packer->width)
+    return -1;
+  s32 y = 0;
+  for(s32 left = width; left > 0; index++)
+  {
+    y = Max(y, packer->nodes[index].y);
+    if(y + height > (s32)packer->height)
+      return -1;
+    left -= packer->nodes[index].width;
+  }
+  return y;
+}
+
+//- nb: lowest top edge first, then the narrowest node
+internal b32
+rect_pack_skyline_insert(Rect_Packer *packer, u32 width, u32 height, Rect_Pack_Rect *rect)
+{
+  if(rect_pack_guillotine_insert(packer, width, height, rect))
+    return 1;
+  s32 best_index = -1, best_top = 0x7fffffff, best_width = 0x7fffffff, best_y = 0;
+  for(u32 i = 0; i < packer->node_count; i++)
+  {
+    s32 y = rect_pack_skyline_fit(packer, i, (s32)width, (s32)height);
+    if(y < 0)
+      continue;
+    s32 top = y + (s32)height;
+    if(top < best_top || (top == best_top && packer->nodes[i].width < best_width))
+    {
+      best_index = (s32)i;
+      best_top   = top;
+      best_width = packer->nodes[i].width;
+      best_y     = y;
+    }
+  }
+  if(best_index < 0)
+    return 0;
+
+  //- nb: the new node, then trim what it covers and join equal heights
+  Rect_Pack_Node node = {packer->nodes[best_index].x, best_top, (s32)width};
+  memmove(packer->nodes + best_index + 1, packer->nodes + best_index, sizeof(Rect_Pack_Node) * (packer->node_count - best_index));
+  packer->nodes[best_index] = node;
+  packer->node_count += 1;
+  for(u32 i = (u32)best_index + 1; i < packer->node_count;)
+  {
+    Rect_Pack_Node *prev = &packer->nodes[i - 1];
+    Rect_Pack_Node *next = &packer->nodes[i];
+    s32 overlap = prev->x + prev->width - next->x;
+    if(overlap <= 0)
+      break;
+    next->x     += overlap;
+    next->width -= overlap;
+    if(next->width > 0)
+      break;
+    memmove(packer->nodes + i, packer->nodes + i + 1, sizeof(Rect_Pack_Node) * (packer->node_count - i - 1));
+    packer->node_count -= 1;
+  }
+  for(u32 i = 0; i + 1 < packer->node_count;)
+  {
+    if(packer->nodes[i].y == packer->nodes[i + 1].y)
+    {
+      packer->nodes[i].width += packer->nodes[i + 1].width;
+      memmove(packer->nodes + i + 1, packer->nodes + i + 2, sizeof(Rect_Pack_Node) * (packer->node_count - i - 2));
+      packer->node_count -= 1;
+    }
+    else
+    {
+      i += 1;
+    }
+  }
+  *rect = {(u32)node.x, (u32)best_y, width, height};
+  return 1;
+}
+
+////////////////////////////////
+//~ nb: MaxRects
+// nb: free rects overlap, every one is as big as it can be. A placed rect
+// cuts each free rect it touches into up to four, and any free rect inside
+// another is dropped.
+internal b32
+rect_pack_maxrects_insert(Rect_Packer *packer, u32 width, u32 height, Rect_Pack_Rect *rect)
+{
+  u32 best = 0xffffffffu, best_short = 0xffffffffu, best_long = 0xffffffffu;
+  for(u32 i = 0; i < packer->free_count; i++)
+  {
+    Rect_Pack_Rect free = packer->free_rects[i];
+    if(free.width < width || free.height < height)
+      continue;
+    u32 dw = free.width - width, dh = free.height - height;
+    u32 short_side = Min(dw, dh), long_side = Max(dw, dh);
+    if(short_side < best_short || (short_side == best_short && long_side < best_long))
+    {
+      best       = i;
+      best_short = short_side;
+      best_long  = long_side;
+    }
+  }
+  if(best == 0xffffffffu)
+    return 0;
+  Rect_Pack_Rect placed = {packer->free_rects[best].x, packer->free_rects[best].y, width, height};
+
+  //- nb: split, dead rects get a zero width until compacted
+  u32 old_count = packer->free_count;
+  for(u32 i = 0; i < old_count; i++)
+  {
+    Rect_Pack_Rect free = packer->free_rects[i];
+    if(placed.x >= free.x + free.width || placed.x + placed.width <= free.x ||
+       placed.y >= free.y + free.height || placed.y + placed.height <= free.y)
+      continue;
+    packer->free_rects[i].width = 0;
+    Rect_Pack_Rect pieces[4] =
+    {
+      {free.x, free.y, placed.x > free.x ? placed.x - free.x : 0, free.height},
+      {placed.x + placed.width, free.y,
+        free.x + free.width > placed.x + placed.width ? free.x + free.width - (placed.x + placed.width) : 0, free.height},
+      {free.x, free.y, free.width, placed.y > free.y ? placed.y - free.y : 0},
+      {free.x, placed.y + placed.height,
+        free.width, free.y + free.height > placed.y + placed.height ? free.y + free.height - (placed.y + placed.height) : 0},
+    };
+    for(u32 p = 0; p < 4; p++)
+    {
+      // nb: dropping one when full only loses space
+      if(pieces[p].width > 0 && pieces[p].height > 0 && packer->free_count < packer->free_capacity)
+        packer->free_rects[packer->free_count++] = pieces[p];
+    }
+  }
+
+  //- nb: only new pieces can be inside something, or have old rects inside
+  // them, the old ones were pruned against each other already
+  for(u32 j = old_count; j < packer->free_count; j++)
+  {
+    for(u32 i = 0; i < packer->free_count && packer->free_rects[j].width; i++)
+    {
+      if(i == j || packer->free_rects[i].width == 0)
+        continue;
+      if(rect_pack_contains(packer->free_rects[i], packer->free_rects[j]))
+        packer->free_rects[j].width = 0;
+      else if(i < old_count && rect_pack_contains(packer->free_rects[j], packer->free_rects[i]))
+        packer->free_rects[i].width = 0;
+    }
+  }
+  u32 alive = 0;
+  for(u32 i = 0; i < packer->free_count; i++)
+  {
+    if(packer->free_rects[i].width)
+      packer->free_rects[alive++] = packer->free_rects[i];
+  }
+  packer->free_count = alive;
+  *rect = placed;
+  return 1;
+}
+
+internal void
+rect_pack_maxrects_remove(Rect_Packer *packer, Rect_Pack_Rect rect)
+{
+  for(u32 i = 0; i < packer->free_count; i++)
+  {
+    if(rect_pack_contains(packer->free_rects[i], rect))
+      return;
+  }
+  for(u32 i = 0; i < packer->free_count;)
+  {
+    if(rect_pack_contains(rect, packer->free_rects[i]))
+      rect_pack_free_remove(packer, i);
+    else
+      i += 1;
+  }
+  rect_pack_free_push(packer, rect);
+}
+
+////////////////////////////////
+//~ nb: Packer
+Rect_Packer *
+rect_pack_alloc(Arena *arena, Rect_Pack_Strategy strategy, u32 width, u32 height, u32 max_rects)
+{
+  Rect_Packer *packer = (Rect_Packer*)arena_push(arena, sizeof(Rect_Packer));
+  memset(packer, 0, sizeof(Rect_Packer));
+  packer->strategy = strategy;
+  packer->width    = width;
+  packer->height   = height;
+  // nb: a few free rects per placed one, splits and holes outnumber the
+  // rects under churn
+  packer->free_capacity = Max(64u, max_rects * 4);
+  packer->free_rects = (Rect_Pack_Rect*)arena_push(arena, sizeof(Rect_Pack_Rect) * packer->free_capacity);
+  if(strategy == RECT_PACK_SHELF)
+  {
+    packer->shelf_capacity = height;
+    packer->shelves = (Rect_Pack_Shelf*)arena_push(arena, sizeof(Rect_Pack_Shelf) * packer->shelf_capacity);
+  }
+  if(strategy == RECT_PACK_SKYLINE)
+    packer->nodes = (Rect_Pack_Node*)arena_push(arena, sizeof(Rect_Pack_Node) * (width + 1));
+  rect_pack_reset(packer);
+  return packer;
+}
+
+void
+rect_pack_reset(Rect_Packer *packer)
+{
+  packer->used_area   = 0;
+  packer->rect_count  = 0;
+  packer->shelf_count = 0;
+  packer->free_count  = 0;
+  packer->node_count  = 0;
+  switch(packer->strategy)
+  {
+    case RECT_PACK_SKYLINE:
+    {
+      packer->nodes[0]   = {0, 0, (s32)packer->width};
+      packer->node_count = 1;
+    }break;
+    case RECT_PACK_GUILLOTINE:
+    case RECT_PACK_MAXRECTS:
+    {
+      packer->free_rects[0] = {0, 0, packer->width, packer->height};
+      packer->free_count    = 1;
+    }break;
+    default: break;
+  }
+}
+
+b32
+rect_pack_insert(Rect_Packer *packer, u32 width, u32 height, Rect_Pack_Rect *rect)
+{
+  if(width == 0 || height == 0 || width > packer->width || height > packer->height)
+    return 0;
+  b32 ok = 0;
+  switch(packer->strategy)
+  {
+    case RECT_PACK_SHELF:      ok = rect_pack_shelf_insert(packer, width, height, rect); break;
+    case RECT_PACK_SKYLINE:    ok = rect_pack_skyline_insert(packer, width, height, rect); break;
+    case RECT_PACK_GUILLOTINE: ok = rect_pack_guillotine_insert(packer, width, height, rect); break;
+    case RECT_PACK_MAXRECTS:   ok = rect_pack_maxrects_insert(packer, width, height, rect); break;
+    default: break;
+  }
+  if(ok)
+  {
+    packer->used_area  += (u64)width * height;
+    packer->rect_count += 1;
+  }
+  return ok;
+}
+
+void
+rect_pack_remove(Rect_Packer *packer, Rect_Pack_Rect rect)
+{
+  Assert(packer->rect_count > 0);
+  packer->used_area  -= (u64)rect.width * rect.height;
+  packer->rect_count -= 1;
+  if(packer->rect_count == 0)
+  {
+    rect_pack_reset(packer);
+    return;
+  }
+  switch(packer->strategy)
+  {
+    case RECT_PACK_MAXRECTS: rect_pack_maxrects_remove(packer, rect); break;
+    default:                 rect_pack_free_push(packer, rect); break;
+  }
+}
+
+f32
+rect_pack_occupancy(Rect_Packer *packer)
+{
+  return (f32)((f64)packer->used_area / ((f64)packer->width * packer->height));
+}
+
+const char *
+rect_pack_strategy_string(Rect_Pack_Strategy strategy)
+{
+  return strategy < RECT_PACK_STRATEGY_COUNT ? rect_pack_strategy_strings[strategy] : "?";
+}
@@ -0,0 +1,94 @@
+#ifndef RECT_PACK_H
+#define RECT_PACK_H
+
+////////////////////////////////
+//~ nb: Rectangle packing
+// Places rectangles in a fixed width x height bin and takes them back, for
+// glyph atlases and sprite sheets. Four strategies, cheapest first:
+//
+//  shelf       rows as tall as the first rect in them, best fitting row
+//  skyline     bottom-left on the top edge of everything placed
+//  guillotine  free rects split in two on every insert, best area fit
+//  maxrects    maximal free rects, best short side fit, packs tightest
+//
+// Shelf and skyline can't give space back on their own, removed rects go
+// to a list of holes that later inserts try first. Guillotine and maxrects
+// put them back in their free lists. Padding is the caller's, ask for the
+// padded size. Only depends on base.h.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum Rect_Pack_Strategy
+{
+  RECT_PACK_SHELF,
+  RECT_PACK_SKYLINE,
+  RECT_PACK_GUILLOTINE,
+  RECT_PACK_MAXRECTS,
+  RECT_PACK_STRATEGY_COUNT,
+}
+Rect_Pack_Strategy;
+
+typedef struct Rect_Pack_Rect Rect_Pack_Rect;
+struct Rect_Pack_Rect
+{
+  u32 x;
+  u32 y;
+  u32 width;
+  u32 height;
+};
+
+typedef struct Rect_Pack_Shelf Rect_Pack_Shelf;
+struct Rect_Pack_Shelf
+{
+  u32 y;
+  u32 height;
+  u32 used;                       // width taken from the left
+};
+
+//- nb: the top edge of everything placed, left to right
+typedef struct Rect_Pack_Node Rect_Pack_Node;
+struct Rect_Pack_Node
+{
+  s32 x;
+  s32 y;
+  s32 width;
+};
+
+typedef struct Rect_Packer Rect_Packer;
+struct Rect_Packer
+{
+  Rect_Pack_Strategy strategy;
+  u32                width;
+  u32                height;
+  u64                used_area;
+  u32                rect_count;
+
+  Rect_Pack_Shelf    *shelves;
+  u32                shelf_count;
+  u32                shelf_capacity;
+  Rect_Pack_Node     *nodes;
+  u32                node_count;
+  // nb: holes for shelf and skyline, the free list for the others. When it
+  // is full a freed rect is dropped, the space is lost until a reset.
+  Rect_Pack_Rect     *free_rects;
+  u32                free_count;
+  u32                free_capacity;
+};
+
+// nb: `max_rects` sizes the free lists, more live rects than that still
+// pack but may lose freed space
+Rect_Packer *rect_pack_alloc(Arena *arena, Rect_Pack_Strategy strategy, u32 width, u32 height, u32 max_rects);
+void         rect_pack_reset(Rect_Packer *packer);
+b32          rect_pack_insert(Rect_Packer *packer, u32 width, u32 height, Rect_Pack_Rect *rect);
+// nb: `rect` must be one insert handed out and not removed since
+void         rect_pack_remove(Rect_Packer *packer, Rect_Pack_Rect rect);
+f32          rect_pack_occupancy(Rect_Packer *packer);
+const char  *rect_pack_strategy_string(Rect_Pack_Strategy strategy);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //RECT_PACK_H
@@ -23,6 +23,14 @@ D3D11_INPUT_ELEMENT_DESC r_d3d11_ilay_elements[] =
   { "IUV_RECT",0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1}
 };
 
+//- nb: tile grid, the quad only. Per-tile data comes from a buffer.
+D3D11_INPUT_ELEMENT_DESC r_d3d11_tile_ilay_elements[] =
+{
+  { "POS", 0, DXGI_FORMAT_R32G32B32_FLOAT,    0,                            0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+  { "TEX", 0, DXGI_FORMAT_R32G32B32_FLOAT,    0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+  { "COL", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0},
+};
+
 ////////////////////////////////
 //~ nb: Shader
 const char hlsl[] =
@@ -53,6 +61,7 @@ const char hlsl[] =
 "}                                                          \n"
 "                                                           \n"
 "sampler sampler0 : register(s0);                           \n" 
+"sampler linear_sampler : register(s1);                     \n" 
 "Texture2D<float4> texture0 : register(t0);                 \n" 
 "                                                           \n"
 "PS_INPUT vs(VS_INPUT input)                                \n"
@@ -70,12 +79,141 @@ const char hlsl[] =
 "    return output;                                         \n"
 "}                                                          \n"
 "                                                           \n"
+"// Tile grid, one byte per tile. Keep in sync with          \n"
+"// r_tile_grid_vertex in render_core.cpp.                    \n"
+"struct TILE_VS_INPUT                                       \n"
+"{                                                          \n"
+"     float3 pos   : POS;                                   \n"
+"     float3 uv    : TEX;                                   \n"
+"     float4 color : COL;                                   \n"
+"};                                                         \n"
+"                                                           \n"
+"cbuffer TileGrid : register(b1)                            \n"
+"{                                                          \n"
+"    float2 grid_origin;                                    \n"
+"    float2 grid_tile_size;                                 \n"
+"    uint   grid_columns;                                   \n"
+"    uint   grid_visible_columns;                           \n"
+"    uint2  grid_first;                                     \n"
+"    float4 grid_uv_rect_from_tile[256];                    \n"
+"}                                                          \n"
+"                                                           \n"
+"Buffer<uint> grid_tiles : register(t1);                    \n"
+"                                                           \n"
+"PS_INPUT tile_vs(TILE_VS_INPUT input, uint instance_id : SV_InstanceID) \n"
+"{                                                          \n"
+"    PS_INPUT output;                                       \n"
+"    uint2 column_row = grid_first + uint2(instance_id % grid_visible_columns, instance_id / grid_visible_columns); \n"
+"    uint tile = grid_tiles[column_row.y * grid_columns + column_row.x]; \n"
+"    float2 cell = float2(column_row);                      \n"
+"    float2 world_pos = input.pos.xy * grid_tile_size + (grid_origin + cell * grid_tile_size); \n"
+"    output.pos = mul(projection, float4(world_pos, input.pos.z, 1.0f)); \n"
+"                                                           \n"
+"    float4 uv_rect = grid_uv_rect_from_tile[tile];         \n"
+"    output.uv = input.uv.xy * uv_rect.zw + uv_rect.xy;     \n"
+"    output.color = input.color;                            \n"
+"    return output;                                         \n"
+"}                                                          \n"
+"                                                           \n"
+"// Tile map, the board's tile bytes as a texture under one   \n"
+"// quad. Keep in sync with r_tile_map_sample in             \n"
+"// render_core.cpp.                                         \n"
+"cbuffer TileMap : register(b2)                             \n"
+"{                                                          \n"
+"    float2 map_origin;                                     \n"
+"    float2 map_inv_tile_size;                              \n"
+"    float4 map_rect;                                       \n"
+"    float2 map_target_size;                                \n"
+"    uint   map_columns;                                    \n"
+"    uint   map_rows;                                       \n"
+"    float4 map_uv_rect_from_tile[256];                     \n"
+"}                                                          \n"
+"                                                           \n"
+"Texture2D<uint> map_tiles : register(t1);                  \n"
+"                                                           \n"
+"PS_INPUT tile_map_vs(TILE_VS_INPUT input)                  \n"
+"{                                                          \n"
+"    PS_INPUT output;                                       \n"
+"    float2 pixel = lerp(map_rect.xy, map_rect.zw, input.pos.xy); \n"
+"    output.pos = float4(pixel / map_target_size * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), input.pos.z, 1.0f); \n"
+"    output.uv = input.uv.xy;                               \n"
+"    output.color = input.color;                            \n"
+"    return output;                                         \n"
+"}                                                          \n"
+"                                                           \n"
+"float4 tile_map_ps(PS_INPUT input) : SV_TARGET             \n"
+"{                                                          \n"
+"    // SV_POSITION is the pixel center in window pixels     \n"
+"    float2 local = (input.pos.xy - map_origin) * map_inv_tile_size; \n"
+"    float2 cell = floor(local);                            \n"
+"    if(cell.x < 0 || cell.y < 0 || cell.x >= map_columns || cell.y >= map_rows) \n"
+"        discard;                                           \n"
+"    uint tile = map_tiles.Load(int3(cell, 0));             \n"
+"    float4 uv_rect = map_uv_rect_from_tile[tile];          \n"
+"    float2 uv = (local - cell) * uv_rect.zw + uv_rect.xy;  \n"
+"    float4 tex = texture0.SampleLevel(sampler0, uv, 0);    \n"
+"    return input.color * tex;                              \n"
+"}                                                          \n"
+"                                                           \n"
 "float4 ps(PS_INPUT input) : SV_TARGET                      \n"
 "{                                                          \n"
 "    float4 tex = texture0.Sample(sampler0, input.uv);      \n"
 "    return input.color * tex;                              \n"
+"}                                                          \n"
+"                                                           \n"
+"// One and two channel textures, expanded the way          \n"
+"// r_tex2d_unpack in render_core.cpp does.                  \n"
+"float4 ps_r(PS_INPUT input) : SV_TARGET                    \n"
+"{                                                          \n"
+"    float4 tex = texture0.Sample(sampler0, input.uv);      \n"
+"    return input.color * float4(1.0f, 1.0f, 1.0f, tex.r);  \n"
+"}                                                          \n"
+"                                                           \n"
+"float4 ps_rg(PS_INPUT input) : SV_TARGET                   \n"
+"{                                                          \n"
+"    float4 tex = texture0.Sample(sampler0, input.uv);      \n"
+"    return input.color * tex.rrrg;                         \n"
+"}                                                          \n"
+"                                                           \n"
+"// Signed distance, 0.5 on the edge, filtered. The ramp is  \n"
+"// one pixel wide at any scale, r_tex2d_unpack in           \n"
+"// render_core.cpp is the one texel per pixel case.         \n"
+"// sdf_range is R_TEX2D_SDF_RANGE.                          \n"
+"static const float sdf_range = 8.0f;                       \n"
+"float4 ps_sdf(PS_INPUT input) : SV_TARGET                  \n"
+"{                                                          \n"
+"    float d = texture0.Sample(linear_sampler, input.uv).r; \n"
+"    float texels = (d - 0.5f) * sdf_range;                 \n"
+"    float texels_per_pixel = max(fwidth(texels), 1e-4f);   \n"
+"    float a = saturate(texels / texels_per_pixel + 0.5f);  \n"
+"    return input.color * float4(1.0f, 1.0f, 1.0f, a);      \n"
 "}                                                          \n";
 
+////////////////////////////////
+//~ nb: Texture formats
+global DXGI_FORMAT r_d3d11_format_table[R_TEX2D_FORMAT_COUNT] =
+{
+  DXGI_FORMAT_R8G8B8A8_UNORM,
+  DXGI_FORMAT_R8_UNORM,
+  DXGI_FORMAT_R8G8_UNORM,
+  DXGI_FORMAT_BC1_UNORM,
+  DXGI_FORMAT_BC4_UNORM,
+  DXGI_FORMAT_BC7_UNORM,
+  DXGI_FORMAT_R8_UNORM,
+};
+
+//- nb: sprite pixel shader by format, see R_Tex2DFormat
+global u32 r_d3d11_pixel_shader_from_format[R_TEX2D_FORMAT_COUNT] =
+{
+  0,                              // RGBA8
+  2,                              // R8
+  3,                              // RG8
+  0,                              // BC1
+  2,                              // BC4
+  0,                              // BC7
+  4,                              // SDF8
+};
+
 ////////////////////////////////
 //~ nb: Helper macros
 #define SAFE_RELEASE(COM) \
@@ -102,29 +240,6 @@ struct Vertex
   DirectX::XMFLOAT4 color; 
 };
 
-//- nb: A map of the spritesheet tiles
-enum TileKind
-{
-  TILE_ONE,
-  TILE_TWO,
-  TILE_THREE,
-  TILE_FOUR,
-  TILE_FIVE,
-  TILE_SIX,
-  TILE_SEVEN,
-  TILE_EIGHT,
-  TILE_EMPTY,
-  TILE_DEFAULT,
-  TILE_FLAG,
-  TILE_MINECROSS,
-  TILE_QUESTIONMARK,
-  TILE_DEFAULTQUESTIONMARK,
-  TILE_MINE,
-  TILE_MINERED,
-  TILE_END
-};
-
-
 //- nb: Render init
 void 
 r_init()
@@ -132,6 +247,12 @@ r_init()
   Arena *arena = arena_alloc();
   r_d3d11_state = (R_D3D11_State*)arena_push(arena, sizeof(R_D3D11_State));
   r_d3d11_state->arena = arena;
+  r_d3d11_state->cmd_list = r_cmd_list_alloc();
+  r_d3d11_state->draw_backend.map   = r_d3d11_cmd_map;
+  r_d3d11_state->draw_backend.unmap = r_d3d11_cmd_unmap;
+  r_d3d11_state->draw_backend.draw  = r_d3d11_cmd_draw;
+  r_d3d11_state->frame_fence.completed = r_d3d11_fence_completed;
+  r_d3d11_state->frame_fence.wait      = r_d3d11_fence_wait;
   r_create_device_resources();
   r_create_wic_factory();
 }
@@ -153,13 +274,31 @@ r_destroy()
   
   // nb: shader frees
   SAFE_RELEASE(r_d3d11_state->constant_buffers[0]);
+  SAFE_RELEASE(r_d3d11_state->constant_buffers[1]);
+  SAFE_RELEASE(r_d3d11_state->constant_buffers[2]);
   SAFE_RELEASE(r_d3d11_state->pixel_shaders[0]);
+  SAFE_RELEASE(r_d3d11_state->pixel_shaders[1]);
+  SAFE_RELEASE(r_d3d11_state->pixel_shaders[2]);
+  SAFE_RELEASE(r_d3d11_state->pixel_shaders[3]);
+  SAFE_RELEASE(r_d3d11_state->pixel_shaders[4]);
   SAFE_RELEASE(r_d3d11_state->input_layouts[0]);
+  SAFE_RELEASE(r_d3d11_state->input_layouts[1]);
   SAFE_RELEASE(r_d3d11_state->vertex_shaders[0]);
+  SAFE_RELEASE(r_d3d11_state->vertex_shaders[1]);
+  SAFE_RELEASE(r_d3d11_state->vertex_shaders[2]);
   
   SAFE_RELEASE(r_d3d11_state->vertex_buffer);
   SAFE_RELEASE(r_d3d11_state->index_buffer);
   SAFE_RELEASE(r_d3d11_state->instance_buffer);
+  for(u32 i = 0; i < R_RING_MAX_FRAMES; i++)
+    SAFE_RELEASE(r_d3d11_state->frame_queries[i]);
+  SAFE_RELEASE(r_d3d11_state->board_tile_view);
+  SAFE_RELEASE(r_d3d11_state->board_tile_buffer);
+  r_d3d11_state->board_tile_capacity = 0;
+  SAFE_RELEASE(r_d3d11_state->board_map_view);
+  SAFE_RELEASE(r_d3d11_state->board_map_texture);
+  r_d3d11_state->board_map_columns = 0;
+  r_d3d11_state->board_map_rows    = 0;
   
   // nb: depth/stencil states
   SAFE_RELEASE(r_d3d11_state->plain_depth_stencil);
@@ -188,6 +327,7 @@ r_destroy()
   
   SAFE_RELEASE(r_d3d11_state->wic_factory);
   
+  r_cmd_list_release(r_d3d11_state->cmd_list);
   arena_release(r_d3d11_state->arena);
 }
 
@@ -372,7 +512,141 @@ r_create_device_resources()
     r_d3d11_state->input_layouts[0] = ilay;
   }
   
-  // nb: build pixel shaders
+  // nb: build the tile grid vertex shader and its input layout
+  {
+    ID3DBlob *vshad_source_blob = 0;
+    ID3DBlob *vshad_source_errors = 0;
+    ID3D11VertexShader *vshad = 0;
+    {
+      hr = D3DCompile(hlsl, 
+                      sizeof(hlsl),
+                      0,
+                      0,
+                      0,
+                      "tile_vs",
+                      "vs_5_0",
+                      0,
+                      0,
+                      &vshad_source_blob,
+                      &vshad_source_errors);
+      if(FAILED(hr))
+      {
+        // error printing
+        const char* error_msg = (const char*)vshad_source_errors->GetBufferPointer();
+        char buffer[256];
+        StringCchPrintfA(buffer, sizeof(buffer), "Tile vertex shader compilation failed: %s\n", error_msg);
+        MessageBoxA(0,buffer, "Vertex shader compilation failture", MB_OK);
+        __debugbreak();
+      }
+      else
+      {
+        r_d3d11_state->device->CreateVertexShader(vshad_source_blob->GetBufferPointer(),
+                                                  vshad_source_blob->GetBufferSize(),
+                                                  0,
+                                                  &vshad);
+      }
+    }
+    
+    ID3D11InputLayout *ilay = 0;
+    r_d3d11_state->device->CreateInputLayout(r_d3d11_tile_ilay_elements,
+                                             ARRAYSIZE(r_d3d11_tile_ilay_elements),
+                                             vshad_source_blob->GetBufferPointer(),
+                                             vshad_source_blob->GetBufferSize(),
+                                             &ilay);
+    vshad_source_blob->Release();
+    
+    r_d3d11_state->vertex_shaders[1] = vshad;
+    r_d3d11_state->input_layouts[1] = ilay;
+  }
+  
+  // nb: build the tile map vertex shader, it takes the tile grid's input
+  // layout
+  {
+    ID3DBlob *vshad_source_blob = 0;
+    ID3DBlob *vshad_source_errors = 0;
+    ID3D11VertexShader *vshad = 0;
+    {
+      hr = D3DCompile(hlsl, 
+                      sizeof(hlsl),
+                      0,
+                      0,
+                      0,
+                      "tile_map_vs",
+                      "vs_5_0",
+                      0,
+                      0,
+                      &vshad_source_blob,
+                      &vshad_source_errors);
+      if(FAILED(hr))
+      {
+        // error printing
+        const char* error_msg = (const char*)vshad_source_errors->GetBufferPointer();
+        char buffer[256];
+        StringCchPrintfA(buffer, sizeof(buffer), "Tile map vertex shader compilation failed: %s\n", error_msg);
+        MessageBoxA(0,buffer, "Vertex shader compilation failture", MB_OK);
+        __debugbreak();
+      }
+      else
+      {
+        r_d3d11_state->device->CreateVertexShader(vshad_source_blob->GetBufferPointer(),
+                                                  vshad_source_blob->GetBufferSize(),
+                                                  0,
+                                                  &vshad);
+      }
+    }
+    vshad_source_blob->Release();
+    
+    r_d3d11_state->vertex_shaders[2] = vshad;
+  }
+  
+  // nb: build pixel shaders, the sprite shader for each kind of texture
+  {
+    struct { const char *entry; u32 slot; } pixel_shader_entries[] =
+    {
+      {"ps",    0},
+      {"ps_r",  2},
+      {"ps_rg", 3},
+      {"ps_sdf", 4},
+    };
+    for(u32 i = 0; i < ArrayCount(pixel_shader_entries); i++)
+    {
+      ID3DBlob *pshad_source_blob = 0;
+      ID3DBlob *pshad_source_errors = 0;
+      ID3D11PixelShader *pshad = 0;
+      hr = D3DCompile(hlsl, 
+                      sizeof(hlsl),
+                      0,
+                      0,
+                      0,
+                      pixel_shader_entries[i].entry,
+                      "ps_5_0",
+                      0,
+                      0,
+                      &pshad_source_blob,
+                      &pshad_source_errors);
+      if(FAILED(hr))
+      {
+        // error printing
+        const char* error_msg = (const char*)pshad_source_errors->GetBufferPointer();
+        char buffer[256];
+        StringCchPrintfA(buffer, sizeof(buffer), "Pixel shader %s compilation failed: %s\n", pixel_shader_entries[i].entry, error_msg);
+        MessageBoxA(0, buffer, "Pixel shader compilation failture", MB_OK);
+        __debugbreak();
+      }
+      else
+      {
+        r_d3d11_state->device->CreatePixelShader(pshad_source_blob->GetBufferPointer(),
+                                                 pshad_source_blob->GetBufferSize(),
+                                                 0,
+                                                 &pshad);
+      }
+      
+      pshad_source_blob->Release();
+      r_d3d11_state->pixel_shaders[pixel_shader_entries[i].slot] = pshad;
+    }
+  }
+  
+  // nb: build the tile map pixel shader
   {
     ID3DBlob *pshad_source_blob = 0;
     ID3DBlob *pshad_source_errors = 0;
@@ -383,7 +657,7 @@ r_create_device_resources()
                       0,
                       0,
                       0,
-                      "ps",
+                      "tile_map_ps",
                       "ps_5_0",
                       0,
                       0,
@@ -394,7 +668,7 @@ r_create_device_resources()
         // error printing
         const char* error_msg = (const char*)pshad_source_errors->GetBufferPointer();
         char buffer[256];
-        StringCchPrintfA(buffer, sizeof(buffer), "Vertex shader compilation failed: %s\n", error_msg);
+        StringCchPrintfA(buffer, sizeof(buffer), "Tile map pixel shader compilation failed: %s\n", error_msg);
         MessageBoxA(0, buffer, "Pixel shader compilation failture", MB_OK);
         __debugbreak();
       }
@@ -407,7 +681,7 @@ r_create_device_resources()
       }
       
       pshad_source_blob->Release();
-      r_d3d11_state->pixel_shaders[0] = pshad;
+      r_d3d11_state->pixel_shaders[1] = pshad;
     }
   }
   
@@ -430,6 +704,40 @@ r_create_device_resources()
     r_d3d11_state->constant_buffers[0] = buffer;
   }
   
+  // nb: tile grid constants
+  {
+    ID3D11Buffer *buffer = 0;
+    {
+      D3D11_BUFFER_DESC desc = {0};
+      {
+        desc.ByteWidth      = sizeof(R_TileGridConstants);
+        desc.Usage          = D3D11_USAGE_DYNAMIC;
+        desc.BindFlags      = D3D11_BIND_CONSTANT_BUFFER;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+      }
+      r_d3d11_state->device->CreateBuffer(&desc, 0, &buffer);
+    }
+    r_d3d11_state->constant_buffers[1] = buffer;
+    r_d3d11_state->tile_grid_valid = 0;
+  }
+  
+  // nb: tile map constants
+  {
+    ID3D11Buffer *buffer = 0;
+    {
+      D3D11_BUFFER_DESC desc = {0};
+      {
+        desc.ByteWidth      = sizeof(R_TileMapConstants);
+        desc.Usage          = D3D11_USAGE_DYNAMIC;
+        desc.BindFlags      = D3D11_BIND_CONSTANT_BUFFER;
+        desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+      }
+      r_d3d11_state->device->CreateBuffer(&desc, 0, &buffer);
+    }
+    r_d3d11_state->constant_buffers[2] = buffer;
+    r_d3d11_state->tile_map_valid = 0;
+  }
+  
   // nb: build vertex buffers
   {
     
@@ -472,20 +780,18 @@ r_create_device_resources()
     D3D11_SUBRESOURCE_DATA data= {indices};
     r_d3d11_state->device->CreateBuffer(&desc, &data, &r_d3d11_state->index_buffer);
   }
-  // nb: build instance buffer
+  // nb: instance ring, the buffer itself is made by the first map
   {
-    ID3D11Buffer *buffer;
-    {
-      D3D11_BUFFER_DESC desc = {0};
-      {
-        desc.ByteWidth      = sizeof(InstanceData) * 30*16 * 100; // TODO(nb): update instance buffer at will?
-        desc.Usage          = D3D11_USAGE_DYNAMIC;
-        desc.BindFlags      = D3D11_BIND_VERTEX_BUFFER;
-        desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-      }
-      r_d3d11_state->device->CreateBuffer(&desc, 0, &buffer);
-    }
-    r_d3d11_state->instance_buffer = buffer;
+    r_ring_init(&r_d3d11_state->instance_ring, sizeof(InstanceData) * 30*16 * 100);
+  }
+  // nb: frame fence
+  {
+    D3D11_QUERY_DESC desc = {0};
+    desc.Query = D3D11_QUERY_EVENT;
+    for(u32 i = 0; i < R_RING_MAX_FRAMES; i++)
+      r_d3d11_state->device->CreateQuery(&desc, &r_d3d11_state->frame_queries[i]);
+    r_d3d11_state->frame_fence_submitted = 0;
+    r_d3d11_state->frame_fence_completed = 0;
   }
   
 }
@@ -592,6 +898,7 @@ r_create_window_size_dependent_resources()
   r_d3d11_state->context->VSSetShader(r_d3d11_state->vertex_shaders[0], NULL, 0);
   r_d3d11_state->context->PSSetShader(r_d3d11_state->pixel_shaders[0], NULL, 0);
   r_d3d11_state->context->PSSetSamplers(0, 1, &r_d3d11_state->point_sampler);
+  r_d3d11_state->context->PSSetSamplers(1, 1, &r_d3d11_state->linear_sampler);
   r_d3d11_state->context->OMSetRenderTargets(1, &r_d3d11_state->framebuffer_rtv, NULL);
   r_d3d11_state->context->OMSetBlendState(r_d3d11_state->main_blend_state, NULL, 0xffffffff);
   
@@ -650,6 +957,24 @@ r_clear(const float *color)
 void 
 r_present()
 {
+  //- nb: everything queued this frame goes out with one map
+  r_cmd_list_flush(r_d3d11_state->cmd_list, &r_d3d11_state->draw_backend);
+  r_d3d11_state->last_frame_counters = r_d3d11_state->draw_backend.counters;
+  memset(&r_d3d11_state->draw_backend.counters, 0, sizeof(R_FrameCounters));
+  
+  //- nb: Signal the end of the frame. The query slot is free again once
+  // the frame that used it last is done, a grow can drop the ring's frames
+  // so this doesn't rely on r_ring_end_frame.
+  {
+    R_Fence *fence = &r_d3d11_state->frame_fence;
+    u64 value = r_d3d11_state->frame_fence_submitted + 1;
+    if(value > R_RING_MAX_FRAMES)
+      r_d3d11_fence_wait(fence, value - R_RING_MAX_FRAMES);
+    r_ring_end_frame(&r_d3d11_state->instance_ring, value, fence);
+    r_d3d11_state->context->End(r_d3d11_state->frame_queries[(value - 1) % R_RING_MAX_FRAMES]);
+    r_d3d11_state->frame_fence_submitted = value;
+  }
+  
   HRESULT hr = r_d3d11_state->swapchain->Present(1, 0);
   ////////////////////////////////
   
@@ -689,44 +1014,308 @@ r_set_transform(f32 x, f32 y, f32 scale_x, f32 scale_y)
   
 }
 
-void
-r_submit_batch(const InstanceData *instance_data, u32 length, R_Handle texture)
+////////////////////////////////
+//~ nb: Frame command list
+static_assert(sizeof(InstanceData) == sizeof(R_Quad), "InstanceData has to match R_Quad");
+
+InstanceData *
+r_push_quads(R_Handle texture, R_Layer layer, u32 count)
 {
-  //- nb: Fill instance buffer
-  D3D11_MAPPED_SUBRESOURCE mapped;
+  return (InstanceData*)r_cmd_push_quads(r_d3d11_state->cmd_list, texture, layer, count);
+}
+
+R_FrameCounters
+r_frame_counters()
+{
+  return r_d3d11_state->last_frame_counters;
+}
+
+internal R_Quad *
+r_d3d11_cmd_map(R_DrawBackend *backend, u32 quad_count)
+{
+  R_Ring *ring = &r_d3d11_state->instance_ring;
+  R_RingAlloc alloc = r_ring_alloc(ring, (u64)quad_count * sizeof(R_Quad), sizeof(R_Quad), &r_d3d11_state->frame_fence);
+  
+  //- nb: the ring grew (or this is the first map), make a buffer that size.
+  // Draws already issued keep the old one alive.
+  if(alloc.discard)
   {
-    r_d3d11_state->context->Map(r_d3d11_state->instance_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
-    CopyMemory(mapped.pData, instance_data, sizeof(InstanceData) * length);
-    r_d3d11_state->context->Unmap(r_d3d11_state->instance_buffer, 0);
+    SAFE_RELEASE(r_d3d11_state->instance_buffer);
+    D3D11_BUFFER_DESC desc = {0};
+    {
+      desc.ByteWidth      = (UINT)ring->capacity;
+      desc.Usage          = D3D11_USAGE_DYNAMIC;
+      desc.BindFlags      = D3D11_BIND_VERTEX_BUFFER;
+      desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    }
+    r_d3d11_state->device->CreateBuffer(&desc, 0, &r_d3d11_state->instance_buffer);
   }
   
-  //- nb: Set buffers
+  //- nb: the fence made sure the GPU is done with this range
+  D3D11_MAP map_type = alloc.discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+  D3D11_MAPPED_SUBRESOURCE mapped;
+  r_d3d11_state->context->Map(r_d3d11_state->instance_buffer, 0, map_type, 0, &mapped);
+  r_d3d11_state->instance_base = (u32)(alloc.offset / sizeof(R_Quad));
+  return (R_Quad*)((u8*)mapped.pData + alloc.offset);
+}
+
+internal void
+r_d3d11_cmd_unmap(R_DrawBackend *backend)
+{
+  r_d3d11_state->context->Unmap(r_d3d11_state->instance_buffer, 0);
+  
+  //- nb: Set buffers, once for all of the frame's draws
   {
     UINT strides[2] = { sizeof(Vertex), sizeof(InstanceData) };
     UINT offsets[2] = { 0, 0 };
     ID3D11Buffer *buffers[2] = { r_d3d11_state->vertex_buffer, r_d3d11_state->instance_buffer };
     r_d3d11_state->context->IASetVertexBuffers(0, 2, buffers, strides, offsets);
   }
-  
-  
+}
+
+internal void
+r_d3d11_cmd_draw(R_DrawBackend *backend, R_Handle texture, u32 first_quad, u32 quad_count)
+{
   R_D3D11_Tex2D *tex2d = r_d3d11_tex2d_from_handle(texture);
+  r_d3d11_state->context->PSSetShader(r_d3d11_state->pixel_shaders[r_d3d11_pixel_shader_from_format[tex2d->format]], NULL, 0);
   r_d3d11_state->context->PSSetShaderResources(0, 1, &tex2d->view);
   r_d3d11_state->context->DrawIndexedInstanced(6,             // indices,
-                                               length,        // num
+                                               quad_count,    // num
                                                0,             // start index loc
                                                0,             // base vertex loc
-                                               0);            // start instance loc
+                                               r_d3d11_state->instance_base + first_quad); // start instance loc
+}
+
+//- nb: Frame fence. Queries complete in order, so the count of completed
+// ones is the fence value.
+internal u64
+r_d3d11_fence_completed(R_Fence *fence)
+{
+  while(r_d3d11_state->frame_fence_completed < r_d3d11_state->frame_fence_submitted)
+  {
+    ID3D11Query *query = r_d3d11_state->frame_queries[r_d3d11_state->frame_fence_completed % R_RING_MAX_FRAMES];
+    if(r_d3d11_state->context->GetData(query, 0, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+      break;
+    r_d3d11_state->frame_fence_completed += 1;
+  }
+  return r_d3d11_state->frame_fence_completed;
 }
 
-// TODO(nb): ?
+internal void
+r_d3d11_fence_wait(R_Fence *fence, u64 value)
+{
+  // nb: the queries may still sit in the command buffer
+  if(r_d3d11_fence_completed(fence) < value)
+    r_d3d11_state->context->Flush();
+  while(r_d3d11_fence_completed(fence) < value)
+    YieldProcessor();
+}
+
+////////////////////////////////
+//~ nb: Board tiles
+b32
+r_board_tiles_reserve(u32 count)
+{
+  if(r_d3d11_state->board_tile_buffer && r_d3d11_state->board_tile_capacity >= count)
+    return 0;
+  SAFE_RELEASE(r_d3d11_state->board_tile_view);
+  SAFE_RELEASE(r_d3d11_state->board_tile_buffer);
+  count = ClampBot(count, 1);
+  
+  // nb: default usage, the dirty ranges go in through UpdateSubresource
+  // which stages them, so ranges the GPU is still drawing from are safe
+  ID3D11Buffer *buffer = 0;
+  {
+    D3D11_BUFFER_DESC desc = {0};
+    {
+      // nb: buffer sizes are whole dwords
+      desc.ByteWidth      = AlignPow2(count, 4);
+      desc.Usage          = D3D11_USAGE_DEFAULT;
+      desc.BindFlags      = D3D11_BIND_SHADER_RESOURCE;
+    }
+    r_d3d11_state->device->CreateBuffer(&desc, 0, &buffer);
+  }
+  ID3D11ShaderResourceView *view = 0;
+  {
+    D3D11_SHADER_RESOURCE_VIEW_DESC desc = {};
+    {
+      desc.Format              = DXGI_FORMAT_R8_UINT;
+      desc.ViewDimension       = D3D11_SRV_DIMENSION_BUFFER;
+      desc.Buffer.FirstElement = 0;
+      desc.Buffer.NumElements  = count;
+    }
+    r_d3d11_state->device->CreateShaderResourceView(buffer, &desc, &view);
+  }
+  r_d3d11_state->board_tile_buffer   = buffer;
+  r_d3d11_state->board_tile_view     = view;
+  r_d3d11_state->board_tile_capacity = count;
+  r_d3d11_state->board_upload_backend.upload = r_d3d11_board_upload;
+  return 1;
+}
+
+internal void
+r_d3d11_board_upload(R_UploadBackend *backend, u64 offset, u64 size, const void *data, b32 full)
+{
+  D3D11_BOX box = {(UINT)offset, 0, 0, (UINT)(offset + size), 1, 1};
+  r_d3d11_state->context->UpdateSubresource(r_d3d11_state->board_tile_buffer, 0, &box, data, 0, 0);
+  r_d3d11_state->draw_backend.counters.updates        += 1;
+  r_d3d11_state->draw_backend.counters.bytes_uploaded += size;
+}
+
+void
+r_board_tiles_upload(R_UploadPlan *plan, const u8 *tiles)
+{
+  r_upload_plan_execute(&r_d3d11_state->board_upload_backend, plan, tiles, 1);
+}
+
+void
+r_submit_tile_grid(R_TileGridConstants *grid, u32 count, R_Handle texture)
+{
+  //- nb: the constants only change with the board size and the camera
+  if(!r_d3d11_state->tile_grid_valid || memcmp(&r_d3d11_state->tile_grid, grid, sizeof(R_TileGridConstants)) != 0)
+  {
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    r_d3d11_state->context->Map(r_d3d11_state->constant_buffers[1], 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+    CopyMemory(mapped.pData, grid, sizeof(R_TileGridConstants));
+    r_d3d11_state->context->Unmap(r_d3d11_state->constant_buffers[1], 0);
+    r_d3d11_state->tile_grid = *grid;
+    r_d3d11_state->tile_grid_valid = 1;
+    r_d3d11_state->draw_backend.counters.maps           += 1;
+    r_d3d11_state->draw_backend.counters.bytes_uploaded += sizeof(R_TileGridConstants);
+  }
+  
+  //- nb: Set buffers, the quad is the only vertex input
+  {
+    UINT stride = sizeof(Vertex);
+    UINT offset = 0;
+    r_d3d11_state->context->IASetVertexBuffers(0, 1, &r_d3d11_state->vertex_buffer, &stride, &offset);
+  }
+  r_d3d11_state->context->IASetInputLayout(r_d3d11_state->input_layouts[1]);
+  r_d3d11_state->context->VSSetShader(r_d3d11_state->vertex_shaders[1], NULL, 0);
+  // nb: the last sprite draw may have left a one channel shader bound
+  r_d3d11_state->context->PSSetShader(r_d3d11_state->pixel_shaders[0], NULL, 0);
+  r_d3d11_state->context->VSSetConstantBuffers(1, 1, &r_d3d11_state->constant_buffers[1]);
+  r_d3d11_state->context->VSSetShaderResources(1, 1, &r_d3d11_state->board_tile_view);
+  
+  R_D3D11_Tex2D *tex2d = r_d3d11_tex2d_from_handle(texture);
+  r_d3d11_state->context->PSSetShaderResources(0, 1, &tex2d->view);
+  r_d3d11_state->context->DrawIndexedInstanced(6, count, 0, 0, 0);
+  r_d3d11_state->draw_backend.counters.draws += 1;
+  
+  //- nb: back to the instanced sprite path for everything else
+  r_d3d11_state->context->IASetInputLayout(r_d3d11_state->input_layouts[0]);
+  r_d3d11_state->context->VSSetShader(r_d3d11_state->vertex_shaders[0], NULL, 0);
+}
+
+////////////////////////////////
+//~ nb: Board tile map
+b32
+r_board_map_reserve(u32 columns, u32 rows)
+{
+  if(r_d3d11_state->board_map_texture &&
+     r_d3d11_state->board_map_columns == columns && r_d3d11_state->board_map_rows == rows)
+    return 0;
+  SAFE_RELEASE(r_d3d11_state->board_map_view);
+  SAFE_RELEASE(r_d3d11_state->board_map_texture);
+  Assert(columns <= R_TILE_MAP_MAX_SIZE && rows <= R_TILE_MAP_MAX_SIZE);
+  
+  // nb: default usage for the same reason as the tile buffer, the dirty
+  // rows go in through UpdateSubresource
+  D3D11_TEXTURE2D_DESC desc = {0};
+  {
+    desc.Width              = ClampBot(columns, 1);
+    desc.Height             = ClampBot(rows, 1);
+    desc.MipLevels          = 1;
+    desc.ArraySize          = 1;
+    desc.Format             = DXGI_FORMAT_R8_UINT;
+    desc.SampleDesc.Count   = 1;
+    desc.Usage              = D3D11_USAGE_DEFAULT;
+    desc.BindFlags          = D3D11_BIND_SHADER_RESOURCE;
+  }
+  r_d3d11_state->device->CreateTexture2D(&desc, 0, &r_d3d11_state->board_map_texture);
+  r_d3d11_state->device->CreateShaderResourceView((ID3D11Resource *)r_d3d11_state->board_map_texture, 0, &r_d3d11_state->board_map_view);
+  r_d3d11_state->board_map_columns = columns;
+  r_d3d11_state->board_map_rows    = rows;
+  r_d3d11_state->board_map_upload_backend.upload = r_d3d11_board_map_upload;
+  return 1;
+}
+
+//- nb: a range of cells is at most three boxes of rows, `data` points at
+// the range's first cell
+internal void
+r_d3d11_board_map_upload(R_UploadBackend *backend, u64 offset, u64 size, const void *data, b32 full)
+{
+  u32 columns = r_d3d11_state->board_map_columns;
+  const u8 *cells = (const u8*)data - offset;
+  R_TileMapBox boxes[3];
+  u32 box_count = r_tile_map_boxes(columns, offset, size, boxes);
+  for(u32 i = 0; i < box_count; i++)
+  {
+    R_TileMapBox *box = &boxes[i];
+    D3D11_BOX d3d_box = {box->x, box->y, 0, box->x + box->width, box->y + box->height, 1};
+    r_d3d11_state->context->UpdateSubresource(r_d3d11_state->board_map_texture, 0, &d3d_box,
+                                              cells + (u64)box->y * columns + box->x, columns, 0);
+    r_d3d11_state->draw_backend.counters.updates        += 1;
+    r_d3d11_state->draw_backend.counters.bytes_uploaded += (u64)box->width * box->height;
+  }
+}
+
+void
+r_board_map_upload(R_UploadPlan *plan, const u8 *tiles)
+{
+  r_upload_plan_execute(&r_d3d11_state->board_map_upload_backend, plan, tiles, 1);
+}
+
+void
+r_submit_tile_map(R_TileMapConstants *map, R_Handle texture)
+{
+  //- nb: the constants only change with the board size and the camera
+  if(!r_d3d11_state->tile_map_valid || memcmp(&r_d3d11_state->tile_map, map, sizeof(R_TileMapConstants)) != 0)
+  {
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    r_d3d11_state->context->Map(r_d3d11_state->constant_buffers[2], 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+    CopyMemory(mapped.pData, map, sizeof(R_TileMapConstants));
+    r_d3d11_state->context->Unmap(r_d3d11_state->constant_buffers[2], 0);
+    r_d3d11_state->tile_map = *map;
+    r_d3d11_state->tile_map_valid = 1;
+    r_d3d11_state->draw_backend.counters.maps           += 1;
+    r_d3d11_state->draw_backend.counters.bytes_uploaded += sizeof(R_TileMapConstants);
+  }
+  
+  //- nb: Set buffers, the quad is the only vertex input
+  {
+    UINT stride = sizeof(Vertex);
+    UINT offset = 0;
+    r_d3d11_state->context->IASetVertexBuffers(0, 1, &r_d3d11_state->vertex_buffer, &stride, &offset);
+  }
+  r_d3d11_state->context->IASetInputLayout(r_d3d11_state->input_layouts[1]);
+  r_d3d11_state->context->VSSetShader(r_d3d11_state->vertex_shaders[2], NULL, 0);
+  r_d3d11_state->context->PSSetShader(r_d3d11_state->pixel_shaders[1], NULL, 0);
+  r_d3d11_state->context->VSSetConstantBuffers(2, 1, &r_d3d11_state->constant_buffers[2]);
+  r_d3d11_state->context->PSSetConstantBuffers(2, 1, &r_d3d11_state->constant_buffers[2]);
+  
+  R_D3D11_Tex2D *tex2d = r_d3d11_tex2d_from_handle(texture);
+  ID3D11ShaderResourceView *views[2] = { tex2d->view, r_d3d11_state->board_map_view };
+  r_d3d11_state->context->PSSetShaderResources(0, 2, views);
+  r_d3d11_state->context->DrawIndexed(6, 0, 0);
+  r_d3d11_state->draw_backend.counters.draws += 1;
+  
+  //- nb: back to the instanced sprite path for everything else
+  r_d3d11_state->context->IASetInputLayout(r_d3d11_state->input_layouts[0]);
+  r_d3d11_state->context->VSSetShader(r_d3d11_state->vertex_shaders[0], NULL, 0);
+  r_d3d11_state->context->PSSetShader(r_d3d11_state->pixel_shaders[0], NULL, 0);
+}
+
+// nb: `format` is what the texture is kept as on the GPU, compressed formats
+// are encoded here at load time (see render_bc)
 R_Handle
-r_tex2d_load_file(const wchar_t *filename)
+r_tex2d_load_file(const wchar_t *filename, R_Tex2DFormat format)
 {
-  return r_create_tex2d_from_file(filename);
+  return r_create_tex2d_from_file(filename, format);
 }
 
 R_Handle
-r_tex2d_alloc(DirectX::XMUINT2 size, void *data)
+r_tex2d_alloc(R_Tex2DFormat format, DirectX::XMUINT2 size, void *data)
 {
   R_D3D11_Tex2D *texture;
   // nb: See if there is a free texture
@@ -750,9 +1339,7 @@ r_tex2d_alloc(DirectX::XMUINT2 size, void *data)
   {
     initial_data = &initial_data_;
     initial_data->pSysMem = data;
-    initial_data->SysMemPitch = size.x * 4;
-    // TODO(nb): more formats?
-    //initial_data->SysMemPitch = r_tex2d_format_bytes_per_pixel_table[format] * size.x;
+    initial_data->SysMemPitch = (UINT)r_tex2d_row_pitch(format, size.x);
   }
   
   //- nb: create texture
@@ -762,7 +1349,7 @@ r_tex2d_alloc(DirectX::XMUINT2 size, void *data)
     texture_desc.Height             = size.y;
     texture_desc.MipLevels          = 1;
     texture_desc.ArraySize          = 1;
-    texture_desc.Format             = DXGI_FORMAT_R8G8B8A8_UNORM;
+    texture_desc.Format             = r_d3d11_format_table[format];
     texture_desc.SampleDesc.Count   = 1;
     texture_desc.Usage              = D3D11_USAGE_DEFAULT;
     texture_desc.BindFlags          = D3D11_BIND_SHADER_RESOURCE;
@@ -771,8 +1358,9 @@ r_tex2d_alloc(DirectX::XMUINT2 size, void *data)
   r_d3d11_state->device->CreateTexture2D(&texture_desc, initial_data, &texture->texture);
   r_d3d11_state->device->CreateShaderResourceView((ID3D11Resource *)texture->texture, 0, &texture->view);
   
-  // TODO(nb): add more info: format, resource kind etc
-  texture->size = size;
+  // TODO(nb): add more info: resource kind etc
+  texture->size   = size;
+  texture->format = format;
   
   R_Handle handle = r_d3d11_handle_from_tex2d(texture);
   return handle;
@@ -791,6 +1379,19 @@ void r_tex2d_release(R_Handle handle)
   SAFE_RELEASE(texture->view);
 }
 
+void
+r_tex2d_update(R_Handle handle, u32 x, u32 y, u32 width, u32 height, const void *data)
+{
+  R_D3D11_Tex2D *texture = r_d3d11_tex2d_from_handle(handle);
+  if(texture == &r_d3d11_tex2d_nil || width == 0 || height == 0)
+    return;
+  //- nb: compressed formats update whole blocks
+  D3D11_BOX box = {x, y, 0, x + width, y + height, 1};
+  r_d3d11_state->context->UpdateSubresource(texture->texture, 0, &box, data, (UINT)r_tex2d_row_pitch(texture->format, width), 0);
+  r_d3d11_state->draw_backend.counters.updates        += 1;
+  r_d3d11_state->draw_backend.counters.bytes_uploaded += r_tex2d_size(texture->format, width, height);
+}
+
 internal R_D3D11_Tex2D *
 r_d3d11_tex2d_from_handle(R_Handle handle)
 {
@@ -809,7 +1410,7 @@ r_d3d11_handle_from_tex2d(R_D3D11_Tex2D *texture)
 }
 
 internal R_Handle
-r_create_tex2d_from_file(const wchar_t *filename)
+r_create_tex2d_from_file(const wchar_t *filename, R_Tex2DFormat format)
 {
   // TODO(nb): error checking
   HRESULT hr = S_OK;
@@ -849,7 +1450,22 @@ r_create_tex2d_from_file(const wchar_t *filename)
   void *pixels = (void*)arena_push(r_d3d11_state->arena, buffer_size);
   hr = converter->CopyPixels(nullptr, stride, buffer_size, (BYTE*)pixels);
   
-  R_Handle handle = r_tex2d_alloc({width, height}, pixels);
+  //- nb: into the requested format, blocks need whole 4x4 tiles (mip 0 of a
+  // BC texture has to be a multiple of 4) so anything else stays RGBA8
+  if(r_tex2d_format_is_compressed(format) && (width % 4 != 0 || height % 4 != 0))
+    format = R_TEX2D_FORMAT_RGBA8;
+  void *data = pixels;
+  if(r_tex2d_format_is_compressed(format))
+  {
+    data = arena_push(r_d3d11_state->arena, r_tex2d_size(format, width, height));
+    r_bc_encode(format, (u32*)pixels, width, height, data);
+  }
+  else if(format != R_TEX2D_FORMAT_RGBA8)
+  {
+    data = arena_push(r_d3d11_state->arena, r_tex2d_size(format, width, height));
+    r_tex2d_pack(format, data, (u32*)pixels, (u64)width * height);
+  }
+  R_Handle handle = r_tex2d_alloc(format, {width, height}, data);
   
   converter->Release();
   frame->Release();
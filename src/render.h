@@ -15,15 +15,6 @@ struct InstanceData
   DirectX::XMFLOAT4 iuv_rect;  // offset in normalized coordinates
 };
 
-// TODO(nb): implement this
-typedef union R_Handle R_Handle;
-union R_Handle
-{
-  u64 U64[1];
-  u32 U32[2];
-  u16 U16[4];
-};
-
 typedef struct R_D3D11_Tex2D R_D3D11_Tex2D;
 struct R_D3D11_Tex2D
 {
@@ -33,6 +24,7 @@ struct R_D3D11_Tex2D
   ID3D11Texture2D           *texture;
   ID3D11ShaderResourceView  *view;
   DirectX::XMUINT2           size;
+  R_Tex2DFormat              format;
 };
 
 ////////////////////////////////
@@ -81,13 +73,50 @@ struct R_D3D11_State
   ID3D11DepthStencilState *plain_depth_stencil;
   ////////////////////////////////
   //- nb: Shaders
-  ID3D11VertexShader      *vertex_shaders[1];
-  ID3D11InputLayout       *input_layouts[1];
-  ID3D11PixelShader       *pixel_shaders[1];
-  ID3D11Buffer            *constant_buffers[1];
+  // nb: [0] instanced sprites, [1] tile grid, [2] tile map. The tile map
+  // shares the tile grid's input layout and brings its own pixel shader.
+  // Pixel shaders: [0] sprites, [1] tile map, [2] sprites from one channel
+  // textures, [3] from two channel ones, [4] from distance fields.
+  ID3D11VertexShader      *vertex_shaders[3];
+  ID3D11InputLayout       *input_layouts[2];
+  ID3D11PixelShader       *pixel_shaders[5];
+  ID3D11Buffer            *constant_buffers[3];
   ID3D11Buffer            *vertex_buffer;
   ID3D11Buffer            *index_buffer;
+  //- nb: Instance ring. Every flush takes the next range of instance_buffer
+  // and maps it with NO_OVERWRITE, ranges come back once their frame's
+  // query completed. The buffer is recreated when the ring grows.
   ID3D11Buffer            *instance_buffer;
+  R_Ring                  instance_ring;
+  u32                     instance_base;            // first quad of the current map
+  //- nb: Frame fence, one event query per frame in flight
+  ID3D11Query             *frame_queries[R_RING_MAX_FRAMES];
+  u64                     frame_fence_submitted;
+  u64                     frame_fence_completed;
+  R_Fence                 frame_fence;
+  //- nb: Frame command list, flushed by r_present into instance_buffer
+  R_CmdList               *cmd_list;
+  R_DrawBackend           draw_backend;
+  R_FrameCounters         last_frame_counters;
+  //- nb: Board tiles, one byte each, drawn by the tile grid shader.
+  // Persistent, only dirty ranges get uploaded.
+  ID3D11Buffer              *board_tile_buffer;
+  ID3D11ShaderResourceView  *board_tile_view;
+  u32                       board_tile_capacity;
+  R_UploadBackend           board_upload_backend;
+  // nb: what constant_buffers[1] holds
+  R_TileGridConstants       tile_grid;
+  b32                       tile_grid_valid;
+  //- nb: Board tile map, the same bytes as an R8_UINT texture, columns x
+  // rows. Only dirty rows get uploaded.
+  ID3D11Texture2D           *board_map_texture;
+  ID3D11ShaderResourceView  *board_map_view;
+  u32                       board_map_columns;
+  u32                       board_map_rows;
+  R_UploadBackend           board_map_upload_backend;
+  // nb: what constant_buffers[2] holds
+  R_TileMapConstants        tile_map;
+  b32                       tile_map_valid;
   ////////////////////////////////
   IWICImagingFactory       *wic_factory;
   
@@ -104,17 +133,43 @@ void r_handle_device_lost();
 void r_set_transform(f32 x, f32 y, f32 scale_x, f32 scale_y);
 
 
-void r_submit_batch(const InstanceData *data, u32 data_len, R_Handle texture);
+// nb: Appends `count` quads to the frame command list and returns them to
+// be filled in. They are drawn by r_present, see R_CmdList.
+InstanceData *r_push_quads(R_Handle texture, R_Layer layer, u32 count);
+// nb: Draws, maps and bytes of the last presented frame.
+R_FrameCounters r_frame_counters();
+// nb: The board's tile bytes stay on the GPU between frames. Reserve
+// returns 1 when the buffer had to be (re)created, its contents are gone
+// then and everything has to be marked dirty.
+b32  r_board_tiles_reserve(u32 count);
+void r_board_tiles_upload(R_UploadPlan *plan, const u8 *tiles);
+// nb: Draws `count` tiles, visible_columns wide, see R_TileGridConstants.
+void r_submit_tile_grid(R_TileGridConstants *grid, u32 count, R_Handle texture);
+// nb: The tile map version, reserve returns 1 the same way. Draws a single
+// quad, see R_TileMapConstants.
+b32  r_board_map_reserve(u32 columns, u32 rows);
+void r_board_map_upload(R_UploadPlan *plan, const u8 *tiles);
+void r_submit_tile_map(R_TileMapConstants *map, R_Handle texture);
 void r_clear(const float *color);
 void r_present();
 
 
-R_Handle r_tex2d_load_file(const wchar_t *filename, Arena *scratch_arena);
+R_Handle r_tex2d_load_file(const wchar_t *filename, R_Tex2DFormat format);
 void r_tex2d_release(R_Handle handle);
+// nb: Overwrites a rectangle of texels, `data` is rows of the texture's
+// format. Compressed textures take whole blocks.
+void r_tex2d_update(R_Handle handle, u32 x, u32 y, u32 width, u32 height, const void *data);
 
 internal void r_create_wic_factory();
-internal R_Handle r_tex2d_alloc(DirectX::XMUINT2 size, void *data);
-internal R_Handle r_create_tex2d_from_file(const wchar_t *filename);
+internal R_Handle r_tex2d_alloc(R_Tex2DFormat format, DirectX::XMUINT2 size, void *data);
+internal R_Handle r_create_tex2d_from_file(const wchar_t *filename, R_Tex2DFormat format);
+internal R_Quad *r_d3d11_cmd_map(R_DrawBackend *backend, u32 quad_count);
+internal void r_d3d11_cmd_unmap(R_DrawBackend *backend);
+internal u64 r_d3d11_fence_completed(R_Fence *fence);
+internal void r_d3d11_fence_wait(R_Fence *fence, u64 value);
+internal void r_d3d11_cmd_draw(R_DrawBackend *backend, R_Handle texture, u32 first_quad, u32 quad_count);
+internal void r_d3d11_board_upload(R_UploadBackend *backend, u64 offset, u64 size, const void *data, b32 full);
+internal void r_d3d11_board_map_upload(R_UploadBackend *backend, u64 offset, u64 size, const void *data, b32 full);
 
 ////////////////////////////////
 //~ nb: Helper functions
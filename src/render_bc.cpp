@@ -0,0 +1,1042 @@
+#include "render_bc.h"
+
+#include <math.h>
+
+#if defined(__AVX2__)
+# include <immintrin.h>
+# define R_BC_SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+# include <emmintrin.h>
+# define R_BC_SIMD_SSE2 1
+#endif
+
+// nb: power iterations for the principal axis, four is plenty for 16 texels
+#define R_BC_AXIS_ITERATIONS 4
+// nb: BC7 least squares refits, each from the indices of the last
+#define R_BC7_REFIT_PASSES 2
+
+// nb: BC7 index weights out of 64, 4-bit and 2-bit indices
+global u32 r_bc7_weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+global u32 r_bc7_weights2[4] = {0, 21, 43, 64};
+
+////////////////////////////////
+//~ nb: Helper functions
+internal inline u32
+r_bc_channel(u32 texel, u32 channel)
+{
+  return (texel >> (channel * 8)) & 0xff;
+}
+
+internal inline u32
+r_bc_round_channel(f32 v, u32 max)
+{
+  return (u32)Clamp(0.f, v + 0.5f, (f32)max);
+}
+
+//- nb: the 4x4 block at (bx, by), repeating the last column and row past
+// the edge
+internal void
+r_bc_fetch_block(const u32 *rgba, u32 width, u32 height, u32 bx, u32 by, u32 *texels)
+{
+  for(u32 y = 0; y < 4; y++)
+  {
+    u32 sy = Min(by * 4 + y, height - 1);
+    for(u32 x = 0; x < 4; x++)
+    {
+      u32 sx = Min(bx * 4 + x, width - 1);
+      texels[y * 4 + x] = rgba[(u64)sy * width + sx];
+    }
+  }
+}
+
+//- nb: for every texel the nearest of `palette_count` entries by squared
+// distance over the channels in its `masks` entry, returns the summed
+// distance. Ties go to the lower entry.
+internal u32
+r_bc_select(const u32 *texels, const u32 *masks, const u32 *palette, u32 palette_count, u8 *indices)
+{
+  u32 total = 0;
+#if R_BC_SIMD_AVX2
+  const __m256i zero = _mm256_setzero_si256();
+  for(u32 half = 0; half < 16; half += 8)
+  {
+    __m256i keep = _mm256_loadu_si256((__m256i*)(masks + half));
+    __m256i t    = _mm256_and_si256(_mm256_loadu_si256((__m256i*)(texels + half)), keep);
+    __m256i keep_lo = _mm256_unpacklo_epi8(keep, zero);
+    __m256i keep_hi = _mm256_unpackhi_epi8(keep, zero);
+    __m256i t_lo = _mm256_unpacklo_epi8(t, zero);
+    __m256i t_hi = _mm256_unpackhi_epi8(t, zero);
+    __m256i best       = _mm256_set1_epi32(0x7fffffff);
+    __m256i best_index = zero;
+    for(u32 p = 0; p < palette_count; p++)
+    {
+      __m256i c8 = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)palette[p]), zero);
+      __m256i d_lo = _mm256_sub_epi16(t_lo, _mm256_and_si256(c8, keep_lo));
+      __m256i d_hi = _mm256_sub_epi16(t_hi, _mm256_and_si256(c8, keep_hi));
+      // nb: rg and ba sums per texel, texels 0 1 | 4 5 and 2 3 | 6 7 per lane
+      __m256 s_lo = _mm256_castsi256_ps(_mm256_madd_epi16(d_lo, d_lo));
+      __m256 s_hi = _mm256_castsi256_ps(_mm256_madd_epi16(d_hi, d_hi));
+      __m256i dist = _mm256_add_epi32(_mm256_castps_si256(_mm256_shuffle_ps(s_lo, s_hi, _MM_SHUFFLE(2, 0, 2, 0))),
+                                      _mm256_castps_si256(_mm256_shuffle_ps(s_lo, s_hi, _MM_SHUFFLE(3, 1, 3, 1))));
+      __m256i less = _mm256_cmpgt_epi32(best, dist);
+      best       = _mm256_min_epi32(best, dist);
+      best_index = _mm256_blendv_epi8(best_index, _mm256_set1_epi32((int)p), less);
+    }
+    u32 lane_best[8], lane_index[8];
+    _mm256_storeu_si256((__m256i*)lane_best, best);
+    _mm256_storeu_si256((__m256i*)lane_index, best_index);
+    for(u32 i = 0; i < 8; i++)
+    {
+      total += lane_best[i];
+      indices[half + i] = (u8)lane_index[i];
+    }
+  }
+#elif R_BC_SIMD_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  for(u32 quarter = 0; quarter < 16; quarter += 4)
+  {
+    __m128i keep = _mm_loadu_si128((__m128i*)(masks + quarter));
+    __m128i t    = _mm_and_si128(_mm_loadu_si128((__m128i*)(texels + quarter)), keep);
+    __m128i keep_lo = _mm_unpacklo_epi8(keep, zero);
+    __m128i keep_hi = _mm_unpackhi_epi8(keep, zero);
+    __m128i t_lo = _mm_unpacklo_epi8(t, zero);
+    __m128i t_hi = _mm_unpackhi_epi8(t, zero);
+    __m128i best       = _mm_set1_epi32(0x7fffffff);
+    __m128i best_index = zero;
+    for(u32 p = 0; p < palette_count; p++)
+    {
+      __m128i c8 = _mm_unpacklo_epi8(_mm_set1_epi32((int)palette[p]), zero);
+      __m128i d_lo = _mm_sub_epi16(t_lo, _mm_and_si128(c8, keep_lo));
+      __m128i d_hi = _mm_sub_epi16(t_hi, _mm_and_si128(c8, keep_hi));
+      // nb: rg and ba sums per texel, texels 0 1 and 2 3
+      __m128 s_lo = _mm_castsi128_ps(_mm_madd_epi16(d_lo, d_lo));
+      __m128 s_hi = _mm_castsi128_ps(_mm_madd_epi16(d_hi, d_hi));
+      __m128i dist = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(s_lo, s_hi, _MM_SHUFFLE(2, 0, 2, 0))),
+                                   _mm_castps_si128(_mm_shuffle_ps(s_lo, s_hi, _MM_SHUFFLE(3, 1, 3, 1))));
+      __m128i less = _mm_cmplt_epi32(dist, best);
+      best       = _mm_or_si128(_mm_and_si128(less, dist), _mm_andnot_si128(less, best));
+      best_index = _mm_or_si128(_mm_and_si128(less, _mm_set1_epi32((int)p)), _mm_andnot_si128(less, best_index));
+    }
+    u32 lane_best[4], lane_index[4];
+    _mm_storeu_si128((__m128i*)lane_best, best);
+    _mm_storeu_si128((__m128i*)lane_index, best_index);
+    for(u32 i = 0; i < 4; i++)
+    {
+      total += lane_best[i];
+      indices[quarter + i] = (u8)lane_index[i];
+    }
+  }
+#else
+  for(u32 i = 0; i < 16; i++)
+  {
+    u32 best = 0xffffffff;
+    u32 best_index = 0;
+    for(u32 p = 0; p < palette_count; p++)
+    {
+      u32 dist = 0;
+      for(u32 channel = 0; channel < 4; channel++)
+      {
+        if(!((masks[i] >> (channel * 8)) & 0xff))
+          continue;
+        s32 d = (s32)r_bc_channel(texels[i], channel) - (s32)r_bc_channel(palette[p], channel);
+        dist += (u32)(d * d);
+      }
+      if(dist < best)
+      {
+        best = dist;
+        best_index = p;
+      }
+    }
+    total += best;
+    indices[i] = (u8)best_index;
+  }
+#endif
+  return total;
+}
+
+//- nb: the principal axis of `count` texels over `channels` channels, by
+// power iteration on their covariance. Returns the two texel extremes along
+// it as float endpoints, lo first. Both are the mean when all texels agree.
+internal void
+r_bc_axis_extremes(const u32 *texels, u32 count, u32 channels, f32 *lo, f32 *hi)
+{
+  f32 mean[4] = {0};
+  for(u32 i = 0; i < count; i++)
+    for(u32 c = 0; c < channels; c++)
+      mean[c] += (f32)r_bc_channel(texels[i], c);
+  for(u32 c = 0; c < channels; c++)
+    mean[c] /= (f32)count;
+
+  f32 cov[4][4] = {{0}};
+  for(u32 i = 0; i < count; i++)
+  {
+    f32 d[4];
+    for(u32 c = 0; c < channels; c++)
+      d[c] = (f32)r_bc_channel(texels[i], c) - mean[c];
+    for(u32 a = 0; a < channels; a++)
+      for(u32 b = 0; b < channels; b++)
+        cov[a][b] += d[a] * d[b];
+  }
+
+  //- nb: start from the row of the channel that varies most, a fixed start
+  // like (1, 1, 1) is orthogonal to red against green
+  u32 widest = 0;
+  for(u32 c = 1; c < channels; c++)
+    if(cov[c][c] > cov[widest][widest])
+      widest = c;
+  if(cov[widest][widest] < 1e-3f)
+  {
+    for(u32 c = 0; c < channels; c++)
+      lo[c] = hi[c] = mean[c];
+    return;
+  }
+  f32 axis[4];
+  for(u32 c = 0; c < channels; c++)
+    axis[c] = cov[widest][c] / cov[widest][widest];
+  for(u32 iteration = 0; iteration < R_BC_AXIS_ITERATIONS; iteration++)
+  {
+    f32 next[4] = {0};
+    f32 largest = 0;
+    for(u32 a = 0; a < channels; a++)
+    {
+      for(u32 b = 0; b < channels; b++)
+        next[a] += cov[a][b] * axis[b];
+      largest = Max(largest, fabsf(next[a]));
+    }
+    if(largest < 1e-6f)
+      break;
+    for(u32 c = 0; c < channels; c++)
+      axis[c] = next[c] / largest;
+  }
+
+  u32 lo_texel = 0, hi_texel = 0;
+  f32 lo_dot = 1e30f, hi_dot = -1e30f;
+  for(u32 i = 0; i < count; i++)
+  {
+    f32 dot = 0;
+    for(u32 c = 0; c < channels; c++)
+      dot += ((f32)r_bc_channel(texels[i], c) - mean[c]) * axis[c];
+    if(dot < lo_dot) { lo_dot = dot; lo_texel = texels[i]; }
+    if(dot > hi_dot) { hi_dot = dot; hi_texel = texels[i]; }
+  }
+  for(u32 c = 0; c < channels; c++)
+  {
+    lo[c] = (f32)r_bc_channel(lo_texel, c);
+    hi[c] = (f32)r_bc_channel(hi_texel, c);
+  }
+}
+
+//- nb: least squares endpoints for fixed indices, texel i ~ w * e0 +
+// (1 - w) * e1 with w = weights[i], per channel over the texels whose
+// `masks` entry has it (all of them without masks). Returns 0 and leaves
+// the endpoints when a channel's system is singular (every texel on the
+// same weight).
+internal b32
+r_bc_refit(const u32 *texels, const u32 *masks, const f32 *weights, u32 count, u32 channels, f32 *e0, f32 *e1)
+{
+  f32 aa[4] = {0}, ab[4] = {0}, bb[4] = {0};
+  f32 ax[4] = {0}, bx[4] = {0};
+  for(u32 i = 0; i < count; i++)
+  {
+    f32 a = weights[i];
+    f32 b = 1.f - a;
+    for(u32 c = 0; c < channels; c++)
+    {
+      if(masks && !r_bc_channel(masks[i], c))
+        continue;
+      f32 x = (f32)r_bc_channel(texels[i], c);
+      aa[c] += a * a;
+      ab[c] += a * b;
+      bb[c] += b * b;
+      ax[c] += a * x;
+      bx[c] += b * x;
+    }
+  }
+  f32 refit[2][4];
+  for(u32 c = 0; c < channels; c++)
+  {
+    f32 det = aa[c] * bb[c] - ab[c] * ab[c];
+    if(fabsf(det) < 1e-4f)
+      return 0;
+    f32 inv = 1.f / det;
+    refit[0][c] = Clamp(0.f, (ax[c] * bb[c] - bx[c] * ab[c]) * inv, 255.f);
+    refit[1][c] = Clamp(0.f, (bx[c] * aa[c] - ax[c] * ab[c]) * inv, 255.f);
+  }
+  for(u32 c = 0; c < channels; c++)
+  {
+    e0[c] = refit[0][c];
+    e1[c] = refit[1][c];
+  }
+  return 1;
+}
+
+////////////////////////////////
+//~ nb: BC1
+internal u16
+r_bc1_565_from_rgb(const f32 *rgb)
+{
+  u32 r = r_bc_round_channel(rgb[0] * 31.f / 255.f, 31);
+  u32 g = r_bc_round_channel(rgb[1] * 63.f / 255.f, 63);
+  u32 b = r_bc_round_channel(rgb[2] * 31.f / 255.f, 31);
+  return (u16)((r << 11) | (g << 5) | b);
+}
+
+internal u32
+r_bc1_rgb_from_565(u32 c)
+{
+  u32 r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+  r = (r << 3) | (r >> 2);
+  g = (g << 2) | (g >> 4);
+  b = (b << 3) | (b >> 2);
+  return r | (g << 8) | (b << 16) | 0xff000000;
+}
+
+//- nb: the four colors a block decodes to, entry 3 is transparent black in
+// the three color mode (c0 <= c1)
+internal void
+r_bc1_palette(u32 c0, u32 c1, u32 *palette)
+{
+  palette[0] = r_bc1_rgb_from_565(c0);
+  palette[1] = r_bc1_rgb_from_565(c1);
+  palette[2] = palette[3] = 0xff000000;
+  for(u32 channel = 0; channel < 3; channel++)
+  {
+    u32 a = r_bc_channel(palette[0], channel);
+    u32 b = r_bc_channel(palette[1], channel);
+    u32 shift = channel * 8;
+    if(c0 > c1)
+    {
+      palette[2] |= ((2 * a + b + 1) / 3) << shift;
+      palette[3] |= ((a + 2 * b + 1) / 3) << shift;
+    }
+    else
+    {
+      palette[2] |= ((a + b + 1) / 2) << shift;
+    }
+  }
+  if(c0 <= c1)
+    palette[3] = 0;
+}
+
+//- nb: one endpoint pair, quantized and ordered for the mode, written to
+// `block`. Returns the squared color error over the opaque texels.
+internal u32
+r_bc1_try(const u32 *texels, u32 transparent, const f32 *e0, const f32 *e1, u8 *block, u8 *indices)
+{
+  u32 c0 = r_bc1_565_from_rgb(e0);
+  u32 c1 = r_bc1_565_from_rgb(e1);
+  // nb: four colors needs c0 > c1, three colors c0 <= c1
+  if(transparent ? c0 > c1 : c0 < c1)
+  {
+    u32 swap = c0;
+    c0 = c1;
+    c1 = swap;
+  }
+  u32 palette[4];
+  r_bc1_palette(c0, c1, palette);
+
+  u32 error = 0;
+  u32 bits = 0;
+  if(!transparent && c0 == c1)
+  {
+    memset(indices, 0, 16);
+  }
+  else
+  {
+    // nb: opaque texels never pick the transparent entry
+    u32 select_count = transparent ? 3 : 4;
+    u32 masks[16];
+    for(u32 i = 0; i < 16; i++)
+      masks[i] = 0x00ffffff;
+    error = r_bc_select(texels, masks, palette, select_count, indices);
+    if(transparent)
+    {
+      error = 0;
+      for(u32 i = 0; i < 16; i++)
+      {
+        if((transparent >> i) & 1)
+        {
+          indices[i] = 3;
+          continue;
+        }
+        for(u32 channel = 0; channel < 3; channel++)
+        {
+          s32 d = (s32)r_bc_channel(texels[i], channel) - (s32)r_bc_channel(palette[indices[i]], channel);
+          error += (u32)(d * d);
+        }
+      }
+    }
+  }
+  for(u32 i = 0; i < 16; i++)
+    bits |= (u32)indices[i] << (i * 2);
+
+  block[0] = (u8)c0;
+  block[1] = (u8)(c0 >> 8);
+  block[2] = (u8)c1;
+  block[3] = (u8)(c1 >> 8);
+  memcpy(block + 4, &bits, 4);
+  return error;
+}
+
+void
+r_bc1_encode_block(const u32 *texels, u8 *block)
+{
+  //- nb: texels below half alpha drop out, their colors don't count
+  u32 transparent = 0;
+  u32 opaque[16];
+  u32 opaque_count = 0;
+  for(u32 i = 0; i < 16; i++)
+  {
+    if((texels[i] >> 24) < 128)
+      transparent |= 1u << i;
+    else
+      opaque[opaque_count++] = texels[i];
+  }
+  if(opaque_count == 0)
+  {
+    memset(block, 0, 4);
+    memset(block + 4, 0xff, 4);
+    return;
+  }
+
+  f32 lo[3], hi[3];
+  r_bc_axis_extremes(opaque, opaque_count, 3, lo, hi);
+  u8 indices[16];
+  u8 best_block[8];
+  u32 best_error = r_bc1_try(texels, transparent, hi, lo, best_block, indices);
+
+  //- nb: refit to the indices the extremes got, weight of c0 per index
+  if(best_error > 0)
+  {
+    u32 c0 = best_block[0] | (best_block[1] << 8);
+    u32 c1 = best_block[2] | (best_block[3] << 8);
+    const f32 weights_four[4]  = {1.f, 0.f, 2.f / 3.f, 1.f / 3.f};
+    const f32 weights_three[4] = {1.f, 0.f, 0.5f, 0.f};
+    const f32 *weights_of_index = c0 > c1 ? weights_four : weights_three;
+    f32 weights[16];
+    u32 count = 0;
+    for(u32 i = 0; i < 16; i++)
+      if(!((transparent >> i) & 1))
+        weights[count++] = weights_of_index[indices[i]];
+    f32 e0[3], e1[3];
+    if(r_bc_refit(opaque, 0, weights, opaque_count, 3, e0, e1))
+    {
+      u8 refit_block[8];
+      u32 refit_error = r_bc1_try(texels, transparent, e0, e1, refit_block, indices);
+      if(refit_error < best_error)
+        memcpy(best_block, refit_block, 8);
+    }
+  }
+  memcpy(block, best_block, 8);
+}
+
+void
+r_bc1_decode_block(const u8 *block, u32 *texels)
+{
+  u32 c0 = block[0] | (block[1] << 8);
+  u32 c1 = block[2] | (block[3] << 8);
+  u32 bits;
+  memcpy(&bits, block + 4, 4);
+  u32 palette[4];
+  r_bc1_palette(c0, c1, palette);
+  for(u32 i = 0; i < 16; i++)
+    texels[i] = palette[(bits >> (i * 2)) & 3];
+}
+
+////////////////////////////////
+//~ nb: BC4
+// nb: eight values when e0 > e1, otherwise six plus 0 and 255
+internal void
+r_bc4_palette(u32 e0, u32 e1, u8 *palette)
+{
+  palette[0] = (u8)e0;
+  palette[1] = (u8)e1;
+  if(e0 > e1)
+  {
+    for(u32 i = 2; i < 8; i++)
+      palette[i] = (u8)(((8 - i) * e0 + (i - 1) * e1 + 3) / 7);
+  }
+  else
+  {
+    for(u32 i = 2; i < 6; i++)
+      palette[i] = (u8)(((6 - i) * e0 + (i - 1) * e1 + 2) / 5);
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+}
+
+//- nb: nearest palette value for all 16, returns the squared error
+internal u32
+r_bc4_select(const u8 *values, const u8 *palette, u8 *indices)
+{
+  u32 error = 0;
+#if R_BC_SIMD_SSE2 || R_BC_SIMD_AVX2
+  // nb: a block is 16 bytes, one SSE register, AVX2 has nothing to add
+  __m128i v          = _mm_loadu_si128((__m128i*)values);
+  __m128i best       = _mm_set1_epi8((char)0xff);
+  __m128i best_index = _mm_setzero_si128();
+  for(u32 p = 0; p < 8; p++)
+  {
+    __m128i c = _mm_set1_epi8((char)palette[p]);
+    __m128i d = _mm_or_si128(_mm_subs_epu8(v, c), _mm_subs_epu8(c, v));
+    __m128i less = _mm_andnot_si128(_mm_cmpeq_epi8(d, best), _mm_cmpeq_epi8(_mm_min_epu8(d, best), d));
+    best       = _mm_min_epu8(d, best);
+    best_index = _mm_or_si128(_mm_and_si128(less, _mm_set1_epi8((char)p)), _mm_andnot_si128(less, best_index));
+  }
+  u8 lane_best[16];
+  _mm_storeu_si128((__m128i*)lane_best, best);
+  _mm_storeu_si128((__m128i*)indices, best_index);
+  for(u32 i = 0; i < 16; i++)
+    error += (u32)lane_best[i] * lane_best[i];
+#else
+  for(u32 i = 0; i < 16; i++)
+  {
+    u32 best = 256, best_index = 0;
+    for(u32 p = 0; p < 8; p++)
+    {
+      u32 d = (u32)(values[i] > palette[p] ? values[i] - palette[p] : palette[p] - values[i]);
+      if(d < best)
+      {
+        best = d;
+        best_index = p;
+      }
+    }
+    error += best * best;
+    indices[i] = (u8)best_index;
+  }
+#endif
+  return error;
+}
+
+internal u32
+r_bc4_try(const u8 *values, u32 e0, u32 e1, u8 *block)
+{
+  u8 palette[8];
+  u8 indices[16];
+  r_bc4_palette(e0, e1, palette);
+  u32 error = r_bc4_select(values, palette, indices);
+  u64 bits = e0 | (e1 << 8);
+  for(u32 i = 0; i < 16; i++)
+    bits |= (u64)indices[i] << (16 + i * 3);
+  memcpy(block, &bits, 8);
+  return error;
+}
+
+void
+r_bc4_encode_block(const u32 *texels, u8 *block)
+{
+  u8 values[16];
+  u32 lo = 255, hi = 0;
+  u32 inner_lo = 255, inner_hi = 0;
+  for(u32 i = 0; i < 16; i++)
+  {
+    u32 v = texels[i] >> 24;
+    values[i] = (u8)v;
+    lo = Min(lo, v);
+    hi = Max(hi, v);
+    if(v != 0 && v != 255)
+    {
+      inner_lo = Min(inner_lo, v);
+      inner_hi = Max(inner_hi, v);
+    }
+  }
+  if(lo == hi)
+  {
+    r_bc4_try(values, lo, lo, block);
+    return;
+  }
+
+  //- nb: eight values across the range, or six across what isn't 0 or 255
+  // when the block has those (antialiased glyph edges mostly)
+  u32 error = r_bc4_try(values, hi, lo, block);
+  if(error > 0 && (lo == 0 || hi == 255))
+  {
+    if(inner_lo > inner_hi)
+      inner_lo = inner_hi = lo;
+    u8 six_block[8];
+    if(r_bc4_try(values, inner_lo, inner_hi, six_block) < error)
+      memcpy(block, six_block, 8);
+  }
+}
+
+void
+r_bc4_decode_block(const u8 *block, u32 *texels)
+{
+  u64 bits;
+  memcpy(&bits, block, 8);
+  u8 palette[8];
+  r_bc4_palette(block[0], block[1], palette);
+  for(u32 i = 0; i < 16; i++)
+    texels[i] = 0x00ffffff | ((u32)palette[(bits >> (16 + i * 3)) & 7] << 24);
+}
+
+////////////////////////////////
+//~ nb: BC7
+// nb: Two of the eight modes, both one subset. Mode 6 (RGBA endpoints, 7
+// bits and a p-bit each, 4-bit indices) for blocks on one RGBA line, mode 5
+// (RGB endpoints of 7 bits and alpha endpoints of 8 bits, each with their
+// own 2-bit indices) for blocks whose alpha doesn't follow the color, like a
+// sprite's outline against its transparent surroundings. Every block tries
+// both and keeps the closer. Bit layouts, low bit first:
+//  - mode 6: mode (7 bits, 1 << 6), r0 r1 g0 g1 b0 b1 a0 a1 (7 bits each),
+//    p0, p1, 16 indices of 4 bits
+//  - mode 5: mode (6 bits, 1 << 5), rotation (2 bits), r0 r1 g0 g1 b0 b1 (7
+//    bits each), a0 a1 (8 bits each), 16 color indices of 2 bits, 16 alpha
+//    indices of 2 bits
+// The first index of each set (the anchor) drops its top bit, it is 0.
+internal void
+r_bc7_put_bits(u64 *bits, u32 *at, u64 value, u32 count)
+{
+  u32 word = *at / 64, shift = *at % 64;
+  bits[word] |= value << shift;
+  if(shift + count > 64)
+    bits[word + 1] |= value >> (64 - shift);
+  *at += count;
+}
+
+internal u32
+r_bc7_get_bits(const u64 *bits, u32 *at, u32 count)
+{
+  u32 word = *at / 64, shift = *at % 64;
+  u64 value = bits[word] >> shift;
+  if(shift + count > 64)
+    value |= bits[word + 1] << (64 - shift);
+  *at += count;
+  return (u32)(value & ((1ull << count) - 1));
+}
+
+//- nb: 16 indices, the anchor one bit short
+internal void
+r_bc7_put_indices(u64 *bits, u32 *at, const u8 *indices, u32 index_bits)
+{
+  r_bc7_put_bits(bits, at, indices[0], index_bits - 1);
+  for(u32 i = 1; i < 16; i++)
+    r_bc7_put_bits(bits, at, indices[i], index_bits);
+}
+
+internal void
+r_bc7_get_indices(const u64 *bits, u32 *at, u8 *indices, u32 index_bits)
+{
+  indices[0] = (u8)r_bc7_get_bits(bits, at, index_bits - 1);
+  for(u32 i = 1; i < 16; i++)
+    indices[i] = (u8)r_bc7_get_bits(bits, at, index_bits);
+}
+
+//- nb: the anchor index has to fit in one bit less, otherwise the caller
+// swaps the endpoints and the indices are mirrored here
+internal b32
+r_bc7_fix_anchor(u8 *indices, u32 index_bits)
+{
+  u32 top = (1u << index_bits) - 1;
+  if(indices[0] <= top / 2)
+    return 0;
+  for(u32 i = 0; i < 16; i++)
+    indices[i] = (u8)(top - indices[i]);
+  return 1;
+}
+
+internal inline u32
+r_bc7_interpolate(u32 a, u32 b, u32 w)
+{
+  return ((64 - w) * a + w * b + 32) >> 6;
+}
+
+//- nb: mode 6
+//- nb: 7 bits per channel plus a shared low bit, the p-bit that lands
+// closer overall
+internal void
+r_bc7_mode6_quantize(const f32 *endpoint, u32 *q, u32 *p)
+{
+  f32 best_error = 1e30f;
+  for(u32 bit = 0; bit < 2; bit++)
+  {
+    u32 candidate[4];
+    f32 error = 0;
+    for(u32 c = 0; c < 4; c++)
+    {
+      candidate[c] = r_bc_round_channel((endpoint[c] - (f32)bit) * 0.5f, 127);
+      f32 d = (f32)(candidate[c] * 2 + bit) - endpoint[c];
+      error += d * d;
+    }
+    if(error < best_error)
+    {
+      best_error = error;
+      *p = bit;
+      for(u32 c = 0; c < 4; c++)
+        q[c] = candidate[c];
+    }
+  }
+}
+
+internal void
+r_bc7_mode6_palette(const u32 *q0, u32 p0, const u32 *q1, u32 p1, u32 *palette)
+{
+  for(u32 i = 0; i < 16; i++)
+  {
+    u32 texel = 0;
+    for(u32 c = 0; c < 4; c++)
+      texel |= r_bc7_interpolate(q0[c] * 2 + p0, q1[c] * 2 + p1, r_bc7_weights[i]) << (c * 8);
+    palette[i] = texel;
+  }
+}
+
+internal u32
+r_bc7_mode6_try(const u32 *texels, const u32 *masks, const f32 *e0, const f32 *e1, u8 *block, u8 *indices)
+{
+  u32 q0[4], q1[4], p0, p1;
+  r_bc7_mode6_quantize(e0, q0, &p0);
+  r_bc7_mode6_quantize(e1, q1, &p1);
+  u32 palette[16];
+  r_bc7_mode6_palette(q0, p0, q1, p1, palette);
+  u32 error = r_bc_select(texels, masks, palette, 16, indices);
+
+  u8 stored[16];
+  memcpy(stored, indices, 16);
+  if(r_bc7_fix_anchor(stored, 4))
+  {
+    for(u32 c = 0; c < 4; c++)
+    {
+      u32 swap = q0[c];
+      q0[c] = q1[c];
+      q1[c] = swap;
+    }
+    u32 swap = p0;
+    p0 = p1;
+    p1 = swap;
+  }
+
+  u64 bits[2] = {0};
+  u32 at = 0;
+  r_bc7_put_bits(bits, &at, 1 << 6, 7);
+  for(u32 c = 0; c < 4; c++)
+  {
+    r_bc7_put_bits(bits, &at, q0[c], 7);
+    r_bc7_put_bits(bits, &at, q1[c], 7);
+  }
+  r_bc7_put_bits(bits, &at, p0, 1);
+  r_bc7_put_bits(bits, &at, p1, 1);
+  r_bc7_put_indices(bits, &at, stored, 4);
+  memcpy(block, bits, 16);
+  return error;
+}
+
+internal u32
+r_bc7_mode6_encode(const u32 *texels, const u32 *masks, const u32 *axis_texels, u8 *block)
+{
+  f32 lo[4], hi[4];
+  r_bc_axis_extremes(axis_texels, 16, 4, lo, hi);
+  u8 indices[16];
+  u32 best_error = r_bc7_mode6_try(texels, masks, lo, hi, block, indices);
+
+  //- nb: refit while it helps, texel ~ (64 - w) / 64 * e0 + w / 64 * e1
+  for(u32 pass = 0; pass < R_BC7_REFIT_PASSES && best_error > 0; pass++)
+  {
+    f32 weights[16];
+    for(u32 i = 0; i < 16; i++)
+      weights[i] = (f32)(64 - r_bc7_weights[indices[i]]) / 64.f;
+    f32 e0[4], e1[4];
+    if(!r_bc_refit(texels, masks, weights, 16, 4, e0, e1))
+      break;
+    u8 refit_block[16];
+    u8 refit_indices[16];
+    u32 refit_error = r_bc7_mode6_try(texels, masks, e0, e1, refit_block, refit_indices);
+    if(refit_error >= best_error)
+      break;
+    best_error = refit_error;
+    memcpy(block, refit_block, 16);
+    memcpy(indices, refit_indices, 16);
+  }
+  return best_error;
+}
+
+//- nb: mode 5
+internal inline u32
+r_bc7_mode5_expand(u32 q)
+{
+  return (q << 1) | (q >> 6);
+}
+
+internal u32
+r_bc7_mode5_try(const u32 *texels, const u32 *color_masks, const f32 *e0, const f32 *e1, u32 a0, u32 a1, u8 *block, u8 *color_indices)
+{
+  u32 q0[3], q1[3];
+  for(u32 c = 0; c < 3; c++)
+  {
+    q0[c] = r_bc_round_channel(e0[c] * 127.f / 255.f, 127);
+    q1[c] = r_bc_round_channel(e1[c] * 127.f / 255.f, 127);
+  }
+  u32 color_palette[4], alpha_palette[4];
+  for(u32 i = 0; i < 4; i++)
+  {
+    color_palette[i] = 0;
+    for(u32 c = 0; c < 3; c++)
+      color_palette[i] |= r_bc7_interpolate(r_bc7_mode5_expand(q0[c]), r_bc7_mode5_expand(q1[c]), r_bc7_weights2[i]) << (c * 8);
+    alpha_palette[i] = r_bc7_interpolate(a0, a1, r_bc7_weights2[i]) << 24;
+  }
+  u32 alpha_masks[16];
+  for(u32 i = 0; i < 16; i++)
+    alpha_masks[i] = 0xff000000;
+  u8 alpha_indices[16];
+  u32 error = r_bc_select(texels, color_masks, color_palette, 4, color_indices);
+  error += r_bc_select(texels, alpha_masks, alpha_palette, 4, alpha_indices);
+
+  u8 stored[16];
+  memcpy(stored, color_indices, 16);
+  if(r_bc7_fix_anchor(stored, 2))
+  {
+    for(u32 c = 0; c < 3; c++)
+    {
+      u32 swap = q0[c];
+      q0[c] = q1[c];
+      q1[c] = swap;
+    }
+  }
+  if(r_bc7_fix_anchor(alpha_indices, 2))
+  {
+    u32 swap = a0;
+    a0 = a1;
+    a1 = swap;
+  }
+
+  u64 bits[2] = {0};
+  u32 at = 0;
+  r_bc7_put_bits(bits, &at, 1 << 5, 6);
+  r_bc7_put_bits(bits, &at, 0, 2);
+  for(u32 c = 0; c < 3; c++)
+  {
+    r_bc7_put_bits(bits, &at, q0[c], 7);
+    r_bc7_put_bits(bits, &at, q1[c], 7);
+  }
+  r_bc7_put_bits(bits, &at, a0, 8);
+  r_bc7_put_bits(bits, &at, a1, 8);
+  r_bc7_put_indices(bits, &at, stored, 2);
+  r_bc7_put_indices(bits, &at, alpha_indices, 2);
+  memcpy(block, bits, 16);
+  return error;
+}
+
+internal u32
+r_bc7_mode5_encode(const u32 *texels, const u32 *masks, const u32 *axis_texels, u8 *block)
+{
+  //- nb: color and alpha apart, alpha's endpoints are exact in 8 bits
+  u32 color_masks[16];
+  u32 a0 = 255, a1 = 0;
+  for(u32 i = 0; i < 16; i++)
+  {
+    color_masks[i] = masks[i] & 0x00ffffff;
+    a0 = Min(a0, texels[i] >> 24);
+    a1 = Max(a1, texels[i] >> 24);
+  }
+  f32 lo[3], hi[3];
+  r_bc_axis_extremes(axis_texels, 16, 3, lo, hi);
+  u8 indices[16];
+  u32 best_error = r_bc7_mode5_try(texels, color_masks, lo, hi, a0, a1, block, indices);
+
+  for(u32 pass = 0; pass < R_BC7_REFIT_PASSES && best_error > 0; pass++)
+  {
+    f32 weights[16];
+    for(u32 i = 0; i < 16; i++)
+      weights[i] = (f32)(64 - r_bc7_weights2[indices[i]]) / 64.f;
+    f32 e0[3], e1[3];
+    if(!r_bc_refit(texels, color_masks, weights, 16, 3, e0, e1))
+      break;
+    u8 refit_block[16];
+    u8 refit_indices[16];
+    u32 refit_error = r_bc7_mode5_try(texels, color_masks, e0, e1, a0, a1, refit_block, refit_indices);
+    if(refit_error >= best_error)
+      break;
+    best_error = refit_error;
+    memcpy(block, refit_block, 16);
+    memcpy(indices, refit_indices, 16);
+  }
+  return best_error;
+}
+
+//- nb: blocks
+void
+r_bc7_encode_block(const u32 *texels, u8 *block)
+{
+  //- nb: the color of fully transparent texels never shows, only their
+  // alpha counts. For the axis they take the mean color of the rest.
+  u32 masks[16];
+  u32 axis_texels[16];
+  u32 sum[3] = {0}, shown = 0;
+  for(u32 i = 0; i < 16; i++)
+  {
+    masks[i] = (texels[i] >> 24) ? 0xffffffff : 0xff000000;
+    if(texels[i] >> 24)
+    {
+      for(u32 c = 0; c < 3; c++)
+        sum[c] += r_bc_channel(texels[i], c);
+      shown += 1;
+    }
+  }
+  u32 mean = shown ? (sum[0] / shown) | ((sum[1] / shown) << 8) | ((sum[2] / shown) << 16) : 0;
+  for(u32 i = 0; i < 16; i++)
+    axis_texels[i] = (texels[i] >> 24) ? texels[i] : mean;
+
+  u32 error = r_bc7_mode6_encode(texels, masks, axis_texels, block);
+  if(error > 0)
+  {
+    u8 mode5_block[16];
+    if(r_bc7_mode5_encode(texels, masks, axis_texels, mode5_block) < error)
+      memcpy(block, mode5_block, 16);
+  }
+}
+
+void
+r_bc7_decode_block(const u8 *block, u32 *texels)
+{
+  u64 bits[2];
+  memcpy(bits, block, 16);
+  u32 at = 0;
+  u32 mode = 0;
+  while(mode < 8 && !r_bc7_get_bits(bits, &at, 1))
+    mode += 1;
+  if(mode == 6)
+  {
+    u32 q0[4], q1[4];
+    for(u32 c = 0; c < 4; c++)
+    {
+      q0[c] = r_bc7_get_bits(bits, &at, 7);
+      q1[c] = r_bc7_get_bits(bits, &at, 7);
+    }
+    u32 p0 = r_bc7_get_bits(bits, &at, 1);
+    u32 p1 = r_bc7_get_bits(bits, &at, 1);
+    u32 palette[16];
+    r_bc7_mode6_palette(q0, p0, q1, p1, palette);
+    u8 indices[16];
+    r_bc7_get_indices(bits, &at, indices, 4);
+    for(u32 i = 0; i < 16; i++)
+      texels[i] = palette[indices[i]];
+  }
+  else if(mode == 5)
+  {
+    u32 rotation = r_bc7_get_bits(bits, &at, 2);
+    u32 e0[3], e1[3];
+    for(u32 c = 0; c < 3; c++)
+    {
+      e0[c] = r_bc7_mode5_expand(r_bc7_get_bits(bits, &at, 7));
+      e1[c] = r_bc7_mode5_expand(r_bc7_get_bits(bits, &at, 7));
+    }
+    u32 a0 = r_bc7_get_bits(bits, &at, 8);
+    u32 a1 = r_bc7_get_bits(bits, &at, 8);
+    u8 color_indices[16], alpha_indices[16];
+    r_bc7_get_indices(bits, &at, color_indices, 2);
+    r_bc7_get_indices(bits, &at, alpha_indices, 2);
+    for(u32 i = 0; i < 16; i++)
+    {
+      u32 channels[4];
+      for(u32 c = 0; c < 3; c++)
+        channels[c] = r_bc7_interpolate(e0[c], e1[c], r_bc7_weights2[color_indices[i]]);
+      channels[3] = r_bc7_interpolate(a0, a1, r_bc7_weights2[alpha_indices[i]]);
+      //- nb: rotation swaps alpha with one of the colors
+      if(rotation)
+      {
+        u32 swap = channels[3];
+        channels[3] = channels[rotation - 1];
+        channels[rotation - 1] = swap;
+      }
+      texels[i] = channels[0] | (channels[1] << 8) | (channels[2] << 16) | (channels[3] << 24);
+    }
+  }
+  else
+  {
+    memset(texels, 0, sizeof(u32) * 16);
+  }
+}
+
+////////////////////////////////
+//~ nb: Images
+void
+r_bc_encode(R_Tex2DFormat format, const u32 *rgba, u32 width, u32 height, void *blocks)
+{
+  Assert(r_tex2d_format_is_compressed(format));
+  u32 block_width  = (width + 3) / 4;
+  u32 block_height = (height + 3) / 4;
+  u32 block_bytes  = r_tex2d_format_info(format).bytes_per_block;
+  u8 *out = (u8*)blocks;
+  u32 texels[16];
+  for(u32 by = 0; by < block_height; by++)
+  {
+    for(u32 bx = 0; bx < block_width; bx++)
+    {
+      r_bc_fetch_block(rgba, width, height, bx, by, texels);
+      switch(format)
+      {
+        case R_TEX2D_FORMAT_BC1: r_bc1_encode_block(texels, out); break;
+        case R_TEX2D_FORMAT_BC4: r_bc4_encode_block(texels, out); break;
+        case R_TEX2D_FORMAT_BC7: r_bc7_encode_block(texels, out); break;
+        default: break;
+      }
+      out += block_bytes;
+    }
+  }
+}
+
+void
+r_bc_decode(R_Tex2DFormat format, const void *blocks, u32 width, u32 height, u32 *rgba)
+{
+  Assert(r_tex2d_format_is_compressed(format));
+  u32 block_width  = (width + 3) / 4;
+  u32 block_height = (height + 3) / 4;
+  u32 block_bytes  = r_tex2d_format_info(format).bytes_per_block;
+  const u8 *in = (const u8*)blocks;
+  u32 texels[16];
+  for(u32 by = 0; by < block_height; by++)
+  {
+    for(u32 bx = 0; bx < block_width; bx++)
+    {
+      switch(format)
+      {
+        case R_TEX2D_FORMAT_BC1: r_bc1_decode_block(in, texels); break;
+        case R_TEX2D_FORMAT_BC4: r_bc4_decode_block(in, texels); break;
+        case R_TEX2D_FORMAT_BC7: r_bc7_decode_block(in, texels); break;
+        default: break;
+      }
+      in += block_bytes;
+      u32 rows    = Min(4, height - by * 4);
+      u32 columns = Min(4, width - bx * 4);
+      for(u32 y = 0; y < rows; y++)
+        memcpy(rgba + (u64)(by * 4 + y) * width + bx * 4, texels + y * 4, sizeof(u32) * columns);
+    }
+  }
+}
+
+////////////////////////////////
+//~ nb: Error metrics
+internal f64
+r_bc_psnr(f64 mse)
+{
+  if(mse <= 0)
+    return HUGE_VAL;
+  return 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+R_BCError
+r_bc_error(const u32 *reference, const u32 *decoded, u64 count)
+{
+  R_BCError result = {0};
+  u64 rgb_sum = 0, alpha_sum = 0, rgb_count = 0;
+  for(u64 i = 0; i < count; i++)
+  {
+    u32 ref = reference[i], dec = decoded[i];
+    s32 da = (s32)(ref >> 24) - (s32)(dec >> 24);
+    alpha_sum += (u64)(da * da);
+    result.max_error = Max(result.max_error, (u32)(da < 0 ? -da : da));
+    if((ref >> 24) == 0 && (dec >> 24) == 0)
+      continue;
+    rgb_count += 1;
+    for(u32 channel = 0; channel < 3; channel++)
+    {
+      s32 d = (s32)r_bc_channel(ref, channel) - (s32)r_bc_channel(dec, channel);
+      rgb_sum += (u64)(d * d);
+      result.max_error = Max(result.max_error, (u32)(d < 0 ? -d : d));
+    }
+  }
+  result.mse_rgb    = rgb_count ? (f64)rgb_sum / (f64)(rgb_count * 3) : 0;
+  result.mse_alpha  = count ? (f64)alpha_sum / (f64)count : 0;
+  result.psnr_rgb   = r_bc_psnr(result.mse_rgb);
+  result.psnr_alpha = r_bc_psnr(result.mse_alpha);
+  return result;
+}
@@ -0,0 +1,60 @@
+#ifndef RENDER_BC_H
+#define RENDER_BC_H
+
+////////////////////////////////
+//~ nb: Block compression
+// CPU encoder and decoder for the block compressed texture formats, so
+// sprite sheets and atlases can go to the GPU as BC blocks. Runs at load
+// time or offline (it only depends on base.h and render_core.h and builds
+// into the headless core). Every format works on 4x4 blocks of RGBA8
+// texels:
+//  - BC1, RGB 5:6:5 endpoints and 2-bit indices. Blocks with alpha below
+//    128 use the three color mode, those texels become transparent black.
+//  - BC4, one channel, the same one R8 keeps (alpha, see r_tex2d_pack).
+//  - BC7, modes 6 and 5 only (one subset, RGBA on one line or color and
+//    alpha apart), whichever is closer per block. The decoder reads those
+//    two as well, other modes decode to transparent black.
+// Endpoints come from the block's principal axis, are refit by least
+// squares and the better of the two is kept. Index search is SSE2 (AVX2
+// when built for it). The color of fully transparent texels is free.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// nb: Whole images. `rgba` is width x height texels, `blocks` holds
+// r_tex2d_size(format, width, height) bytes, rows of blocks. Edge blocks
+// repeat the last column and row.
+void r_bc_encode(R_Tex2DFormat format, const u32 *rgba, u32 width, u32 height, void *blocks);
+// nb: Expanded the way the shaders see it, BC4 like r_tex2d_unpack does R8.
+void r_bc_decode(R_Tex2DFormat format, const void *blocks, u32 width, u32 height, u32 *rgba);
+
+//- nb: single blocks, 16 texels row by row
+void r_bc1_encode_block(const u32 *texels, u8 *block);
+void r_bc4_encode_block(const u32 *texels, u8 *block);
+void r_bc7_encode_block(const u32 *texels, u8 *block);
+void r_bc1_decode_block(const u8 *block, u32 *texels);
+void r_bc4_decode_block(const u8 *block, u32 *texels);
+void r_bc7_decode_block(const u8 *block, u32 *texels);
+
+////////////////////////////////
+//~ nb: Error metrics
+// Against the source, per channel squared error averaged over texels. The
+// color of texels transparent in both images doesn't count.
+typedef struct R_BCError R_BCError;
+struct R_BCError
+{
+  f64 mse_rgb;
+  f64 mse_alpha;
+  f64 psnr_rgb;                   // in dB, infinite when exact
+  f64 psnr_alpha;
+  u32 max_error;                  // largest single channel difference
+};
+
+R_BCError r_bc_error(const u32 *reference, const u32 *decoded, u64 count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //RENDER_BC_H
@@ -0,0 +1,767 @@
+#include "render_core.h"
+
+////////////////////////////////
+//~ nb: Helper functions
+//- nb: sets bits [first, first + count)
+internal void
+r_bits_set_range(u64 *bits, u64 first, u64 count)
+{
+  if(count == 0)
+    return;
+  u64 last = first + count - 1;
+  u64 first_word = first / 64;
+  u64 last_word  = last / 64;
+  u64 first_mask = ~0ull << (first & 63);
+  u64 last_mask  = ~0ull >> (63 - (last & 63));
+  if(first_word == last_word)
+  {
+    bits[first_word] |= first_mask & last_mask;
+    return;
+  }
+  bits[first_word] |= first_mask;
+  for(u64 w = first_word + 1; w < last_word; w++)
+  {
+    bits[w] = ~0ull;
+  }
+  bits[last_word] |= last_mask;
+}
+
+//- nb: appends a run of cells, merging it into the last range across small gaps
+internal void
+r_plan_push(R_UploadPlan *plan, u32 first, u32 count)
+{
+  if(plan->range_count > 0)
+  {
+    R_UploadRange *last = &plan->ranges[plan->range_count - 1];
+    u32 last_end = last->first + last->count;
+    if(first - last_end <= R_UPLOAD_MERGE_GAP)
+    {
+      plan->cell_count += first + count - last_end;
+      last->count = first + count - last->first;
+      return;
+    }
+  }
+  // nb: the caller checks range_count against R_UPLOAD_MAX_RANGES, there
+  // is room for one past it
+  R_UploadRange *range = &plan->ranges[plan->range_count++];
+  range->first = first;
+  range->count = count;
+  plan->cell_count += count;
+}
+
+////////////////////////////////
+//~ nb: Texture formats
+global R_Tex2DFormatInfo r_tex2d_format_info_table[R_TEX2D_FORMAT_COUNT] =
+{
+  {1, 4,  4},                     // RGBA8
+  {1, 1,  1},                     // R8
+  {1, 2,  2},                     // RG8
+  {4, 8,  4},                     // BC1
+  {4, 8,  1},                     // BC4
+  {4, 16, 4},                     // BC7
+  {1, 1,  1},                     // SDF8
+};
+
+R_Tex2DFormatInfo
+r_tex2d_format_info(R_Tex2DFormat format)
+{
+  return r_tex2d_format_info_table[format];
+}
+
+b32
+r_tex2d_format_is_compressed(R_Tex2DFormat format)
+{
+  return r_tex2d_format_info_table[format].block_size > 1;
+}
+
+u64
+r_tex2d_row_pitch(R_Tex2DFormat format, u32 width)
+{
+  R_Tex2DFormatInfo *info = &r_tex2d_format_info_table[format];
+  return (u64)(width + info->block_size - 1) / info->block_size * info->bytes_per_block;
+}
+
+u64
+r_tex2d_size(R_Tex2DFormat format, u32 width, u32 height)
+{
+  u32 block_size = r_tex2d_format_info_table[format].block_size;
+  return r_tex2d_row_pitch(format, width) * ((height + block_size - 1) / block_size);
+}
+
+void
+r_tex2d_unpack(R_Tex2DFormat format, u32 *dst, const void *src, u64 count)
+{
+  const u8 *bytes = (const u8*)src;
+  switch(format)
+  {
+    case R_TEX2D_FORMAT_RGBA8:
+    {
+      memcpy(dst, src, sizeof(u32) * count);
+    }
+    break;
+    case R_TEX2D_FORMAT_R8:
+    {
+      for(u64 i = 0; i < count; i++)
+        dst[i] = 0x00ffffff | ((u32)bytes[i] << 24);
+    }
+    break;
+    case R_TEX2D_FORMAT_RG8:
+    {
+      for(u64 i = 0; i < count; i++)
+      {
+        u32 l = bytes[i * 2 + 0];
+        dst[i] = l | (l << 8) | (l << 16) | ((u32)bytes[i * 2 + 1] << 24);
+      }
+    }
+    break;
+    case R_TEX2D_FORMAT_SDF8:
+    {
+      // nb: ps_sdf with a pixel per texel, coverage ramps over one texel
+      for(u64 i = 0; i < count; i++)
+      {
+        f32 distance = ((f32)bytes[i] - 127.5f) * (R_TEX2D_SDF_RANGE / 255.0f);
+        u32 a = (u32)(Clamp(0.0f, distance + 0.5f, 1.0f) * 255.0f + 0.5f);
+        dst[i] = 0x00ffffff | (a << 24);
+      }
+    }
+    break;
+    default:
+    {
+      Assert(!"compressed formats are decoded block by block");
+    }
+    break;
+  }
+}
+
+void
+r_tex2d_pack(R_Tex2DFormat format, void *dst, const u32 *src, u64 count)
+{
+  u8 *bytes = (u8*)dst;
+  switch(format)
+  {
+    case R_TEX2D_FORMAT_RGBA8:
+    {
+      memcpy(dst, src, sizeof(u32) * count);
+    }
+    break;
+    case R_TEX2D_FORMAT_R8:
+    {
+      for(u64 i = 0; i < count; i++)
+        bytes[i] = (u8)(src[i] >> 24);
+    }
+    break;
+    case R_TEX2D_FORMAT_RG8:
+    {
+      for(u64 i = 0; i < count; i++)
+      {
+        bytes[i * 2 + 0] = (u8)src[i];
+        bytes[i * 2 + 1] = (u8)(src[i] >> 24);
+      }
+    }
+    break;
+    case R_TEX2D_FORMAT_SDF8:
+    {
+      for(u64 i = 0; i < count; i++)
+      {
+        f32 distance = (f32)(src[i] >> 24) / 255.0f - 0.5f;
+        bytes[i] = (u8)Clamp(0.0f, 127.5f + distance * (255.0f / R_TEX2D_SDF_RANGE) + 0.5f, 255.0f);
+      }
+    }
+    break;
+    default:
+    {
+      Assert(!"compressed formats are encoded block by block");
+    }
+    break;
+  }
+}
+
+
+////////////////////////////////
+//~ nb: Dirty cells
+R_DirtyCells *
+r_dirty_alloc(Arena *arena, u32 cell_count)
+{
+  R_DirtyCells *dirty = (R_DirtyCells*)arena_push(arena, sizeof(R_DirtyCells));
+  dirty->cell_count = cell_count;
+  dirty->word_count = (cell_count + 63) / 64;
+  u32 summary_count = (dirty->word_count + 63) / 64;
+  dirty->bits      = (u64*)arena_push(arena, sizeof(u64) * dirty->word_count);
+  dirty->word_bits = (u64*)arena_push(arena, sizeof(u64) * summary_count);
+  memset(dirty->bits, 0, sizeof(u64) * dirty->word_count);
+  memset(dirty->word_bits, 0, sizeof(u64) * summary_count);
+  // nb: nothing was uploaded yet
+  dirty->all = 1;
+  return dirty;
+}
+
+void
+r_dirty_mark(R_DirtyCells *dirty, u32 first, u32 count)
+{
+  if(dirty->all || first >= dirty->cell_count)
+    return;
+  count = ClampTop(count, dirty->cell_count - first);
+  if(count == 0)
+    return;
+  r_bits_set_range(dirty->bits, first, count);
+  u32 first_word = first / 64;
+  u32 last_word  = (first + count - 1) / 64;
+  r_bits_set_range(dirty->word_bits, first_word, last_word - first_word + 1);
+}
+
+void
+r_dirty_mark_all(R_DirtyCells *dirty)
+{
+  dirty->all = 1;
+}
+
+R_UploadPlan
+r_dirty_plan(R_DirtyCells *dirty, Arena *arena)
+{
+  R_UploadPlan plan = {0};
+  plan.ranges = (R_UploadRange*)arena_push(arena, sizeof(R_UploadRange) * (R_UPLOAD_MAX_RANGES + 1));
+
+  //- nb: walk the dirty words only, runs of set bits become ranges
+  u32 summary_count = (dirty->word_count + 63) / 64;
+  for(u32 s = 0; s < summary_count && !dirty->all; s++)
+  {
+    for(u64 summary = dirty->word_bits[s]; summary != 0; summary &= summary - 1)
+    {
+      u32 w = s * 64 + ctz_u64(summary);
+      u64 bits = dirty->bits[w];
+      dirty->bits[w] = 0;
+      while(bits)
+      {
+        u32 start  = ctz_u64(bits);
+        u64 rest   = ~(bits >> start);
+        u32 length = rest ? ctz_u64(rest) : 64 - start;
+        r_plan_push(&plan, w * 64 + start, length);
+        bits &= (start + length >= 64) ? 0 : (~0ull << (start + length));
+        if(plan.range_count > R_UPLOAD_MAX_RANGES)
+        {
+          dirty->all = 1;
+          break;
+        }
+      }
+      if(dirty->all)
+        break;
+    }
+    dirty->word_bits[s] = 0;
+  }
+
+  //- nb: everything, or too scattered to be worth the calls
+  if(dirty->all)
+  {
+    memset(dirty->bits, 0, sizeof(u64) * dirty->word_count);
+    memset(dirty->word_bits, 0, sizeof(u64) * summary_count);
+    dirty->all = 0;
+    plan.ranges[0].first = 0;
+    plan.ranges[0].count = dirty->cell_count;
+    plan.range_count = dirty->cell_count ? 1 : 0;
+    plan.cell_count  = dirty->cell_count;
+    plan.full        = 1;
+  }
+  return plan;
+}
+
+
+////////////////////////////////
+//~ nb: Upload backends
+void
+r_upload_plan_execute(R_UploadBackend *backend, R_UploadPlan *plan, const void *src, u32 instance_size)
+{
+  for(u32 i = 0; i < plan->range_count; i++)
+  {
+    R_UploadRange *range = &plan->ranges[i];
+    u64 offset = (u64)range->first * instance_size;
+    u64 size   = (u64)range->count * instance_size;
+    backend->upload(backend, offset, size, (const u8*)src + offset, plan->full);
+  }
+}
+
+//- nb: Recording backend
+internal void
+r_upload_recorder_upload(R_UploadBackend *backend, u64 offset, u64 size, const void *data, b32 full)
+{
+  R_UploadRecorder *recorder = (R_UploadRecorder*)backend;
+  Assert(offset + size <= recorder->buffer_size);
+  memcpy(recorder->buffer + offset, data, size);
+  if(recorder->record_count == recorder->record_capacity)
+  {
+    u32 capacity = recorder->record_capacity ? recorder->record_capacity * 2 : 64;
+    R_UploadRecord *records = (R_UploadRecord*)arena_push(recorder->arena, sizeof(R_UploadRecord) * capacity);
+    memcpy(records, recorder->records, sizeof(R_UploadRecord) * recorder->record_count);
+    recorder->records = records;
+    recorder->record_capacity = capacity;
+  }
+  R_UploadRecord *record = &recorder->records[recorder->record_count++];
+  record->offset = offset;
+  record->size   = size;
+  recorder->frame_bytes += size;
+  recorder->total_bytes += size;
+}
+
+R_UploadRecorder *
+r_upload_recorder_alloc(Arena *arena, u64 buffer_size)
+{
+  R_UploadRecorder *recorder = (R_UploadRecorder*)arena_push(arena, sizeof(R_UploadRecorder));
+  memset(recorder, 0, sizeof(R_UploadRecorder));
+  recorder->backend.upload = r_upload_recorder_upload;
+  recorder->arena          = arena;
+  recorder->buffer         = (u8*)arena_push(arena, buffer_size);
+  recorder->buffer_size    = buffer_size;
+  memset(recorder->buffer, 0, buffer_size);
+  return recorder;
+}
+
+void
+r_upload_recorder_frame(R_UploadRecorder *recorder)
+{
+  recorder->record_count = 0;
+  recorder->frame_bytes  = 0;
+}
+
+
+////////////////////////////////
+//~ nb: Tile grid
+// nb: keep in sync with tile_vs in render.cpp
+R_TileGridVertex
+r_tile_grid_vertex(R_TileGridConstants *grid, const u8 *tiles, u32 instance_id, f32 corner_x, f32 corner_y)
+{
+  R_TileGridVertex vertex;
+  u32 column = grid->first_x + instance_id % grid->visible_columns;
+  u32 row    = grid->first_y + instance_id / grid->visible_columns;
+  u32 tile = tiles[row * grid->columns + column];
+  f32 cell_x = (f32)column;
+  f32 cell_y = (f32)row;
+  f32 *uv_rect = grid->uv_rect_from_tile[tile];
+  vertex.pos[0] = corner_x * grid->tile_size[0] + (grid->origin[0] + cell_x * grid->tile_size[0]);
+  vertex.pos[1] = corner_y * grid->tile_size[1] + (grid->origin[1] + cell_y * grid->tile_size[1]);
+  vertex.uv[0]  = corner_x * uv_rect[2] + uv_rect[0];
+  vertex.uv[1]  = corner_y * uv_rect[3] + uv_rect[1];
+  return vertex;
+}
+
+
+////////////////////////////////
+//~ nb: Tile view
+void
+r_tile_from_screen(R_TileView *view, f64 screen_x, f64 screen_y, s64 *tile_x, s64 *tile_y)
+{
+  *tile_x = (s64)floor((screen_x / view->zoom + view->x) / view->tile_size);
+  *tile_y = (s64)floor((screen_y / view->zoom + view->y) / view->tile_size);
+}
+
+void
+r_screen_from_tile(R_TileView *view, s64 tile_x, s64 tile_y, f64 *screen_x, f64 *screen_y)
+{
+  *screen_x = (tile_x * view->tile_size - view->x) * view->zoom;
+  *screen_y = (tile_y * view->tile_size - view->y) * view->zoom;
+}
+
+R_TileRect
+r_tile_view_rect(R_TileView *view)
+{
+  R_TileRect rect;
+  r_tile_from_screen(view, 0, 0, &rect.x0, &rect.y0);
+  //- nb: the tile under the last pixel's far edge, unless that edge is where
+  // it starts
+  r_tile_from_screen(view, view->width, view->height, &rect.x1, &rect.y1);
+  f64 screen_x, screen_y;
+  r_screen_from_tile(view, rect.x1, rect.y1, &screen_x, &screen_y);
+  rect.x1 += (screen_x < view->width);
+  rect.y1 += (screen_y < view->height);
+  return rect;
+}
+
+R_TileRect
+r_tile_rect_intersect(R_TileRect a, R_TileRect b)
+{
+  R_TileRect rect;
+  rect.x0 = Max(a.x0, b.x0);
+  rect.y0 = Max(a.y0, b.y0);
+  rect.x1 = Max(rect.x0, Min(a.x1, b.x1));
+  rect.y1 = Max(rect.y0, Min(a.y1, b.y1));
+  return rect;
+}
+
+////////////////////////////////
+//~ nb: Tile map
+b32
+r_tile_map_set_view(R_TileMapConstants *map, R_TileView *view)
+{
+  f64 tile_pixels = view->tile_size * view->zoom;
+  f64 origin_x, origin_y;
+  r_screen_from_tile(view, 0, 0, &origin_x, &origin_y);
+  map->origin[0]        = (f32)origin_x;
+  map->origin[1]        = (f32)origin_y;
+  map->inv_tile_size[0] = (f32)(1.0 / tile_pixels);
+  map->inv_tile_size[1] = (f32)(1.0 / tile_pixels);
+  map->target_size[0]   = (f32)view->width;
+  map->target_size[1]   = (f32)view->height;
+
+  //- nb: the board's edges, clipped to the window
+  map->rect[0] = (f32)Clamp(0.0, origin_x, (f64)view->width);
+  map->rect[1] = (f32)Clamp(0.0, origin_y, (f64)view->height);
+  map->rect[2] = (f32)Clamp(0.0, origin_x + map->columns * tile_pixels, (f64)view->width);
+  map->rect[3] = (f32)Clamp(0.0, origin_y + map->rows * tile_pixels, (f64)view->height);
+  return map->rect[0] < map->rect[2] && map->rect[1] < map->rect[3];
+}
+
+R_TileMapSample
+r_tile_map_sample(R_TileMapConstants *map, const u8 *tiles, f32 x, f32 y)
+{
+  R_TileMapSample sample = {0};
+  f32 local_x = (x - map->origin[0]) * map->inv_tile_size[0];
+  f32 local_y = (y - map->origin[1]) * map->inv_tile_size[1];
+  f32 cell_x = floorf(local_x);
+  f32 cell_y = floorf(local_y);
+  if(cell_x < 0 || cell_y < 0 || cell_x >= (f32)map->columns || cell_y >= (f32)map->rows)
+    return sample;
+  u32 tile = tiles[(u64)cell_y * map->columns + (u64)cell_x];
+  f32 *uv_rect = map->uv_rect_from_tile[tile];
+  sample.covered = 1;
+  sample.tile    = tile;
+  sample.uv[0]   = (local_x - cell_x) * uv_rect[2] + uv_rect[0];
+  sample.uv[1]   = (local_y - cell_y) * uv_rect[3] + uv_rect[1];
+  return sample;
+}
+
+u32
+r_tile_map_boxes(u32 columns, u64 first, u64 count, R_TileMapBox *boxes)
+{
+  u32 box_count = 0;
+  u32 x = (u32)(first % columns);
+  u32 y = (u32)(first / columns);
+  //- nb: the rest of the first row, or all of the range if it ends there
+  if(count > 0 && x > 0)
+  {
+    u32 width = (u32)Min(count, (u64)(columns - x));
+    boxes[box_count++] = {x, y, width, 1};
+    count -= width;
+    y += 1;
+  }
+  if(count >= columns)
+  {
+    u32 height = (u32)(count / columns);
+    boxes[box_count++] = {0, y, columns, height};
+    count -= (u64)height * columns;
+    y += height;
+  }
+  if(count > 0)
+  {
+    boxes[box_count++] = {0, y, (u32)count, 1};
+  }
+  return box_count;
+}
+
+////////////////////////////////
+//~ nb: Ring allocator
+void
+r_ring_init(R_Ring *ring, u64 capacity)
+{
+  memset(ring, 0, sizeof(R_Ring));
+  ring->capacity = capacity;
+  ring->grown    = 1;
+}
+
+//- nb: hands back the space of every frame the GPU is done with
+internal void
+r_ring_retire(R_Ring *ring, u64 completed)
+{
+  while(ring->frame_count > 0 && ring->frames[ring->frame_first].fence <= completed)
+  {
+    ring->tail = ring->frames[ring->frame_first].end;
+    ring->frame_first = (ring->frame_first + 1) % R_RING_MAX_FRAMES;
+    ring->frame_count -= 1;
+  }
+}
+
+R_RingAlloc
+r_ring_alloc(R_Ring *ring, u64 size, u64 align, R_Fence *fence)
+{
+  R_RingAlloc result = {0};
+  r_ring_retire(ring, fence->completed(fence));
+  for(;;)
+  {
+    //- nb: allocations never straddle the end, skip to the start instead
+    u64 pos = AlignPow2(ring->head, align);
+    if(pos % ring->capacity + size > ring->capacity)
+      pos += ring->capacity - pos % ring->capacity;
+    if(pos + size - ring->tail <= ring->capacity)
+    {
+      ring->head = pos + size;
+      result.offset  = pos % ring->capacity;
+      result.discard = ring->grown;
+      ring->grown = 0;
+      return result;
+    }
+
+    //- nb: the frame alone doesn't fit, grow
+    if(ring->frame_count == 0 || size + (ring->head - ring->frame_start) > ring->capacity)
+    {
+      u64 demand = size + (ring->head - ring->frame_start);
+      u64 capacity = ring->capacity * 2;
+      while(capacity < demand)
+        capacity *= 2;
+      ring->capacity    = capacity;
+      ring->head        = 0;
+      ring->tail        = 0;
+      ring->frame_start = 0;
+      ring->frame_first = 0;
+      ring->frame_count = 0;
+      ring->grown       = 1;
+      ring->grow_count += 1;
+      continue;
+    }
+
+    //- nb: wait for the oldest frame in flight
+    fence->wait(fence, ring->frames[ring->frame_first].fence);
+    ring->wait_count += 1;
+    r_ring_retire(ring, fence->completed(fence));
+  }
+}
+
+void
+r_ring_end_frame(R_Ring *ring, u64 fence_value, R_Fence *fence)
+{
+  if(ring->frame_count == R_RING_MAX_FRAMES)
+  {
+    fence->wait(fence, ring->frames[ring->frame_first].fence);
+    ring->wait_count += 1;
+    r_ring_retire(ring, fence->completed(fence));
+  }
+  u32 idx = (ring->frame_first + ring->frame_count) % R_RING_MAX_FRAMES;
+  ring->frames[idx].fence = fence_value;
+  ring->frames[idx].end   = ring->head;
+  ring->frame_count += 1;
+  ring->frame_start = ring->head;
+}
+
+////////////////////////////////
+//~ nb: Frame command list
+R_CmdList *
+r_cmd_list_alloc(void)
+{
+  Arena *arena = arena_alloc();
+  R_CmdList *list = (R_CmdList*)arena_push(arena, sizeof(R_CmdList));
+  memset(list, 0, sizeof(R_CmdList));
+  list->arena      = arena;
+  list->cmd_arena  = arena_alloc_reserve(Gigabytes(1));
+  list->quad_arena = arena_alloc_reserve(Gigabytes(4));
+  list->cmds  = (R_Cmd*)arena_push(list->cmd_arena, 0);
+  list->quads = (R_Quad*)arena_push(list->quad_arena, 0);
+  return list;
+}
+
+void
+r_cmd_list_release(R_CmdList *list)
+{
+  arena_release(list->quad_arena);
+  arena_release(list->cmd_arena);
+  arena_release(list->arena);
+}
+
+internal u32
+r_cmd_texture_slot(R_CmdList *list, R_Handle texture)
+{
+  u32 mask = ArrayCount(list->texture_hash) - 1;
+  for(u32 h = (u32)rng_hash_u64(texture.U64[0], 0) & mask;; h = (h + 1) & mask)
+  {
+    u32 entry = list->texture_hash[h];
+    if(entry == 0)
+    {
+      Assert(list->texture_count < R_CMD_MAX_TEXTURES);
+      list->textures[list->texture_count] = texture;
+      list->texture_hash[h] = (u16)(list->texture_count + 1);
+      return list->texture_count++;
+    }
+    if(list->textures[entry - 1].U64[0] == texture.U64[0])
+      return entry - 1;
+  }
+}
+
+R_Quad *
+r_cmd_push_quads(R_CmdList *list, R_Handle texture, u32 layer, u32 count)
+{
+  Assert(layer < R_LAYER_COUNT);
+  u32 slot = r_cmd_texture_slot(list, texture);
+  u64 group = ((u64)layer << R_CMD_KEY_LAYER_SHIFT) | ((u64)slot << R_CMD_KEY_TEXTURE_SHIFT);
+  R_Quad *quads = (R_Quad*)arena_push(list->quad_arena, sizeof(R_Quad) * count);
+  Assert(quads == list->quads + list->quad_count);
+
+  //- nb: same layer and texture as the last push, the quads follow on
+  R_Cmd *last = list->cmd_count ? &list->cmds[list->cmd_count - 1] : 0;
+  if(last && (last->key & ~0xffffffffull) == group)
+  {
+    last->quad_count += count;
+  }
+  else
+  {
+    R_Cmd *cmd = (R_Cmd*)arena_push(list->cmd_arena, sizeof(R_Cmd));
+    Assert(cmd == list->cmds + list->cmd_count);
+    cmd->key        = group | list->cmd_count;
+    cmd->first_quad = list->quad_count;
+    cmd->quad_count = count;
+    list->cmd_count += 1;
+  }
+  list->quad_count += count;
+  return quads;
+}
+
+//- nb: LSD radix sort on the key bytes, skipping bytes all keys share
+internal R_Cmd *
+r_cmd_sort(R_Cmd *cmds, R_Cmd *scratch, u32 count)
+{
+  u64 all_or = 0, all_and = ~0ull;
+  for(u32 i = 0; i < count; i++)
+  {
+    all_or  |= cmds[i].key;
+    all_and &= cmds[i].key;
+  }
+  u64 varying = all_or ^ all_and;
+  for(u32 shift = 0; shift < 64; shift += 8)
+  {
+    if(((varying >> shift) & 0xff) == 0)
+      continue;
+    u32 offsets[256] = {0};
+    for(u32 i = 0; i < count; i++)
+    {
+      offsets[(cmds[i].key >> shift) & 0xff] += 1;
+    }
+    u32 total = 0;
+    for(u32 d = 0; d < 256; d++)
+    {
+      u32 digit_count = offsets[d];
+      offsets[d] = total;
+      total += digit_count;
+    }
+    for(u32 i = 0; i < count; i++)
+    {
+      scratch[offsets[(cmds[i].key >> shift) & 0xff]++] = cmds[i];
+    }
+    R_Cmd *swap = cmds;
+    cmds = scratch;
+    scratch = swap;
+  }
+  return cmds;
+}
+
+void
+r_cmd_list_flush(R_CmdList *list, R_DrawBackend *backend)
+{
+  if(list->quad_count > 0)
+  {
+    R_Cmd *scratch = (R_Cmd*)arena_push(list->cmd_arena, sizeof(R_Cmd) * list->cmd_count);
+    R_Cmd *cmds = r_cmd_sort(list->cmds, scratch, list->cmd_count);
+
+    //- nb: one map for the whole frame, in draw order
+    R_Quad *dst = backend->map(backend, list->quad_count);
+    u32 cursor = 0;
+    for(u32 i = 0; i < list->cmd_count; i++)
+    {
+      memcpy(dst + cursor, list->quads + cmds[i].first_quad, sizeof(R_Quad) * cmds[i].quad_count);
+      cursor += cmds[i].quad_count;
+    }
+    backend->unmap(backend);
+
+    //- nb: neighbors with the same texture share a draw, whatever the layer
+    u32 run_first = 0;
+    u32 run_end = 0;
+    u32 draw_count = 0;
+    for(u32 i = 0; i < list->cmd_count; i++)
+    {
+      u32 slot = (u32)(cmds[i].key >> R_CMD_KEY_TEXTURE_SHIFT) & 0xffff;
+      run_end += cmds[i].quad_count;
+      b32 run_ends = (i + 1 == list->cmd_count ||
+                      ((cmds[i + 1].key >> R_CMD_KEY_TEXTURE_SHIFT) & 0xffff) != slot);
+      if(run_ends)
+      {
+        backend->draw(backend, list->textures[slot], run_first, run_end - run_first);
+        run_first = run_end;
+        draw_count += 1;
+      }
+    }
+
+    backend->counters.cmds           += list->cmd_count;
+    backend->counters.quads          += list->quad_count;
+    backend->counters.draws          += draw_count;
+    backend->counters.maps           += 1;
+    backend->counters.bytes_uploaded += sizeof(R_Quad) * list->quad_count;
+  }
+
+  arena_clear(list->cmd_arena);
+  arena_clear(list->quad_arena);
+  list->cmds  = (R_Cmd*)arena_push(list->cmd_arena, 0);
+  list->quads = (R_Quad*)arena_push(list->quad_arena, 0);
+  list->cmd_count     = 0;
+  list->quad_count    = 0;
+  list->texture_count = 0;
+  memset(list->texture_hash, 0, sizeof(list->texture_hash));
+}
+
+//- nb: Recording draw backend
+internal R_Quad *
+r_draw_recorder_map(R_DrawBackend *backend, u32 quad_count)
+{
+  R_DrawRecorder *recorder = (R_DrawRecorder*)backend;
+  recorder->quads      = (R_Quad*)arena_push(recorder->arena, sizeof(R_Quad) * quad_count);
+  recorder->quad_count = quad_count;
+  return recorder->quads;
+}
+
+internal void
+r_draw_recorder_unmap(R_DrawBackend *backend)
+{
+}
+
+internal void
+r_draw_recorder_draw(R_DrawBackend *backend, R_Handle texture, u32 first_quad, u32 quad_count)
+{
+  R_DrawRecorder *recorder = (R_DrawRecorder*)backend;
+  Assert(first_quad + quad_count <= recorder->quad_count);
+  if(recorder->draw_count == recorder->draw_capacity)
+  {
+    u32 capacity = recorder->draw_capacity ? recorder->draw_capacity * 2 : 64;
+    R_DrawRecord *draws = (R_DrawRecord*)arena_push(recorder->arena, sizeof(R_DrawRecord) * capacity);
+    memcpy(draws, recorder->draws, sizeof(R_DrawRecord) * recorder->draw_count);
+    recorder->draws = draws;
+    recorder->draw_capacity = capacity;
+  }
+  R_DrawRecord *draw = &recorder->draws[recorder->draw_count++];
+  draw->texture    = texture;
+  draw->first_quad = first_quad;
+  draw->quad_count = quad_count;
+}
+
+R_DrawRecorder *
+r_draw_recorder_alloc(void)
+{
+  Arena *arena = arena_alloc_reserve(Gigabytes(4));
+  R_DrawRecorder *recorder = (R_DrawRecorder*)arena_push(arena, sizeof(R_DrawRecorder));
+  memset(recorder, 0, sizeof(R_DrawRecorder));
+  recorder->backend.map   = r_draw_recorder_map;
+  recorder->backend.unmap = r_draw_recorder_unmap;
+  recorder->backend.draw  = r_draw_recorder_draw;
+  recorder->arena = arena;
+  recorder->arena_reset_pos = arena->pos;
+  return recorder;
+}
+
+void
+r_draw_recorder_release(R_DrawRecorder *recorder)
+{
+  arena_release(recorder->arena);
+}
+
+void
+r_draw_recorder_frame(R_DrawRecorder *recorder)
+{
+  arena_pop_to(recorder->arena, recorder->arena_reset_pos);
+  recorder->quads         = 0;
+  recorder->quad_count    = 0;
+  recorder->draws         = 0;
+  recorder->draw_count    = 0;
+  recorder->draw_capacity = 0;
+  memset(&recorder->backend.counters, 0, sizeof(R_FrameCounters));
+}
@@ -0,0 +1,459 @@
+#ifndef RENDER_CORE_H
+#define RENDER_CORE_H
+
+////////////////////////////////
+//~ nb: Render core
+// The parts of the renderer that don't talk to a graphics API. Only depends
+// on base.h, so it builds with the board core (build.sh) and can be driven
+// against a recording backend instead of D3D11.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// TODO(nb): implement this
+typedef union R_Handle R_Handle;
+union R_Handle
+{
+  u64 U64[1];
+  u32 U32[2];
+  u16 U16[4];
+};
+
+////////////////////////////////
+//~ nb: Texture formats
+// What a texture holds per texel, or per 4x4 block for the compressed
+// formats. The sprite shaders expand one and two channel textures: one
+// channel is coverage under white (1, 1, 1, r), two are luminance and
+// alpha (r, r, r, g). RGBA8 is 0 so zeroed textures are RGBA8. SDF8 is
+// one channel of signed distance (see glyph_sdf.h), its shader turns it
+// into coverage at whatever scale it is drawn.
+typedef enum R_Tex2DFormat
+{
+  R_TEX2D_FORMAT_RGBA8,
+  R_TEX2D_FORMAT_R8,
+  R_TEX2D_FORMAT_RG8,
+  R_TEX2D_FORMAT_BC1,             // RGB and 1-bit alpha, 8 bytes per block
+  R_TEX2D_FORMAT_BC4,             // one channel, 8 bytes per block
+  R_TEX2D_FORMAT_BC7,             // RGBA, 16 bytes per block
+  R_TEX2D_FORMAT_SDF8,            // distance, 128 on the edge
+  R_TEX2D_FORMAT_COUNT,
+} R_Tex2DFormat;
+
+typedef struct R_Tex2DFormatInfo R_Tex2DFormatInfo;
+struct R_Tex2DFormatInfo
+{
+  u32 block_size;                 // texels per side, 1 when uncompressed
+  u32 bytes_per_block;
+  u32 channels;                   // before the expansion
+};
+
+// nb: texels of distance the 0..255 of an SDF8 texel spans, half inside
+#define R_TEX2D_SDF_RANGE 8.0f
+
+R_Tex2DFormatInfo r_tex2d_format_info(R_Tex2DFormat format);
+b32               r_tex2d_format_is_compressed(R_Tex2DFormat format);
+// nb: Bytes per row of texels (of blocks for compressed formats) and of a
+// whole width x height rectangle, partial blocks count as whole ones.
+u64               r_tex2d_row_pitch(R_Tex2DFormat format, u32 width);
+u64               r_tex2d_size(R_Tex2DFormat format, u32 width, u32 height);
+// nb: CPU side of the expansion: `count` texels of an uncompressed format
+// to RGBA8, the way the sprite shaders see them, and back. Packing keeps
+// alpha for one channel and red and alpha for two, so texels the expansion
+// can produce survive the round trip. SDF8 unpacks to coverage as drawn at
+// one texel per pixel, and packs coverage back to distance.
+void              r_tex2d_unpack(R_Tex2DFormat format, u32 *dst, const void *src, u64 count);
+void              r_tex2d_pack(R_Tex2DFormat format, void *dst, const u32 *src, u64 count);
+
+////////////////////////////////
+//~ nb: Dirty cells
+// Persistent instance buffers (one instance per board cell) only upload
+// what changed. Game code marks cell ranges dirty, r_dirty_plan turns the
+// marks into a short list of ranges and clears them.
+// nb: dirty gaps up to this many cells are uploaded along with their
+// neighbors rather than costing another upload call
+#define R_UPLOAD_MERGE_GAP   8
+// nb: past this many ranges a single full upload is cheaper
+#define R_UPLOAD_MAX_RANGES  64
+
+typedef struct R_DirtyCells R_DirtyCells;
+struct R_DirtyCells
+{
+  u64           *bits;            // one bit per cell
+  u64           *word_bits;       // one bit per word of `bits` that has any set
+  u32           cell_count;
+  u32           word_count;
+  b32           all;
+};
+
+//- nb: a range of cells, in instances
+typedef struct R_UploadRange R_UploadRange;
+struct R_UploadRange
+{
+  u32 first;
+  u32 count;
+};
+
+typedef struct R_UploadPlan R_UploadPlan;
+struct R_UploadPlan
+{
+  R_UploadRange *ranges;
+  u32           range_count;
+  // nb: the whole buffer in one range, lets a backend orphan it instead
+  b32           full;
+  // nb: cells covered by the ranges, dirty or not
+  u32           cell_count;
+};
+
+R_DirtyCells *r_dirty_alloc(Arena *arena, u32 cell_count);
+void          r_dirty_mark(R_DirtyCells *dirty, u32 first, u32 count);
+void          r_dirty_mark_all(R_DirtyCells *dirty);
+// nb: Ranges are ascending and don't overlap. Clears the marks.
+R_UploadPlan  r_dirty_plan(R_DirtyCells *dirty, Arena *arena);
+
+////////////////////////////////
+//~ nb: Upload backends
+// Where planned ranges go. The D3D11 renderer copies them into a GPU
+// buffer, the recording backend keeps them (and a copy of the buffer) so
+// the byte ranges of every frame can be checked headless.
+typedef struct R_UploadBackend R_UploadBackend;
+typedef void R_Upload_Func(R_UploadBackend *backend, u64 offset, u64 size, const void *data, b32 full);
+struct R_UploadBackend
+{
+  R_Upload_Func *upload;
+};
+
+// nb: `src` is the CPU copy of the whole buffer
+void r_upload_plan_execute(R_UploadBackend *backend, R_UploadPlan *plan, const void *src, u32 instance_size);
+
+//- nb: byte range of one upload
+typedef struct R_UploadRecord R_UploadRecord;
+struct R_UploadRecord
+{
+  u64 offset;
+  u64 size;
+};
+
+typedef struct R_UploadRecorder R_UploadRecorder;
+struct R_UploadRecorder
+{
+  R_UploadBackend backend;
+  Arena           *arena;
+  // nb: what the GPU buffer would hold
+  u8              *buffer;
+  u64             buffer_size;
+  // nb: uploads since the last r_upload_recorder_frame
+  R_UploadRecord  *records;
+  u32             record_count;
+  u32             record_capacity;
+  u64             frame_bytes;
+  u64             total_bytes;
+};
+
+R_UploadRecorder *r_upload_recorder_alloc(Arena *arena, u64 buffer_size);
+// nb: Starts a new frame, forgets the previous frame's records.
+void              r_upload_recorder_frame(R_UploadRecorder *recorder);
+
+////////////////////////////////
+//~ nb: Tile grid
+// Draw path for boards: the only per-instance data is the packed Tile
+// byte. Only a rectangle of the board is drawn, the vertex shader puts
+// instance i at column first_x + i % visible_columns, row
+// first_y + i / visible_columns and looks the sprite up by tile byte. This
+// is the constant buffer it reads, laid out the way HLSL packs it.
+typedef struct R_TileGridConstants R_TileGridConstants;
+struct R_TileGridConstants
+{
+  f32 origin[2];                  // top left of tile 0, in pixels
+  f32 tile_size[2];
+  u32 columns;                    // of the whole board, the tile buffer's stride
+  u32 visible_columns;
+  u32 first_x;
+  u32 first_y;
+  f32 uv_rect_from_tile[256][4];  // offset xy, scale zw
+};
+
+typedef struct R_TileGridVertex R_TileGridVertex;
+struct R_TileGridVertex
+{
+  f32 pos[2];                     // in pixels, before the projection
+  f32 uv[2];
+};
+
+// nb: CPU reference of the tile grid vertex shader, same math in the same
+// order. `corner` is the unit quad vertex (0 or 1 on each axis).
+R_TileGridVertex r_tile_grid_vertex(R_TileGridConstants *grid, const u8 *tiles, u32 instance_id, f32 corner_x, f32 corner_y);
+
+////////////////////////////////
+//~ nb: Tile view
+// Where a camera puts a tile grid on screen. Drawing (which tiles cover
+// the window) and picking (which tile is under the cursor) both go
+// through r_tile_from_screen, so they can't disagree about a tile.
+typedef struct R_TileView R_TileView;
+struct R_TileView
+{
+  f64 x;                          // world position of the window's top left,
+  f64 y;                          // in pixels at zoom 1
+  f64 zoom;
+  f64 tile_size;                  // in pixels at zoom 1
+  u32 width;                      // of the window, in pixels
+  u32 height;
+};
+
+//- nb: tiles [x0, x1) x [y0, y1)
+typedef struct R_TileRect R_TileRect;
+struct R_TileRect
+{
+  s64 x0;
+  s64 y0;
+  s64 x1;
+  s64 y1;
+};
+
+void       r_tile_from_screen(R_TileView *view, f64 screen_x, f64 screen_y, s64 *tile_x, s64 *tile_y);
+// nb: Screen position of a tile's top left corner.
+void       r_screen_from_tile(R_TileView *view, s64 tile_x, s64 tile_y, f64 *screen_x, f64 *screen_y);
+// nb: Every tile that covers a pixel of the window.
+R_TileRect r_tile_view_rect(R_TileView *view);
+R_TileRect r_tile_rect_intersect(R_TileRect a, R_TileRect b);
+
+////////////////////////////////
+//~ nb: Tile map
+// Board path whose draw cost doesn't grow with the cell count: the tile
+// bytes live in an R8_UINT texture, columns x rows, and one quad covers the
+// part of the board inside the window. The pixel shader finds the cell
+// under the pixel, loads its byte and samples the sprite at the pixel's
+// spot in the cell. Works in window pixels, r_set_transform doesn't apply.
+// nb: D3D11's limit for either side of a 2D texture, larger boards stay on
+// the tile grid
+#define R_TILE_MAP_MAX_SIZE 16384
+
+//- nb: the constant buffer, laid out the way HLSL packs it
+typedef struct R_TileMapConstants R_TileMapConstants;
+struct R_TileMapConstants
+{
+  f32 origin[2];                  // top left of tile 0, in pixels
+  f32 inv_tile_size[2];           // cells per pixel, so the shader multiplies
+  f32 rect[4];                    // the quad, x0 y0 x1 y1 in pixels
+  f32 target_size[2];             // of the window
+  u32 columns;
+  u32 rows;
+  f32 uv_rect_from_tile[256][4];  // offset xy, scale zw
+};
+
+typedef struct R_TileMapSample R_TileMapSample;
+struct R_TileMapSample
+{
+  b32 covered;                    // 0 off the board, the shader discards
+  u32 tile;
+  f32 uv[2];
+};
+
+//- nb: rows of cells, where a range of the row-major tile bytes goes in
+// the texture
+typedef struct R_TileMapBox R_TileMapBox;
+struct R_TileMapBox
+{
+  u32 x;
+  u32 y;
+  u32 width;
+  u32 height;
+};
+
+// nb: Origin, scale and quad for a view. `columns`, `rows` and the uv
+// rects are left alone. Returns 0 when no pixel of the board is visible.
+b32             r_tile_map_set_view(R_TileMapConstants *map, R_TileView *view);
+// nb: CPU reference of the tile map pixel shader, same math in the same
+// order. `x, y` is the pixel's center in window pixels.
+R_TileMapSample r_tile_map_sample(R_TileMapConstants *map, const u8 *tiles, f32 x, f32 y);
+// nb: `count` cells from `first` as at most three boxes: the rest of the
+// first row, the full rows, the start of the last row. Returns the count.
+u32             r_tile_map_boxes(u32 columns, u64 first, u64 count, R_TileMapBox *boxes);
+
+////////////////////////////////
+//~ nb: Frame fence
+// Tells how far the GPU got. Every frame signals the next value at its end,
+// a frame is done once completed() reached its value.
+typedef struct R_Fence R_Fence;
+typedef u64  R_Fence_Completed_Func(R_Fence *fence);
+typedef void R_Fence_Wait_Func(R_Fence *fence, u64 value);
+struct R_Fence
+{
+  R_Fence_Completed_Func *completed;
+  R_Fence_Wait_Func      *wait;
+};
+
+////////////////////////////////
+//~ nb: Ring allocator
+// Bookkeeping for a dynamic GPU buffer that is suballocated front to back
+// and mapped with NO_OVERWRITE. Space is handed back a whole frame at a
+// time once the fence says the GPU is past it. An allocation that doesn't
+// fit behind the in-flight frames waits for the oldest one. One that
+// doesn't fit even with the buffer to itself grows the buffer: the backend
+// makes a new one of `capacity` bytes and maps it with DISCARD, the old
+// buffer stays alive for whatever was already drawn from it.
+#define R_RING_MAX_FRAMES 8
+
+typedef struct R_RingFrame R_RingFrame;
+struct R_RingFrame
+{
+  u64 fence;
+  u64 end;                        // head when the frame ended
+};
+
+typedef struct R_Ring R_Ring;
+struct R_Ring
+{
+  u64           capacity;         // in bytes
+  // nb: running byte positions, offset = position % capacity
+  u64           head;
+  u64           tail;
+  u64           frame_start;
+  R_RingFrame   frames[R_RING_MAX_FRAMES];
+  u32           frame_first;
+  u32           frame_count;
+  // nb: the buffer has to be (re)created at `capacity` before the next map
+  b32           grown;
+  u64           grow_count;
+  u64           wait_count;
+};
+
+typedef struct R_RingAlloc R_RingAlloc;
+struct R_RingAlloc
+{
+  u64 offset;
+  // nb: first map of a new buffer
+  b32 discard;
+};
+
+void        r_ring_init(R_Ring *ring, u64 capacity);
+// nb: `align` has to divide the capacity, growing keeps it that way.
+R_RingAlloc r_ring_alloc(R_Ring *ring, u64 size, u64 align, R_Fence *fence);
+// nb: Closes the frame, its space comes back once `fence_value` completed.
+void        r_ring_end_frame(R_Ring *ring, u64 fence_value, R_Fence *fence);
+
+////////////////////////////////
+//~ nb: Frame command list
+// Quads are appended during the frame, tagged with a texture and a layer.
+// At the end of the frame they are sorted by a 64-bit key, copied into the
+// instance buffer with a single map and drawn with one draw per run of
+// equal textures. Layers draw in order; inside a layer quads are grouped by
+// texture and keep their submission order per texture, so quads that have
+// to overlap in a given order need different layers.
+typedef enum R_Layer
+{
+  R_LAYER_WORLD,
+  R_LAYER_UI,
+  R_LAYER_COUNT,
+} R_Layer;
+
+//- nb: one instance, the layout of InstanceData
+typedef struct R_Quad R_Quad;
+struct R_Quad
+{
+  f32 pos[2];                     // in pixels
+  f32 size[2];
+  f32 uv_rect[4];                 // offset xy, scale zw
+};
+
+//- nb: key bits, high to low: layer, texture slot, sequence
+#define R_CMD_KEY_LAYER_SHIFT     56
+#define R_CMD_KEY_TEXTURE_SHIFT   32
+// nb: distinct textures per frame
+#define R_CMD_MAX_TEXTURES        1024
+
+typedef struct R_Cmd R_Cmd;
+struct R_Cmd
+{
+  u64 key;
+  u32 first_quad;
+  u32 quad_count;
+};
+
+typedef struct R_FrameCounters R_FrameCounters;
+struct R_FrameCounters
+{
+  u32 cmds;
+  u32 quads;
+  u32 draws;
+  u32 maps;
+  // nb: copies that go around a map (UpdateSubresource and the like)
+  u32 updates;
+  u64 bytes_uploaded;
+};
+
+typedef struct R_CmdList R_CmdList;
+struct R_CmdList
+{
+  Arena         *arena;
+  // nb: one arena each so both arrays stay contiguous as they grow.
+  // Cleared every frame.
+  Arena         *cmd_arena;
+  Arena         *quad_arena;
+  R_Cmd         *cmds;
+  u32           cmd_count;
+  R_Quad        *quads;
+  u32           quad_count;
+  // nb: textures used this frame, the key holds the slot. The hash maps
+  // handles to slot + 1, 0 is empty.
+  R_Handle      textures[R_CMD_MAX_TEXTURES];
+  u32           texture_count;
+  u16           texture_hash[R_CMD_MAX_TEXTURES * 2];
+};
+
+//- nb: Where a flushed list goes. map hands out room for every quad of the
+// frame at once, draw then covers a range of it.
+typedef struct R_DrawBackend R_DrawBackend;
+typedef R_Quad *R_Draw_Map_Func(R_DrawBackend *backend, u32 quad_count);
+typedef void    R_Draw_Unmap_Func(R_DrawBackend *backend);
+typedef void    R_Draw_Func(R_DrawBackend *backend, R_Handle texture, u32 first_quad, u32 quad_count);
+struct R_DrawBackend
+{
+  R_Draw_Map_Func   *map;
+  R_Draw_Unmap_Func *unmap;
+  R_Draw_Func       *draw;
+  // nb: added to by every flush, reset by the owner
+  R_FrameCounters   counters;
+};
+
+R_CmdList *r_cmd_list_alloc(void);
+void       r_cmd_list_release(R_CmdList *list);
+// nb: Returns room for `count` quads, valid until the flush.
+R_Quad    *r_cmd_push_quads(R_CmdList *list, R_Handle texture, u32 layer, u32 count);
+// nb: Sorts, uploads and draws everything pushed since the last flush.
+void       r_cmd_list_flush(R_CmdList *list, R_DrawBackend *backend);
+
+//- nb: Recording draw backend
+typedef struct R_DrawRecord R_DrawRecord;
+struct R_DrawRecord
+{
+  R_Handle texture;
+  u32      first_quad;
+  u32      quad_count;
+};
+
+typedef struct R_DrawRecorder R_DrawRecorder;
+struct R_DrawRecorder
+{
+  R_DrawBackend backend;
+  Arena         *arena;
+  // nb: everything pushed past this point is thrown away every frame
+  u64           arena_reset_pos;
+  // nb: the last mapped instance data and the draws since
+  R_Quad        *quads;
+  u32           quad_count;
+  R_DrawRecord  *draws;
+  u32           draw_count;
+  u32           draw_capacity;
+};
+
+R_DrawRecorder *r_draw_recorder_alloc(void);
+void            r_draw_recorder_release(R_DrawRecorder *recorder);
+// nb: Starts a new frame, forgets the previous one's draws and counters.
+void            r_draw_recorder_frame(R_DrawRecorder *recorder);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //RENDER_CORE_H
@@ -0,0 +1,559 @@
+#include "render_soft.h"
+
+#include <stdio.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+# include <emmintrin.h>
+# define R_SOFT_SIMD_SSE2 1
+#endif
+
+// nb: what the nil texture samples to, transparent black like an unbound
+// texture on the GPU
+global u32 r_soft_nil_texel = 0;
+global R_SoftTex2D r_soft_tex2d_nil = {&r_soft_tex2d_nil, 0, 0, R_TEX2D_FORMAT_RGBA8, &r_soft_nil_texel, 0, 1, 1};
+
+////////////////////////////////
+//~ nb: Helper functions
+internal R_SoftTex2D *
+r_soft_tex2d_from_handle(R_Handle handle)
+{
+  R_SoftTex2D *texture = (R_SoftTex2D*)handle.U64[0];
+  if(!texture)
+    texture = &r_soft_tex2d_nil;
+  return texture;
+}
+
+//- nb: os memory rounded up to whole pages, for buffers that come and go
+internal void *
+r_soft_reserve(u64 size, u64 *reserved)
+{
+  *reserved = AlignPow2(ClampBot(size, 1), PAGE_SIZE);
+  void *ptr = os_reserve(*reserved);
+  Assert(ptr && os_commit(ptr, *reserved));
+  return ptr;
+}
+
+//- nb: `data` in the texture's format into texels [x, x + width) by [y, y +
+// height). Compressed formats come as rows of blocks and decode block by
+// block, the region has to start on a block.
+internal void
+r_soft_tex2d_write(R_SoftTex2D *texture, u32 x, u32 y, u32 width, u32 height, const void *data)
+{
+  u64 pitch = r_tex2d_row_pitch(texture->format, width);
+  if(!r_tex2d_format_is_compressed(texture->format))
+  {
+    for(u32 row = 0; row < height; row++)
+    {
+      r_tex2d_unpack(texture->format, texture->texels + (u64)(y + row) * texture->width + x, (const u8*)data + row * pitch, width);
+    }
+    return;
+  }
+  Assert(x % 4 == 0 && y % 4 == 0);
+  u32 block_bytes = r_tex2d_format_info(texture->format).bytes_per_block;
+  u32 texels[16];
+  for(u32 by = 0; by * 4 < height; by++)
+  {
+    const u8 *block = (const u8*)data + by * pitch;
+    for(u32 bx = 0; bx * 4 < width; bx++, block += block_bytes)
+    {
+      switch(texture->format)
+      {
+        case R_TEX2D_FORMAT_BC1: r_bc1_decode_block(block, texels); break;
+        case R_TEX2D_FORMAT_BC4: r_bc4_decode_block(block, texels); break;
+        case R_TEX2D_FORMAT_BC7: r_bc7_decode_block(block, texels); break;
+        default: break;
+      }
+      u32 rows    = Min(4, height - by * 4);
+      u32 columns = Min(4, width - bx * 4);
+      for(u32 row = 0; row < rows; row++)
+        memcpy(texture->texels + (u64)(y + by * 4 + row) * texture->width + x + bx * 4, texels + row * 4, sizeof(u32) * columns);
+    }
+  }
+}
+
+//- nb: src * a + dst * (1 - a) in 8-bit, rounded the way UNORM blending
+// rounds. The alpha is the source's (SrcBlendAlpha ONE, DestBlendAlpha ZERO).
+internal inline u32
+r_soft_blend_pixel(u32 src, u32 dst)
+{
+  u32 a  = src >> 24;
+  u32 ia = 255 - a;
+  u32 out = src & 0xff000000;
+  for(u32 shift = 0; shift < 24; shift += 8)
+  {
+    u32 t = ((src >> shift) & 0xff) * a + ((dst >> shift) & 0xff) * ia + 128;
+    out |= ((t + (t >> 8)) >> 8) << shift;
+  }
+  return out;
+}
+
+//- nb: one row of a quad, `columns` holds the texel column of every pixel
+internal void
+r_soft_blend_span(u32 *dst, const u32 *src_row, const u32 *columns, u32 count)
+{
+  u32 i = 0;
+#if R_SOFT_SIMD_SSE2
+  const __m128i zero    = _mm_setzero_si128();
+  const __m128i opaque  = _mm_set1_epi32((int)0xff000000);
+  const __m128i max     = _mm_set1_epi16(255);
+  const __m128i round   = _mm_set1_epi16(128);
+  for(; i + 4 <= count; i += 4)
+  {
+    __m128i src = _mm_setr_epi32((int)src_row[columns[i + 0]], (int)src_row[columns[i + 1]],
+                                 (int)src_row[columns[i + 2]], (int)src_row[columns[i + 3]]);
+    //- nb: all four opaque, nothing to blend
+    __m128i alpha = _mm_and_si128(src, opaque);
+    if(_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, opaque)) == 0xffff)
+    {
+      _mm_storeu_si128((__m128i*)(dst + i), src);
+      continue;
+    }
+    __m128i dest  = _mm_loadu_si128((__m128i*)(dst + i));
+    __m128i src_lo = _mm_unpacklo_epi8(src, zero);
+    __m128i src_hi = _mm_unpackhi_epi8(src, zero);
+    __m128i dst_lo = _mm_unpacklo_epi8(dest, zero);
+    __m128i dst_hi = _mm_unpackhi_epi8(dest, zero);
+    // nb: every pixel's alpha in all four of its lanes
+    __m128i a_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src_lo, 0xff), 0xff);
+    __m128i a_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(src_hi, 0xff), 0xff);
+    __m128i t_lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(src_lo, a_lo),
+                                               _mm_mullo_epi16(dst_lo, _mm_sub_epi16(max, a_lo))), round);
+    __m128i t_hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(src_hi, a_hi),
+                                               _mm_mullo_epi16(dst_hi, _mm_sub_epi16(max, a_hi))), round);
+    t_lo = _mm_srli_epi16(_mm_add_epi16(t_lo, _mm_srli_epi16(t_lo, 8)), 8);
+    t_hi = _mm_srli_epi16(_mm_add_epi16(t_hi, _mm_srli_epi16(t_hi, 8)), 8);
+    __m128i color = _mm_andnot_si128(opaque, _mm_packus_epi16(t_lo, t_hi));
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(color, alpha));
+  }
+#endif
+  for(; i < count; i++)
+  {
+    dst[i] = r_soft_blend_pixel(src_row[columns[i]], dst[i]);
+  }
+}
+
+//- nb: texel index of a coordinate, wrapped
+internal inline u32
+r_soft_wrap(f32 coord, u32 size)
+{
+  s64 texel = (s64)floorf(coord * size) % (s64)size;
+  return (u32)(texel < 0 ? texel + size : texel);
+}
+
+////////////////////////////////
+//~ nb: Rasterizer
+typedef struct R_Soft_Raster_Job R_Soft_Raster_Job;
+struct R_Soft_Raster_Job
+{
+  R_SoftState *soft;
+  u32         *columns;         // scratch, one per framebuffer column
+  u32         thread_idx;
+  u32         thread_count;
+};
+
+//- nb: pixels whose center lies in [x0, x1) x [y0, y1), clipped to the
+// framebuffer. 0 when there are none.
+internal b32
+r_soft_pixel_rect(R_SoftState *soft, f32 x0, f32 y0, f32 x1, f32 y1, s64 *px0, s64 *py0, s64 *px1, s64 *py1)
+{
+  *px0 = Max((s64)ceilf(x0 - 0.5f), 0);
+  *py0 = Max((s64)ceilf(y0 - 0.5f), 0);
+  *px1 = Min((s64)ceilf(x1 - 0.5f), (s64)soft->width);
+  *py1 = Min((s64)ceilf(y1 - 0.5f), (s64)soft->height);
+  return *px0 < *px1 && *py0 < *py1;
+}
+
+//- nb: first of this thread's bands that reaches row `py0` or below it
+internal u64
+r_soft_first_band(R_Soft_Raster_Job *job, s64 py0)
+{
+  u64 band_rows = (u64)R_SOFT_BAND_ROWS * job->thread_count;
+  u64 band_y = (u64)py0 / band_rows * band_rows + (u64)job->thread_idx * R_SOFT_BAND_ROWS;
+  if(band_y + R_SOFT_BAND_ROWS <= (u64)py0)
+    band_y += band_rows;
+  return band_y;
+}
+
+//- nb: the rows of the quad in this thread's bands
+internal void
+r_soft_raster_quad(R_Soft_Raster_Job *job, R_Quad *quad, R_SoftTex2D *texture)
+{
+  R_SoftState *soft = job->soft;
+  f32 x0 = quad->pos[0], x1 = quad->pos[0] + quad->size[0];
+  f32 y0 = quad->pos[1], y1 = quad->pos[1] + quad->size[1];
+  s64 px0, py0, px1, py1;
+  if(!r_soft_pixel_rect(soft, x0, y0, x1, y1, &px0, &py0, &px1, &py1))
+    return;
+  u64 band_rows = (u64)R_SOFT_BAND_ROWS * job->thread_count;
+  u64 band_y = r_soft_first_band(job, py0);
+  if(band_y >= (u64)py1)
+    return;
+
+  //- nb: texel columns are the same on every row
+  u32 count = (u32)(px1 - px0);
+  f32 du = quad->uv_rect[2] / quad->size[0];
+  f32 dv = quad->uv_rect[3] / quad->size[1];
+  for(u32 i = 0; i < count; i++)
+  {
+    f32 center = (f32)(px0 + i) + 0.5f;
+    job->columns[i] = r_soft_wrap(quad->uv_rect[0] + (center - x0) * du, texture->width);
+  }
+
+  for(; band_y < (u64)py1; band_y += band_rows)
+  {
+    u64 row_first = Max(band_y, (u64)py0);
+    u64 row_last  = Min(band_y + R_SOFT_BAND_ROWS, (u64)py1);
+    for(u64 y = row_first; y < row_last; y++)
+    {
+      f32 center = (f32)y + 0.5f;
+      u32 row = r_soft_wrap(quad->uv_rect[1] + (center - y0) * dv, texture->height);
+      r_soft_blend_span(soft->framebuffer + y * soft->width + px0,
+                        texture->texels + (u64)row * texture->width, job->columns, count);
+    }
+  }
+}
+
+//- nb: every pixel of the quad through r_tile_map_sample, the ones off the
+// board are discarded
+internal void
+r_soft_raster_tile_map(R_Soft_Raster_Job *job, R_SoftDraw *draw)
+{
+  R_SoftState *soft = job->soft;
+  R_TileMapConstants *map = draw->tile_map;
+  R_SoftTex2D *texture = draw->texture;
+  s64 px0, py0, px1, py1;
+  if(!r_soft_pixel_rect(soft, map->rect[0], map->rect[1], map->rect[2], map->rect[3], &px0, &py0, &px1, &py1))
+    return;
+  u64 band_rows = (u64)R_SOFT_BAND_ROWS * job->thread_count;
+  for(u64 band_y = r_soft_first_band(job, py0); band_y < (u64)py1; band_y += band_rows)
+  {
+    u64 row_first = Max(band_y, (u64)py0);
+    u64 row_last  = Min(band_y + R_SOFT_BAND_ROWS, (u64)py1);
+    for(u64 y = row_first; y < row_last; y++)
+    {
+      u32 *dst = soft->framebuffer + y * soft->width;
+      f32 center_y = (f32)y + 0.5f;
+      for(s64 x = px0; x < px1; x++)
+      {
+        R_TileMapSample sample = r_tile_map_sample(map, draw->tiles, (f32)x + 0.5f, center_y);
+        if(!sample.covered)
+          continue;
+        u32 row    = r_soft_wrap(sample.uv[1], texture->height);
+        u32 column = r_soft_wrap(sample.uv[0], texture->width);
+        dst[x] = r_soft_blend_pixel(texture->texels[(u64)row * texture->width + column], dst[x]);
+      }
+    }
+  }
+}
+
+internal void
+r_soft_raster_thread(void *params)
+{
+  R_Soft_Raster_Job *job = (R_Soft_Raster_Job*)params;
+  R_SoftState *soft = job->soft;
+  for(u32 d = 0; d < soft->draw_count; d++)
+  {
+    R_SoftDraw *draw = &soft->draws[d];
+    if(draw->tile_map)
+    {
+      r_soft_raster_tile_map(job, draw);
+      continue;
+    }
+    for(u32 q = 0; q < draw->quad_count; q++)
+    {
+      r_soft_raster_quad(job, &soft->quads[draw->first_quad + q], draw->texture);
+    }
+  }
+}
+
+//- nb: rasterizes the queue in order, every thread owns its bands
+internal void
+r_soft_raster(R_SoftState *soft)
+{
+  if(soft->draw_count > 0)
+  {
+    u32 band_count = (soft->height + R_SOFT_BAND_ROWS - 1) / R_SOFT_BAND_ROWS;
+    u32 thread_count = Clamp(1, soft->thread_count, ClampBot(band_count, 1));
+    Temp temp = temp_begin(soft->quad_arena);
+    R_Soft_Raster_Job *jobs = (R_Soft_Raster_Job*)arena_push(temp.arena, sizeof(R_Soft_Raster_Job) * thread_count);
+    OS_Thread *threads = (OS_Thread*)arena_push(temp.arena, sizeof(OS_Thread) * thread_count);
+    for(u32 i = 0; i < thread_count; i++)
+    {
+      R_Soft_Raster_Job *job = &jobs[i];
+      job->soft         = soft;
+      job->columns      = (u32*)arena_push(temp.arena, sizeof(u32) * ClampBot(soft->width, 1));
+      job->thread_idx   = i;
+      job->thread_count = thread_count;
+    }
+    // nb: the calling thread takes the first share itself
+    for(u32 i = 1; i < thread_count; i++)
+    {
+      os_thread_launch(&threads[i], r_soft_raster_thread, &jobs[i]);
+    }
+    r_soft_raster_thread(&jobs[0]);
+    for(u32 i = 1; i < thread_count; i++)
+    {
+      os_thread_join(&threads[i]);
+    }
+    temp_end(temp);
+  }
+  arena_clear(soft->quad_arena);
+  arena_clear(soft->draw_arena);
+  arena_clear(soft->map_arena);
+  soft->quads      = (R_Quad*)arena_push(soft->quad_arena, 0);
+  soft->quad_count = 0;
+  soft->draws      = (R_SoftDraw*)arena_push(soft->draw_arena, 0);
+  soft->draw_count = 0;
+}
+
+//- nb: Appends queued draws, quads first
+internal R_Quad *
+r_soft_queue_quads(R_SoftState *soft, u32 count)
+{
+  R_Quad *quads = (R_Quad*)arena_push(soft->quad_arena, sizeof(R_Quad) * count);
+  Assert(quads == soft->quads + soft->quad_count);
+  soft->quad_count += count;
+  return quads;
+}
+
+internal void
+r_soft_queue_draw(R_SoftState *soft, R_SoftTex2D *texture, u32 first_quad, u32 quad_count)
+{
+  R_SoftDraw *draw = (R_SoftDraw*)arena_push(soft->draw_arena, sizeof(R_SoftDraw));
+  Assert(draw == soft->draws + soft->draw_count);
+  draw->texture    = texture;
+  draw->first_quad = first_quad;
+  draw->quad_count = quad_count;
+  draw->tile_map   = 0;
+  draw->tiles      = 0;
+  soft->draw_count += 1;
+  soft->draw_backend.counters.draws += 1;
+}
+
+//- nb: Draw backend for the command list, the flushed quads go to the queue
+internal R_Quad *
+r_soft_cmd_map(R_DrawBackend *backend, u32 quad_count)
+{
+  R_SoftState *soft = (R_SoftState*)backend;
+  soft->map_first_quad = soft->quad_count;
+  return r_soft_queue_quads(soft, quad_count);
+}
+
+internal void
+r_soft_cmd_unmap(R_DrawBackend *backend)
+{
+}
+
+internal void
+r_soft_cmd_draw(R_DrawBackend *backend, R_Handle texture, u32 first_quad, u32 quad_count)
+{
+  R_SoftState *soft = (R_SoftState*)backend;
+  r_soft_queue_draw(soft, r_soft_tex2d_from_handle(texture), soft->map_first_quad + first_quad, quad_count);
+}
+
+////////////////////////////////
+//~ nb: Software renderer
+R_SoftState *
+r_soft_alloc(u32 width, u32 height, u32 thread_count)
+{
+  Arena *arena = arena_alloc();
+  R_SoftState *soft = (R_SoftState*)arena_push(arena, sizeof(R_SoftState));
+  memset(soft, 0, sizeof(R_SoftState));
+  soft->arena        = arena;
+  soft->thread_count = thread_count ? thread_count : os_logical_core_count();
+  soft->thread_count = Clamp(1, soft->thread_count, R_SOFT_MAX_THREADS);
+  soft->cmd_list     = r_cmd_list_alloc();
+  soft->draw_backend.map   = r_soft_cmd_map;
+  soft->draw_backend.unmap = r_soft_cmd_unmap;
+  soft->draw_backend.draw  = r_soft_cmd_draw;
+  soft->quad_arena   = arena_alloc_reserve(Gigabytes(4));
+  soft->draw_arena   = arena_alloc_reserve(Gigabytes(1));
+  soft->map_arena    = arena_alloc();
+  soft->quads        = (R_Quad*)arena_push(soft->quad_arena, 0);
+  soft->draws        = (R_SoftDraw*)arena_push(soft->draw_arena, 0);
+  r_soft_resize(soft, width, height);
+  return soft;
+}
+
+void
+r_soft_release(R_SoftState *soft)
+{
+  //- nb: textures still alive own their texels
+  for(R_SoftTex2D *texture = soft->first_allocated_tex2d; texture; texture = texture->next_allocated)
+  {
+    if(texture->texels)
+      os_release(texture->texels, texture->texels_reserved);
+  }
+  if(soft->framebuffer)
+    os_release(soft->framebuffer, soft->framebuffer_reserved);
+  r_cmd_list_release(soft->cmd_list);
+  arena_release(soft->quad_arena);
+  arena_release(soft->draw_arena);
+  arena_release(soft->map_arena);
+  arena_release(soft->arena);
+}
+
+void
+r_soft_resize(R_SoftState *soft, u32 width, u32 height)
+{
+  r_soft_raster(soft);
+  if(soft->framebuffer)
+    os_release(soft->framebuffer, soft->framebuffer_reserved);
+  soft->framebuffer = (u32*)r_soft_reserve(sizeof(u32) * (u64)width * height, &soft->framebuffer_reserved);
+  soft->width  = width;
+  soft->height = height;
+}
+
+R_Handle
+r_soft_tex2d_alloc(R_SoftState *soft, R_Tex2DFormat format, u32 width, u32 height, const void *data)
+{
+  R_SoftTex2D *texture;
+  // nb: See if there is a free texture
+  texture = soft->first_free_tex2d;
+  if(!texture)
+  {
+    texture = (R_SoftTex2D*)arena_push(soft->arena, sizeof(R_SoftTex2D));
+    memset(texture, 0, sizeof(R_SoftTex2D));
+    texture->next_allocated = soft->first_allocated_tex2d;
+    soft->first_allocated_tex2d = texture;
+  }
+  else
+  {
+    soft->first_free_tex2d = texture->next;
+  }
+  texture->generation += 1;
+  texture->format = format;
+  texture->next   = 0;
+  texture->width  = ClampBot(width, 1);
+  texture->height = ClampBot(height, 1);
+  texture->texels = (u32*)r_soft_reserve(sizeof(u32) * (u64)texture->width * texture->height, &texture->texels_reserved);
+  if(data)
+    r_soft_tex2d_write(texture, 0, 0, width, height, data);
+
+  R_Handle handle = {0};
+  handle.U64[0] = (u64)texture;
+  return handle;
+}
+
+void
+r_soft_tex2d_release(R_SoftState *soft, R_Handle handle)
+{
+  R_SoftTex2D *texture = r_soft_tex2d_from_handle(handle);
+  if(texture == &r_soft_tex2d_nil)
+    return;
+  // nb: queued draws may still sample it
+  r_soft_raster(soft);
+  os_release(texture->texels, texture->texels_reserved);
+  texture->texels = 0;
+  // nb: Add to list of free textures
+  texture->next = soft->first_free_tex2d;
+  soft->first_free_tex2d = texture;
+}
+
+void
+r_soft_tex2d_update(R_SoftState *soft, R_Handle handle, u32 x, u32 y, u32 width, u32 height, const void *data)
+{
+  R_SoftTex2D *texture = r_soft_tex2d_from_handle(handle);
+  if(texture == &r_soft_tex2d_nil)
+    return;
+  //- nb: draws queued before the update see the old texels
+  r_soft_raster(soft);
+  Assert(x + width <= texture->width && y + height <= texture->height);
+  r_soft_tex2d_write(texture, x, y, width, height, data);
+  soft->draw_backend.counters.updates        += 1;
+  soft->draw_backend.counters.bytes_uploaded += r_tex2d_size(texture->format, width, height);
+}
+
+void
+r_soft_clear(R_SoftState *soft, const f32 *color)
+{
+  r_soft_raster(soft);
+  u32 packed = 0;
+  for(u32 c = 0; c < 4; c++)
+  {
+    f32 channel = Clamp(0.0f, color[c], 1.0f);
+    packed |= (u32)(channel * 255.0f + 0.5f) << (c * 8);
+  }
+  u64 pixel_count = (u64)soft->width * soft->height;
+  for(u64 i = 0; i < pixel_count; i++)
+  {
+    soft->framebuffer[i] = packed;
+  }
+}
+
+R_Quad *
+r_soft_push_quads(R_SoftState *soft, R_Handle texture, R_Layer layer, u32 count)
+{
+  return r_cmd_push_quads(soft->cmd_list, texture, layer, count);
+}
+
+void
+r_soft_submit_tile_grid(R_SoftState *soft, R_TileGridConstants *grid, const u8 *tiles, u32 count, R_Handle texture)
+{
+  if(count == 0)
+    return;
+  //- nb: one quad per tile, corners where r_tile_grid_vertex puts them
+  u32 first_quad = soft->quad_count;
+  R_Quad *quads = r_soft_queue_quads(soft, count);
+  for(u32 i = 0; i < count; i++)
+  {
+    R_TileGridVertex corner = r_tile_grid_vertex(grid, tiles, i, 0, 0);
+    u32 column = grid->first_x + i % grid->visible_columns;
+    u32 row    = grid->first_y + i / grid->visible_columns;
+    f32 *uv_rect = grid->uv_rect_from_tile[tiles[row * grid->columns + column]];
+    R_Quad *quad = &quads[i];
+    quad->pos[0]     = corner.pos[0];
+    quad->pos[1]     = corner.pos[1];
+    quad->size[0]    = grid->tile_size[0];
+    quad->size[1]    = grid->tile_size[1];
+    memcpy(quad->uv_rect, uv_rect, sizeof(quad->uv_rect));
+  }
+  r_soft_queue_draw(soft, r_soft_tex2d_from_handle(texture), first_quad, count);
+  soft->draw_backend.counters.quads += count;
+}
+
+void
+r_soft_submit_tile_map(R_SoftState *soft, R_TileMapConstants *map, const u8 *tiles, R_Handle texture)
+{
+  R_TileMapConstants *copy = (R_TileMapConstants*)arena_push(soft->map_arena, sizeof(R_TileMapConstants));
+  *copy = *map;
+  r_soft_queue_draw(soft, r_soft_tex2d_from_handle(texture), soft->quad_count, 0);
+  R_SoftDraw *draw = &soft->draws[soft->draw_count - 1];
+  draw->tile_map = copy;
+  draw->tiles    = tiles;
+}
+
+void
+r_soft_present(R_SoftState *soft)
+{
+  r_cmd_list_flush(soft->cmd_list, &soft->draw_backend);
+  r_soft_raster(soft);
+  soft->last_frame_counters = soft->draw_backend.counters;
+  memset(&soft->draw_backend.counters, 0, sizeof(R_FrameCounters));
+}
+
+b32
+r_soft_write_ppm(R_SoftState *soft, const char *path)
+{
+  FILE *file = fopen(path, "wb");
+  if(!file)
+    return 0;
+  fprintf(file, "P6\n%u %u\n255\n", soft->width, soft->height);
+  Temp temp = temp_begin(soft->quad_arena);
+  u8 *rgb = (u8*)arena_push(temp.arena, 3 * (u64)soft->width);
+  b32 ok = 1;
+  for(u32 y = 0; y < soft->height && ok; y++)
+  {
+    u32 *row = soft->framebuffer + (u64)y * soft->width;
+    for(u32 x = 0; x < soft->width; x++)
+    {
+      rgb[x * 3 + 0] = (u8)(row[x] >> 0);
+      rgb[x * 3 + 1] = (u8)(row[x] >> 8);
+      rgb[x * 3 + 2] = (u8)(row[x] >> 16);
+    }
+    ok = fwrite(rgb, 3, soft->width, file) == soft->width;
+  }
+  temp_end(temp);
+  ok = (fclose(file) == 0) && ok;
+  return ok;
+}
@@ -0,0 +1,115 @@
+#ifndef RENDER_SOFT_H
+#define RENDER_SOFT_H
+
+////////////////////////////////
+//~ nb: Software renderer
+// CPU backend with the renderer's API (clear, push quads, tile grid, tile
+// map, present, textures) for runs without a GPU: benchmarks, golden images,
+// servers. Draws axis-aligned textured quads into an RGBA8 framebuffer the
+// way the D3D11 renderer does: a pixel is covered when its center is, the
+// point sampler wraps, and blending is main_blend_state (color by source
+// alpha, alpha replaced by the source's). Draws are queued and rasterized
+// at r_soft_present (or the next clear), in row bands spread over threads.
+// Only depends on base.h and render_core.h.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// nb: rows per band, bands go round robin to the threads
+#define R_SOFT_BAND_ROWS    16
+#define R_SOFT_MAX_THREADS  64
+
+typedef struct R_SoftTex2D R_SoftTex2D;
+struct R_SoftTex2D
+{
+  R_SoftTex2D   *next;            // in the free list
+  R_SoftTex2D   *next_allocated;  // every texture ever made, for the release
+  u64           generation;
+  R_Tex2DFormat format;           // as allocated, the texels are unpacked
+  u32           *texels;          // RGBA8, row-major
+  u64           texels_reserved;  // in bytes
+  u32           width;
+  u32           height;
+};
+
+//- nb: a range of queued quads with one texture, or a tile map
+typedef struct R_SoftDraw R_SoftDraw;
+struct R_SoftDraw
+{
+  R_SoftTex2D   *texture;
+  u32           first_quad;
+  u32           quad_count;
+  R_TileMapConstants *tile_map;   // 0 for quads
+  const u8      *tiles;
+};
+
+typedef struct R_SoftState R_SoftState;
+struct R_SoftState
+{
+  // nb: first, so the backend's callbacks can get back here
+  R_DrawBackend draw_backend;
+  Arena         *arena;
+  R_SoftTex2D   *first_free_tex2d;
+  R_SoftTex2D   *first_allocated_tex2d;
+
+  ////////////////////////////////
+  // nb: RGBA8, row-major, what a swapchain buffer would hold
+  u32           *framebuffer;
+  u64           framebuffer_reserved;
+  u32           width;
+  u32           height;
+  u32           thread_count;
+
+  ////////////////////////////////
+  // nb: Frame command list, flushed into the queue by r_soft_present
+  R_CmdList     *cmd_list;
+  u32           map_first_quad;
+  // nb: queued draws, one arena each so both arrays stay contiguous.
+  // Cleared once rasterized.
+  Arena         *quad_arena;
+  Arena         *draw_arena;
+  // nb: copies of the queued tile maps' constants
+  Arena         *map_arena;
+  R_Quad        *quads;
+  u32           quad_count;
+  R_SoftDraw    *draws;
+  u32           draw_count;
+  R_FrameCounters last_frame_counters;
+};
+
+// nb: `thread_count` 0 picks one per logical core.
+R_SoftState *r_soft_alloc(u32 width, u32 height, u32 thread_count);
+void         r_soft_release(R_SoftState *soft);
+// nb: The framebuffer's contents are undefined afterwards.
+void         r_soft_resize(R_SoftState *soft, u32 width, u32 height);
+
+// nb: `data` is `format`, `width` texels per row, 0 leaves the texels
+// undefined. Kept unpacked to RGBA8, see r_tex2d_unpack, compressed formats
+// decode with render_bc.
+R_Handle     r_soft_tex2d_alloc(R_SoftState *soft, R_Tex2DFormat format, u32 width, u32 height, const void *data);
+void         r_soft_tex2d_release(R_SoftState *soft, R_Handle handle);
+// nb: `data` is rows of the texture's format. For compressed formats x and
+// y are multiples of 4, and so are width and height short of the edge.
+void         r_soft_tex2d_update(R_SoftState *soft, R_Handle handle, u32 x, u32 y, u32 width, u32 height, const void *data);
+
+void         r_soft_clear(R_SoftState *soft, const f32 *color);
+R_Quad      *r_soft_push_quads(R_SoftState *soft, R_Handle texture, R_Layer layer, u32 count);
+// nb: Queued right away, like r_submit_tile_grid draws right away.
+// `tiles` is the whole board, see R_TileGridConstants.
+void         r_soft_submit_tile_grid(R_SoftState *soft, R_TileGridConstants *grid, const u8 *tiles, u32 count, R_Handle texture);
+// nb: Queued right away as well, resolved per pixel by r_tile_map_sample.
+// `tiles` is read when the queue is rasterized and has to stay alive until
+// then.
+void         r_soft_submit_tile_map(R_SoftState *soft, R_TileMapConstants *map, const u8 *tiles, R_Handle texture);
+// nb: Flushes the command list and rasterizes everything queued.
+void         r_soft_present(R_SoftState *soft);
+
+// nb: Binary PPM of the framebuffer, alpha dropped. Returns 0 on failure.
+b32          r_soft_write_ppm(R_SoftState *soft, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //RENDER_SOFT_H
@@ -0,0 +1,328 @@
+#include "text_cache.h"
+
+////////////////////////////////
+//~ nb: Types
+typedef struct Text_Cache_Entry Text_Cache_Entry;
+struct Text_Cache_Entry
+{
+  Text_Run_Key     key;
+  u64              hash;
+  u32              length;
+  const char       *str;          // in `data`, after the quads and batches
+  Text_Run         run;
+  u8               *data;
+  u64              data_capacity;
+  u64              last_used_frame;
+  // nb: most recently used first, also the free list through next
+  Text_Cache_Entry *prev;
+  Text_Cache_Entry *next;
+};
+
+struct Text_Cache
+{
+  Arena             *arena;
+  // nb: every entry's data, cleared whole when it goes past max_bytes
+  Arena             *data_arena;
+  u64               data_bytes;
+  Text_Cache_Params params;
+  Text_Cache_Entry  *entries;
+  Text_Cache_Entry  *first_free;
+  u32               run_count;
+  // nb: open addressing, entry index + 1, 0 is empty
+  u32               *table;
+  u32               table_mask;
+  Text_Cache_Entry  lru;
+  u64               frame;
+  Text_Cache_Stats  stats;
+  Text_Cache_Stats  frame_stats;
+  Text_Cache_Stats  last_frame_stats;
+};
+
+////////////////////////////////
+//~ nb: Helper functions
+//- nb: FNV-1a over the string, which also finds its length, then the key
+internal u64
+text_run_hash(Text_Run_Key key, const char *str, u32 *length)
+{
+  u64 h = 0xcbf29ce484222325ull;
+  const u8 *at = (const u8*)str;
+  for(; *at; at++)
+    h = (h ^ *at) * 0x100000001b3ull;
+  *length = (u32)(at - (const u8*)str);
+  u32 bits[4];
+  memcpy(bits, &key, sizeof(bits));
+  for(u32 i = 0; i < 4; i++)
+    h = (h ^ bits[i]) * 0x9e3779b97f4a7c15ull;
+  return h ^ (h >> 29);
+}
+
+internal inline b32
+text_run_key_equal(Text_Run_Key a, Text_Run_Key b)
+{
+  // nb: bitwise, so -0 and 0 are different positions but NaN finds itself
+  return memcmp(&a, &b, sizeof(Text_Run_Key)) == 0;
+}
+
+//- nb: LRU list
+internal void
+text_lru_remove(Text_Cache_Entry *entry)
+{
+  entry->prev->next = entry->next;
+  entry->next->prev = entry->prev;
+}
+
+internal void
+text_lru_push_front(Text_Cache *cache, Text_Cache_Entry *entry)
+{
+  entry->prev = &cache->lru;
+  entry->next = cache->lru.next;
+  entry->next->prev = entry;
+  cache->lru.next = entry;
+}
+
+//- nb: hash map
+internal u32
+text_table_find(Text_Cache *cache, u64 hash, Text_Run_Key key, const char *str, u32 length)
+{
+  for(u32 i = (u32)hash & cache->table_mask;; i = (i + 1) & cache->table_mask)
+  {
+    u32 value = cache->table[i];
+    if(value == 0)
+      return i;
+    Text_Cache_Entry *entry = &cache->entries[value - 1];
+    if(entry->hash == hash && entry->length == length && text_run_key_equal(entry->key, key) &&
+       memcmp(entry->str, str, length) == 0)
+      return i;
+  }
+}
+
+//- nb: backward shift, so lookups never need tombstones
+internal void
+text_table_remove(Text_Cache *cache, Text_Cache_Entry *entry)
+{
+  u32 hole = text_table_find(cache, entry->hash, entry->key, entry->str, entry->length);
+  Assert(cache->table[hole] != 0);
+  for(u32 i = (hole + 1) & cache->table_mask; cache->table[i]; i = (i + 1) & cache->table_mask)
+  {
+    u32 home = (u32)cache->entries[cache->table[i] - 1].hash & cache->table_mask;
+    // nb: can the entry at i move back to the hole without passing its home
+    b32 movable = (hole <= i) ? (home <= hole || home > i) : (home <= hole && home > i);
+    if(movable)
+    {
+      cache->table[hole] = cache->table[i];
+      hole = i;
+    }
+  }
+  cache->table[hole] = 0;
+}
+
+////////////////////////////////
+//~ nb: Eviction
+internal void
+text_cache_unlink(Text_Cache *cache, Text_Cache_Entry *entry)
+{
+  text_table_remove(cache, entry);
+  text_lru_remove(entry);
+  cache->run_count -= 1;
+}
+
+internal void
+text_cache_evict(Text_Cache *cache, Text_Cache_Entry *entry)
+{
+  text_cache_unlink(cache, entry);
+  // nb: the data stays with the entry for the next run that fits it
+  entry->next = cache->first_free;
+  cache->first_free = entry;
+  cache->stats.evictions += 1;
+  cache->frame_stats.evictions += 1;
+}
+
+//- nb: every run goes along with the data arena
+internal void
+text_cache_clear(Text_Cache *cache)
+{
+  memset(cache->table, 0, sizeof(u32) * (cache->table_mask + 1));
+  cache->first_free = 0;
+  for(u32 i = cache->params.max_runs; i > 0; i--)
+  {
+    Text_Cache_Entry *entry = &cache->entries[i - 1];
+    entry->data          = 0;
+    entry->data_capacity = 0;
+    entry->next = cache->first_free;
+    cache->first_free = entry;
+  }
+  cache->lru.prev = cache->lru.next = &cache->lru;
+  cache->run_count = 0;
+  arena_clear(cache->data_arena);
+  cache->data_bytes = 0;
+}
+
+//- nb: a free entry, else the LRU one if it wasn't used this frame
+internal Text_Cache_Entry *
+text_cache_take_entry(Text_Cache *cache)
+{
+  if(!cache->first_free)
+  {
+    Text_Cache_Entry *lru = cache->lru.prev;
+    if(lru == &cache->lru || lru->last_used_frame >= cache->frame)
+      return 0;
+    text_cache_evict(cache, lru);
+  }
+  Text_Cache_Entry *entry = cache->first_free;
+  cache->first_free = entry->next;
+  return entry;
+}
+
+////////////////////////////////
+//~ nb: Text cache
+Text_Cache_Params
+text_cache_default_params(void)
+{
+  Text_Cache_Params params = {TEXT_CACHE_MAX_RUNS, TEXT_CACHE_MAX_BYTES};
+  return params;
+}
+
+Text_Cache *
+text_cache_alloc(Text_Cache_Params params)
+{
+  Arena *arena = arena_alloc();
+  Text_Cache *cache = (Text_Cache*)arena_push(arena, sizeof(Text_Cache));
+  memset(cache, 0, sizeof(Text_Cache));
+  cache->arena      = arena;
+  cache->data_arena = arena_alloc();
+  cache->params     = params;
+  // nb: frame 0 is before anything was used
+  cache->frame = 1;
+
+  cache->entries = (Text_Cache_Entry*)arena_push(arena, sizeof(Text_Cache_Entry) * params.max_runs);
+  memset(cache->entries, 0, sizeof(Text_Cache_Entry) * params.max_runs);
+
+  //- nb: at most half full
+  u32 table_size = 16;
+  while(table_size < params.max_runs * 2)
+    table_size *= 2;
+  cache->table = (u32*)arena_push(arena, sizeof(u32) * table_size);
+  cache->table_mask = table_size - 1;
+  text_cache_clear(cache);
+  return cache;
+}
+
+void
+text_cache_release(Text_Cache *cache)
+{
+  arena_release(cache->data_arena);
+  arena_release(cache->arena);
+}
+
+void
+text_cache_frame(Text_Cache *cache)
+{
+  cache->last_frame_stats = cache->frame_stats;
+  memset(&cache->frame_stats, 0, sizeof(Text_Cache_Stats));
+  cache->frame += 1;
+}
+
+const Text_Run *
+text_cache_get(Text_Cache *cache, Text_Run_Key key, const char *str)
+{
+  u32 length = 0;
+  u64 hash = text_run_hash(key, str, &length);
+  u32 bucket = text_table_find(cache, hash, key, str, length);
+  if(!cache->table[bucket])
+  {
+    cache->stats.misses += 1;
+    cache->frame_stats.misses += 1;
+    return 0;
+  }
+  Text_Cache_Entry *entry = &cache->entries[cache->table[bucket] - 1];
+  entry->last_used_frame = cache->frame;
+  text_lru_remove(entry);
+  text_lru_push_front(cache, entry);
+  cache->stats.hits += 1;
+  cache->stats.glyphs_cached += entry->run.quad_count;
+  cache->frame_stats.hits += 1;
+  cache->frame_stats.glyphs_cached += entry->run.quad_count;
+  return &entry->run;
+}
+
+const Text_Run *
+text_cache_put(Text_Cache *cache, Text_Run_Key key, const char *str, const Text_Run *run)
+{
+  cache->stats.glyphs_laid_out += run->quad_count;
+  cache->frame_stats.glyphs_laid_out += run->quad_count;
+  if(run->transient)
+    return run;
+
+  u32 length = 0;
+  u64 hash = text_run_hash(key, str, &length);
+  u64 quad_bytes  = sizeof(R_Quad) * run->quad_count;
+  u64 batch_bytes = sizeof(Text_Run_Batch) * run->batch_count;
+  u64 bytes = AlignPow2(quad_bytes + batch_bytes + length + 1, 16);
+  if(bytes > cache->params.max_bytes)
+    return run;
+
+  //- nb: the run already there for this string, else a new entry, then
+  // room for the data
+  Text_Cache_Entry *entry = 0;
+  u32 bucket = text_table_find(cache, hash, key, str, length);
+  if(cache->table[bucket])
+  {
+    entry = &cache->entries[cache->table[bucket] - 1];
+    text_cache_unlink(cache, entry);
+  }
+  else
+  {
+    entry = text_cache_take_entry(cache);
+    if(!entry)
+      return run;
+  }
+  if(entry->data_capacity < bytes)
+  {
+    if(cache->data_bytes + bytes > cache->params.max_bytes)
+    {
+      // nb: the entry is no run right now, the clear takes it back as well
+      text_cache_clear(cache);
+      cache->stats.resets += 1;
+      cache->frame_stats.resets += 1;
+      entry = text_cache_take_entry(cache);
+    }
+    entry->data          = (u8*)arena_push(cache->data_arena, bytes);
+    entry->data_capacity = bytes;
+    cache->data_bytes   += bytes;
+  }
+
+  entry->key    = key;
+  entry->hash   = hash;
+  entry->length = length;
+  entry->run    = *run;
+  entry->run.quads   = (R_Quad*)entry->data;
+  entry->run.batches = (Text_Run_Batch*)(entry->data + quad_bytes);
+  char *copy = (char*)(entry->data + quad_bytes + batch_bytes);
+  memcpy(entry->run.quads, run->quads, quad_bytes);
+  memcpy(entry->run.batches, run->batches, batch_bytes);
+  memcpy(copy, str, length + 1);
+  entry->str = copy;
+  entry->last_used_frame = cache->frame;
+  text_lru_push_front(cache, entry);
+  cache->table[text_table_find(cache, hash, key, str, length)] = (u32)(entry - cache->entries) + 1;
+  cache->run_count += 1;
+  return &entry->run;
+}
+
+Text_Cache_Stats
+text_cache_stats(Text_Cache *cache)
+{
+  return cache->stats;
+}
+
+Text_Cache_Stats
+text_cache_frame_stats(Text_Cache *cache)
+{
+  return cache->last_frame_stats;
+}
+
+u32
+text_cache_run_count(Text_Cache *cache)
+{
+  return cache->run_count;
+}
@@ -0,0 +1,94 @@
+#ifndef TEXT_CACHE_H
+#define TEXT_CACHE_H
+
+////////////////////////////////
+//~ nb: Text run cache
+// Laid out strings kept across frames, so text that doesn't change (labels,
+// banners, a HUD between ticks) costs a hash and a copy instead of decoding
+// and walking the glyph metrics every frame. A run is keyed by the string,
+// the caller's font id, size and position, and holds its quads batched by
+// texture, ready for r_push_quads.
+//
+// Runs not used in the current frame are evicted least recently used first
+// when the cache is full. Their quads live in one data arena; when that
+// reaches its budget every run is dropped at once and the cache starts
+// over. Only depends on base.h and render_core.h.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEXT_CACHE_MAX_RUNS   256
+#define TEXT_CACHE_MAX_BYTES  (1 << 20)
+
+typedef struct Text_Run_Key Text_Run_Key;
+struct Text_Run_Key
+{
+  u32 font;                       // the caller's font id
+  u32 size;                       // em size in 1/64 pixels
+  f32 x;                          // pen position of the first glyph
+  f32 y;
+};
+
+//- nb: quads [first_quad, first_quad + quad_count) are on `texture`
+typedef struct Text_Run_Batch Text_Run_Batch;
+struct Text_Run_Batch
+{
+  R_Handle texture;
+  u32      first_quad;
+  u32      quad_count;
+};
+
+// nb: A laid out string. Transient runs hold glyphs that may move between
+// frames (the glyph cache's), they are counted but never kept.
+typedef struct Text_Run Text_Run;
+struct Text_Run
+{
+  R_Quad         *quads;
+  u32            quad_count;
+  Text_Run_Batch *batches;
+  u32            batch_count;
+  f32            advance;         // from the key's x to the pen after the last glyph
+  b32            transient;
+};
+
+typedef struct Text_Cache_Params Text_Cache_Params;
+struct Text_Cache_Params
+{
+  u32 max_runs;
+  u64 max_bytes;                  // quads, batches and strings of every run
+};
+
+typedef struct Text_Cache_Stats Text_Cache_Stats;
+struct Text_Cache_Stats
+{
+  u64 hits;
+  u64 misses;
+  u64 glyphs_cached;              // quads handed out from hits
+  u64 glyphs_laid_out;            // quads put after a miss
+  u64 evictions;
+  u64 resets;                     // every run dropped, the data arena was full
+};
+
+typedef struct Text_Cache Text_Cache;
+
+Text_Cache_Params text_cache_default_params(void);
+Text_Cache       *text_cache_alloc(Text_Cache_Params params);
+void              text_cache_release(Text_Cache *cache);
+// nb: Starts a frame, runs not used since become evictable.
+void              text_cache_frame(Text_Cache *cache);
+// nb: The run for `str` at `key`, 0 on a miss. Valid until the next put.
+const Text_Run   *text_cache_get(Text_Cache *cache, Text_Run_Key key, const char *str);
+// nb: Keeps a copy of `run` for the next gets. Returns the copy, or `run`
+// itself when it is transient or there is no room this frame.
+const Text_Run   *text_cache_put(Text_Cache *cache, Text_Run_Key key, const char *str, const Text_Run *run);
+Text_Cache_Stats  text_cache_stats(Text_Cache *cache);
+// nb: the last frame text_cache_frame finished
+Text_Cache_Stats  text_cache_frame_stats(Text_Cache *cache);
+u32               text_cache_run_count(Text_Cache *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //TEXT_CACHE_H